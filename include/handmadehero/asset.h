@@ -16,8 +16,14 @@ struct audio {
 };
 
 struct font {
+  // NOTE(e2dk4r): glyph bitmap of every codepoint, only fonts of version 0
+  // files have it, 0 otherwise
   struct bitmap_id *codepoints;
-  f32 *horizontalAdvanceTable;
+  f32 *horizontalAdvances;
+  struct hha_font_kerning *kernings;
+  // NOTE(e2dk4r): views into glyph atlas, 0 when font has no atlas
+  struct hha_font_glyph *glyphs;
+  struct bitmap *glyphBitmaps;
   u32 bitmapIdOffset;
 };
 
@@ -52,9 +58,23 @@ struct asset {
   struct asset_memory_header *header;
 
   u32 fileIndex;
+  // index in HHA_SECTION_TYPE_ASSETS of file
+  u32 fileAssetIndex;
+  // 0 when asset is not in a bundle
+  u32 bundleIndex;
+  // index + 1 in game_assets.stream.requests, 0 when not requested
+  u32 requestIndex;
+  // stream frame asset was asked for, load latency is measured from it
+  u32 requestFrameIndex;
   struct hha_asset hhaAsset;
 };
 
+struct asset_bundle {
+  // range in game_assets.bundleAssets
+  u32 assetIndexFirst;
+  u32 assetIndexOnePastLast;
+};
+
 struct bitmap_info {
   char *filename;
   struct v2 alignPercentage;
@@ -82,18 +102,165 @@ struct asset_group {
   u32 tagLastIndex;
 };
 
+/* NOTE(e2dk4r): Tags of every asset in a type, laid out as structure of arrays.
+ * Lane i is asset (type->assetIndexFirst + i), so BestMatchAsset can score
+ * 4 assets at once instead of walking each asset's tag list.
+ */
+struct asset_tag_index {
+  // asset count of type rounded up to 4
+  u32 laneCount;
+
+  // 0 for assets, F32_MAX for padding lanes so that they never match
+  f32 *bias;
+
+  // values[tagId] is null when no asset of type has that tag
+  f32 *values[ASSET_TAG_COUNT];
+  // 1 when asset has the tag, 0 otherwise
+  f32 *masks[ASSET_TAG_COUNT];
+
+  // NOTE(e2dk4r): Direct lookup for ASSET_TAG_UNICODE_CODEPOINT.
+  // Only built when every asset of type has integral codepoint tag.
+  // codepointAssets[codepoint - codepointFirst] is asset index, 0 when none.
+  u32 codepointFirst;
+  u32 codepointCount;
+  u32 *codepointAssets;
+};
+
 struct asset_file {
   struct platform_file_handle handle;
+  // NOTE(e2dk4r): version 0 header is converted on load, its offsets are
+  // kept in sections
   struct hha_header header;
+  struct hha_section sections[HHA_SECTION_TYPE_COUNT];
 
   // TODO: if we ever do thread stacks, assetTypes does not
   // need to be kept here probably.
   struct hha_asset_type *assetTypes;
+  // NOTE(e2dk4r): only valid while loading, point into game_assets
+  // and temporary memory respectively
+  struct hha_tag *tags;
+  union {
+    struct hha_asset *hhaAssets;
+    // when header.version is 0
+    struct hha_asset_v0 *hhaAssetsV0;
+  };
+  struct hha_bundle *hhaBundles;
+  // bundle asset indices of file are translated in place
+  u32 *bundleAssets;
+  // asset index in file to asset index in game_assets,
+  // only bitmaps are mapped as only they can be bundled
+  u32 *assetIndexMap;
 
   u32 tagBase;
+  u32 bundleBase;
+  u32 bundleAssetBase;
   u32 fontBitmapIdOffset;
+  u32 atlasBitmapIdOffset;
+  // layout of file changed on disk, it is loaded on restart
+  b32 isReloadPending;
+};
+
+/*
+ * Priority of asset request, lower is more urgent. Drawn assets are ordered
+ * by distance to camera in meters. Prefetched assets come after all drawn
+ * ones, ordered by estimated seconds until they come on screen.
+ */
+#define ASSET_PRIORITY_NOW 0.0f
+#define ASSET_PRIORITY_PREFETCH 1000.0f
+
+#define ASSET_REQUEST_COUNT_MAX 256
+// loads that can wait in low priority queue at once, rest wait as requests
+#define ASSET_STREAM_IN_FLIGHT_MAX 8
+
+struct asset_request {
+  u32 assetIndex;
+  f32 priority;
+  // frame asset was last requested in
+  u32 frameIndex;
+};
+
+/*
+ * Bitmap loads are not queued in request order. They are collected as
+ * requests, and once every frame most urgent ones are queued, keeping low
+ * priority queue short. Requests that are not renewed in a frame are
+ * cancelled. Only used from game thread.
+ */
+struct asset_stream {
+  u32 frameIndex;
+  u32 requestCount;
+  struct asset_request requests[ASSET_REQUEST_COUNT_MAX];
+
+  // since start
+  u64 requestedCount;
+  u64 dispatchedCount;
+  u64 cancelledCount;
+  // new requests not taken because table was full of more urgent ones
+  u64 droppedCount;
+};
+
+struct asset_counters {
+  // AssetGet found asset loaded or not
+  u64 hitCount;
+  u64 missCount;
+  u64 loadCount;
+  // read from asset pack files
+  u64 loadedBytes;
+  u64 evictionCount;
+  u64 evictedBytes;
+  // draws skipped by render groups as asset was not loaded
+  u64 missingResourceCount;
+};
+
+/*
+ * Load latency is measured in frames, from when asset is requested until it
+ * is loaded. First bucket counts loads finished in same frame, bucket n
+ * counts ones that took [2^(n-1), 2^n) frames and last bucket counts rest.
+ */
+#define ASSET_LATENCY_BUCKET_COUNT 10
+
+/* NOTE(e2dk4r): Counters for sizing asset memory for content. Loads are
+ * counted from worker threads, rest under asset lock or from game thread.
+ */
+struct asset_telemetry {
+  // since start
+  struct asset_counters total;
+  // counted in last frame
+  struct asset_counters lastFrame;
+  // total when frame started
+  struct asset_counters frameStart;
+
+  u64 memorySize;
+  u64 memoryUsed;
+  u64 memoryUsedMax;
+
+  // requests waiting and loads in flight at end of frame
+  u32 queueDepth;
+  u32 queueDepthMax;
+
+  // asset packs that are new or changed their layout on disk, they are loaded on restart
+  u32 reloadPendingFileCount;
+
+  u64 loadLatencies[ASSET_LATENCY_BUCKET_COUNT];
+};
+
+#if HANDMADEHERO_DEBUG
+#define ASSET_TRACE_EVENT_COUNT_MAX 16384
+
+struct asset_trace_event {
+  u32 frameIndex;
+  u32 assetIndex;
 };
 
+/* NOTE(e2dk4r): Loads of assets in order they finish, see hha_trace_header.
+ * Loads are traced from worker threads, ones after events are full are not
+ * traced.
+ */
+struct asset_trace {
+  u32 eventCount;
+  struct asset_trace_event *events;
+};
+#endif
+
 enum asset_memory_block_flags {
   ASSET_MEMORY_BLOCK_USED = (1 << 0),
 };
@@ -126,12 +293,25 @@ struct game_assets {
   struct asset *assets;
 
   struct asset_type assetTypes[ASSET_TYPE_COUNT];
+  struct asset_tag_index tagIndexes[ASSET_TYPE_COUNT];
+
+  // first bundle is always null
+  u32 bundleCount;
+  struct asset_bundle *bundles;
+  u32 bundleAssetCount;
+  u32 *bundleAssets;
 
   u8 *hhaData;
 
   u32 fileCount;
   struct asset_file *files;
 
+  struct asset_stream stream;
+  struct asset_telemetry telemetry;
+#if HANDMADEHERO_DEBUG
+  struct asset_trace trace;
+#endif
+
   u32 operationLock;
 };
 
@@ -145,8 +325,14 @@ void
 BitmapLoadImmediate(struct game_assets *assets, struct bitmap_id id);
 
 void
-BitmapPrefetch(struct game_assets *assets, struct bitmap_id id);
+BitmapRequest(struct game_assets *assets, struct bitmap_id id, f32 priority);
+
+// secondsUntilVisible is estimate of when bitmap is going to be drawn
+void
+BitmapPrefetch(struct game_assets *assets, struct bitmap_id id, f32 secondsUntilVisible);
 
+// NOTE(e2dk4r): for bitmap in atlas, returns its atlas. Where bitmap is in
+// atlas can be found with BitmapInfoGet().
 struct bitmap *
 BitmapGet(struct game_assets *assets, struct bitmap_id id, u32 generationId);
 
@@ -201,9 +387,14 @@ struct font_id
 BestMatchFont(struct game_assets *assets, enum asset_type_id typeId, struct asset_vector *matchVector,
               struct asset_vector *weightVector);
 
+// bitmap of codepoint in fonts of version 0 files, 0 otherwise
 struct bitmap_id
 FontGetBitmapGlyph(struct game_assets *assets, struct hha_font *fontInfo, struct font *font, u32 codepoint);
 
+// NOTE(e2dk4r): returns view of glyph in font's atlas, 0 when font has no atlas
+struct bitmap *
+FontGetGlyphBitmap(struct hha_font *fontInfo, struct font *font, u32 codepoint);
+
 f32
 FontGetLineAdvance(struct hha_font *fontInfo);
 
@@ -216,6 +407,45 @@ FontGetHorizontalAdvanceForPair(struct hha_font *fontInfo, struct font *font, u3
 struct hha_font *
 FontInfoGet(struct game_assets *assets, struct font_id id);
 
+struct bundle_id
+BundleGetForBitmap(struct game_assets *assets, struct bitmap_id id);
+
+/* NOTE(e2dk4r): Loads every bitmap in bundle that is not loaded yet,
+ * with one read and one task.
+ */
+void
+BundleLoad(struct game_assets *assets, struct bundle_id id);
+
+/* NOTE(e2dk4r): Queues most urgent bitmap requests and cancels ones that are
+ * not requested since last call. Call once every frame.
+ */
+void
+AssetStreamUpdate(struct game_assets *assets);
+
+/* NOTE(e2dk4r): Reads metadata of asset pack files again, after they are
+ * written on disk. Assets whose metadata changed are evicted, and loaded
+ * again when they are next used. Asset pack must keep its asset types, tags
+ * and bundles, otherwise it is not reloaded. Work on low priority queue must
+ * be completed, and no generation of caller can be in flight, as it waits
+ * for generations of other threads to end.
+ */
+void
+AssetFilesReload(struct game_assets *assets);
+
+/* NOTE(e2dk4r): Closes frame of telemetry. Call once every frame after
+ * rendering, with missing resource count of render groups in frame.
+ */
+void
+AssetTelemetryEndFrame(struct game_assets *assets, u32 missingResourceCount);
+
+#if HANDMADEHERO_DEBUG
+/* NOTE(e2dk4r): Writes asset trace to file at path, for builder to order
+ * data of packs. Work on low priority queue must be completed.
+ */
+void
+AssetTraceWrite(struct game_assets *assets, char *path);
+#endif
+
 u32
 BeginGeneration(struct game_assets *assets);
 
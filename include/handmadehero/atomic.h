@@ -3,12 +3,22 @@
 
 #if COMPILER_GCC || COMPILER_CLANG
 
+#define AtomicLoad(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
 #define AtomicStore(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define AtomicExchange(ptr, value) __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL)
 #define AtomicCompareExchange(ptr, expected, desired)                                                                  \
   __atomic_compare_exchange_n(ptr, expected, desired, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
 #define AtomicCompareExchangeExplicit(ptr, expected, desired, weak, successMemOrder, failureMemOrder)                  \
   __atomic_compare_exchange_n(ptr, expected, desired, weak, successMemOrder, failureMemOrder)
 #define AtomicFetchAdd(ptr, value) __atomic_fetch_add(ptr, value, __ATOMIC_RELEASE)
+#define AtomicFetchSub(ptr, value) __atomic_fetch_sub(ptr, value, __ATOMIC_RELEASE)
+// for store followed by load of another variable, that other thread does in reverse
+#define AtomicLoadSeqCst(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
+#define AtomicStoreSeqCst(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST)
+// for telemetry counters and flags that do not publish other memory
+#define AtomicLoadRelaxed(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define AtomicStoreRelaxed(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELAXED)
+#define AtomicFetchAddRelaxed(ptr, value) __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED)
 
 #elif COMPILER_MSVC
 #error "TODO: msvc atomics"
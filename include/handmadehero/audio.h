@@ -2,41 +2,324 @@
 #define HANDMADEHERO_AUDIO_H
 
 #include "asset.h"
+#include "audio_effect.h"
+#include "resampler.h"
 #include "types.h"
 
+/* NOTE(e2dk4r): Playing audios are owned by mixer, which runs on audio
+ * thread. Game thread only sends commands to mixer, and refers to a playing
+ * audio with its id.
+ */
+struct playing_audio_id {
+  u32 value;
+};
+
+/* NOTE(e2dk4r): Playing audios are mixed into a bus. Every bus runs its
+ * filter and reverb, is scaled by its volume, runs its limiter, and is
+ * mixed into its parent bus. Parent of a bus always comes before it, so
+ * buses are mixed down from last one to master.
+ */
+enum audio_bus_id {
+  AUDIO_BUS_MASTER,
+  AUDIO_BUS_MUSIC,
+  AUDIO_BUS_SOUND,
+  AUDIO_BUS_INTERFACE,
+  AUDIO_BUS_COUNT,
+};
+
+struct audio_bus {
+  enum audio_bus_id parent;
+  struct v2 currentVolume;
+  struct v2 dCurrentVolume;
+  struct v2 targetVolume;
+
+  // filter is built again when it changes or sample rate changes
+  enum biquad_type filterType;
+  f32 filterFrequency;
+  f32 filterQ;
+  u32 filterSampleRate;
+  struct biquad filter;
+  struct biquad_state filterStates[2];
+
+  struct reverb reverb;
+  struct limiter limiter;
+};
+
 struct playing_audio {
+  struct playing_audio_id playingAudioId;
   struct v2 currentVolume;
   struct v2 dCurrentVolume;
   struct v2 targetVolume;
   f32 dSample;
+  f32 priority;
+  // only advances its play cursor, not mixed
+  b32 isVirtual;
+  // gain of fade between virtual and real, 0 when virtual, in units per second
+  f32 virtualFade;
+  f32 dVirtualFade;
+  // keeps AUDIO_STREAM_AHEAD_COUNT audios in its chain loaded ahead
+  b32 isStreaming;
+  // mixed any samples, stopping after is underrun
+  b32 isStarted;
 
+  enum audio_bus_id busId;
   struct audio_id id;
+  // audio before id in its chain, 0 when id is first one
+  struct audio_id previousId;
   f32 samplesPlayed;
   struct playing_audio *next;
 };
 
+enum audio_command_type {
+  AUDIO_COMMAND_TYPE_PLAY,
+  AUDIO_COMMAND_TYPE_CHANGE_VOLUME,
+  AUDIO_COMMAND_TYPE_CHANGE_PITCH,
+  AUDIO_COMMAND_TYPE_CHANGE_REAL_AUDIO_COUNT,
+  AUDIO_COMMAND_TYPE_CHANGE_RESAMPLER,
+  AUDIO_COMMAND_TYPE_CHANGE_BUS,
+  AUDIO_COMMAND_TYPE_CHANGE_BUS_VOLUME,
+  AUDIO_COMMAND_TYPE_CHANGE_BUS_FILTER,
+  AUDIO_COMMAND_TYPE_CHANGE_BUS_REVERB,
+  AUDIO_COMMAND_TYPE_CHANGE_BUS_LIMITER,
+};
+
+/* NOTE(e2dk4r): How mixer reads pitched audios. Audios at unity pitch are
+ * always read as is.
+ *   - nearest: sample closest to play cursor
+ *   - linear: interpolates between two samples, aliases when pitched.
+ *     This is default.
+ *   - sinc: windowed sinc filter, see resampler.h. It costs several times
+ *     more than linear, so it is opt in with ChangeResampler().
+ */
+enum audio_resampler {
+  AUDIO_RESAMPLER_NEAREST,
+  AUDIO_RESAMPLER_LINEAR,
+  AUDIO_RESAMPLER_SINC,
+};
+
+struct audio_command {
+  enum audio_command_type type;
+  struct playing_audio_id playingAudioId;
+  enum audio_bus_id busId;
+  union {
+    // AUDIO_COMMAND_TYPE_PLAY
+    struct {
+      struct audio_id audioId;
+      f32 priority;
+      b32 isStreaming;
+    };
+    // AUDIO_COMMAND_TYPE_CHANGE_VOLUME, AUDIO_COMMAND_TYPE_CHANGE_BUS_VOLUME
+    struct {
+      f32 fadeDurationInSeconds;
+      struct v2 volume;
+    };
+    // AUDIO_COMMAND_TYPE_CHANGE_PITCH
+    f32 dSample;
+    // AUDIO_COMMAND_TYPE_CHANGE_REAL_AUDIO_COUNT
+    u32 realAudioCountMax;
+    // AUDIO_COMMAND_TYPE_CHANGE_RESAMPLER
+    enum audio_resampler resampler;
+    // AUDIO_COMMAND_TYPE_CHANGE_BUS_FILTER
+    struct {
+      enum biquad_type filterType;
+      f32 filterFrequency;
+      f32 filterQ;
+    };
+    // AUDIO_COMMAND_TYPE_CHANGE_BUS_REVERB
+    struct {
+      f32 reverbWet;
+      f32 reverbRoomSize;
+    };
+    // AUDIO_COMMAND_TYPE_CHANGE_BUS_LIMITER
+    f32 limiterThreshold;
+  };
+};
+
+// must be power of 2
+#define AUDIO_COMMAND_COUNT 1024
+#define PLAYING_AUDIO_COUNT_MAX 256
+
+/* NOTE(e2dk4r): Mixer cost is bounded by mixing at most realAudioCountMax
+ * playing audios, ones that are loudest after scaled with their bus and
+ * master volume and their priority. Rest are virtual, they only advance
+ * their play cursor and volume, so when they are mixed again they continue
+ * from where they would be. Audios quieter than AUDIO_VOLUME_AUDIBLE_MIN
+ * are always virtual.
+ * Audios that become real fade in, ones that become virtual fade out and
+ * are mixed until their fade ends, so swaps do not click.
+ */
+#define REAL_AUDIO_COUNT_MAX_DEFAULT 64
+#define AUDIO_PRIORITY_DEFAULT 1.0f
+#define AUDIO_VOLUME_AUDIBLE_MIN (1.0f / 32768.0f)
+#define AUDIO_VIRTUAL_FADE_SECONDS 0.005f
+
+/* NOTE(e2dk4r): Long audios like music are chained by builder. Streaming
+ * playing audio loads audios ahead in its chain and keeps them in asset
+ * cache, so next audio is ready long before it is needed. Loads are retried
+ * in chain order, which is order they are needed, every time mixer runs.
+ */
+#define AUDIO_STREAM_AHEAD_COUNT 2
+// audio ahead that is not loaded this close to when it is needed is late
+#define AUDIO_STREAM_LATE_SECONDS 1.0f
+
+/* NOTE(e2dk4r): Mixer does not queue loads itself. Work queue has one
+ * producer, game thread, and waits when it is full. Mixer writes ids of
+ * audios it needs into load request ring instead, and game thread loads
+ * them once every frame. Requests are dropped when ring is full, mixer
+ * sends them again next time it runs.
+ */
+// must be power of 2
+#define AUDIO_LOAD_REQUEST_COUNT 512
+
+/* NOTE(e2dk4r): Mixer does not use asset system, which takes asset lock.
+ * Game thread publishes snapshot of audios once every frame instead, with
+ * sample count, channel count and next audio in chain of every audio, and
+ * samples of loaded audios that mixer needs. Samples are kept from being
+ * evicted by generation of snapshot, which ends when mixer cannot read
+ * snapshot anymore.
+ *   - Mixer announces snapshot it reads in snapshotInUse, then checks it is
+ *     still latest. Game thread does not write over or end latest snapshot,
+ *     or ones from snapshot in use to latest.
+ *   - Samples are stamped by newest snapshot that publishes them, which is
+ *     never ended before snapshot mixer reads them from.
+ *   - Audios are published for AUDIO_SNAPSHOT_HOLD_COUNT frames after they
+ *     are played, asked for by mixer or used by mixer.
+ */
+#define AUDIO_SNAPSHOT_COUNT 3
+#define AUDIO_SNAPSHOT_AUDIO_COUNT_MAX 1024
+#define AUDIO_SNAPSHOT_HOLD_COUNT 8
+// audios played in a frame that are published at end of it
+#define AUDIO_PLAYED_COUNT_MAX 64
+
+struct audio_snapshot_audio {
+  // 0 when samples are not published
+  s16 *samples[2];
+  u32 sampleCount;
+  u32 channelCount;
+  struct audio_id nextInChain;
+  // mixer read samples, or needs them soon
+  volatile u32 isUsed;
+};
+
+struct audio_snapshot {
+  u32 audioIndexFirst;
+  u32 audioCount;
+  struct audio_snapshot_audio *audios;
+
+  // only used by game thread
+  b32 isLive;
+  u32 generationId;
+};
+
 struct audio_state {
+  // only used by mixer after init
   struct memory_arena *permanentArena;
   struct playing_audio *firstPlayingAudio;
   struct playing_audio *firstFreePlayingAudio;
 
   struct v2 masterVolume;
+  u32 realAudioCountMax;
+  enum audio_resampler resampler;
+  struct sinc_table sincTable;
+  struct audio_bus buses[AUDIO_BUS_COUNT];
+
+  /* NOTE(e2dk4r): Single producer single consumer ring. Game thread writes
+   * commands, mixer reads them before mixing. Neither side waits, commands
+   * are dropped when ring is full.
+   */
+  volatile u32 commandWriteIndex;
+  volatile u32 commandReadIndex;
+  struct audio_command commands[AUDIO_COMMAND_COUNT];
+
+  // single producer single consumer ring, mixer writes, game thread reads
+  volatile u32 loadRequestWriteIndex;
+  volatile u32 loadRequestReadIndex;
+  struct audio_id loadRequests[AUDIO_LOAD_REQUEST_COUNT];
+
+  /* NOTE(e2dk4r): Counted since start with relaxed atomics, read by any
+   * thread with AtomicLoadRelaxed. Stream counters are written by mixer,
+   * dropped commands by game thread.
+   */
+  // streaming audio stopped as its audio is not loaded
+  u64 streamUnderrunCount;
+  u64 streamUnderrunSampleCount;
+  // times mixer found audio ahead late
+  u64 streamLateCount;
+  u32 droppedCommandCount;
+
+  // number of snapshot, which is its index plus 1, 0 when there is none
+  volatile u32 snapshotLatest;
+  volatile u32 snapshotInUse;
+  struct audio_snapshot snapshots[AUDIO_SNAPSHOT_COUNT];
+
+  // only used by game thread
+  u32 nextPlayingAudioId;
+  // frames left that audio is published for, indexed same as snapshot audios
+  u8 *snapshotHolds;
+  u32 playedCount;
+  struct audio_id playedIds[AUDIO_PLAYED_COUNT_MAX];
 };
 
 void
 AudioStateInit(struct audio_state *audioState, struct memory_arena *permanentArena);
 
+// loads audios that mixer needs, only called by game thread
+void
+AudioLoadRequestsProcess(struct audio_state *audioState, struct game_assets *assets);
+
+// publishes audios to mixer, only called by game thread once every frame
+void
+AudioSnapshotPublish(struct audio_state *audioState, struct game_assets *assets);
+
+/* Stops publishing audios and waits until mixer stops reading snapshots,
+ * so no generation of audio state is in flight. Only called by game
+ * thread, before assets are reloaded.
+ */
+void
+AudioSnapshotWithdraw(struct audio_state *audioState, struct game_assets *assets);
+
 b32
-OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *audioBuffer, struct game_assets *assets);
+OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *audioBuffer);
 
-struct playing_audio *
+struct playing_audio_id
 PlayAudio(struct audio_state *audioState, struct audio_id id);
 
+struct playing_audio_id
+PlayAudioPriority(struct audio_state *audioState, struct audio_id id, f32 priority);
+
+struct playing_audio_id
+PlayAudioStream(struct audio_state *audioState, struct audio_id id, f32 priority);
+
 void
-ChangeVolume(struct audio_state *audioState, struct playing_audio *playingAudio, f32 fadeDurationInSeconds,
+ChangeVolume(struct audio_state *audioState, struct playing_audio_id playingAudioId, f32 fadeDurationInSeconds,
              struct v2 volume);
 
 void
-ChangePitch(struct audio_state *audioState, struct playing_audio *playingAudio, f32 dSample);
+ChangePitch(struct audio_state *audioState, struct playing_audio_id playingAudioId, f32 dSample);
+
+void
+ChangeRealAudioCount(struct audio_state *audioState, u32 realAudioCountMax);
+
+void
+ChangeResampler(struct audio_state *audioState, enum audio_resampler resampler);
+
+// playing audios are in master bus when they start
+void
+ChangeBus(struct audio_state *audioState, struct playing_audio_id playingAudioId, enum audio_bus_id busId);
+
+void
+ChangeBusVolume(struct audio_state *audioState, enum audio_bus_id busId, f32 fadeDurationInSeconds, struct v2 volume);
+
+// BIQUAD_TYPE_NONE turns filter off
+void
+ChangeBusFilter(struct audio_state *audioState, enum audio_bus_id busId, enum biquad_type type, f32 frequency, f32 q);
+
+// wet of 0 turns reverb off, roomSize is from 0 to 1
+void
+ChangeBusReverb(struct audio_state *audioState, enum audio_bus_id busId, f32 wet, f32 roomSize);
+
+// threshold is fraction of full scale, 0 turns limiter off
+void
+ChangeBusLimiter(struct audio_state *audioState, enum audio_bus_id busId, f32 threshold);
 
 #endif /* HANDMADEHERO_AUDIO_H */
@@ -0,0 +1,317 @@
+#ifndef HANDMADEHERO_AUDIO_EFFECT_H
+#define HANDMADEHERO_AUDIO_EFFECT_H
+
+#include "math.h"
+#include "types.h"
+#include <x86intrin.h>
+
+/*
+ * Effects process channels 8 samples at a time, one chunk in one __m256,
+ * same as mixer.
+ */
+
+/* NOTE(e2dk4r): Biquad filter is a recursion, every output depends on two
+ * outputs before it. It is written in block form, so 8 outputs are computed
+ * at once from 8 inputs and filter state before chunk:
+ *
+ *   y[0..7] = sum(x[k] * input[k]) + x[-1] * state[0] + x[-2] * state[1]
+ *                                  + y[-1] * state[2] + y[-2] * state[3]
+ *
+ * input[k] is impulse response delayed by k, state[i] is response to only
+ * that state. Both are precomputed when filter changes.
+ */
+enum biquad_type {
+  BIQUAD_TYPE_NONE,
+  BIQUAD_TYPE_LOWPASS,
+  BIQUAD_TYPE_HIGHPASS,
+};
+
+struct biquad {
+  enum biquad_type type;
+  f32 input[8][8];
+  f32 state[4][8];
+};
+
+struct biquad_state {
+  f32 x1;
+  f32 x2;
+  f32 y1;
+  f32 y2;
+};
+
+// runs filter with coefficients one sample at a time
+internal inline void
+BiquadRun(f32 b0, f32 b1, f32 b2, f32 a1, f32 a2, f32 *input, struct biquad_state state, f32 *output)
+{
+  for (u32 index = 0; index < 8; index++) {
+    f32 x = input[index];
+    f32 y = b0 * x + b1 * state.x1 + b2 * state.x2 - a1 * state.y1 - a2 * state.y2;
+    state.x2 = state.x1;
+    state.x1 = x;
+    state.y2 = state.y1;
+    state.y1 = y;
+    output[index] = y;
+  }
+}
+
+/*
+ * Lowpass and highpass filters from Robert Bristow-Johnson's audio EQ
+ * cookbook. frequency is cutoff in Hz, q is resonance, 0.7071 is flat.
+ */
+internal inline void
+BiquadInit(struct biquad *biquad, enum biquad_type type, f32 frequency, f32 q, u32 sampleRate)
+{
+  biquad->type = type;
+  if (type == BIQUAD_TYPE_NONE)
+    return;
+
+  // NOTE(e2dk4r): at 0 or nyquist sin(w0) is 0, q of 0 divides by zero
+  frequency = Clamp(1.0f, 0.49f * (f32)sampleRate, frequency);
+  q = Maximum(q, 0.01f);
+
+  f32 w0 = TAU32 * frequency / (f32)sampleRate;
+  f32 cosW0 = Cos(w0);
+  f32 alpha = Sin(w0) / (2.0f * q);
+
+  f32 b0, b1, b2;
+  if (type == BIQUAD_TYPE_LOWPASS) {
+    b0 = (1.0f - cosW0) * 0.5f;
+    b1 = 1.0f - cosW0;
+    b2 = (1.0f - cosW0) * 0.5f;
+  } else {
+    b0 = (1.0f + cosW0) * 0.5f;
+    b1 = -(1.0f + cosW0);
+    b2 = (1.0f + cosW0) * 0.5f;
+  }
+  f32 a0 = 1.0f + alpha;
+  f32 a1 = -2.0f * cosW0;
+  f32 a2 = 1.0f - alpha;
+
+  b0 /= a0;
+  b1 /= a0;
+  b2 /= a0;
+  a1 /= a0;
+  a2 /= a0;
+
+  f32 zero[8] = {};
+  struct biquad_state noState = {};
+
+  f32 impulse[8] = {1.0f};
+  f32 impulseResponse[8];
+  BiquadRun(b0, b1, b2, a1, a2, impulse, noState, impulseResponse);
+  for (u32 k = 0; k < 8; k++) {
+    for (u32 index = 0; index < 8; index++)
+      biquad->input[k][index] = index >= k ? impulseResponse[index - k] : 0.0f;
+  }
+
+  struct biquad_state states[4] = {{.x1 = 1.0f}, {.x2 = 1.0f}, {.y1 = 1.0f}, {.y2 = 1.0f}};
+  for (u32 stateIndex = 0; stateIndex < 4; stateIndex++)
+    BiquadRun(b0, b1, b2, a1, a2, zero, states[stateIndex], biquad->state[stateIndex]);
+}
+
+internal inline void
+BiquadProcess(struct biquad *biquad, struct biquad_state *state, __m256 *samples, u32 chunkCount)
+{
+  __m256 input[8];
+  for (u32 k = 0; k < 8; k++)
+    input[k] = _mm256_loadu_ps(biquad->input[k]);
+  __m256 stateX1 = _mm256_loadu_ps(biquad->state[0]);
+  __m256 stateX2 = _mm256_loadu_ps(biquad->state[1]);
+  __m256 stateY1 = _mm256_loadu_ps(biquad->state[2]);
+  __m256 stateY2 = _mm256_loadu_ps(biquad->state[3]);
+
+  f32 x1 = state->x1;
+  f32 x2 = state->x2;
+  f32 y1 = state->y1;
+  f32 y2 = state->y2;
+  for (u32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+    f32 x[8];
+    _mm256_storeu_ps(x, samples[chunkIndex]);
+
+    __m256 y = _mm256_mul_ps(_mm256_set1_ps(x1), stateX1);
+    y = _mm256_fmadd_ps(_mm256_set1_ps(x2), stateX2, y);
+    for (u32 k = 0; k < 8; k++)
+      y = _mm256_fmadd_ps(_mm256_set1_ps(x[k]), input[k], y);
+    y = _mm256_fmadd_ps(_mm256_set1_ps(y1), stateY1, y);
+    y = _mm256_fmadd_ps(_mm256_set1_ps(y2), stateY2, y);
+    samples[chunkIndex] = y;
+
+    x1 = x[7];
+    x2 = x[6];
+    y1 = y[7];
+    y2 = y[6];
+  }
+
+  state->x1 = x1;
+  state->x2 = x2;
+  state->y1 = y1;
+  state->y2 = y2;
+}
+
+/* NOTE(e2dk4r): Schroeder reverb, parallel comb filters into allpass
+ * filters in series. Every delay is multiple of 8 samples, so chunk never
+ * reads samples written in itself and never wraps around its delay line.
+ * Delays are tuned for 48kHz, right channel is spread a bit longer.
+ */
+#define REVERB_COMB_COUNT 4
+#define REVERB_ALLPASS_COUNT 2
+#define REVERB_STEREO_SPREAD 24
+#define REVERB_ALLPASS_FEEDBACK 0.5f
+#define REVERB_COMB_DELAYS {1112, 1184, 1280, 1352}
+#define REVERB_ALLPASS_DELAYS {552, 440}
+// sum of all delays of both channels
+#define REVERB_MEMORY_COUNT                                                                                            \
+  (2 * (1112 + 1184 + 1280 + 1352 + 552 + 440) + 2 * (REVERB_COMB_COUNT + REVERB_ALLPASS_COUNT) * REVERB_STEREO_SPREAD)
+
+struct reverb_line {
+  f32 *samples;
+  u32 delay;
+  u32 position;
+};
+
+struct reverb {
+  // amount of reverb, 0 is off
+  f32 wet;
+  // 0 to 1, how long reverb rings
+  f32 roomSize;
+  struct reverb_line combs[2][REVERB_COMB_COUNT];
+  struct reverb_line allpasses[2][REVERB_ALLPASS_COUNT];
+};
+
+// memory is REVERB_MEMORY_COUNT floats
+internal inline void
+ReverbInit(struct reverb *reverb, f32 *memory)
+{
+  u32 combDelays[REVERB_COMB_COUNT] = REVERB_COMB_DELAYS;
+  u32 allpassDelays[REVERB_ALLPASS_COUNT] = REVERB_ALLPASS_DELAYS;
+
+  reverb->wet = 0.0f;
+  reverb->roomSize = 0.0f;
+  __builtin_memset(memory, 0, sizeof(*memory) * REVERB_MEMORY_COUNT);
+  for (u32 channelIndex = 0; channelIndex < 2; channelIndex++) {
+    u32 spread = channelIndex * REVERB_STEREO_SPREAD;
+    for (u32 combIndex = 0; combIndex < REVERB_COMB_COUNT; combIndex++) {
+      struct reverb_line *line = &reverb->combs[channelIndex][combIndex];
+      line->samples = memory;
+      line->delay = combDelays[combIndex] + spread;
+      line->position = 0;
+      memory += line->delay;
+    }
+    for (u32 allpassIndex = 0; allpassIndex < REVERB_ALLPASS_COUNT; allpassIndex++) {
+      struct reverb_line *line = &reverb->allpasses[channelIndex][allpassIndex];
+      line->samples = memory;
+      line->delay = allpassDelays[allpassIndex] + spread;
+      line->position = 0;
+      memory += line->delay;
+    }
+  }
+}
+
+// silence what rang while reverb was off
+internal inline void
+ReverbClear(struct reverb *reverb)
+{
+  __builtin_memset(reverb->combs[0][0].samples, 0, sizeof(f32) * REVERB_MEMORY_COUNT);
+  for (u32 channelIndex = 0; channelIndex < 2; channelIndex++) {
+    for (u32 combIndex = 0; combIndex < REVERB_COMB_COUNT; combIndex++)
+      reverb->combs[channelIndex][combIndex].position = 0;
+    for (u32 allpassIndex = 0; allpassIndex < REVERB_ALLPASS_COUNT; allpassIndex++)
+      reverb->allpasses[channelIndex][allpassIndex].position = 0;
+  }
+}
+
+internal inline void
+ReverbProcess(struct reverb *reverb, u32 channelIndex, __m256 *samples, u32 chunkCount)
+{
+  __m256 combFeedback = _mm256_set1_ps(reverb->roomSize);
+  __m256 allpassFeedback = _mm256_set1_ps(REVERB_ALLPASS_FEEDBACK);
+  __m256 wet = _mm256_set1_ps(reverb->wet / (f32)REVERB_COMB_COUNT);
+  struct reverb_line *combs = reverb->combs[channelIndex];
+  struct reverb_line *allpasses = reverb->allpasses[channelIndex];
+
+  for (u32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+    __m256 dry = samples[chunkIndex];
+
+    // y[n] = x[n] + g * y[n - delay]
+    __m256 value = _mm256_setzero_ps();
+    for (u32 combIndex = 0; combIndex < REVERB_COMB_COUNT; combIndex++) {
+      struct reverb_line *line = &combs[combIndex];
+      f32 *position = line->samples + line->position;
+      __m256 y = _mm256_fmadd_ps(combFeedback, _mm256_loadu_ps(position), dry);
+      _mm256_storeu_ps(position, y);
+      value = _mm256_add_ps(value, y);
+
+      line->position += 8;
+      if (line->position == line->delay)
+        line->position = 0;
+    }
+
+    // v[n] = x[n] + g * v[n - delay], y[n] = v[n - delay] - g * v[n]
+    for (u32 allpassIndex = 0; allpassIndex < REVERB_ALLPASS_COUNT; allpassIndex++) {
+      struct reverb_line *line = &allpasses[allpassIndex];
+      f32 *position = line->samples + line->position;
+      __m256 old = _mm256_loadu_ps(position);
+      __m256 v = _mm256_fmadd_ps(allpassFeedback, old, value);
+      _mm256_storeu_ps(position, v);
+      value = _mm256_fnmadd_ps(allpassFeedback, v, old);
+
+      line->position += 8;
+      if (line->position == line->delay)
+        line->position = 0;
+    }
+
+    samples[chunkIndex] = _mm256_fmadd_ps(wet, value, dry);
+  }
+}
+
+/* NOTE(e2dk4r): Peak limiter, same gain for both channels. Gain drops
+ * right away for chunk that is over threshold, and recovers over
+ * LIMITER_RELEASE_SECONDS.
+ */
+#define LIMITER_RELEASE_SECONDS 0.1f
+
+struct limiter {
+  // peak sample value, 0 is off
+  f32 threshold;
+  f32 gain;
+};
+
+internal inline f32
+HorizontalMax8(__m256 value)
+{
+  __m128 max = _mm_max_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+  max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+  max = _mm_max_ss(max, _mm_shuffle_ps(max, max, 1));
+  return _mm_cvtss_f32(max);
+}
+
+internal inline void
+LimiterProcess(struct limiter *limiter, __m256 *samples0, __m256 *samples1, u32 chunkCount, u32 sampleRate)
+{
+  f32 release = 8.0f / (LIMITER_RELEASE_SECONDS * (f32)sampleRate);
+  __m256 signMask = _mm256_set1_ps(-0.0f);
+  __m256 sampleLane = _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+
+  f32 gain = limiter->gain;
+  for (u32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+    __m256 peak = _mm256_max_ps(_mm256_andnot_ps(signMask, samples0[chunkIndex]),
+                                _mm256_andnot_ps(signMask, samples1[chunkIndex]));
+    f32 peakMax = HorizontalMax8(peak);
+    f32 targetGain = peakMax > limiter->threshold ? limiter->threshold / peakMax : 1.0f;
+
+    f32 nextGain = targetGain;
+    if (targetGain > gain)
+      nextGain = gain + Minimum(targetGain - gain, release);
+
+    // ramp to next gain in chunk, but never above what keeps this chunk under threshold
+    __m256 gains = _mm256_fmadd_ps(sampleLane, _mm256_set1_ps((nextGain - gain) / 8.0f), _mm256_set1_ps(gain));
+    gains = _mm256_min_ps(gains, _mm256_set1_ps(targetGain));
+    samples0[chunkIndex] = _mm256_mul_ps(samples0[chunkIndex], gains);
+    samples1[chunkIndex] = _mm256_mul_ps(samples1[chunkIndex], gains);
+
+    gain = nextGain;
+  }
+  limiter->gain = gain;
+}
+
+#endif /* HANDMADEHERO_AUDIO_EFFECT_H */
@@ -0,0 +1,46 @@
+#ifndef HANDMADEHERO_CHECKSUM_H
+#define HANDMADEHERO_CHECKSUM_H
+
+#include "types.h"
+#include <x86intrin.h>
+
+/*
+ * CRC-32C (Castagnoli) using SSE4.2 crc32 instruction.
+ *
+ * Checksum can be calculated in pieces, pass 0 on first call
+ * and result of previous call on next ones.
+ *
+ *   u32 crc = Crc32cAccumulate(0, a, aSize);
+ *   crc = Crc32cAccumulate(crc, b, bSize);
+ */
+internal inline u32
+Crc32cAccumulate(u32 crc, void *data, u64 size)
+{
+  u8 *byte = data;
+  u64 result = ~crc;
+
+  while (size >= 8) {
+    u64 value;
+    __builtin_memcpy(&value, byte, sizeof(value));
+    result = _mm_crc32_u64(result, value);
+    byte += 8;
+    size -= 8;
+  }
+
+  u32 result32 = (u32)result;
+  while (size) {
+    result32 = _mm_crc32_u8(result32, *byte);
+    byte++;
+    size--;
+  }
+
+  return ~result32;
+}
+
+internal inline u32
+Crc32c(void *data, u64 size)
+{
+  return Crc32cAccumulate(0, data, size);
+}
+
+#endif /* HANDMADEHERO_CHECKSUM_H */
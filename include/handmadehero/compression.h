@@ -0,0 +1,298 @@
+#ifndef HANDMADEHERO_COMPRESSION_H
+#define HANDMADEHERO_COMPRESSION_H
+
+#include "types.h"
+
+/*
+ * LZ77 compression in LZ4 block format.
+ *
+ * Sequence is:
+ *   u8 token;                 // literal length << 4 | (match length - 4)
+ *   u8 literalLength[];       // when literal length nibble is 15, 255s then rest
+ *   u8 literals[literalLength];
+ *   u16 offset;               // little endian, distance back to match
+ *   u8 matchLength[];         // when match length nibble is 15, 255s then rest
+ *
+ * Last sequence only has literals. Last 5 bytes are always literals and
+ * last match starts at least 12 bytes before end.
+ */
+
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_FIND_LIMIT 12
+#define LZ_OFFSET_MAX 0xffff
+#define LZ_HASH_BITS 12
+
+// maximum size of compressed data for input of size
+internal inline u64
+LzCompressBound(u64 size)
+{
+  return size + size / 255 + 16;
+}
+
+/*
+ * Extra bytes needed after decompressed data, when decompressing in place.
+ * Literals can only make output shorter than input by 1 byte per 255,
+ * matches always make output longer.
+ */
+internal inline u64
+LzInPlaceMargin(u64 size)
+{
+  return size / 255 + 32;
+}
+
+internal inline u32
+LzRead32(u8 *memory)
+{
+  u32 value;
+  __builtin_memcpy(&value, memory, sizeof(value));
+  return value;
+}
+
+internal inline u64
+LzRead64(u8 *memory)
+{
+  u64 value;
+  __builtin_memcpy(&value, memory, sizeof(value));
+  return value;
+}
+
+internal inline u32
+LzHash(u32 sequence)
+{
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+internal inline u8 *
+LzWriteLength(u8 *op, u64 length)
+{
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (u8)length;
+  return op;
+}
+
+internal inline u8 *
+LzWriteSequence(u8 *op, u8 *literals, u64 literalLength, u64 offset, u64 matchLength)
+{
+  u8 *token = op++;
+
+  *token = (u8)((literalLength >= 15 ? 15 : literalLength) << 4);
+  if (literalLength >= 15)
+    op = LzWriteLength(op, literalLength - 15);
+
+  __builtin_memcpy(op, literals, literalLength);
+  op += literalLength;
+
+  // last sequence
+  if (matchLength == 0)
+    return op;
+
+  *op++ = (u8)(offset >> 0);
+  *op++ = (u8)(offset >> 8);
+
+  matchLength -= LZ_MIN_MATCH;
+  *token |= (u8)(matchLength >= 15 ? 15 : matchLength);
+  if (matchLength >= 15)
+    op = LzWriteLength(op, matchLength - 15);
+
+  return op;
+}
+
+/*
+ * Compresses src into dest. dest must be at least LzCompressBound(srcSize)
+ * bytes. Returns size of compressed data.
+ */
+internal inline u64
+LzCompress(void *dest, void *src, u64 srcSize)
+{
+  u8 *input = src;
+  u8 *inputEnd = input + srcSize;
+  u8 *op = dest;
+
+  u8 *anchor = input;
+  if (srcSize > LZ_MATCH_FIND_LIMIT) {
+    // NOTE(e2dk4r): table holds position of last sequence with same hash.
+    // Candidates are always verified, so stale entries are harmless.
+    u32 table[1 << LZ_HASH_BITS];
+    __builtin_memset(table, 0, sizeof(table));
+
+    u8 *ipLimit = inputEnd - LZ_MATCH_FIND_LIMIT;
+    u8 *matchLimit = inputEnd - LZ_LAST_LITERALS;
+
+    u8 *ip = input + 1;
+    u32 searchCount = 0;
+    while (ip <= ipLimit) {
+      u32 sequence = LzRead32(ip);
+      u32 hash = LzHash(sequence);
+      u8 *candidate = input + table[hash];
+      table[hash] = (u32)(ip - input);
+
+      u64 offset = (u64)(ip - candidate);
+      if (offset == 0 || offset > LZ_OFFSET_MAX || LzRead32(candidate) != sequence) {
+        // skip faster on data that does not compress
+        ip += 1 + (searchCount++ >> 6);
+        continue;
+      }
+      searchCount = 0;
+
+      while (ip > anchor && candidate > input && ip[-1] == candidate[-1]) {
+        ip--;
+        candidate--;
+      }
+
+      u8 *matchEnd = ip + LZ_MIN_MATCH;
+      u8 *matchCursor = candidate + LZ_MIN_MATCH;
+      while (matchEnd + 8 <= matchLimit) {
+        u64 difference = LzRead64(matchEnd) ^ LzRead64(matchCursor);
+        if (difference) {
+          matchEnd += (u32)__builtin_ctzll(difference) >> 3;
+          goto matchFound;
+        }
+        matchEnd += 8;
+        matchCursor += 8;
+      }
+      while (matchEnd < matchLimit && *matchEnd == *matchCursor) {
+        matchEnd++;
+        matchCursor++;
+      }
+
+    matchFound:
+      op = LzWriteSequence(op, anchor, (u64)(ip - anchor), offset, (u64)(matchEnd - ip));
+
+      ip = matchEnd;
+      anchor = ip;
+
+      if (ip <= ipLimit)
+        table[LzHash(LzRead32(ip - 2))] = (u32)(ip - 2 - input);
+    }
+  }
+
+  op = LzWriteSequence(op, anchor, (u64)(inputEnd - anchor), 0, 0);
+
+  return (u64)(op - (u8 *)dest);
+}
+
+// returns 0 when length runs past input
+internal inline u8 *
+LzReadLength(u8 *ip, u8 *ipEnd, u64 *length)
+{
+  u8 value;
+  do {
+    if (ip >= ipEnd)
+      return 0;
+    value = *ip++;
+    *length += value;
+  } while (value == 255);
+
+  return ip;
+}
+
+/*
+ * When isInPlace is set, src must be at end of dest buffer. Then every write
+ * is checked to stay behind unread input.
+ */
+internal inline b32
+LzDecompressBlock(u8 *dest, u64 destSize, u8 *src, u64 srcSize, b32 isInPlace)
+{
+  u8 *op = dest;
+  u8 *opEnd = dest + destSize;
+  u8 *ip = src;
+  u8 *ipEnd = src + srcSize;
+
+  while (ip < ipEnd) {
+    u8 token = *ip++;
+
+    u64 literalLength = token >> 4;
+    if (literalLength == 15) {
+      ip = LzReadLength(ip, ipEnd, &literalLength);
+      if (!ip)
+        return 0;
+    }
+
+    if (literalLength > (u64)(ipEnd - ip) || literalLength > (u64)(opEnd - op))
+      return 0;
+    if (isInPlace && op > ip)
+      return 0;
+
+    // short literals are copied with one fixed size copy, bytes after them
+    // are overwritten by next sequence
+    if (literalLength <= 16 && ipEnd - ip >= 16 && opEnd - op >= 16 && (!isInPlace || ip - op >= 16))
+      __builtin_memcpy(op, ip, 16);
+    else
+      __builtin_memmove(op, ip, literalLength);
+    op += literalLength;
+    ip += literalLength;
+
+    // last sequence
+    if (ip == ipEnd)
+      return op == opEnd;
+
+    if (ipEnd - ip < 2)
+      return 0;
+    u64 offset = (u64)ip[0] | (u64)ip[1] << 8;
+    ip += 2;
+    if (offset == 0 || offset > (u64)(op - dest))
+      return 0;
+
+    u64 matchLength = token & 15;
+    if (matchLength == 15) {
+      ip = LzReadLength(ip, ipEnd, &matchLength);
+      if (!ip)
+        return 0;
+    }
+    matchLength += LZ_MIN_MATCH;
+
+    if (matchLength > (u64)(opEnd - op))
+      return 0;
+    if (isInPlace && matchLength > (u64)(ip - op))
+      return 0;
+
+    u8 *match = op - offset;
+    u8 *matchEnd = op + matchLength;
+    if (offset < 8) {
+      // NOTE(e2dk4r): Any multiple of offset is also period of the match.
+      // After first bytes are written, copy from 8 or more bytes back.
+      u64 period = offset * ((8 + offset - 1) / offset);
+      u8 *periodStart = op + period - offset;
+      while (op < matchEnd && op < periodStart)
+        *op++ = *match++;
+      match = op - period;
+    }
+    while (op + 8 <= matchEnd) {
+      __builtin_memcpy(op, match, 8);
+      op += 8;
+      match += 8;
+    }
+    while (op < matchEnd)
+      *op++ = *match++;
+  }
+
+  return 0;
+}
+
+// returns 1 when src decompressed exactly into destSize bytes
+internal inline b32
+LzDecompress(void *dest, u64 destSize, void *src, u64 srcSize)
+{
+  return LzDecompressBlock(dest, destSize, src, srcSize, 0);
+}
+
+/*
+ * Decompresses data that is placed at end of buffer, into start of buffer.
+ * bufferSize is expected to be destSize + LzInPlaceMargin(destSize).
+ * Returns 1 when data decompressed exactly into destSize bytes.
+ */
+internal inline b32
+LzDecompressInPlace(void *buffer, u64 bufferSize, u64 destSize, u64 srcSize)
+{
+  if (destSize > bufferSize || srcSize > bufferSize)
+    return 0;
+
+  u8 *src = (u8 *)buffer + bufferSize - srcSize;
+  return LzDecompressBlock(buffer, destSize, src, srcSize, 1);
+}
+
+#endif /* HANDMADEHERO_COMPRESSION_H */
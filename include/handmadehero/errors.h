@@ -37,6 +37,8 @@ enum handmadehero_error {
 
   HANDMADEHERO_ERROR_FILE_IS_NOT_HHA,
   HANDMADEHERO_ERROR_HHA_VERSION_IS_NOT_SUPPORTED,
+  HANDMADEHERO_ERROR_HHA_MALFORMED,
+  HANDMADEHERO_ERROR_HHA_CHECKSUM_MISMATCH,
 };
 
 #endif /* HANDMADEHERO_ERROR_H */
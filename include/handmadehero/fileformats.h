@@ -36,6 +36,10 @@ enum asset_type_id {
   /* ================ FONT ================ */
   ASSET_TYPE_FONT,
 
+  /* ================ BITMAPS ================ */
+  // bitmaps that have pixels of other bitmaps, see hha_bitmap
+  ASSET_TYPE_ATLAS,
+
   ASSET_TYPE_COUNT
 };
 
@@ -48,26 +52,68 @@ enum asset_tag_id {
   ASSET_TAG_COUNT
 };
 
+/* NOTE(e2dk4r): Layout of version 1
+ *
+ *   hha_header
+ *   hha_section[sectionCount]           at sectionsOffset
+ *   hha_tag[tagCount]                   HHA_SECTION_TYPE_TAGS
+ *   hha_asset_type[assetTypeCount]      HHA_SECTION_TYPE_ASSET_TYPES
+ *   hha_asset[assetCount]               HHA_SECTION_TYPE_ASSETS
+ *   asset data                          HHA_SECTION_TYPE_DATA
+ *   hha_bundle[]                        HHA_SECTION_TYPE_BUNDLES
+ *   u32 assetIndex[]                    HHA_SECTION_TYPE_BUNDLE_ASSETS
+ *   u64 sourceHash[assetCount]          HHA_SECTION_TYPE_SOURCE_HASHES
+ *
+ * Every section and every asset's data starts at HHA_ALIGNMENT boundary,
+ * padding is filled with zeros.
+ */
+
 // Handmadehero Asset Header
 struct hha_header {
 #define HHA_MAGIC HHA_ENCODE('h', 'h', 'a', 'f')
   u32 magic;
 
-#define HHA_VERSION 0
+#define HHA_VERSION 1
   u32 version;
 
   u32 tagCount;
   u32 assetCount;
   u32 assetTypeCount;
 
-  // hha_tag[tagCount]
-  u64 tagsOffset;
+  // hha_section[sectionCount]
+  u32 sectionCount;
+  u64 sectionsOffset;
+};
 
-  // hha_asset_type[assetTypeCount]
-  u64 assetTypesOffset;
+#define HHA_ALIGNMENT 64
 
-  // hha_asset[assetCount]
-  u64 assetsOffset;
+enum hha_section_type {
+  HHA_SECTION_TYPE_TAGS,
+  HHA_SECTION_TYPE_ASSET_TYPES,
+  HHA_SECTION_TYPE_ASSETS,
+  HHA_SECTION_TYPE_DATA,
+  // optional
+  HHA_SECTION_TYPE_BUNDLES,
+  HHA_SECTION_TYPE_BUNDLE_ASSETS,
+  // hash of what asset is built from, only used by builder to reuse data of
+  // unchanged assets, 0 when asset cannot be reused
+  HHA_SECTION_TYPE_SOURCE_HASHES,
+
+  HHA_SECTION_TYPE_COUNT
+};
+
+struct hha_section {
+  u32 type;
+  // crc32c of section, 0 when it is not calculated
+  u32 checksum;
+  u64 offset;
+  u64 size;
+};
+
+enum hha_codec {
+  HHA_CODEC_NONE,
+  // LZ4 block format, see compression.h
+  HHA_CODEC_LZ,
 };
 
 struct bitmap_id {
@@ -82,6 +128,10 @@ struct font_id {
   u32 value;
 };
 
+struct bundle_id {
+  u32 value;
+};
+
 struct hha_tag {
   u32 id;
   f32 value;
@@ -97,12 +147,23 @@ struct hha_bitmap {
   u32 width;
   u32 height;
   f32 alignPercentage[2];
+  // 0 when bitmap has its own pixels
+  struct bitmap_id atlasId;
+  u16 atlasX;
+  u16 atlasY;
   /*
    * NOTE: data is:
-   *   u32 pixels[width * height];
+   *   when atlasId is 0
+   *     u32 pixels[width * height];
    */
 };
 
+/* NOTE(e2dk4r): Bitmap in atlas has no data, its pixels are rectangle at
+ * (atlasX, atlasY) with its width and height in atlas bitmap. Atlas is asset
+ * of ASSET_TYPE_ATLAS in same file, so small bitmaps drawn together are
+ * loaded and sampled from one bitmap.
+ */
+
 enum hha_audio_chain {
   HHA_AUDIO_CHAIN_NONE,
   HHA_AUDIO_CHAIN_LOOP,
@@ -124,15 +185,74 @@ struct hha_font {
   f32 ascent;
   f32 descent;
   f32 lineGap;
+  // 0 or power of 2
+  u32 kerningCount;
+  // 0 when font has no glyph atlas
+  u16 atlasWidth;
+  u16 atlasHeight;
+  // 0 when atlas has coverage of glyphs, otherwise it has signed distances
+  u16 sdfSpread;
+  // font pixels per atlas texel
+  u16 atlasDownscale;
   /*
    * NOTE: data is:
-   *   struct bitmap_id codepoints[codepointCount];
-   *   f32 horizontalAdvanceTable[codepointCount * codepointCount];
+   *   f32 horizontalAdvances[codepointCount];
+   *   struct hha_font_kerning kernings[kerningCount];
+   *   when atlasWidth is not 0
+   *     struct hha_font_glyph glyphs[codepointCount];
+   *     u32 atlasPixels[atlasWidth * atlasHeight];
    */
 };
 
+/* NOTE(e2dk4r): Kernings are open addressing hash table. Pair is stored at
+ * HHAFontKerningSlot() or at first empty slot after it, wrapping around.
+ * At most half of slots are used. Empty slots have codepoint 0.
+ * Advance of pair is horizontalAdvances[prevCodepoint] + kerning advance.
+ */
+struct hha_font_kerning {
+  u32 prevCodepoint;
+  u32 codepoint;
+  f32 advance;
+};
+
+/* NOTE(e2dk4r): Glyphs of font are packed in one atlas bitmap, so text can
+ * be drawn with one font load. Glyph is rectangle in atlas, rows are bottom
+ * up like bitmaps. Codepoints without glyph have zero width and height.
+ */
+struct hha_font_glyph {
+  u16 x;
+  u16 y;
+  u16 width;
+  u16 height;
+  f32 alignPercentage[2];
+};
+
+/* NOTE(e2dk4r): Atlas of font with sdfSpread has signed distance to glyph
+ * edge in alpha of texels instead of coverage. Distance is in atlas texels,
+ * -sdfSpread to sdfSpread is mapped to 0 to 255, so edge is at 127.5 and
+ * inside of glyph is above it. Glyphs are padded by sdfSpread texels.
+ * Distances are filtered well when scaled, so atlas is rasterized smaller
+ * than font by atlasDownscale and glyph is drawn atlasDownscale times its
+ * texel size.
+ */
+
+internal inline u32
+HHAFontKerningSlot(u32 prevCodepoint, u32 codepoint, u32 kerningCount)
+{
+  u32 hash = (prevCodepoint * 0x9e3779b1) ^ (codepoint * 0x85ebca77);
+  hash ^= hash >> 15;
+  return hash & (kerningCount - 1);
+}
+
 struct hha_asset {
   u64 dataOffset;
+  // size of data in file, compressed size when codec is not none
+  u32 dataSize;
+  // crc32c of data in file
+  u32 dataChecksum;
+  // enum hha_codec
+  u32 codec;
+
   u32 tagIndexFirst;
   u32 tagIndexOnePastLast;
   union {
@@ -142,6 +262,98 @@ struct hha_asset {
   };
 };
 
+/* NOTE(e2dk4r): Bitmaps that are drawn together, like parts of hero facing
+ * one direction. Data of bundle's assets is contiguous in file, so the
+ * bundle can be loaded with one read.
+ */
+struct hha_bundle {
+  // range in HHA_SECTION_TYPE_BUNDLE_ASSETS
+  u32 assetIndexFirst;
+  u32 assetIndexOnePastLast;
+};
+#define HHA_BUNDLE_ASSET_COUNT_MAX 16
+
+/* NOTE(e2dk4r): Asset trace is written by debug builds of game, it has
+ * loads of assets in order they finish. Builder reads it to lay out data of
+ * packs in order game uses it, so assets used together are adjacent.
+ *
+ *   hha_trace_header
+ *   hha_trace_event[eventCount]
+ */
+struct hha_trace_header {
+#define HHA_TRACE_MAGIC HHA_ENCODE('h', 'h', 'a', 't')
+  u32 magic;
+
+#define HHA_TRACE_VERSION 0
+  u32 version;
+
+  u32 eventCount;
+};
+
+struct hha_trace_event {
+  // asset is matched with its source hash, so trace is used as long as
+  // asset is built from same sources, see HHA_SECTION_TYPE_SOURCE_HASHES
+  u64 sourceHash;
+  // frame asset is requested in
+  u32 frameIndex;
+};
+
+/*****************************************************************
+ * VERSION 0
+ *   Only kept for reading old asset pack files.
+ *****************************************************************/
+
+struct hha_header_v0 {
+  u32 magic;
+  u32 version;
+
+  u32 tagCount;
+  u32 assetCount;
+  u32 assetTypeCount;
+
+  // hha_tag[tagCount]
+  u64 tagsOffset;
+
+  // hha_asset_type[assetTypeCount]
+  u64 assetTypesOffset;
+
+  // hha_asset_v0[assetCount]
+  u64 assetsOffset;
+};
+
+struct hha_bitmap_v0 {
+  u32 width;
+  u32 height;
+  f32 alignPercentage[2];
+  /*
+   * NOTE: data is:
+   *   u32 pixels[width * height];
+   */
+};
+
+struct hha_font_v0 {
+  u32 codepointCount;
+  f32 ascent;
+  f32 descent;
+  f32 lineGap;
+  /*
+   * NOTE: data is:
+   *   struct bitmap_id codepoints[codepointCount];
+   *   f32 horizontalAdvanceTable[codepointCount * codepointCount];
+   */
+};
+
+struct hha_asset_v0 {
+  u64 dataOffset;
+  u32 tagIndexFirst;
+  u32 tagIndexOnePastLast;
+  union {
+    struct hha_bitmap_v0 bitmap;
+    struct hha_audio audio;
+    struct hha_font_v0 font;
+  };
+};
+
 #pragma pack(pop)
 
 #endif /* HANDMADEHERO_FILEFORMATS_H */
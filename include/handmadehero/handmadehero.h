@@ -93,7 +93,7 @@ struct game_state {
   // entropy that doesn't affect gameplay
   struct random_series effectsEntropy;
   struct audio_state audioState;
-  struct playing_audio *music;
+  struct playing_audio_id music;
 
   u32 nextParticle;
   struct particle particles[256];
@@ -102,16 +102,44 @@ struct game_state {
 };
 
 struct task_with_memory {
-  b32 isUsed : 1;
+  struct task_pool *pool;
+  // index + 1 of next free task, 0 when last
+  u32 nextFree;
   struct memory_arena arena;
   struct memory_temp memoryFlush;
 };
 
+#define TASK_ARENA_SIZE (1 * MEGABYTES)
+#define TASK_COUNT_MIN 4
+#define TASK_COUNT_MAX 64
+
+/*
+ * Lock-free pool of task arenas. Tasks are begun on game thread and ended on
+ * any worker thread.
+ *
+ * Free list head packs index + 1 of first free task into low 32 bits and a
+ * generation into high 32 bits, so compare exchange fails when head was popped
+ * and pushed back in between (ABA).
+ */
+struct task_pool {
+  u64 freeHead;
+  u32 count;
+  u32 usedCount;
+  // highest usedCount since last frame
+  u32 usedCountMax;
+
+  // requests refused since last frame, and in total
+  u32 refusedCount;
+  u64 refusedCountTotal;
+
+  struct task_with_memory tasks[TASK_COUNT_MAX];
+};
+
 struct transient_state {
   b32 isInitialized : 1;
 
   struct memory_arena transientArena;
-  struct task_with_memory tasks[4];
+  struct task_pool taskPool;
 
   u32 groundBufferCount;
   struct ground_buffer *groundBuffers;
@@ -139,6 +167,9 @@ CollisionRuleGet(struct game_state *state, u32 storageIndexA);
 void
 CollisionRuleAdd(struct game_state *state, u32 storageIndexA, u32 storageIndexB, u8 shouldCollide);
 
+void
+TaskPoolInit(struct task_pool *pool, struct memory_arena *arena, u32 workerCount);
+
 struct task_with_memory *
 BeginTaskWithMemory(struct transient_state *transientState);
 
@@ -23,6 +23,11 @@ enum platform_file_type {
 };
 
 typedef struct platform_file_handle (*pfnPlatformOpenNextFile)(struct platform_file_group *fileGroup);
+// opens same path as handle again, as file can be replaced on disk
+typedef struct platform_file_handle (*pfnPlatformReopenFile)(struct platform_file_handle *handle);
+typedef void (*pfnPlatformCloseFile)(struct platform_file_handle *handle);
+// whether handles are opened from same path
+typedef b32 (*pfnPlatformIsSameFile)(struct platform_file_handle *handle, struct platform_file_handle *other);
 typedef void (*pfnPlatformReadFromFile)(void *dest, struct platform_file_handle *handle, u64 offset, u64 size);
 typedef struct platform_file_group (*pfnPlatformGetAllFilesOfTypeBegin)(enum platform_file_type type);
 typedef void (*pfnPlatformGetAllFilesOfTypeEnd)(struct platform_file_group *fileGroup);
@@ -57,6 +62,7 @@ enum {
   CYCLE_COUNTER_ProcessPixel,
   CYCLE_COUNTER_DrawRectangleQuickly,
   CYCLE_COUNTER_AudioMixer,
+  CYCLE_COUNTER_AudioCallback,
   CYCLE_COUNTER_COUNT
 };
 
@@ -65,6 +71,26 @@ struct cycle_counter {
   u64 hitCount;
 };
 
+/*
+ * Audio output of platform layer. Written by audio thread on every
+ * callback, read by debug overlay.
+ */
+struct platform_audio_telemetry {
+  // samples audio server processes every cycle
+  u32 quantum;
+  // samples asked for at last callback, and most ever asked for
+  u32 requestedSampleCount;
+  u32 requestedSampleCountMax;
+  // callbacks that gave silence, had no buffer or missed a cycle
+  u32 underrunCount;
+  // time from writing a sample until it is heard
+  u64 latencyNanoseconds;
+  u64 latencyNanosecondsMax;
+  // time between audio server cycles, and most ever
+  u64 cycleIntervalNanoseconds;
+  u64 cycleIntervalNanosecondsMax;
+};
+
 u64
 rdtsc(void);
 extern struct game_memory *DEBUG_GLOBAL_MEMORY;
@@ -143,6 +169,9 @@ struct game_input {
   f32 dtPerFrame;
   struct game_controller_input controllers[5];
 
+  // asset pack files are written or replaced since last frame
+  u8 assetFilesChanged : 1;
+
 #if HANDMADEHERO_DEBUG
   u8 gameCodeReloaded : 1;
 #endif
@@ -171,6 +200,9 @@ struct platform_api {
   pfnPlatformWorkQueueCompleteAllWork WorkQueueCompleteAllWork;
 
   pfnPlatformOpenNextFile OpenNextFile;
+  pfnPlatformReopenFile ReopenFile;
+  pfnPlatformCloseFile CloseFile;
+  pfnPlatformIsSameFile IsSameFile;
   pfnPlatformReadFromFile ReadFromFile;
   pfnPlatformHasFileError HasFileError;
   pfnPlatformFileError FileError;
@@ -196,11 +228,15 @@ struct game_memory {
 
   struct platform_work_queue *highPriorityQueue;
   struct platform_work_queue *lowPriorityQueue;
+  // number of threads working on each queue
+  u32 highPriorityWorkerCount;
+  u32 lowPriorityWorkerCount;
 
   struct platform_api platform;
 
 #if HANDMADEHERO_INTERNAL
   struct cycle_counter counters[CYCLE_COUNTER_COUNT];
+  struct platform_audio_telemetry audioTelemetry;
   struct render_group *DEBUGtextRenderGroup;
 #endif
 };
@@ -222,4 +258,9 @@ b32
 GameOutputAudio(struct game_memory *memory, struct game_audio_buffer *buffer);
 typedef b32 (*pfnGameOutputAudio)(struct game_memory *memory, struct game_audio_buffer *buffer);
 
+// called once before platform exits
+void
+GameShutdown(struct game_memory *memory);
+typedef void (*pfnGameShutdown)(struct game_memory *memory);
+
 #endif /* HANDMADEHERO_PLATFORM_H */
@@ -62,11 +62,13 @@ enum render_group_entry_type {
   RENDER_GROUP_ENTRY_TYPE_RECTANGLE = (1 << 0),
   RENDER_GROUP_ENTRY_TYPE_BITMAP = (1 << 1),
   RENDER_GROUP_ENTRY_TYPE_COORDINATE_SYSTEM = (1 << 2),
+  RENDER_GROUP_ENTRY_TYPE_BITMAP_REGION = (1 << 3),
+  RENDER_GROUP_ENTRY_TYPE_BITMAP_SDF = (1 << 4),
 };
 
 // render_group_entry is tagged union
 struct render_group_entry {
-  enum render_group_entry_type type : 4;
+  enum render_group_entry_type type : 5;
 };
 
 struct render_group_entry_clear {
@@ -80,6 +82,25 @@ struct render_group_entry_bitmap {
   struct v4 color;
 };
 
+// NOTE(e2dk4r): only sourceRect of bitmap is drawn, like bitmap in atlas
+struct render_group_entry_bitmap_region {
+  struct bitmap *bitmap;
+  struct rect2s sourceRect;
+  struct v2 position;
+  struct v2 size;
+  struct v4 color;
+};
+
+// NOTE(e2dk4r): bitmap has signed distances in alpha, see hha_font_glyph
+struct render_group_entry_bitmap_sdf {
+  struct bitmap *bitmap;
+  struct v2 position;
+  struct v2 size;
+  struct v4 color;
+  // distance in texels that alpha of 0 and 255 are away from edge
+  f32 sdfSpread;
+};
+
 struct render_group_entry_rectangle {
   struct v2 position;
   struct v4 color;
@@ -170,6 +191,11 @@ Bitmap(struct render_group *renderGroup, struct bitmap *bitmap, struct v3 offset
 void
 BitmapWithColor(struct render_group *renderGroup, struct bitmap *bitmap, struct v3 offset, f32 height, struct v4 color);
 
+// bitmap has signed distances to edge of shape instead of colors, shape is filled with color
+void
+BitmapSDF(struct render_group *renderGroup, struct bitmap *bitmap, struct v3 offset, f32 height, struct v4 color,
+          f32 sdfSpread);
+
 void
 BitmapAsset(struct render_group *renderGroup, struct bitmap_id id, struct v3 offset, f32 height, struct v4 color);
 
@@ -0,0 +1,249 @@
+#ifndef HANDMADEHERO_RESAMPLER_H
+#define HANDMADEHERO_RESAMPLER_H
+
+#include "math.h"
+#include "types.h"
+#include <x86intrin.h>
+
+/*
+ * Resamplers read 8 output samples at once, one per lane, from 16-bit
+ * source samples at fractional sample positions.
+ *
+ * Windowed sinc resampler is a polyphase FIR filter. Each output sample is
+ * dot product of SINC_TAP_COUNT source samples around its position with
+ * filter coefficients for its fractional position. Coefficients are
+ * precomputed for SINC_PHASE_COUNT + 1 fractional positions, and
+ * interpolated between two nearest ones.
+ *
+ * Reading faster than source rate, pitching up, folds frequencies above
+ * new Nyquist back into audible range. So there is a table for every
+ * SINC_RATIO_STEP of pitch, each with cutoff lowered by pitch.
+ */
+
+#define SINC_TAP_COUNT 16
+#define SINC_PHASE_COUNT 32
+#define SINC_TABLE_COUNT 4
+#define SINC_RATIO_STEP 0.5f
+// cutoff at unity pitch, in cycles per source sample
+#define SINC_CUTOFF 0.45f
+#define SINC_KAISER_BETA 6.0f
+
+struct sinc_table {
+  f32 coefficients[SINC_TABLE_COUNT][SINC_PHASE_COUNT + 1][SINC_TAP_COUNT];
+};
+
+// modified Bessel function of first kind, order 0
+internal inline f32
+BesselI0(f32 value)
+{
+  f32 sum = 1.0f;
+  f32 term = 1.0f;
+  f32 halfValue = value * 0.5f;
+  for (u32 k = 1; k < 24; k++) {
+    f32 factor = halfValue / (f32)k;
+    term *= factor * factor;
+    sum += term;
+  }
+  return sum;
+}
+
+internal inline void
+SincTableInit(struct sinc_table *table)
+{
+  f32 windowScale = 1.0f / BesselI0(SINC_KAISER_BETA);
+  f32 halfWidth = (f32)(SINC_TAP_COUNT / 2);
+  for (u32 tableIndex = 0; tableIndex < SINC_TABLE_COUNT; tableIndex++) {
+    f32 ratio = 1.0f + SINC_RATIO_STEP * (f32)tableIndex;
+    f32 cutoff = SINC_CUTOFF / ratio;
+
+    for (u32 phase = 0; phase <= SINC_PHASE_COUNT; phase++) {
+      f32 *coefficients = table->coefficients[tableIndex][phase];
+      f32 sum = 0.0f;
+      for (u32 tap = 0; tap < SINC_TAP_COUNT; tap++) {
+        // distance of tap from sample position
+        f32 x = (f32)tap - (halfWidth - 1.0f) - (f32)phase / (f32)SINC_PHASE_COUNT;
+
+        f32 y = 2.0f * cutoff * x;
+        f32 sinc = y == 0.0f ? 1.0f : Sin(PI32 * y) / (PI32 * y);
+
+        f32 r = x / halfWidth;
+        f32 window = r * r < 1.0f ? BesselI0(SINC_KAISER_BETA * SquareRoot(1.0f - r * r)) * windowScale : 0.0f;
+
+        coefficients[tap] = sinc * window;
+        sum += coefficients[tap];
+      }
+
+      // unity gain at DC
+      for (u32 tap = 0; tap < SINC_TAP_COUNT; tap++)
+        coefficients[tap] /= sum;
+    }
+  }
+}
+
+// coefficients for reading dSample source samples per output sample
+internal inline f32 *
+SincTableCoefficients(struct sinc_table *table, f32 dSample)
+{
+  u32 tableIndex = 0;
+  if (dSample > 1.0f)
+    tableIndex = (u32)Ceil((dSample - 1.0f) / SINC_RATIO_STEP);
+  if (tableIndex > SINC_TABLE_COUNT - 1)
+    tableIndex = SINC_TABLE_COUNT - 1;
+  return (f32 *)table->coefficients[tableIndex];
+}
+
+internal inline __m256
+SampleContiguous(s16 *samples)
+{
+  return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i *)samples)));
+}
+
+internal inline __m256
+SampleLinear(s16 *samples, __m256i sampleIndex, __m256i sampleMask, __m256 frac)
+{
+  /* NOTE(e2dk4r): One 32-bit gather fetches both taps, sample at index in
+   * low 16 bits and next sample in high 16 bits. Lanes whose next sample
+   * is past the end are not read and stay zero.
+   */
+  __m256i samplePair = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (int const *)samples, sampleIndex,
+                                                   sampleMask, sizeof(*samples));
+  __m256 sampleValue0 = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(samplePair, 16), 16));
+  __m256 sampleValue1 = _mm256_cvtepi32_ps(_mm256_srai_epi32(samplePair, 16));
+
+#define _mm256_lerp(a, b, t)                                                                                           \
+  _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), t), a), _mm256_mul_ps(t, b))
+  return _mm256_lerp(sampleValue0, sampleValue1, frac);
+}
+
+internal inline __m256
+SampleNearest(s16 *samples, __m256i sampleIndex, __m256i sampleMask)
+{
+  __m256i sampleWord = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (int const *)samples, sampleIndex,
+                                                   sampleMask, sizeof(*samples));
+  return _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(sampleWord, 16), 16));
+}
+
+// sum of each of 8 vectors, in lane order
+internal inline __m256
+HorizontalSum8(__m256 *values)
+{
+  __m256 sum01 = _mm256_hadd_ps(values[0], values[1]);
+  __m256 sum23 = _mm256_hadd_ps(values[2], values[3]);
+  __m256 sum45 = _mm256_hadd_ps(values[4], values[5]);
+  __m256 sum67 = _mm256_hadd_ps(values[6], values[7]);
+  __m256 sum0123 = _mm256_hadd_ps(sum01, sum23);
+  __m256 sum4567 = _mm256_hadd_ps(sum45, sum67);
+  return _mm256_add_ps(_mm256_permute2f128_ps(sum0123, sum4567, 0x20),
+                       _mm256_permute2f128_ps(sum0123, sum4567, 0x31));
+}
+
+// coefficients for fractional position between phase and next phase
+internal inline void
+SincPhaseCoefficients(f32 *coefficients, s32 phase, f32 phaseFrac, __m256 *coefficients0, __m256 *coefficients1)
+{
+  f32 *phaseCoefficients = coefficients + phase * SINC_TAP_COUNT;
+  __m256 t = _mm256_set1_ps(phaseFrac);
+  __m256 a0 = _mm256_loadu_ps(phaseCoefficients);
+  __m256 a1 = _mm256_loadu_ps(phaseCoefficients + 8);
+  __m256 b0 = _mm256_loadu_ps(phaseCoefficients + SINC_TAP_COUNT);
+  __m256 b1 = _mm256_loadu_ps(phaseCoefficients + SINC_TAP_COUNT + 8);
+  *coefficients0 = _mm256_fmadd_ps(t, _mm256_sub_ps(b0, a0), a0);
+  *coefficients1 = _mm256_fmadd_ps(t, _mm256_sub_ps(b1, a1), a1);
+}
+
+internal inline __m256
+SincDot(s16 *taps, __m256 coefficients0, __m256 coefficients1)
+{
+  __m256 dot = _mm256_mul_ps(coefficients0, SampleContiguous(taps));
+  return _mm256_fmadd_ps(coefficients1, SampleContiguous(taps + 8), dot);
+}
+
+/* NOTE(e2dk4r): Samples of audio chained before or after the one that is
+ * read. Taps past edges of audio are read from them, so filter does not
+ * change at boundaries of streamed audios. Sample count is 0 when there is
+ * no such audio or it is not loaded, then taps past edge are zero.
+ */
+struct sinc_neighbor {
+  s16 *samples[2];
+  u32 sampleCount;
+};
+
+// same as SincDot(), samples out of range are read from neighbors
+internal inline __m256
+SincDotEdge(s16 *samples, u32 sampleCount, struct sinc_neighbor *before, struct sinc_neighbor *after,
+            u32 channelIndex, s32 firstSampleIndex, __m256 coefficients0, __m256 coefficients1)
+{
+  s16 taps[SINC_TAP_COUNT];
+  for (s32 tap = 0; tap < SINC_TAP_COUNT; tap++) {
+    s32 sampleIndex = firstSampleIndex + tap;
+    if (sampleIndex < 0) {
+      s32 beforeIndex = (s32)before->sampleCount + sampleIndex;
+      taps[tap] = beforeIndex >= 0 ? before->samples[channelIndex][beforeIndex] : 0;
+    } else if (sampleIndex < (s32)sampleCount) {
+      taps[tap] = samples[sampleIndex];
+    } else {
+      s32 afterIndex = sampleIndex - (s32)sampleCount;
+      taps[tap] = afterIndex < (s32)after->sampleCount ? after->samples[channelIndex][afterIndex] : 0;
+    }
+  }
+  return SincDot(taps, coefficients0, coefficients1);
+}
+
+/*
+ * Reads one or two channels with windowed sinc resampler. Coefficients are
+ * from SincTableCoefficients(), and interpolated once for both channels.
+ */
+internal inline void
+SampleSinc(f32 *coefficients, s16 *samples0, s16 *samples1, b32 isStereo, u32 sampleCount,
+           struct sinc_neighbor *before, struct sinc_neighbor *after, __m256 samplePosition, __m256 *sampleValue0,
+           __m256 *sampleValue1)
+{
+  // taps are read as two 8 wide halves
+  static_assert(SINC_TAP_COUNT == 16);
+
+  __m256i sampleIndex = _mm256_cvttps_epi32(samplePosition);
+  __m256 frac = _mm256_sub_ps(samplePosition, _mm256_cvtepi32_ps(sampleIndex));
+  __m256 phasePosition = _mm256_mul_ps(frac, _mm256_set1_ps((f32)SINC_PHASE_COUNT));
+  __m256i phase = _mm256_cvttps_epi32(phasePosition);
+  __m256 phaseFrac = _mm256_sub_ps(phasePosition, _mm256_cvtepi32_ps(phase));
+
+  s32 firstSampleIndices[8];
+  s32 phases[8];
+  f32 phaseFracs[8];
+  _mm256_storeu_si256((__m256i *)firstSampleIndices,
+                      _mm256_sub_epi32(sampleIndex, _mm256_set1_epi32(SINC_TAP_COUNT / 2 - 1)));
+  _mm256_storeu_si256((__m256i *)phases, phase);
+  _mm256_storeu_ps(phaseFracs, phaseFrac);
+
+  __m256 dot0[8];
+  __m256 dot1[8];
+  __m256 coefficients0;
+  __m256 coefficients1;
+
+  /* NOTE(e2dk4r): Sample positions increase by lane, so when taps of first
+   * and last lanes are inside audio, all are. Only chunks at the edges of
+   * audio check every tap.
+   */
+  if (firstSampleIndices[0] >= 0 && firstSampleIndices[7] + SINC_TAP_COUNT <= (s32)sampleCount) {
+    for (u32 lane = 0; lane < 8; lane++) {
+      SincPhaseCoefficients(coefficients, phases[lane], phaseFracs[lane], &coefficients0, &coefficients1);
+      dot0[lane] = SincDot(samples0 + firstSampleIndices[lane], coefficients0, coefficients1);
+      if (isStereo)
+        dot1[lane] = SincDot(samples1 + firstSampleIndices[lane], coefficients0, coefficients1);
+    }
+  } else {
+    for (u32 lane = 0; lane < 8; lane++) {
+      SincPhaseCoefficients(coefficients, phases[lane], phaseFracs[lane], &coefficients0, &coefficients1);
+      dot0[lane] = SincDotEdge(samples0, sampleCount, before, after, 0, firstSampleIndices[lane], coefficients0,
+                               coefficients1);
+      if (isStereo)
+        dot1[lane] = SincDotEdge(samples1, sampleCount, before, after, 1, firstSampleIndices[lane], coefficients0,
+                                 coefficients1);
+    }
+  }
+
+  *sampleValue0 = HorizontalSum8(dot0);
+  *sampleValue1 = isStereo ? HorizontalSum8(dot1) : *sampleValue0;
+}
+
+#endif /* HANDMADEHERO_RESAMPLER_H */
@@ -107,4 +107,63 @@ HexStringToU8(struct string hexString)
   return value;
 }
 
+/*
+ * Builds zero terminated text into fixed size memory. Text that does not fit
+ * is truncated.
+ */
+struct string_builder {
+  u8 *memory;
+  u64 length;
+  u64 size;
+};
+
+internal inline struct string_builder
+StringBuilder(u8 *memory, u64 size)
+{
+  struct string_builder builder = {};
+
+  assert(size > 0 && "no space for zero terminator");
+  builder.memory = memory;
+  builder.size = size;
+
+  return builder;
+}
+
+internal inline void
+StringBuilderAppend(struct string_builder *builder, struct string string)
+{
+  for (u64 index = 0; index < string.length && builder->length + 1 < builder->size; index++) {
+    builder->memory[builder->length] = string.value[index];
+    builder->length++;
+  }
+}
+
+internal inline void
+StringBuilderAppendZeroTerminated(struct string_builder *builder, char *string)
+{
+  StringBuilderAppend(builder, StringFromZeroTerminated((u8 *)string, builder->size));
+}
+
+internal inline void
+StringBuilderAppendU64(struct string_builder *builder, u64 value)
+{
+  // 18446744073709551615
+  u8 digits[20];
+  u64 digitCount = 0;
+  do {
+    digits[sizeof(digits) - 1 - digitCount] = (u8)('0' + value % 10);
+    digitCount++;
+    value /= 10;
+  } while (value);
+
+  StringBuilderAppend(builder, StringFrom(digits + sizeof(digits) - digitCount, digitCount));
+}
+
+internal inline char *
+StringBuilderTerminate(struct string_builder *builder)
+{
+  builder->memory[builder->length] = 0;
+  return (char *)builder->memory;
+}
+
 #endif /* HANDMADEHERO_TEXT_H */
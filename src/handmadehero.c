@@ -6,6 +6,7 @@
 #include <handmadehero/math.h>
 #include <handmadehero/random.h>
 #include <handmadehero/render_group.h>
+#include <handmadehero/text.h>
 #include <handmadehero/world.h>
 
 comptime u32 TILES_PER_WIDTH = 17;
@@ -500,29 +501,127 @@ IsGroundBufferEmpty(struct ground_buffer *groundBuffer)
   return !WorldPositionIsValid(&groundBuffer->position);
 }
 
+internal void
+TaskPoolPush(struct task_pool *pool, struct task_with_memory *task)
+{
+  u32 taskNumber = (u32)(task - pool->tasks) + 1;
+  u64 head = AtomicLoad(&pool->freeHead);
+  u64 newHead;
+  do {
+    AtomicStore(&task->nextFree, (u32)head);
+    // NOTE(e2dk4r): only push changes generation, task can only become head
+    // again after being pushed
+    u64 generation = (head >> 32) + 1;
+    newHead = generation << 32 | taskNumber;
+  } while (!AtomicCompareExchangeExplicit(&pool->freeHead, &head, newHead, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+internal struct task_with_memory *
+TaskPoolPop(struct task_pool *pool)
+{
+  u64 head = AtomicLoad(&pool->freeHead);
+  struct task_with_memory *task;
+  u64 newHead;
+  do {
+    u32 taskNumber = (u32)head;
+    if (taskNumber == 0)
+      return 0;
+
+    task = pool->tasks + taskNumber - 1;
+    u32 nextFree = AtomicLoad(&task->nextFree);
+    newHead = (head & 0xffffffff00000000) | nextFree;
+    // NOTE(e2dk4r): failed exchange must also acquire, nextFree of new head is read next
+  } while (!AtomicCompareExchangeExplicit(&pool->freeHead, &head, newHead, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+  return task;
+}
+
+/*
+ * Adds up to count tasks to pool. Must not be called while temporary memory
+ * of arena is in use.
+ */
+internal void
+TaskPoolAdd(struct task_pool *pool, struct memory_arena *arena, u32 count)
+{
+  // NOTE(e2dk4r): leave space for per frame memory, like render and sim region
+  comptime memory_arena_size_t reserveSize = 64 * MEGABYTES;
+
+  for (u32 index = 0; index < count; index++) {
+    if (pool->count == TASK_COUNT_MAX)
+      break;
+    if (MemoryArenaGetRemainingSize(arena) < TASK_ARENA_SIZE + reserveSize)
+      break;
+
+    struct task_with_memory *task = pool->tasks + pool->count;
+    task->pool = pool;
+    MemorySubArenaInit(&task->arena, arena, TASK_ARENA_SIZE);
+    pool->count++;
+
+    TaskPoolPush(pool, task);
+  }
+}
+
+/*
+ * Sizes pool so that every worker can run one task while another one waits in
+ * queue.
+ */
+void
+TaskPoolInit(struct task_pool *pool, struct memory_arena *arena, u32 workerCount)
+{
+  pool->freeHead = 0;
+  pool->count = 0;
+  pool->usedCount = 0;
+  pool->usedCountMax = 0;
+  pool->refusedCount = 0;
+  pool->refusedCountTotal = 0;
+
+  u32 count = Minimum(Maximum(2 * workerCount, TASK_COUNT_MIN), TASK_COUNT_MAX);
+  TaskPoolAdd(pool, arena, count);
+}
+
+/*
+ * Called once at start of frame. Grows pool by number of requests refused in
+ * last frame, so bursts of loads are not throttled twice.
+ */
+internal void
+TaskPoolBeginFrame(struct task_pool *pool, struct memory_arena *arena)
+{
+  u32 refusedCount = AtomicExchange(&pool->refusedCount, 0);
+  if (refusedCount > 0)
+    TaskPoolAdd(pool, arena, refusedCount);
+
+  AtomicStore(&pool->usedCountMax, AtomicLoad(&pool->usedCount));
+}
+
 struct task_with_memory *
 BeginTaskWithMemory(struct transient_state *transientState)
 {
-  struct task_with_memory *foundTask = 0;
-  for (u32 taskIndex = 0; taskIndex < ARRAY_COUNT(transientState->tasks); taskIndex++) {
-    struct task_with_memory *task = transientState->tasks + taskIndex;
-
-    if (!task->isUsed) {
-      foundTask = task;
-      foundTask->memoryFlush = BeginTemporaryMemory(&foundTask->arena);
-      foundTask->isUsed = 1;
-      break;
-    }
+  struct task_pool *pool = &transientState->taskPool;
+
+  struct task_with_memory *task = TaskPoolPop(pool);
+  if (!task) {
+    AtomicFetchAdd(&pool->refusedCount, 1);
+    AtomicFetchAdd(&pool->refusedCountTotal, 1);
+    return 0;
   }
 
-  return foundTask;
+  u32 usedCount = AtomicFetchAdd(&pool->usedCount, 1) + 1;
+  u32 usedCountMax = AtomicLoad(&pool->usedCountMax);
+  while (usedCount > usedCountMax && !AtomicCompareExchange(&pool->usedCountMax, &usedCountMax, usedCount))
+    ;
+
+  task->memoryFlush = BeginTemporaryMemory(&task->arena);
+  return task;
 }
 
 void
 EndTaskWithMemory(struct task_with_memory *task)
 {
+  struct task_pool *pool = task->pool;
+
   EndTemporaryMemory(&task->memoryFlush);
-  task->isUsed = 0;
+  AtomicFetchSub(&pool->usedCount, 1);
+  TaskPoolPush(pool, task);
 }
 
 struct fill_ground_chunk_work {
@@ -637,8 +736,8 @@ OverlayCycleCounters(struct game_memory *memory)
 #if HANDMADEHERO_INTERNAL
   DEBUGTextLine("#7f1d1d#CYCLE #10b981#COUNTS:");
 
-  char *counterNameTable[] = {"GameUpdateAndRender", "DrawRenderGroup",      "DrawRectangleSlowly",
-                              "ProcessPixel",        "DrawRectangleQuickly", "AudioMixer"};
+  char *counterNameTable[] = {"GameUpdateAndRender",  "DrawRenderGroup", "DrawRectangleSlowly", "ProcessPixel",
+                              "DrawRectangleQuickly", "AudioMixer",      "AudioCallback"};
   static_assert(ARRAY_COUNT(counterNameTable) == CYCLE_COUNTER_COUNT);
   for (u32 counterIndex = 0; counterIndex < ARRAY_COUNT(memory->counters); counterIndex++) {
     struct cycle_counter *counter = memory->counters + counterIndex;
@@ -656,6 +755,216 @@ OverlayCycleCounters(struct game_memory *memory)
 #endif
 }
 
+internal struct hero_bitmap_ids
+HeroBitmapIdsGet(struct game_assets *assets, f32 facingDirection)
+{
+  struct hero_bitmap_ids result = {};
+
+  struct asset_vector matchVector = {};
+  matchVector.e[ASSET_TAG_FACING_DIRECTION] = facingDirection;
+  struct asset_vector weightVector = {};
+  weightVector.e[ASSET_TAG_FACING_DIRECTION] = 1.0f;
+  result.head = BestMatchBitmap(assets, ASSET_TYPE_HEAD, &matchVector, &weightVector);
+  result.torso = BestMatchBitmap(assets, ASSET_TYPE_TORSO, &matchVector, &weightVector);
+  result.cape = BestMatchBitmap(assets, ASSET_TYPE_CAPE, &matchVector, &weightVector);
+
+  return result;
+}
+
+/*
+ * Requests bitmaps of entity that is not on screen yet. Sooner it can reach
+ * screen, sooner bitmaps are loaded.
+ */
+internal void
+EntityPrefetch(struct game_assets *assets, struct entity *entity, struct v3 positionRelativeToCamera,
+               struct v3 cameraVelocity, struct rect2 screenBounds)
+{
+  struct v2 position = positionRelativeToCamera.xy;
+  struct v2 closestOnScreen = v2(Clamp(screenBounds.min.x, screenBounds.max.x, position.x),
+                                 Clamp(screenBounds.min.y, screenBounds.max.y, position.y));
+  struct v2 fromScreen = v2_sub(position, closestOnScreen);
+  f32 distance = v2_length(fromScreen);
+
+  // NOTE(e2dk4r): camera can turn towards entity any time, so assume it is
+  // approaching at least with walking speed
+  f32 approachSpeed = 2.0f;
+  if (distance > 0.0f) {
+    struct v2 relativeVelocity = v2_sub(entity->dPosition.xy, cameraVelocity.xy);
+    f32 speed = -v2_dot(relativeVelocity, fromScreen) / distance;
+    approachSpeed = Maximum(approachSpeed, speed);
+  }
+  f32 secondsUntilVisible = distance / approachSpeed;
+
+  struct bitmap_id shadow = BitmapGetFirstId(assets, ASSET_TYPE_SHADOW);
+  if (entity->type & ENTITY_TYPE_HERO) {
+    struct hero_bitmap_ids heroBitmapIds = HeroBitmapIdsGet(assets, entity->facingDirection);
+    BitmapPrefetch(assets, shadow, secondsUntilVisible);
+    BitmapPrefetch(assets, heroBitmapIds.torso, secondsUntilVisible);
+    BitmapPrefetch(assets, heroBitmapIds.cape, secondsUntilVisible);
+    BitmapPrefetch(assets, heroBitmapIds.head, secondsUntilVisible);
+  }
+
+  else if (entity->type & ENTITY_TYPE_FAMILIAR) {
+    struct hero_bitmap_ids heroBitmapIds = HeroBitmapIdsGet(assets, entity->facingDirection);
+    BitmapPrefetch(assets, shadow, secondsUntilVisible);
+    BitmapPrefetch(assets, heroBitmapIds.head, secondsUntilVisible);
+  }
+
+  else if (entity->type & ENTITY_TYPE_MONSTER) {
+    struct hero_bitmap_ids heroBitmapIds = HeroBitmapIdsGet(assets, entity->facingDirection);
+    BitmapPrefetch(assets, shadow, secondsUntilVisible);
+    BitmapPrefetch(assets, heroBitmapIds.torso, secondsUntilVisible);
+  }
+
+  else if (entity->type & ENTITY_TYPE_SWORD) {
+    BitmapPrefetch(assets, shadow, secondsUntilVisible);
+    BitmapPrefetch(assets, BitmapGetFirstId(assets, ASSET_TYPE_SWORD), secondsUntilVisible);
+  }
+
+  else if (entity->type & ENTITY_TYPE_WALL) {
+    BitmapPrefetch(assets, BitmapGetFirstId(assets, ASSET_TYPE_TREE), secondsUntilVisible);
+  }
+}
+
+internal void
+OverlayAudioTelemetry(struct game_memory *memory, struct audio_state *audioState)
+{
+#if HANDMADEHERO_INTERNAL
+  struct platform_audio_telemetry *telemetry = &memory->audioTelemetry;
+  u8 lineMemory[256];
+  struct string_builder line = StringBuilder(lineMemory, sizeof(lineMemory));
+  StringBuilderAppendZeroTerminated(&line, "#7f1d1d#AUDIO #10b981#QUANTUM ");
+  StringBuilderAppendU64(&line, telemetry->quantum);
+  StringBuilderAppendZeroTerminated(&line, " REQUESTED ");
+  StringBuilderAppendU64(&line, telemetry->requestedSampleCount);
+  StringBuilderAppendZeroTerminated(&line, " MAX ");
+  StringBuilderAppendU64(&line, telemetry->requestedSampleCountMax);
+  StringBuilderAppendZeroTerminated(&line, " UNDERRUN ");
+  StringBuilderAppendU64(&line, telemetry->underrunCount);
+  DEBUGTextLine(StringBuilderTerminate(&line));
+
+  line = StringBuilder(lineMemory, sizeof(lineMemory));
+  StringBuilderAppendZeroTerminated(&line, "LATENCY ");
+  StringBuilderAppendU64(&line, telemetry->latencyNanoseconds / 1000);
+  StringBuilderAppendZeroTerminated(&line, "us MAX ");
+  StringBuilderAppendU64(&line, telemetry->latencyNanosecondsMax / 1000);
+  StringBuilderAppendZeroTerminated(&line, "us CYCLE ");
+  StringBuilderAppendU64(&line, telemetry->cycleIntervalNanoseconds / 1000);
+  StringBuilderAppendZeroTerminated(&line, "us MAX ");
+  StringBuilderAppendU64(&line, telemetry->cycleIntervalNanosecondsMax / 1000);
+  StringBuilderAppendZeroTerminated(&line, "us");
+  DEBUGTextLine(StringBuilderTerminate(&line));
+
+  line = StringBuilder(lineMemory, sizeof(lineMemory));
+  StringBuilderAppendZeroTerminated(&line, "STREAM UNDERRUN ");
+  StringBuilderAppendU64(&line, AtomicLoadRelaxed(&audioState->streamUnderrunCount));
+  StringBuilderAppendZeroTerminated(&line, " SAMPLES ");
+  StringBuilderAppendU64(&line, AtomicLoadRelaxed(&audioState->streamUnderrunSampleCount));
+  StringBuilderAppendZeroTerminated(&line, " LATE ");
+  StringBuilderAppendU64(&line, AtomicLoadRelaxed(&audioState->streamLateCount));
+  StringBuilderAppendZeroTerminated(&line, " DROPPED COMMANDS ");
+  StringBuilderAppendU64(&line, AtomicLoadRelaxed(&audioState->droppedCommandCount));
+  DEBUGTextLine(StringBuilderTerminate(&line));
+#endif
+}
+
+internal void
+OverlayTaskPool(struct task_pool *pool)
+{
+#if HANDMADEHERO_INTERNAL
+  u8 memory[128];
+  struct string_builder line = StringBuilder(memory, sizeof(memory));
+  StringBuilderAppendZeroTerminated(&line, "#7f1d1d#TASKS #10b981#USED ");
+  StringBuilderAppendU64(&line, AtomicLoad(&pool->usedCountMax));
+  StringBuilderAppendZeroTerminated(&line, "/");
+  StringBuilderAppendU64(&line, pool->count);
+  StringBuilderAppendZeroTerminated(&line, " REFUSED ");
+  StringBuilderAppendU64(&line, AtomicLoad(&pool->refusedCount));
+  StringBuilderAppendZeroTerminated(&line, " TOTAL ");
+  StringBuilderAppendU64(&line, AtomicLoad(&pool->refusedCountTotal));
+  DEBUGTextLine(StringBuilderTerminate(&line));
+#endif
+}
+
+#if HANDMADEHERO_INTERNAL
+internal void
+StringBuilderAppendKilobytes(struct string_builder *builder, u64 bytes)
+{
+  StringBuilderAppendU64(builder, bytes / KILOBYTES);
+  StringBuilderAppendZeroTerminated(builder, "K");
+}
+
+internal void
+StringBuilderAppendAssetCounters(struct string_builder *builder, struct asset_counters *counters)
+{
+  StringBuilderAppendZeroTerminated(builder, "HIT ");
+  StringBuilderAppendU64(builder, counters->hitCount);
+  StringBuilderAppendZeroTerminated(builder, " MISS ");
+  StringBuilderAppendU64(builder, counters->missCount);
+  StringBuilderAppendZeroTerminated(builder, " LOAD ");
+  StringBuilderAppendU64(builder, counters->loadCount);
+  StringBuilderAppendZeroTerminated(builder, " ");
+  StringBuilderAppendKilobytes(builder, counters->loadedBytes);
+  StringBuilderAppendZeroTerminated(builder, " EVICT ");
+  StringBuilderAppendU64(builder, counters->evictionCount);
+  StringBuilderAppendZeroTerminated(builder, " ");
+  StringBuilderAppendKilobytes(builder, counters->evictedBytes);
+  StringBuilderAppendZeroTerminated(builder, " MISSING ");
+  StringBuilderAppendU64(builder, counters->missingResourceCount);
+}
+
+internal void
+StringBuilderAppendAssetMemory(struct string_builder *builder, struct asset_telemetry *telemetry)
+{
+  StringBuilderAppendZeroTerminated(builder, "MEMORY ");
+  StringBuilderAppendKilobytes(builder, telemetry->memoryUsed);
+  StringBuilderAppendZeroTerminated(builder, "/");
+  StringBuilderAppendKilobytes(builder, telemetry->memorySize);
+  StringBuilderAppendZeroTerminated(builder, " MAX ");
+  StringBuilderAppendKilobytes(builder, telemetry->memoryUsedMax);
+  StringBuilderAppendZeroTerminated(builder, " QUEUE ");
+  StringBuilderAppendU64(builder, telemetry->queueDepth);
+  StringBuilderAppendZeroTerminated(builder, " MAX ");
+  StringBuilderAppendU64(builder, telemetry->queueDepthMax);
+  StringBuilderAppendZeroTerminated(builder, " RELOAD PENDING ");
+  StringBuilderAppendU64(builder, telemetry->reloadPendingFileCount);
+}
+
+// lower bound of each bucket in frames, then its count
+internal void
+StringBuilderAppendAssetLatencies(struct string_builder *builder, struct asset_telemetry *telemetry)
+{
+  StringBuilderAppendZeroTerminated(builder, "LATENCY");
+  for (u32 bucket = 0; bucket < ASSET_LATENCY_BUCKET_COUNT; bucket++) {
+    StringBuilderAppendZeroTerminated(builder, " ");
+    StringBuilderAppendU64(builder, bucket == 0 ? 0 : 1u << (bucket - 1));
+    StringBuilderAppendZeroTerminated(builder, ":");
+    StringBuilderAppendU64(builder, AtomicLoad(&telemetry->loadLatencies[bucket]));
+  }
+}
+#endif
+
+internal void
+OverlayAssetTelemetry(struct asset_telemetry *telemetry)
+{
+#if HANDMADEHERO_INTERNAL
+  u8 memory[256];
+  struct string_builder line = StringBuilder(memory, sizeof(memory));
+  StringBuilderAppendZeroTerminated(&line, "#7f1d1d#ASSETS #10b981#");
+  StringBuilderAppendAssetMemory(&line, telemetry);
+  DEBUGTextLine(StringBuilderTerminate(&line));
+
+  line = StringBuilder(memory, sizeof(memory));
+  StringBuilderAppendZeroTerminated(&line, "FRAME ");
+  StringBuilderAppendAssetCounters(&line, &telemetry->lastFrame);
+  DEBUGTextLine(StringBuilderTerminate(&line));
+
+  line = StringBuilder(memory, sizeof(memory));
+  StringBuilderAppendAssetLatencies(&line, telemetry);
+  DEBUGTextLine(StringBuilderTerminate(&line));
+#endif
+}
+
 #if HANDMADEHERO_INTERNAL
 struct game_memory *DEBUG_GLOBAL_MEMORY;
 struct render_group *DEBUG_TEXT_RENDER_GROUP;
@@ -672,11 +981,41 @@ GameOutputAudio(struct game_memory *memory, struct game_audio_buffer *audioBuffe
   if (audioBuffer->sampleCount == 0)
     return isWritten;
 
-  isWritten = OutputPlayingAudios(&state->audioState, audioBuffer, transientState->assets);
+  isWritten = OutputPlayingAudios(&state->audioState, audioBuffer);
 
   return isWritten;
 }
 
+void
+GameShutdown(struct game_memory *memory)
+{
+  struct game_state *state = memory->permanentStorage;
+  struct transient_state *transientState = memory->transientStorage;
+  if (!state->isInitialized || !transientState->isInitialized)
+    return;
+
+  Platform->WorkQueueCompleteAllWork(transientState->lowPriorityQueue);
+
+#if HANDMADEHERO_DEBUG
+  // NOTE(e2dk4r): kept for sizing asset memory of content
+  struct asset_telemetry *telemetry = &transientState->assets->telemetry;
+  u8 buffer[1024];
+  struct string_builder report = StringBuilder(buffer, sizeof(buffer));
+  StringBuilderAppendAssetMemory(&report, telemetry);
+  StringBuilderAppendZeroTerminated(&report, "\nTOTAL ");
+  StringBuilderAppendAssetCounters(&report, &telemetry->total);
+  StringBuilderAppendZeroTerminated(&report, "\n");
+  StringBuilderAppendAssetLatencies(&report, telemetry);
+  StringBuilderAppendZeroTerminated(&report, "\n");
+  if (!Platform->WriteEntireFile("asset_telemetry.txt", report.length, report.memory)) {
+    // TODO: notify user
+  }
+
+  // NOTE(e2dk4r): builder lays out data of packs with it, see hha_trace_header
+  AssetTraceWrite(transientState->assets, "asset_trace.hht");
+#endif
+}
+
 struct platform_api *Platform;
 void
 GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct game_backbuffer *backbuffer)
@@ -691,6 +1030,9 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
   assert(Platform->WorkQueueAddEntry && "platform layer NOT implemented PlatformWorkQueueAddEntry");
   assert(Platform->WorkQueueCompleteAllWork && "platform layer NOT implemented PlatformWorkQueueCompleteAllWork");
   assert(Platform->OpenNextFile && "platform layer NOT implemented PlatformOpenFile");
+  assert(Platform->ReopenFile && "platform layer NOT implemented PlatformReopenFile");
+  assert(Platform->CloseFile && "platform layer NOT implemented PlatformCloseFile");
+  assert(Platform->IsSameFile && "platform layer NOT implemented PlatformIsSameFile");
   assert(Platform->ReadFromFile && "platform layer NOT implemented PlatformReadFromFile");
   assert(Platform->GetAllFilesOfTypeBegin && "platform layer NOT implemented PlatformGetAllFilesOfTypeBegin");
   assert(Platform->HasFileError && "platform layer NOT implemented PlatformHasFileError");
@@ -893,12 +1235,8 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
     memory_arena_size_t size = memory->transientStorageSize - sizeof(*transientState);
     MemoryArenaInit(&transientState->transientArena, data, size);
 
-    for (u32 taskIndex = 0; taskIndex < ARRAY_COUNT(transientState->tasks); taskIndex++) {
-      struct task_with_memory *task = transientState->tasks + taskIndex;
-
-      task->isUsed = 0;
-      MemorySubArenaInit(&task->arena, &transientState->transientArena, 1 * MEGABYTES);
-    }
+    u32 workerCount = memory->highPriorityWorkerCount + memory->lowPriorityWorkerCount;
+    TaskPoolInit(&transientState->taskPool, &transientState->transientArena, workerCount);
 
     transientState->highPriorityQueue = memory->highPriorityQueue;
     transientState->lowPriorityQueue = memory->lowPriorityQueue;
@@ -944,9 +1282,11 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
     transientState->assets = GameAssetsAllocate(&transientState->transientArena, 16 * MEGABYTES, transientState);
 
 #if 0
-    state->music = PlayAudio(&state->audioState, AudioGetFirstId(transientState->assets, ASSET_TYPE_MUSIC));
+    state->music = PlayAudioStream(&state->audioState, AudioGetFirstId(transientState->assets, ASSET_TYPE_MUSIC),
+                                  AUDIO_PRIORITY_DEFAULT);
+    ChangeBus(&state->audioState, state->music, AUDIO_BUS_MUSIC);
 #else
-    state->music = 0;
+    state->music = (struct playing_audio_id){};
 #endif
 
 #if HANDMADEHERO_INTERNAL
@@ -957,6 +1297,18 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
     transientState->isInitialized = 1;
   }
 
+  TaskPoolBeginFrame(&transientState->taskPool, &transientState->transientArena);
+
+  if (input->assetFilesChanged) {
+    // NOTE(e2dk4r): loads in flight read from files that are going to be closed, mixer cannot queue new ones
+    Platform->WorkQueueCompleteAllWork(transientState->lowPriorityQueue);
+    // reload waits until no generation is in flight
+    AudioSnapshotWithdraw(&state->audioState, transientState->assets);
+    AssetFilesReload(transientState->assets);
+  }
+
+  AudioLoadRequestsProcess(&state->audioState, transientState->assets);
+
 #if HANDMADEHERO_INTERNAL
   DEBUG_TEXT_RENDER_GROUP = memory->DEBUGtextRenderGroup;
   RenderBegin(DEBUG_TEXT_RENDER_GROUP);
@@ -1152,6 +1504,16 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
 
   struct v3 cameraRelativeToSim = WorldPositionSub(world, &state->cameraPosition, &simRegionOrigin);
 
+  // NOTE(e2dk4r): camera follows entity
+  struct v3 cameraVelocity = v3(0.0f, 0.0f, 0.0f);
+  for (u32 entityIndex = 0; entityIndex < simRegion->entityCount; entityIndex++) {
+    struct entity *entity = simRegion->entities + entityIndex;
+    if (entity->storageIndex == state->followedEntityIndex) {
+      cameraVelocity = entity->dPosition;
+      break;
+    }
+  }
+
   for (u32 entityIndex = 0; entityIndex < simRegion->entityCount; entityIndex++) {
     struct entity *entity = simRegion->entities + entityIndex;
     assert(entity);
@@ -1162,8 +1524,11 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
     if (EntityIsFlagSet(entity, ENTITY_FLAG_NONSPACIAL))
       continue;
 
-    if (!entity->updatable)
+    if (!entity->updatable) {
+      struct v3 positionRelativeToCamera = v3_sub(entity->position, cameraRelativeToSim);
+      EntityPrefetch(transientState->assets, entity, positionRelativeToCamera, cameraVelocity, screenBounds);
       continue;
+    }
 
     // TODO(e2dk4r): probably indicates we want to seperate update and render for entities
     struct v3 cameraRelativeToGround = v3_sub(entity->position, cameraRelativeToSim);
@@ -1214,8 +1579,9 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
             sword->distanceRemaining = 5.0f;
             sword->dPosition.xy = v2_mul(dSword, 5.0f);
 
-            PlayAudio(&state->audioState,
-                      RandomAudio(&state->effectsEntropy, transientState->assets, ASSET_TYPE_BLOOP));
+            struct playing_audio_id bloop = PlayAudio(
+                &state->audioState, RandomAudio(&state->effectsEntropy, transientState->assets, ASSET_TYPE_BLOOP));
+            ChangeBus(&state->audioState, bloop, AUDIO_BUS_SOUND);
           }
         }
       }
@@ -1274,14 +1640,7 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
     /*****************************************************************
      * Post-physics entity work (rendering)
      *****************************************************************/
-    struct hero_bitmap_ids heroBitmapIds = {};
-    struct asset_vector matchVector = {};
-    matchVector.e[ASSET_TAG_FACING_DIRECTION] = entity->facingDirection;
-    struct asset_vector weightVector = {};
-    weightVector.e[ASSET_TAG_FACING_DIRECTION] = 1.0f;
-    heroBitmapIds.head = BestMatchBitmap(transientState->assets, ASSET_TYPE_HEAD, &matchVector, &weightVector);
-    heroBitmapIds.torso = BestMatchBitmap(transientState->assets, ASSET_TYPE_TORSO, &matchVector, &weightVector);
-    heroBitmapIds.cape = BestMatchBitmap(transientState->assets, ASSET_TYPE_CAPE, &matchVector, &weightVector);
+    struct hero_bitmap_ids heroBitmapIds = HeroBitmapIdsGet(transientState->assets, entity->facingDirection);
     if (entity->type & ENTITY_TYPE_HERO) {
       f32 shadowAlpha = 1.0f - entity->position.z;
       if (shadowAlpha < 0.0f)
@@ -1289,6 +1648,9 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
 
       HitPoints(renderGroup, entity);
 
+      // NOTE: head, torso and cape facing same direction are loaded together
+      BundleLoad(transientState->assets, BundleGetForBitmap(transientState->assets, heroBitmapIds.head));
+
       f32 heroHeightC = 2.5f;
       f32 heroHeight = heroHeightC * 1.2f;
       BitmapAsset(renderGroup, BitmapGetFirstId(transientState->assets, ASSET_TYPE_SHADOW), v3(0.0f, 0.0f, 0.0f),
@@ -1497,7 +1859,7 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
 
 #if 0
     // Random character
-    particle->bitmapId = RandomBitmap(&state->effectsEntropy, transientState->assets, ASSET_TYPE_FONT);
+    particle->bitmapId = RandomBitmap(&state->effectsEntropy, transientState->assets, ASSET_TYPE_FONT_GLYPH);
 #else
     // Random character restricted to set
     char characters[] = "nothings";
@@ -1506,7 +1868,7 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
         (f32)characters[RandomChoice(&state->effectsEntropy, ARRAY_COUNT(characters) - 1)];
     struct asset_vector weightVector = {};
     weightVector.e[ASSET_TAG_UNICODE_CODEPOINT] = 1.0f;
-    particle->bitmapId = BestMatchBitmap(transientState->assets, ASSET_TYPE_FONT, &matchVector, &weightVector);
+    particle->bitmapId = BestMatchBitmap(transientState->assets, ASSET_TYPE_FONT_GLYPH, &matchVector, &weightVector);
 #endif
   }
 
@@ -1579,9 +1941,14 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
   }
 #endif
 
+  // NOTE(e2dk4r): audios played this frame can be mixed right away
+  AudioSnapshotPublish(&state->audioState, transientState->assets);
+  AssetStreamUpdate(transientState->assets);
+
   struct platform_work_queue *renderQueue = transientState->highPriorityQueue;
   TiledDrawRenderGroup(renderQueue, renderGroup, &drawBuffer);
   RenderEnd(renderGroup);
+  AssetTelemetryEndFrame(transientState->assets, renderGroup->missingResourceCount);
 
   EndSimRegion(simRegion, state);
   EndTemporaryMemory(&simRegionMemory);
@@ -1594,6 +1961,9 @@ GameUpdateAndRender(struct game_memory *memory, struct game_input *input, struct
 
 #if HANDMADEHERO_INTERNAL
   OverlayCycleCounters(memory);
+  OverlayAudioTelemetry(memory, &state->audioState);
+  OverlayTaskPool(&transientState->taskPool);
+  OverlayAssetTelemetry(&transientState->assets->telemetry);
   TiledDrawRenderGroup(renderQueue, DEBUG_TEXT_RENDER_GROUP, &drawBuffer);
   RenderEnd(DEBUG_TEXT_RENDER_GROUP);
 #endif
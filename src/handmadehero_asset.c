@@ -1,13 +1,16 @@
 #include <handmadehero/assert.h>
 #include <handmadehero/asset.h>
 #include <handmadehero/atomic.h>
-#include <handmadehero/handmadehero.h> // BeginTaskWithMemory, EndTaskWithMemory
+#include <handmadehero/checksum.h>
+#include <handmadehero/compression.h>
+#include <handmadehero/handmadehero.h> // BeginTaskWithMemory, EndTaskWithMemory, task_pool
 #include <handmadehero/platform.h>
+#include <x86intrin.h>
 
 internal b32
 IsAssetTypeIdBitmap(enum asset_type_id typeId)
 {
-  return typeId >= ASSET_TYPE_SHADOW && typeId <= ASSET_TYPE_FONT;
+  return (typeId >= ASSET_TYPE_SHADOW && typeId <= ASSET_TYPE_CAPE) || typeId == ASSET_TYPE_ATLAS;
 }
 
 internal b32
@@ -47,9 +50,10 @@ RemoveAssetHeaderFromList(struct asset_memory_header *header)
 internal void
 BeginAssetLock(struct game_assets *assets)
 {
-  u32 expected = 0;
   u32 desired = 1;
   while (1) {
+    // NOTE(e2dk4r): failed exchange writes current value to expected
+    u32 expected = 0;
     if (AtomicCompareExchange(&assets->operationLock, &expected, desired))
       break;
   }
@@ -62,6 +66,129 @@ EndAssetLock(struct game_assets *assets)
   AtomicStore(&assets->operationLock, desired);
 }
 
+/* NOTE(e2dk4r): Takes asset lock when no generation is in flight, so no
+ * thread is using data or metadata of any asset until lock is released.
+ * Must not be called while caller has a generation in flight.
+ */
+internal void
+BeginAssetLockNoGeneration(struct game_assets *assets)
+{
+  while (1) {
+    BeginAssetLock(assets);
+    if (assets->inFlightGenerationCount == 0)
+      break;
+    EndAssetLock(assets);
+    _mm_pause();
+  }
+}
+
+internal struct asset_memory_block *
+InsertMemoryBlock(struct asset_memory_block *prev, void *memory, u64 size)
+{
+  struct asset_memory_block *block = memory;
+  assert(size > sizeof(*block));
+  block->size = size - sizeof(*block);
+  block->flags = 0;
+
+  block->prev = prev;
+  block->next = prev->next;
+
+  block->prev->next = block;
+  block->next->prev = block;
+
+  return block;
+}
+
+internal struct asset_memory_block *
+FindMemoryBlockForSize(struct game_assets *assets, memory_arena_size_t size)
+{
+  struct asset_memory_block *found = 0;
+
+  for (struct asset_memory_block *block = assets->memorySentiel.next; block != &assets->memorySentiel;
+       block = block->next) {
+    if (block->flags & ASSET_MEMORY_BLOCK_USED)
+      continue;
+
+    if (block->size < size)
+      continue;
+
+    found = block;
+    break;
+  }
+
+  return found;
+}
+
+internal b32
+MergeMemoryBlock(struct game_assets *assets, struct asset_memory_block *first, struct asset_memory_block *second)
+{
+  b32 isMerged = 0;
+  if (first == &assets->memorySentiel || second == &assets->memorySentiel)
+    return isMerged;
+
+  if (first->flags & ASSET_MEMORY_BLOCK_USED || second->flags & ASSET_MEMORY_BLOCK_USED)
+    return isMerged;
+
+  // expected to be continuous space
+  u8 *expectedSecond = (u8 *)first + sizeof(*first) + first->size;
+  if ((u8 *)second != expectedSecond)
+    return isMerged;
+
+  // detach memory block from list
+  second->next->prev = second->prev;
+  second->prev->next = second->next;
+
+  // notify that first is bigger now
+  first->size += sizeof(*second) + second->size;
+
+  isMerged = 1;
+
+  return isMerged;
+}
+
+internal b32
+HasGenerationCompleted(struct game_assets *assets, u32 generationId)
+{
+  b32 isCompleted = 1;
+
+  for (u32 index = 0; index < assets->inFlightGenerationCount; index++) {
+    if (assets->inFlightGenerations[index] == generationId) {
+      isCompleted = 0;
+      break;
+    }
+  }
+
+  return isCompleted;
+}
+
+// NOTE(e2dk4r): asset lock must be held
+internal void
+EvictAsset(struct game_assets *assets, struct asset *asset)
+{
+  assert(asset->state == ASSET_STATE_LOADED);
+
+  struct asset_memory_header *header = asset->header;
+  RemoveAssetHeaderFromList(header);
+
+  // release asset memory
+  struct asset_memory_block *block = (struct asset_memory_block *)((u8 *)header - sizeof(*block));
+  block->flags &= (u64)(~ASSET_MEMORY_BLOCK_USED);
+
+  struct asset_telemetry *telemetry = &assets->telemetry;
+  telemetry->total.evictionCount++;
+  telemetry->total.evictedBytes += block->size;
+  telemetry->memoryUsed -= block->size;
+
+  if (MergeMemoryBlock(assets, block->prev, block)) {
+    block = block->prev;
+  }
+
+  MergeMemoryBlock(assets, block, block->next);
+
+  asset->state = ASSET_STATE_UNLOADED;
+  asset->header = 0;
+}
+
 internal struct asset_memory_header *
 AssetGet(struct game_assets *assets, u32 assetIndex, u32 generationId)
 {
@@ -80,6 +207,10 @@ AssetGet(struct game_assets *assets, u32 assetIndex, u32 generationId)
     if (header->generationId < generationId) {
       header->generationId = generationId;
     }
+
+    assets->telemetry.total.hitCount++;
+  } else {
+    assets->telemetry.total.missCount++;
   }
 
   EndAssetLock(assets);
@@ -87,9 +218,36 @@ AssetGet(struct game_assets *assets, u32 assetIndex, u32 generationId)
   return header;
 }
 
+internal struct asset_file *
+AssetFileGet(struct game_assets *assets, u32 fileIndex)
+{
+  assert(fileIndex < assets->fileCount);
+  struct asset_file *file = (assets->files + fileIndex);
+  return file;
+}
+
+// NOTE(e2dk4r): bitmap in atlas is loaded with its atlas, returns atlas of it
+internal struct bitmap_id
+BitmapAtlasResolve(struct game_assets *assets, struct bitmap_id id)
+{
+  if (id.value == 0)
+    return id;
+
+  struct asset *asset = assets->assets + id.value;
+  struct bitmap_id atlasIdInFile = asset->hhaAsset.bitmap.atlasId;
+  if (atlasIdInFile.value == 0)
+    return id;
+
+  struct asset_file *file = AssetFileGet(assets, asset->fileIndex);
+  struct bitmap_id atlasId = {file->atlasBitmapIdOffset + atlasIdInFile.value};
+  assert(atlasId.value < assets->assetCount);
+  return atlasId;
+}
+
 inline struct bitmap *
 BitmapGet(struct game_assets *assets, struct bitmap_id id, u32 generationId)
 {
+  id = BitmapAtlasResolve(assets, id);
   struct asset_memory_header *header = AssetGet(assets, id.value, generationId);
   struct bitmap *bitmap = header ? &header->bitmap : 0;
   return bitmap;
@@ -111,34 +269,109 @@ FontGet(struct game_assets *assets, struct font_id id, u32 generationId)
   return font;
 }
 
+internal b32
+IsOnlyTagWeighted(struct asset_vector *weightVector, enum asset_tag_id onlyTagId)
+{
+  for (u32 tagId = 0; tagId < ASSET_TAG_COUNT; tagId++) {
+    f32 weight = weightVector->e[tagId];
+    if (tagId == onlyTagId ? weight <= 0.0f : weight != 0.0f)
+      return 0;
+  }
+
+  return 1;
+}
+
 internal u32
 BestMatchAsset(struct game_assets *assets, enum asset_type_id typeId, struct asset_vector *matchVector,
                struct asset_vector *weightVector)
 {
   u32 result = 0;
 
-  f32 bestDiff = F32_MAX;
   struct asset_type *type = assets->assetTypes + typeId;
-  for (u32 assetIndex = type->assetIndexFirst; assetIndex < type->assetIndexOnePastLast; assetIndex++) {
-    struct asset *asset = assets->assets + assetIndex;
+  struct asset_tag_index *index = assets->tagIndexes + typeId;
+
+  // NOTE(e2dk4r): Exact match is the best match, when only codepoint is weighted
+  // and every asset is tagged with it.
+  if (index->codepointAssets && IsOnlyTagWeighted(weightVector, ASSET_TAG_UNICODE_CODEPOINT)) {
+    f32 codepoint = matchVector->e[ASSET_TAG_UNICODE_CODEPOINT];
+    if (codepoint >= (f32)index->codepointFirst && codepoint < (f32)(index->codepointFirst + index->codepointCount) &&
+        (f32)(u32)codepoint == codepoint) {
+      result = index->codepointAssets[(u32)codepoint - index->codepointFirst];
+      if (result)
+        return result;
+    }
+  }
+
+  // NOTE(e2dk4r): Only score tags that are weighted and exist in type.
+  u32 activeTagCount = 0;
+  struct {
+    f32 *values;
+    f32 *masks;
+    __m128 a;
+    __m128 aWrapped;
+    __m128 weight;
+  } activeTags[ASSET_TAG_COUNT];
+  for (u32 tagId = 0; tagId < ASSET_TAG_COUNT; tagId++) {
+    f32 weight = weightVector->e[tagId];
+    if (weight == 0.0f || !index->values[tagId])
+      continue;
+
+    f32 a = matchVector->e[tagId];
+    activeTags[activeTagCount].values = index->values[tagId];
+    activeTags[activeTagCount].masks = index->masks[tagId];
+    activeTags[activeTagCount].a = _mm_set1_ps(a);
+    activeTags[activeTagCount].aWrapped = _mm_set1_ps(a - assets->tagRanges[tagId] * SignOf(a));
+    activeTags[activeTagCount].weight = _mm_set1_ps(weight);
+    activeTagCount++;
+  }
+
+  f32 bestTotalDiff = F32_MAX;
+  __m128 signMask = _mm_set1_ps(-0.0f);
+  __m128 bestDiff = _mm_set1_ps(bestTotalDiff);
+  __m128i bestIndex = _mm_setzero_si128();
+  __m128i assetIndex = _mm_setr_epi32((s32)type->assetIndexFirst + 0, (s32)type->assetIndexFirst + 1,
+                                      (s32)type->assetIndexFirst + 2, (s32)type->assetIndexFirst + 3);
+  __m128i four = _mm_set1_epi32(4);
+  for (u32 lane = 0; lane < index->laneCount; lane += 4) {
+    __m128 totalWeightedDiff = _mm_load_ps(index->bias + lane);
 
-    f32 totalWeightedDiff = 0.0f;
-    for (u32 tagIndex = asset->hhaAsset.tagIndexFirst; tagIndex < asset->hhaAsset.tagIndexOnePastLast; tagIndex++) {
-      struct hha_tag *tag = assets->tags + tagIndex;
+    for (u32 activeTagIndex = 0; activeTagIndex < activeTagCount; activeTagIndex++) {
+      __m128 b = _mm_load_ps(activeTags[activeTagIndex].values + lane);
+      __m128 mask = _mm_load_ps(activeTags[activeTagIndex].masks + lane);
 
-      f32 a = matchVector->e[tag->id];
-      f32 b = tag->value;
-      f32 d0 = Absolute(a - b);
-      f32 d1 = Absolute(a - assets->tagRanges[tag->id] * SignOf(a) - b);
-      f32 diff = Minimum(d0, d1);
+      __m128 d0 = _mm_andnot_ps(signMask, activeTags[activeTagIndex].a - b);
+      __m128 d1 = _mm_andnot_ps(signMask, activeTags[activeTagIndex].aWrapped - b);
+      __m128 diff = _mm_min_ps(d0, d1);
 
-      f32 weightedDiff = weightVector->e[tag->id] * diff;
+      __m128 weightedDiff = activeTags[activeTagIndex].weight * diff * mask;
 
       totalWeightedDiff += weightedDiff;
     }
 
-    if (bestDiff > totalWeightedDiff) {
-      bestDiff = totalWeightedDiff;
+    // NOTE(e2dk4r): strictly less, so each lane keeps the first asset on tie
+    __m128 isBetter = _mm_cmplt_ps(totalWeightedDiff, bestDiff);
+    bestDiff = _mm_blendv_ps(bestDiff, totalWeightedDiff, isBetter);
+    bestIndex = _mm_blendv_epi8(bestIndex, assetIndex, _mm_castps_si128(isBetter));
+
+    assetIndex = _mm_add_epi32(assetIndex, four);
+  }
+
+  union m128 {
+    __m128 v;
+    f32 e[4];
+  };
+  union m128i {
+    __m128i v;
+    u32 e[4];
+  };
+  union m128 laneDiff = {bestDiff};
+  union m128i laneIndex = {bestIndex};
+
+  for (u32 lane = 0; lane < 4; lane++) {
+    f32 diff = laneDiff.e[lane];
+    u32 assetIndex = laneIndex.e[lane];
+    if (diff < bestTotalDiff || (diff == bestTotalDiff && result && assetIndex < result)) {
+      bestTotalDiff = diff;
       result = assetIndex;
     }
   }
@@ -172,162 +405,402 @@ BestMatchFont(struct game_assets *assets, enum asset_type_id typeId, struct asse
   return result;
 }
 
-internal struct asset_file *
-AssetFileGet(struct game_assets *assets, u32 fileIndex)
+internal struct asset_memory_header *
+AcquireAssetMemory(struct game_assets *assets, memory_arena_size_t size, u32 assetIndex)
 {
-  assert(fileIndex < assets->fileCount);
-  struct asset_file *file = (assets->files + fileIndex);
-  return file;
-}
+  struct asset_memory_header *result = 0;
 
-internal struct platform_file_handle *
-AssetFileHandleGet(struct game_assets *assets, u32 fileIndex)
-{
-  struct asset_file *file = AssetFileGet(assets, fileIndex);
-  struct platform_file_handle *handle = &file->handle;
-  return handle;
-}
+  BeginAssetLock(assets);
 
-internal struct asset_memory_block *
-InsertMemoryBlock(struct asset_memory_block *prev, void *memory, u64 size)
-{
-  struct asset_memory_block *block = memory;
-  assert(size > sizeof(*block));
-  block->size = size - sizeof(*block);
-  block->flags = 0;
+  for (;;) {
+    struct asset_memory_block *block = FindMemoryBlockForSize(assets, size);
+    if (block && size <= block->size) {
+      block->flags |= ASSET_MEMORY_BLOCK_USED;
 
-  block->prev = prev;
-  block->next = prev->next;
+      result = (struct asset_memory_header *)(block + 1);
 
-  block->prev->next = block;
-  block->next->prev = block;
+      u64 remainingSize = block->size - size;
+      u64 memoryBlockSplitThreshold = 4 * KILOBYTES;
+      if (remainingSize > memoryBlockSplitThreshold) {
+        block->size -= remainingSize;
+        InsertMemoryBlock(block, (u8 *)result + size, remainingSize);
+      }
 
-  return block;
+      struct asset_telemetry *telemetry = &assets->telemetry;
+      telemetry->memoryUsed += block->size;
+      telemetry->memoryUsedMax = Maximum(telemetry->memoryUsedMax, telemetry->memoryUsed);
+      break;
+    } else { // if memory block for size NOT found
+      b32 isEvicted = 0;
+      for (struct asset_memory_header *header = assets->loadedAssetSentiel.prev; header != &assets->loadedAssetSentiel;
+           header = header->prev) {
+        struct asset *asset = assets->assets + header->assetIndex;
+        // NOTE(e2dk4r): asset that is loading, or used by generation in flight, is not evicted
+        if (asset->state < ASSET_STATE_LOADED || !HasGenerationCompleted(assets, asset->header->generationId)) {
+          continue;
+        }
+
+        EvictAsset(assets, asset);
+        isEvicted = 1;
+        break;
+      }
+
+      if (!isEvicted) {
+        // every loaded asset is in use, asset memory is too small
+        InvalidCodePath;
+        break;
+      }
+    }
+  }
+
+  if (result) {
+    // AddAssetHeaderToList
+    result->assetIndex = assetIndex;
+    // NOTE(e2dk4r): memory holds generation of asset evicted from it, which can be newer than ones using this asset
+    result->generationId = 0;
+    InsertAssetHeaderToFront(assets, result);
+
+    // NOTE(e2dk4r): requested bitmaps keep frame of their request
+    struct asset *asset = assets->assets + assetIndex;
+    if (!asset->requestIndex)
+      asset->requestFrameIndex = AtomicLoad(&assets->stream.frameIndex);
+  }
+
+  EndAssetLock(assets);
+
+  return result;
 }
 
-internal struct asset_memory_block *
-FindMemoryBlockForSize(struct game_assets *assets, memory_arena_size_t size)
+internal void
+DoLoadAssetFileHeaderWork(struct platform_work_queue *queue, void *data)
 {
-  struct asset_memory_block *found = 0;
+  struct asset_file *file = data;
+
+  union {
+    struct hha_header v1;
+    struct hha_header_v0 v0;
+  } fileHeader;
+  Platform->ReadFromFile(&fileHeader, &file->handle, 0, sizeof(fileHeader.v1));
+  if (Platform->HasFileError(&file->handle)) {
+    // TODO: notify user
+    assert(0 && "file not read");
+    return;
+  }
 
-  for (struct asset_memory_block *block = assets->memorySentiel.next; block != &assets->memorySentiel;
-       block = block->next) {
-    if (block->flags & ASSET_MEMORY_BLOCK_USED)
-      continue;
+  if (fileHeader.v1.magic != HHA_MAGIC) {
+    // TODO: notify user
+    assert(0 && "file is not hha");
+    Platform->FileError(&file->handle, HANDMADEHERO_ERROR_FILE_IS_NOT_HHA);
+    return;
+  }
 
-    if (block->size < size)
+  if (fileHeader.v1.version > HHA_VERSION) {
+    // TODO: notify user
+    assert(0 && "not supported version");
+    Platform->FileError(&file->handle, HANDMADEHERO_ERROR_HHA_VERSION_IS_NOT_SUPPORTED);
+    return;
+  }
+
+  struct hha_header *header = &file->header;
+  ZeroMemory(file->sections, sizeof(file->sections));
+
+  if (fileHeader.v1.version == 0) {
+    Platform->ReadFromFile(&fileHeader, &file->handle, 0, sizeof(fileHeader.v0));
+    if (Platform->HasFileError(&file->handle)) {
+      // TODO: notify user
+      assert(0 && "file not read");
+      return;
+    }
+
+    struct hha_header_v0 *headerV0 = &fileHeader.v0;
+    *header = (struct hha_header){
+        .magic = headerV0->magic,
+        .version = headerV0->version,
+        .tagCount = headerV0->tagCount,
+        .assetCount = headerV0->assetCount,
+        .assetTypeCount = headerV0->assetTypeCount,
+    };
+
+    file->sections[HHA_SECTION_TYPE_TAGS] = (struct hha_section){
+        .type = HHA_SECTION_TYPE_TAGS,
+        .offset = headerV0->tagsOffset,
+        .size = sizeof(struct hha_tag) * headerV0->tagCount,
+    };
+    file->sections[HHA_SECTION_TYPE_ASSET_TYPES] = (struct hha_section){
+        .type = HHA_SECTION_TYPE_ASSET_TYPES,
+        .offset = headerV0->assetTypesOffset,
+        .size = sizeof(struct hha_asset_type) * headerV0->assetTypeCount,
+    };
+    file->sections[HHA_SECTION_TYPE_ASSETS] = (struct hha_section){
+        .type = HHA_SECTION_TYPE_ASSETS,
+        .offset = headerV0->assetsOffset,
+        .size = sizeof(struct hha_asset_v0) * headerV0->assetCount,
+    };
+    return;
+  }
+
+  *header = fileHeader.v1;
+
+  struct hha_section sections[16];
+  if (header->sectionCount > ARRAY_COUNT(sections)) {
+    // TODO: notify user
+    assert(0 && "hha has too many sections");
+    Platform->FileError(&file->handle, HANDMADEHERO_ERROR_HHA_MALFORMED);
+    return;
+  }
+
+  Platform->ReadFromFile(sections, &file->handle, header->sectionsOffset, sizeof(*sections) * header->sectionCount);
+  if (Platform->HasFileError(&file->handle)) {
+    // TODO: notify user
+    assert(0 && "file not read");
+    return;
+  }
+
+  // NOTE(e2dk4r): unknown sections are skipped, so newer builders can add them
+  for (u32 sectionIndex = 0; sectionIndex < header->sectionCount; sectionIndex++) {
+    struct hha_section *section = sections + sectionIndex;
+    if (section->type >= HHA_SECTION_TYPE_COUNT)
       continue;
 
-    found = block;
-    break;
+    file->sections[section->type] = *section;
   }
 
-  return found;
+  if (file->sections[HHA_SECTION_TYPE_TAGS].size != sizeof(struct hha_tag) * header->tagCount ||
+      file->sections[HHA_SECTION_TYPE_ASSET_TYPES].size != sizeof(struct hha_asset_type) * header->assetTypeCount ||
+      file->sections[HHA_SECTION_TYPE_ASSETS].size != sizeof(struct hha_asset) * header->assetCount) {
+    // TODO: notify user
+    assert(0 && "hha sections do not match header");
+    Platform->FileError(&file->handle, HANDMADEHERO_ERROR_HHA_MALFORMED);
+    return;
+  }
+
+  if (file->sections[HHA_SECTION_TYPE_BUNDLES].size % sizeof(struct hha_bundle) != 0 ||
+      file->sections[HHA_SECTION_TYPE_BUNDLE_ASSETS].size % sizeof(u32) != 0) {
+    // TODO: notify user
+    assert(0 && "hha bundle sections are malformed");
+    Platform->FileError(&file->handle, HANDMADEHERO_ERROR_HHA_MALFORMED);
+    return;
+  }
 }
 
 internal b32
-MergeMemoryBlock(struct game_assets *assets, struct asset_memory_block *first, struct asset_memory_block *second)
+IsSectionChecksumValid(struct hha_section *section, void *data)
 {
-  b32 isMerged = 0;
-  if (first == &assets->memorySentiel || second == &assets->memorySentiel)
-    return isMerged;
+  // NOTE(e2dk4r): version 0 files and old builders do not have checksum
+  if (section->checksum == 0)
+    return 1;
 
-  if (first->flags & ASSET_MEMORY_BLOCK_USED || second->flags & ASSET_MEMORY_BLOCK_USED)
-    return isMerged;
+  return section->checksum == Crc32c(data, section->size);
+}
 
-  // expected to be continuous space
-  u8 *expectedSecond = (u8 *)first + sizeof(*first) + first->size;
-  if ((u8 *)second != expectedSecond)
-    return isMerged;
+internal void
+DoLoadAssetFileMetadataWork(struct platform_work_queue *queue, void *data)
+{
+  struct asset_file *file = data;
 
-  // detach memory block from list
-  second->next->prev = second->prev;
-  second->prev->next = second->next;
+  struct hha_section *assetTypesSection = file->sections + HHA_SECTION_TYPE_ASSET_TYPES;
+  Platform->ReadFromFile(file->assetTypes, &file->handle, assetTypesSection->offset, assetTypesSection->size);
 
-  // notify that first is bigger now
-  first->size += sizeof(*second) + second->size;
+  struct hha_section *tagsSection = file->sections + HHA_SECTION_TYPE_TAGS;
+  Platform->ReadFromFile(file->tags, &file->handle, tagsSection->offset, tagsSection->size);
 
-  isMerged = 1;
+  // NOTE: hhaAssets and its older versions share the same buffer
+  struct hha_section *assetsSection = file->sections + HHA_SECTION_TYPE_ASSETS;
+  Platform->ReadFromFile(file->hhaAssets, &file->handle, assetsSection->offset, assetsSection->size);
 
-  return isMerged;
-}
+  struct hha_section *bundlesSection = file->sections + HHA_SECTION_TYPE_BUNDLES;
+  Platform->ReadFromFile(file->hhaBundles, &file->handle, bundlesSection->offset, bundlesSection->size);
 
-internal b32
-HasGenerationCompleted(struct game_assets *assets, u32 generationId)
-{
-  b32 isCompleted = 1;
+  struct hha_section *bundleAssetsSection = file->sections + HHA_SECTION_TYPE_BUNDLE_ASSETS;
+  Platform->ReadFromFile(file->bundleAssets, &file->handle, bundleAssetsSection->offset, bundleAssetsSection->size);
 
-  for (u32 index = 0; index < assets->inFlightGenerationCount; index++) {
-    if (assets->inFlightGenerations[index] == generationId) {
-      isCompleted = 0;
-      break;
-    }
+  if (Platform->HasFileError(&file->handle)) {
+    // TODO: notify user
+    assert(0 && "file not read");
+    return;
   }
 
-  return isCompleted;
+  if (!IsSectionChecksumValid(assetTypesSection, file->assetTypes) ||
+      !IsSectionChecksumValid(tagsSection, file->tags) || !IsSectionChecksumValid(assetsSection, file->hhaAssets) ||
+      !IsSectionChecksumValid(bundlesSection, file->hhaBundles) ||
+      !IsSectionChecksumValid(bundleAssetsSection, file->bundleAssets)) {
+    // TODO: notify user
+    assert(0 && "hha metadata is corrupted");
+    Platform->FileError(&file->handle, HANDMADEHERO_ERROR_HHA_CHECKSUM_MISMATCH);
+    return;
+  }
 }
 
-internal struct asset_memory_header *
-AcquireAssetMemory(struct game_assets *assets, memory_arena_size_t size, u32 assetIndex)
+internal void
+HHAAssetFromV0(struct hha_asset *dest, struct hha_asset_v0 *src, u32 typeId)
 {
-  struct asset_memory_header *result = 0;
+  *dest = (struct hha_asset){
+      .dataOffset = src->dataOffset,
+      // NOTE: size and checksum of data are unknown in version 0
+      .dataSize = 0,
+      .dataChecksum = 0,
+      .codec = HHA_CODEC_NONE,
+      .tagIndexFirst = src->tagIndexFirst,
+      .tagIndexOnePastLast = src->tagIndexOnePastLast,
+  };
+
+  if (typeId == ASSET_TYPE_FONT) {
+    // NOTE: font has no kernings and no glyph atlas, see FontAdvancesFromV0()
+    dest->font = (struct hha_font){
+        .codepointCount = src->font.codepointCount,
+        .ascent = src->font.ascent,
+        .descent = src->font.descent,
+        .lineGap = src->font.lineGap,
+        .atlasDownscale = 1,
+    };
+  } else if (IsAssetTypeIdBitmap(typeId)) {
+    // NOTE: bitmap is not in atlas
+    dest->bitmap = (struct hha_bitmap){
+        .width = src->bitmap.width,
+        .height = src->bitmap.height,
+        .alignPercentage = {src->bitmap.alignPercentage[0], src->bitmap.alignPercentage[1]},
+    };
+  } else {
+    dest->audio = src->audio;
+  }
+}
 
-  BeginAssetLock(assets);
+// reads asset at srcAssetIndex of file's asset metadata, whatever version it is
+internal void
+HHAAssetRead(struct hha_asset *dest, struct asset_file *file, u32 srcAssetIndex, u32 typeId)
+{
+  if (file->header.version == 0)
+    HHAAssetFromV0(dest, file->hhaAssetsV0 + srcAssetIndex, typeId);
+  else
+    *dest = file->hhaAssets[srcAssetIndex];
+}
 
-  for (;;) {
-    struct asset_memory_block *block = FindMemoryBlockForSize(assets, size);
-    if (block && size <= block->size) {
-      block->flags |= ASSET_MEMORY_BLOCK_USED;
+internal void
+AssetTagIndexBuild(struct game_assets *assets, struct memory_arena *arena)
+{
+  for (u32 typeId = 0; typeId < ASSET_TYPE_COUNT; typeId++) {
+    struct asset_type *type = assets->assetTypes + typeId;
+    struct asset_tag_index *index = assets->tagIndexes + typeId;
+    ZeroMemory(index, sizeof(*index));
 
-      result = (struct asset_memory_header *)(block + 1);
+    u32 assetCount = type->assetIndexOnePastLast - type->assetIndexFirst;
+    if (assetCount == 0)
+      continue;
 
-      u64 remainingSize = block->size - size;
-      u64 memoryBlockSplitThreshold = 4 * KILOBYTES;
-      if (remainingSize > memoryBlockSplitThreshold) {
-        block->size -= remainingSize;
-        InsertMemoryBlock(block, (u8 *)result + size, remainingSize);
-      }
+    index->laneCount = ALIGN4(assetCount);
+    u64 laneArraySize = sizeof(f32) * index->laneCount;
 
-      break;
-    } else { // if memory block for size NOT found
-      for (struct asset_memory_header *header = assets->loadedAssetSentiel.prev; header != &assets->loadedAssetSentiel;
-           header = header->prev) {
-        struct asset *asset = assets->assets + header->assetIndex;
-        if (asset->state < ASSET_STATE_LOADED && !HasGenerationCompleted(assets, asset->header->generationId)) {
+    f32 paddingBias = F32_MAX;
+    index->bias = MemoryArenaPushAlignment(arena, laneArraySize, 16);
+    for (u32 lane = 0; lane < index->laneCount; lane++) {
+      index->bias[lane] = lane < assetCount ? 0.0f : paddingBias;
+    }
+
+    u32 codepointTaggedCount = 0;
+    b32 isCodepointIntegral = 1;
+    u32 codepointMin = U32_MAX;
+    u32 codepointMax = 0;
+
+    for (u32 lane = 0; lane < assetCount; lane++) {
+      struct asset *asset = assets->assets + type->assetIndexFirst + lane;
+      for (u32 tagIndex = asset->hhaAsset.tagIndexFirst; tagIndex < asset->hhaAsset.tagIndexOnePastLast; tagIndex++) {
+        struct hha_tag *tag = assets->tags + tagIndex;
+        if (tag->id >= ASSET_TAG_COUNT) {
+          // TODO: notify user
+          assert(0 && "tag id is invalid");
           continue;
         }
 
-        // evict asset
-        assert(asset->state == ASSET_STATE_LOADED);
+        if (!index->values[tag->id]) {
+          index->values[tag->id] = MemoryArenaPushAlignment(arena, laneArraySize, 16);
+          index->masks[tag->id] = MemoryArenaPushAlignment(arena, laneArraySize, 16);
+          ZeroMemory(index->values[tag->id], laneArraySize);
+          ZeroMemory(index->masks[tag->id], laneArraySize);
+        }
 
-        RemoveAssetHeaderFromList(header);
+        assert(index->masks[tag->id][lane] == 0.0f && "asset has same tag more than once");
+        index->values[tag->id][lane] = tag->value;
+        index->masks[tag->id][lane] = 1.0f;
 
-        // release asset memory
-        struct asset_memory_block *block = (struct asset_memory_block *)((u8 *)header - sizeof(*block));
-        block->flags &= (u64)(~ASSET_MEMORY_BLOCK_USED);
+        if (tag->id == ASSET_TAG_UNICODE_CODEPOINT) {
+          codepointTaggedCount++;
+          if (tag->value < 0.0f || tag->value >= (f32)U32_MAX || (f32)(u32)tag->value != tag->value) {
+            isCodepointIntegral = 0;
+            continue;
+          }
 
-        if (MergeMemoryBlock(assets, block->prev, block)) {
-          block = block->prev;
+          u32 codepoint = (u32)tag->value;
+          codepointMin = Minimum(codepointMin, codepoint);
+          codepointMax = Maximum(codepointMax, codepoint);
         }
+      }
+    }
 
-        MergeMemoryBlock(assets, block, block->next);
+    // NOTE(e2dk4r): Asset without codepoint tag scores 0 on every codepoint,
+    // so direct lookup would not agree with weighted match.
+    comptime u32 codepointLookupMax = 64 * 1024;
+    if (codepointTaggedCount != assetCount || !isCodepointIntegral || codepointMax - codepointMin >= codepointLookupMax)
+      continue;
 
-        asset->state = ASSET_STATE_UNLOADED;
-        asset->header = 0;
-        break;
-      }
+    index->codepointFirst = codepointMin;
+    index->codepointCount = codepointMax - codepointMin + 1;
+    u64 codepointAssetsSize = sizeof(*index->codepointAssets) * index->codepointCount;
+    index->codepointAssets = MemoryArenaPush(arena, codepointAssetsSize);
+    ZeroMemory(index->codepointAssets, codepointAssetsSize);
+
+    for (u32 lane = 0; lane < assetCount; lane++) {
+      u32 codepoint = (u32)index->values[ASSET_TAG_UNICODE_CODEPOINT][lane];
+      u32 *assetIndex = index->codepointAssets + (codepoint - index->codepointFirst);
+      // first asset wins, like weighted match does on tie
+      if (*assetIndex == 0)
+        *assetIndex = type->assetIndexFirst + lane;
     }
   }
+}
 
-  if (result) {
-    // AddAssetHeaderToList
-    result->assetIndex = assetIndex;
-    InsertAssetHeaderToFront(assets, result);
-  }
+// translates bundles of file to asset indices in game_assets
+internal void
+AssetFileBundlesMerge(struct game_assets *assets, struct asset_file *file)
+{
+  u32 bundleCount = (u32)(file->sections[HHA_SECTION_TYPE_BUNDLES].size / sizeof(struct hha_bundle));
+  u32 bundleAssetCount = (u32)(file->sections[HHA_SECTION_TYPE_BUNDLE_ASSETS].size / sizeof(u32));
+
+  for (u32 srcBundleIndex = 0; srcBundleIndex < bundleCount; srcBundleIndex++) {
+    struct hha_bundle *srcBundle = file->hhaBundles + srcBundleIndex;
+    u32 bundleIndex = file->bundleBase + srcBundleIndex;
+    struct asset_bundle *bundle = assets->bundles + bundleIndex;
+
+    if (srcBundle->assetIndexFirst > srcBundle->assetIndexOnePastLast ||
+        srcBundle->assetIndexOnePastLast > bundleAssetCount ||
+        srcBundle->assetIndexOnePastLast - srcBundle->assetIndexFirst > HHA_BUNDLE_ASSET_COUNT_MAX) {
+      // TODO: notify user
+      assert(0 && "bundle is invalid");
+      continue;
+    }
 
-  EndAssetLock(assets);
+    b32 isValid = 1;
+    for (u32 index = srcBundle->assetIndexFirst; index < srcBundle->assetIndexOnePastLast; index++) {
+      u32 *assetIndex = file->bundleAssets + index;
+      if (*assetIndex >= file->header.assetCount || file->assetIndexMap[*assetIndex] == 0) {
+        isValid = 0;
+        break;
+      }
+      *assetIndex = file->assetIndexMap[*assetIndex];
+    }
 
-  return result;
+    if (!isValid) {
+      // TODO: notify user
+      assert(0 && "bundle must only have bitmaps");
+      continue;
+    }
+
+    bundle->assetIndexFirst = file->bundleAssetBase + srcBundle->assetIndexFirst;
+    bundle->assetIndexOnePastLast = file->bundleAssetBase + srcBundle->assetIndexOnePastLast;
+    for (u32 index = bundle->assetIndexFirst; index < bundle->assetIndexOnePastLast; index++) {
+      struct asset *asset = assets->assets + assets->bundleAssets[index];
+      asset->bundleIndex = bundleIndex;
+    }
+  }
 }
 
 inline struct game_assets *
@@ -357,7 +830,28 @@ GameAssetsAllocate(struct memory_arena *arena, memory_arena_size_t size, struct
 
   assets->tagCount = 0;
   assets->assetCount = 1;
+  assets->bundleCount = 1;
+  assets->bundleAssetCount = 0;
+
+  assets->stream.frameIndex = 0;
+  assets->stream.requestCount = 0;
+  assets->stream.requestedCount = 0;
+  assets->stream.dispatchedCount = 0;
+  assets->stream.cancelledCount = 0;
+  assets->stream.droppedCount = 0;
+
+  ZeroMemory(&assets->telemetry, sizeof(assets->telemetry));
+  assets->telemetry.memorySize = (u64)size;
 
+#if HANDMADEHERO_DEBUG
+  struct asset_trace *trace = &assets->trace;
+  trace->eventCount = 0;
+  trace->events = MemoryArenaPush(arena, sizeof(*trace->events) * ASSET_TRACE_EVENT_COUNT_MAX);
+#endif
+
+  struct platform_work_queue *queue = transientState->highPriorityQueue;
+
+  // NOTE: open all asset pack files and read their headers in parallel
   {
     struct platform_file_group fileGroup = Platform->GetAllFilesOfTypeBegin(PLATFORM_FILE_TYPE_ASSET_FILE);
     assets->fileCount = fileGroup.fileCount;
@@ -365,49 +859,57 @@ GameAssetsAllocate(struct memory_arena *arena, memory_arena_size_t size, struct
     for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
       struct asset_file *file = assets->files + fileIndex;
       file->fontBitmapIdOffset = 0;
+      file->atlasBitmapIdOffset = 0;
+      file->isReloadPending = 0;
+      file->assetTypes = 0;
+      file->hhaAssets = 0;
+      file->hhaBundles = 0;
+      file->bundleAssets = 0;
+      file->assetIndexMap = 0;
 
       file->handle = Platform->OpenNextFile(&fileGroup);
-      Platform->ReadFromFile(&file->header, &file->handle, 0, sizeof(file->header));
       if (Platform->HasFileError(&file->handle)) {
         // TODO: notify user
-        assert(0 && "file not opened or read");
-        continue;
-      }
-
-      struct hha_header *header = &file->header;
-      if (header->magic != HHA_MAGIC) {
-        // TODO: notify user
-        assert(0 && "file is not hha");
-        Platform->FileError(&file->handle, HANDMADEHERO_ERROR_FILE_IS_NOT_HHA);
+        assert(0 && "file not opened");
         continue;
       }
 
-      if (header->version > HHA_VERSION) {
-        // TODO: notify user
-        assert(0 && "not supported version");
-        Platform->FileError(&file->handle, HANDMADEHERO_ERROR_HHA_VERSION_IS_NOT_SUPPORTED);
-        continue;
-      }
+      Platform->WorkQueueAddEntry(queue, DoLoadAssetFileHeaderWork, file);
+    }
 
-      u64 assetTypeArraySize = sizeof(*file->assetTypes) * file->header.assetTypeCount;
-      file->assetTypes = MemoryArenaPush(arena, assetTypeArraySize);
-      Platform->ReadFromFile(file->assetTypes, &file->handle, file->header.assetTypesOffset, assetTypeArraySize);
+    Platform->WorkQueueCompleteAllWork(queue);
+    Platform->GetAllFilesOfTypeEnd(&fileGroup);
+  }
 
-      file->tagBase = assets->tagCount;
+  // NOTE: allocate memory for all metadatas from asset pack files
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    struct asset_file *file = assets->files + fileIndex;
 
-      assets->tagCount += header->tagCount;
-      // NOTE: First asset is always null (reserved) asset.
-      assets->assetCount += header->assetCount - 1;
+    if (Platform->HasFileError(&file->handle)) {
+      continue;
     }
 
-    Platform->GetAllFilesOfTypeEnd(&fileGroup);
+    struct hha_header *header = &file->header;
+    file->assetTypes = MemoryArenaPush(arena, sizeof(*file->assetTypes) * header->assetTypeCount);
+
+    file->tagBase = assets->tagCount;
+    file->bundleBase = assets->bundleCount;
+    file->bundleAssetBase = assets->bundleAssetCount;
+
+    assets->tagCount += header->tagCount;
+    // NOTE: First asset is always null (reserved) asset.
+    assets->assetCount += header->assetCount - 1;
+    assets->bundleCount += (u32)(file->sections[HHA_SECTION_TYPE_BUNDLES].size / sizeof(struct hha_bundle));
+    assets->bundleAssetCount += (u32)(file->sections[HHA_SECTION_TYPE_BUNDLE_ASSETS].size / sizeof(u32));
   }
 
-  // NOTE: allocate memory for all metadatas from asset pack files
   assets->tags = MemoryArenaPush(arena, sizeof(*assets->tags) * assets->tagCount);
   assets->assets = MemoryArenaPush(arena, sizeof(*assets->assets) * assets->assetCount);
+  assets->bundles = MemoryArenaPush(arena, sizeof(*assets->bundles) * assets->bundleCount);
+  assets->bundleAssets = MemoryArenaPush(arena, sizeof(*assets->bundleAssets) * assets->bundleAssetCount);
 
-  // NOTE: load tags
+  // NOTE: read asset types, tags and assets of every file as one batch
+  struct memory_temp temp = BeginTemporaryMemory(&transientState->transientArena);
   for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
     struct asset_file *file = assets->files + fileIndex;
 
@@ -415,78 +917,312 @@ GameAssetsAllocate(struct memory_arena *arena, memory_arena_size_t size, struct
       continue;
     }
 
-    struct hha_header *header = &file->header;
-    struct hha_tag *dest = assets->tags + file->tagBase;
-    u64 tagArraySize = header->tagCount * sizeof(*dest);
-    Platform->ReadFromFile(dest, &file->handle, header->tagsOffset, tagArraySize);
+    file->tags = assets->tags + file->tagBase;
+    // NOTE: assets metadata is only needed while merging
+    file->hhaAssets = MemoryArenaPush(temp.arena, file->sections[HHA_SECTION_TYPE_ASSETS].size);
+    file->hhaBundles = MemoryArenaPush(temp.arena, file->sections[HHA_SECTION_TYPE_BUNDLES].size);
+    file->bundleAssets = assets->bundleAssets + file->bundleAssetBase;
+
+    u64 assetIndexMapSize = sizeof(*file->assetIndexMap) * file->header.assetCount;
+    file->assetIndexMap = MemoryArenaPush(temp.arena, assetIndexMapSize);
+    ZeroMemory(file->assetIndexMap, assetIndexMapSize);
+    Platform->WorkQueueAddEntry(queue, DoLoadAssetFileMetadataWork, file);
   }
+  Platform->WorkQueueCompleteAllWork(queue);
+
+  // NOTE: files whose metadata could not be read are not merged, so their tags and bundles are dropped and
+  // following files are moved down. Counts then only cover what is merged.
+  assets->tagCount = 0;
+  assets->assetCount = 1;
+  assets->bundleCount = 1;
+  assets->bundleAssetCount = 0;
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    struct asset_file *file = assets->files + fileIndex;
 
-  // TODO: Fast loading 100+ asset pack files
+    if (Platform->HasFileError(&file->handle)) {
+      continue;
+    }
+
+    struct hha_header *header = &file->header;
+    u32 bundleAssetCount = (u32)(file->sections[HHA_SECTION_TYPE_BUNDLE_ASSETS].size / sizeof(u32));
+    if (file->tagBase != assets->tagCount) {
+      file->tagBase = assets->tagCount;
+      __builtin_memmove(assets->tags + file->tagBase, file->tags, sizeof(*file->tags) * header->tagCount);
+      file->tags = assets->tags + file->tagBase;
+    }
+    if (file->bundleAssetBase != assets->bundleAssetCount) {
+      file->bundleAssetBase = assets->bundleAssetCount;
+      __builtin_memmove(assets->bundleAssets + file->bundleAssetBase, file->bundleAssets,
+                        sizeof(*file->bundleAssets) * bundleAssetCount);
+      file->bundleAssets = assets->bundleAssets + file->bundleAssetBase;
+    }
+    file->bundleBase = assets->bundleCount;
+
+    assets->tagCount += header->tagCount;
+    assets->assetCount += header->assetCount - 1;
+    assets->bundleCount += (u32)(file->sections[HHA_SECTION_TYPE_BUNDLES].size / sizeof(struct hha_bundle));
+    assets->bundleAssetCount += bundleAssetCount;
+  }
 
   // NOTE: merge asset pack files
-  u32 assetCount = 0;
+  // Asset types are laid out in type order, and inside a type in file order.
+  u32 assetCountForTypes[ASSET_TYPE_COUNT] = {};
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    struct asset_file *file = assets->files + fileIndex;
+
+    if (Platform->HasFileError(&file->handle)) {
+      continue;
+    }
+
+    for (u32 srcIndex = 0; srcIndex < file->header.assetTypeCount; srcIndex++) {
+      struct hha_asset_type *srcType = file->assetTypes + srcIndex;
+      if (srcType->typeId >= ASSET_TYPE_COUNT || srcType->assetIndexFirst > srcType->assetIndexOnePastLast ||
+          srcType->assetIndexOnePastLast > file->header.assetCount) {
+        // TODO: notify user
+        assert(0 && "asset type is invalid");
+        continue;
+      }
+
+      assetCountForTypes[srcType->typeId] += srcType->assetIndexOnePastLast - srcType->assetIndexFirst;
+    }
+  }
 
   // first asset is always null
   struct asset *firstAsset = assets->assets + 0;
   ZeroMemory(firstAsset, sizeof(*firstAsset));
-  assetCount++;
 
+  // first bundle is always null, bundles of files that cannot be read stay empty
+  ZeroMemory(assets->bundles, sizeof(*assets->bundles) * assets->bundleCount);
+
+  u32 assetCount = 1;
+  u32 nextAssetIndexForTypes[ASSET_TYPE_COUNT];
   for (u32 destAssetTypeId = 0; destAssetTypeId < ASSET_TYPE_COUNT; destAssetTypeId++) {
     struct asset_type *destType = assets->assetTypes + destAssetTypeId;
     destType->assetIndexFirst = assetCount;
+    assetCount += assetCountForTypes[destAssetTypeId];
+    destType->assetIndexOnePastLast = assetCount;
 
-    for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
-      struct asset_file *file = assets->files + fileIndex;
+    nextAssetIndexForTypes[destAssetTypeId] = destType->assetIndexFirst;
+  }
 
-      if (Platform->HasFileError(&file->handle)) {
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    struct asset_file *file = assets->files + fileIndex;
+
+    if (Platform->HasFileError(&file->handle)) {
+      continue;
+    }
+
+    for (u32 srcIndex = 0; srcIndex < file->header.assetTypeCount; srcIndex++) {
+      struct hha_asset_type *srcType = file->assetTypes + srcIndex;
+      if (srcType->typeId >= ASSET_TYPE_COUNT || srcType->assetIndexFirst > srcType->assetIndexOnePastLast ||
+          srcType->assetIndexOnePastLast > file->header.assetCount) {
         continue;
       }
 
-      struct hha_header *header = &file->header;
+      u32 *nextAssetIndex = nextAssetIndexForTypes + srcType->typeId;
+      if (srcType->typeId == ASSET_TYPE_FONT_GLYPH) {
+        file->fontBitmapIdOffset = *nextAssetIndex - srcType->assetIndexFirst;
+      } else if (srcType->typeId == ASSET_TYPE_ATLAS) {
+        file->atlasBitmapIdOffset = *nextAssetIndex - srcType->assetIndexFirst;
+      }
 
-      for (u32 srcIndex = 0; srcIndex < file->header.assetTypeCount; srcIndex++) {
-        struct hha_asset_type *srcType = file->assetTypes + srcIndex;
-        if (srcType->typeId == destAssetTypeId) {
-          if (srcType->typeId == ASSET_TYPE_FONT_GLYPH) {
-            file->fontBitmapIdOffset = assetCount - srcType->assetIndexFirst;
-          }
+      for (u32 srcAssetIndex = srcType->assetIndexFirst; srcAssetIndex < srcType->assetIndexOnePastLast;
+           srcAssetIndex++) {
+        assert(*nextAssetIndex < assets->assetCount);
+        struct asset *asset = assets->assets + *nextAssetIndex;
+
+        // TODO: validate hhaAsset
+
+        asset->fileIndex = fileIndex;
+        asset->fileAssetIndex = srcAssetIndex;
+        asset->bundleIndex = 0;
+        asset->requestIndex = 0;
+        if (IsAssetTypeIdBitmap(srcType->typeId))
+          file->assetIndexMap[srcAssetIndex] = *nextAssetIndex;
+        HHAAssetRead(&asset->hhaAsset, file, srcAssetIndex, srcType->typeId);
+        asset->hhaAsset.tagIndexFirst += file->tagBase;
+        asset->hhaAsset.tagIndexOnePastLast += file->tagBase;
+
+        (*nextAssetIndex)++;
+      }
+    }
+
+    AssetFileBundlesMerge(assets, file);
+
+    file->hhaAssets = 0;
+    file->hhaBundles = 0;
+    file->bundleAssets = 0;
+    file->assetIndexMap = 0;
+  }
+
+  EndTemporaryMemory(&temp);
+
+  assert(assetCount == assets->assetCount && "missing assets");
+
+  AssetTagIndexBuild(assets, arena);
+
+  return assets;
+}
+
+// NOTE(e2dk4r): asset indices are assigned by layout, so it cannot change in place
+internal b32
+IsAssetFileHeaderSame(struct asset_file *file, struct asset_file *newFile)
+{
+  struct hha_header *header = &file->header;
+  struct hha_header *newHeader = &newFile->header;
+  if (newHeader->tagCount != header->tagCount || newHeader->assetCount != header->assetCount ||
+      newHeader->assetTypeCount != header->assetTypeCount)
+    return 0;
+
+  // bundles are translated into game_assets when merged, so they are compared by checksum
+  enum hha_section_type bundleSectionTypes[] = {HHA_SECTION_TYPE_BUNDLES, HHA_SECTION_TYPE_BUNDLE_ASSETS};
+  for (u32 index = 0; index < ARRAY_COUNT(bundleSectionTypes); index++) {
+    struct hha_section *section = file->sections + bundleSectionTypes[index];
+    struct hha_section *newSection = newFile->sections + bundleSectionTypes[index];
+    if (newSection->size != section->size || newSection->checksum != section->checksum)
+      return 0;
+  }
+
+  return 1;
+}
+
+void
+AssetFilesReload(struct game_assets *assets)
+{
+  struct transient_state *transientState = assets->transientState;
+
+  // NOTE(e2dk4r): assets are visited in same order GameAssetsAllocate merged them
+  u32 nextAssetIndexForTypes[ASSET_TYPE_COUNT];
+  for (u32 typeId = 0; typeId < ASSET_TYPE_COUNT; typeId++) {
+    nextAssetIndexForTypes[typeId] = assets->assetTypes[typeId].assetIndexFirst;
+  }
+
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    struct asset_file *file = assets->files + fileIndex;
+
+    if (Platform->HasFileError(&file->handle)) {
+      continue;
+    }
+
+    struct memory_temp temp = BeginTemporaryMemory(&transientState->transientArena);
+
+    struct asset_file *newFile = MemoryArenaPush(temp.arena, sizeof(*newFile));
+    *newFile = *file;
+    newFile->handle = Platform->ReopenFile(&file->handle);
+    if (!Platform->HasFileError(&newFile->handle))
+      DoLoadAssetFileHeaderWork(0, newFile);
+
+    struct hha_header *header = &file->header;
+    b32 isLayoutSame = !Platform->HasFileError(&newFile->handle) && IsAssetFileHeaderSame(file, newFile);
+    if (isLayoutSame) {
+      newFile->assetTypes = MemoryArenaPush(temp.arena, sizeof(*newFile->assetTypes) * header->assetTypeCount);
+      newFile->tags = MemoryArenaPush(temp.arena, sizeof(*newFile->tags) * header->tagCount);
+      newFile->hhaAssets = MemoryArenaPush(temp.arena, newFile->sections[HHA_SECTION_TYPE_ASSETS].size);
+      newFile->hhaBundles = MemoryArenaPush(temp.arena, newFile->sections[HHA_SECTION_TYPE_BUNDLES].size);
+      newFile->bundleAssets = MemoryArenaPush(temp.arena, newFile->sections[HHA_SECTION_TYPE_BUNDLE_ASSETS].size);
+      DoLoadAssetFileMetadataWork(0, newFile);
+
+      isLayoutSame =
+          !Platform->HasFileError(&newFile->handle) &&
+          __builtin_memcmp(newFile->assetTypes, file->assetTypes,
+                           sizeof(*file->assetTypes) * header->assetTypeCount) == 0 &&
+          __builtin_memcmp(newFile->tags, assets->tags + file->tagBase, sizeof(*file->tags) * header->tagCount) == 0;
+    }
+
+    file->isReloadPending = !isLayoutSame;
+    if (isLayoutSame) {
+      /* NOTE(e2dk4r): Nothing is reading from old file. Caller completed work
+       * queue, and only game thread queues loads, mixer sends its loads
+       * through load request ring. So no load is queued until reload is done.
+       */
+      Platform->CloseFile(&file->handle);
+      file->handle = newFile->handle;
+      file->header = newFile->header;
+      __builtin_memcpy(file->sections, newFile->sections, sizeof(file->sections));
+    } else {
+      Platform->CloseFile(&newFile->handle);
+    }
+
+    /* NOTE(e2dk4r): Loaded data and metadata of asset must agree, fonts and
+     * atlas regions are read from both. Changed asset is evicted before its
+     * metadata is replaced, while nothing uses either.
+     */
+    if (isLayoutSame)
+      BeginAssetLockNoGeneration(assets);
+
+    for (u32 srcIndex = 0; srcIndex < header->assetTypeCount; srcIndex++) {
+      struct hha_asset_type *srcType = file->assetTypes + srcIndex;
+      if (srcType->typeId >= ASSET_TYPE_COUNT || srcType->assetIndexFirst > srcType->assetIndexOnePastLast ||
+          srcType->assetIndexOnePastLast > header->assetCount) {
+        continue;
+      }
+
+      u32 *nextAssetIndex = nextAssetIndexForTypes + srcType->typeId;
+      for (u32 srcAssetIndex = srcType->assetIndexFirst; srcAssetIndex < srcType->assetIndexOnePastLast;
+           srcAssetIndex++) {
+        assert(*nextAssetIndex < assets->assetCount);
+        struct asset *asset = assets->assets + *nextAssetIndex;
+        (*nextAssetIndex)++;
+
+        if (!isLayoutSame)
+          continue;
 
-          u32 assetCountForType = srcType->assetIndexOnePastLast - srcType->assetIndexFirst;
+        struct hha_asset hhaAsset;
+        HHAAssetRead(&hhaAsset, newFile, srcAssetIndex, srcType->typeId);
+        hhaAsset.tagIndexFirst += file->tagBase;
+        hhaAsset.tagIndexOnePastLast += file->tagBase;
 
-          // read assets metadata from file into temporary structure
-          struct hha_asset *hhaAssets;
-          u64 firstOffset = header->assetsOffset + (srcType->assetIndexFirst * sizeof(*hhaAssets));
-          u64 assetArraySize = assetCountForType * sizeof(*hhaAssets);
-          struct memory_temp temp = BeginTemporaryMemory(&transientState->transientArena);
-          hhaAssets = MemoryArenaPush(temp.arena, assetArraySize);
-          Platform->ReadFromFile(hhaAssets, &file->handle, firstOffset, assetArraySize);
+        if (__builtin_memcmp(&asset->hhaAsset, &hhaAsset, sizeof(hhaAsset)) == 0)
+          continue;
 
-          for (u32 assetIndex = 0; assetIndex < assetCountForType; assetIndex++) {
-            assert(assetCount < assets->assetCount);
-            struct hha_asset *hhaAsset = hhaAssets + assetIndex;
-            struct asset *asset = assets->assets + assetCount;
+        // no load is queued, see above
+        assert(asset->state != ASSET_STATE_QUEUED);
+        if (asset->state == ASSET_STATE_LOADED)
+          EvictAsset(assets, asset);
+        asset->hhaAsset = hhaAsset;
+      }
+    }
 
-            // TODO: validate hhaAsset
+    if (isLayoutSame)
+      EndAssetLock(assets);
 
-            asset->fileIndex = fileIndex;
-            asset->hhaAsset = *hhaAsset;
-            asset->hhaAsset.tagIndexFirst += file->tagBase;
-            asset->hhaAsset.tagIndexOnePastLast += file->tagBase;
+    EndTemporaryMemory(&temp);
+  }
 
-            assetCount++;
-          }
+  /* NOTE(e2dk4r): Asset indices are assigned by layout of all packs, so
+   * assets of new packs cannot be merged in while game runs. They are
+   * reported with packs whose layout changed, and are loaded on restart.
+   */
+  u32 reloadPendingFileCount = 0;
+  struct platform_file_group fileGroup = Platform->GetAllFilesOfTypeBegin(PLATFORM_FILE_TYPE_ASSET_FILE);
+  for (u32 groupFileIndex = 0; groupFileIndex < fileGroup.fileCount; groupFileIndex++) {
+    struct platform_file_handle handle = Platform->OpenNextFile(&fileGroup);
+    if (Platform->HasFileError(&handle)) {
+      Platform->CloseFile(&handle);
+      continue;
+    }
 
-          EndTemporaryMemory(&temp);
-        }
+    // NOTE(e2dk4r): packs are matched by path, renamed pack is new one
+    b32 isNew = 1;
+    for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+      struct asset_file *file = assets->files + fileIndex;
+      if (!Platform->HasFileError(&file->handle) && Platform->IsSameFile(&handle, &file->handle)) {
+        isNew = 0;
+        break;
       }
     }
+    if (isNew)
+      reloadPendingFileCount++;
 
-    destType->assetIndexOnePastLast = assetCount;
+    Platform->CloseFile(&handle);
   }
+  Platform->GetAllFilesOfTypeEnd(&fileGroup);
 
-  assert(assetCount == assets->assetCount && "missing assets");
-
-  return assets;
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    if (assets->files[fileIndex].isReloadPending)
+      reloadPendingFileCount++;
+  }
+  assets->telemetry.reloadPendingFileCount = reloadPendingFileCount;
 }
 
 u32
@@ -544,28 +1280,204 @@ RandomAudio(struct random_series *series, struct game_assets *assets, enum asset
 }
 
 struct load_asset_work {
-  struct platform_file_handle *handle;
+  struct game_assets *assets;
+  struct asset_file *file;
   void *dest;
   u64 offset;
   u64 size;
+  // size of memory at dest, bigger than size when asset is compressed
+  u64 capacity;
 
   struct asset *asset;
   enum asset_state finalState;
   struct task_with_memory *task;
+  // glyph views are setup after font is loaded, 0 for other assets
+  struct font *font;
 };
 
+// NOTE(e2dk4r): Compressed data is read to end of asset memory and
+// decompressed in place, so it needs a little more memory than its size.
+internal u32
+AssetDataCapacity(struct hha_asset *info, u32 dataSize)
+{
+  u32 capacity = dataSize;
+  if (info->codec == HHA_CODEC_LZ)
+    capacity += (u32)LzInPlaceMargin(dataSize);
+  return capacity;
+}
+
+internal b32
+IsAssetDataSizeValid(struct hha_asset *info, u64 size, u64 capacity)
+{
+  switch ((enum hha_codec)info->codec) {
+  case HHA_CODEC_NONE:
+    return info->dataSize == size;
+  case HHA_CODEC_LZ:
+    return info->dataSize <= capacity;
+  default:
+    return 0;
+  }
+}
+
+// NOTE: size and checksum of data are unknown in version 0
+internal inline b32
+IsAssetDataVerified(struct load_asset_work *work)
+{
+  return work->file->header.version >= 1;
+}
+
+// size of asset's data in file
+internal inline u64
+AssetDataStoredSize(struct load_asset_work *work)
+{
+  return IsAssetDataVerified(work) ? work->asset->hhaAsset.dataSize : work->size;
+}
+
+/*
+ * Verifies data read from file and puts it into dest, decompressing when
+ * needed. data is either at end of dest or somewhere else in memory.
+ */
+internal b32
+AssetDataUnpack(struct load_asset_work *work, u8 *data, u64 dataSize)
+{
+  struct hha_asset *info = &work->asset->hhaAsset;
+
+  if (IsAssetDataVerified(work) && info->dataChecksum != Crc32c(data, dataSize)) {
+    // TODO: notify user
+    assert(0 && "asset data is corrupted");
+    return 0;
+  }
+
+  switch ((enum hha_codec)info->codec) {
+  case HHA_CODEC_NONE: {
+    if (data != work->dest)
+      __builtin_memcpy(work->dest, data, work->size);
+  } break;
+
+  case HHA_CODEC_LZ: {
+    b32 isDecompressed;
+    if (data == (u8 *)work->dest + work->capacity - dataSize)
+      isDecompressed = LzDecompressInPlace(work->dest, work->capacity, work->size, dataSize);
+    else
+      isDecompressed = LzDecompress(work->dest, work->size, data, dataSize);
+
+    if (!isDecompressed) {
+      // TODO: notify user
+      assert(0 && "asset data cannot be decompressed");
+      return 0;
+    }
+  } break;
+  }
+
+  return 1;
+}
+
+// NOTE(e2dk4r): called from worker threads
+internal void
+AssetLoadFinish(struct load_asset_work *work, u64 loadedBytes)
+{
+  struct game_assets *assets = work->assets;
+  struct asset_telemetry *telemetry = &assets->telemetry;
+  AtomicFetchAdd(&telemetry->total.loadCount, 1);
+  AtomicFetchAdd(&telemetry->total.loadedBytes, loadedBytes);
+
+  u32 latency = AtomicLoad(&assets->stream.frameIndex) - work->asset->requestFrameIndex;
+  u32 bucket = 0;
+  if (latency > 0)
+    bucket = Minimum(32 - (u32)__builtin_clz(latency), ASSET_LATENCY_BUCKET_COUNT - 1);
+  AtomicFetchAdd(&telemetry->loadLatencies[bucket], 1);
+
+#if HANDMADEHERO_DEBUG
+  struct asset_trace *trace = &assets->trace;
+  u32 eventIndex = AtomicFetchAdd(&trace->eventCount, 1);
+  if (eventIndex < ASSET_TRACE_EVENT_COUNT_MAX) {
+    trace->events[eventIndex] = (struct asset_trace_event){
+        .frameIndex = work->asset->requestFrameIndex,
+        .assetIndex = (u32)(work->asset - assets->assets),
+    };
+  }
+#endif
+
+  AtomicStore(&work->asset->state, work->finalState);
+}
+
+// NOTE(e2dk4r): called from worker threads, after data of font is loaded
+/* NOTE(e2dk4r): Font of version 0 has advance of every pair in
+ * horizontalAdvanceTable[codepointCount][codepointCount]. Advance of pair
+ * with codepoint 0 has no kerning, so it is the advance of previous
+ * codepoint. It is moved to front of table in place, kernings are dropped.
+ */
+internal void
+FontAdvancesFromV0(struct font *font, struct hha_font *fontInfo)
+{
+  u32 codepointCount = fontInfo->codepointCount;
+  f32 *horizontalAdvanceTable = font->horizontalAdvances;
+  for (u32 codepoint = 0; codepoint < codepointCount; codepoint++)
+    font->horizontalAdvances[codepoint] = horizontalAdvanceTable[codepoint * codepointCount];
+}
+
+internal void
+FontGlyphBitmapsSetup(struct font *font, struct hha_font *fontInfo)
+{
+  if (!font->glyphBitmaps)
+    return;
+
+  u32 atlasWidth = fontInfo->atlasWidth;
+  u32 atlasHeight = fontInfo->atlasHeight;
+  s32 stride = (s32)(atlasWidth * BITMAP_BYTES_PER_PIXEL);
+  u8 *atlasPixels = (u8 *)(font->glyphs + fontInfo->codepointCount);
+
+  for (u32 codepoint = 0; codepoint < fontInfo->codepointCount; codepoint++) {
+    struct hha_font_glyph *glyph = font->glyphs + codepoint;
+    struct bitmap *bitmap = font->glyphBitmaps + codepoint;
+
+    u32 glyphWidth = glyph->width;
+    u32 glyphHeight = glyph->height;
+    if (glyphWidth == 0 || glyphHeight == 0 || glyph->x + glyphWidth > atlasWidth ||
+        glyph->y + glyphHeight > atlasHeight) {
+      ZeroMemory(bitmap, sizeof(*bitmap));
+      continue;
+    }
+
+    bitmap->width = glyphWidth;
+    bitmap->height = glyphHeight;
+    bitmap->stride = stride;
+    bitmap->memory = atlasPixels + (s64)glyph->y * stride + (s64)glyph->x * BITMAP_BYTES_PER_PIXEL;
+    bitmap->widthOverHeight = (f32)glyphWidth / (f32)glyphHeight;
+    bitmap->alignPercentage = v2(glyph->alignPercentage[0], glyph->alignPercentage[1]);
+  }
+}
+
 internal void
 LoadAssetWork(struct load_asset_work *work)
 {
   struct asset *asset = work->asset;
+  struct asset_file *file = work->file;
+
+  if (IsAssetDataVerified(work) && !IsAssetDataSizeValid(&asset->hhaAsset, work->size, work->capacity)) {
+    // TODO: notify user
+    assert(0 && "asset data size is invalid");
+    ZeroMemory(work->dest, work->size);
+    AssetLoadFinish(work, 0);
+    return;
+  }
 
-  Platform->ReadFromFile(work->dest, work->handle, work->offset, work->size);
+  u64 dataSize = AssetDataStoredSize(work);
+  u8 *data = (u8 *)work->dest + work->capacity - dataSize;
+  Platform->ReadFromFile(data, &file->handle, work->offset, dataSize);
 
-  if (Platform->HasFileError(work->handle)) {
+  b32 isValid = !Platform->HasFileError(&file->handle) && AssetDataUnpack(work, data, dataSize);
+  if (!isValid) {
     ZeroMemory(work->dest, work->size);
   }
 
-  AtomicStore(&asset->state, work->finalState);
+  if (work->font) {
+    if (file->header.version == 0)
+      FontAdvancesFromV0(work->font, &asset->hhaAsset.font);
+    FontGlyphBitmapsSetup(work->font, &asset->hhaAsset.font);
+  }
+
+  AssetLoadFinish(work, dataSize);
 }
 
 internal void
@@ -576,11 +1488,61 @@ DoLoadAssetWork(struct platform_work_queue *queue, void *data)
   EndTaskWithMemory(work->task);
 }
 
-internal inline void
+// acquires memory for bitmap and sets up work that fills it
+internal void
+BitmapSetup(struct game_assets *assets, u32 assetIndex, struct load_asset_work *work)
+{
+  struct asset *asset = assets->assets + assetIndex;
+
+  // setup header
+  struct hha_asset *info = &asset->hhaAsset;
+  assert(info->dataOffset && "asset not setup properly");
+  struct hha_bitmap *bitmapInfo = &info->bitmap;
+
+  u32 width = bitmapInfo->width;
+  u32 height = bitmapInfo->height;
+  s32 stride = (s32)(width * BITMAP_BYTES_PER_PIXEL);
+
+  struct asset_memory_size size = {};
+  size.section = (u16)stride;
+  size.data = height * size.section;
+  size.total = AssetDataCapacity(info, size.data) + sizeof(*asset->header);
+
+  asset->header = AcquireAssetMemory(assets, size.total, assetIndex);
+  void *memory = (asset->header + 1);
+
+  // setup bitmap
+  struct bitmap *bitmap = &asset->header->bitmap;
+  bitmap->width = width;
+  bitmap->height = height;
+  bitmap->stride = stride;
+  bitmap->memory = memory;
+
+  bitmap->widthOverHeight = (f32)bitmap->width / (f32)bitmap->height;
+  bitmap->alignPercentage = v2(bitmapInfo->alignPercentage[0], bitmapInfo->alignPercentage[1]);
+
+  // setup work
+  work->assets = assets;
+  work->file = AssetFileGet(assets, asset->fileIndex);
+  work->dest = bitmap->memory;
+  work->offset = info->dataOffset;
+  work->size = size.data;
+  work->capacity = size.total - sizeof(*asset->header);
+
+  work->task = 0;
+  work->asset = asset;
+  work->finalState = ASSET_STATE_LOADED;
+  work->font = 0;
+}
+
+// returns 0 when load is refused for lack of task memory
+internal inline b32
 _BitmapLoad(struct game_assets *assets, struct bitmap_id id, b32 immediate)
 {
   if (id.value == 0)
-    return;
+    return 1;
+
+  id = BitmapAtlasResolve(assets, id);
 
   struct asset *asset = assets->assets + id.value;
 
@@ -594,47 +1556,13 @@ _BitmapLoad(struct game_assets *assets, struct bitmap_id id, b32 immediate)
       if (!task) {
         // memory cannot obtained, revert back
         AtomicStore(&asset->state, ASSET_STATE_UNLOADED);
-        return;
+        return 0;
       }
     }
 
-    // setup header
-    struct hha_asset *info = &asset->hhaAsset;
-    assert(info->dataOffset && "asset not setup properly");
-    struct hha_bitmap *bitmapInfo = &info->bitmap;
-
-    u32 width = bitmapInfo->width;
-    u32 height = bitmapInfo->height;
-    s32 stride = (s32)(width * BITMAP_BYTES_PER_PIXEL);
-
-    struct asset_memory_size size = {};
-    size.section = (u16)stride;
-    size.data = height * size.section;
-    size.total = size.data + sizeof(*asset->header);
-
-    asset->header = AcquireAssetMemory(assets, size.total, id.value);
-    void *memory = (asset->header + 1);
-
-    // setup bitmap
-    struct bitmap *bitmap = &asset->header->bitmap;
-    bitmap->width = width;
-    bitmap->height = height;
-    bitmap->stride = stride;
-    bitmap->memory = memory;
-
-    bitmap->widthOverHeight = (f32)bitmap->width / (f32)bitmap->height;
-    bitmap->alignPercentage = v2(bitmapInfo->alignPercentage[0], bitmapInfo->alignPercentage[1]);
-
-    // setup work
     struct load_asset_work work = {};
-    work.handle = AssetFileHandleGet(assets, asset->fileIndex);
-    work.dest = bitmap->memory;
-    work.offset = info->dataOffset;
-    work.size = size.data;
-
+    BitmapSetup(assets, id.value, &work);
     work.task = task;
-    work.asset = asset;
-    work.finalState = ASSET_STATE_LOADED;
 
     if (immediate) {
       LoadAssetWork(&work);
@@ -657,12 +1585,14 @@ _BitmapLoad(struct game_assets *assets, struct bitmap_id id, b32 immediate)
     while (*state == ASSET_STATE_QUEUED)
       ;
   }
+
+  return 1;
 }
 
 inline void
 BitmapLoad(struct game_assets *assets, struct bitmap_id id)
 {
-  _BitmapLoad(assets, id, 0);
+  BitmapRequest(assets, id, ASSET_PRIORITY_NOW);
 }
 
 inline void
@@ -671,10 +1601,360 @@ BitmapLoadImmediate(struct game_assets *assets, struct bitmap_id id)
   _BitmapLoad(assets, id, 1);
 }
 
+internal void
+AssetRequestRemove(struct game_assets *assets, u32 requestIndex)
+{
+  struct asset_stream *stream = &assets->stream;
+  assert(requestIndex < stream->requestCount);
+
+  struct asset_request *request = stream->requests + requestIndex;
+  assets->assets[request->assetIndex].requestIndex = 0;
+
+  // move last request into its place
+  stream->requestCount--;
+  if (requestIndex != stream->requestCount) {
+    *request = stream->requests[stream->requestCount];
+    assets->assets[request->assetIndex].requestIndex = requestIndex + 1;
+  }
+}
+
+inline void
+BitmapRequest(struct game_assets *assets, struct bitmap_id id, f32 priority)
+{
+  if (id.value == 0)
+    return;
+
+  assert(id.value < assets->assetCount);
+  id = BitmapAtlasResolve(assets, id);
+  struct asset *asset = assets->assets + id.value;
+  if (asset->state != ASSET_STATE_UNLOADED)
+    return;
+
+  struct asset_stream *stream = &assets->stream;
+  struct asset_request *request;
+  if (asset->requestIndex) {
+    request = stream->requests + asset->requestIndex - 1;
+    // NOTE(e2dk4r): most urgent request in frame wins, priority from earlier
+    // frames is replaced
+    if (request->frameIndex == stream->frameIndex && request->priority <= priority)
+      return;
+  } else {
+    if (stream->requestCount == ARRAY_COUNT(stream->requests)) {
+      u32 leastUrgentIndex = 0;
+      for (u32 requestIndex = 1; requestIndex < stream->requestCount; requestIndex++) {
+        if (stream->requests[requestIndex].priority > stream->requests[leastUrgentIndex].priority)
+          leastUrgentIndex = requestIndex;
+      }
+
+      if (stream->requests[leastUrgentIndex].priority <= priority) {
+        stream->droppedCount++;
+        return;
+      }
+      AssetRequestRemove(assets, leastUrgentIndex);
+      stream->cancelledCount++;
+    }
+
+    request = stream->requests + stream->requestCount;
+    request->assetIndex = id.value;
+    stream->requestCount++;
+    asset->requestIndex = stream->requestCount;
+    asset->requestFrameIndex = stream->frameIndex;
+    stream->requestedCount++;
+  }
+
+  request->priority = priority;
+  request->frameIndex = stream->frameIndex;
+}
+
+inline void
+BitmapPrefetch(struct game_assets *assets, struct bitmap_id id, f32 secondsUntilVisible)
+{
+  BitmapRequest(assets, id, ASSET_PRIORITY_PREFETCH + Maximum(secondsUntilVisible, 0.0f));
+}
+
 inline void
-BitmapPrefetch(struct game_assets *assets, struct bitmap_id id)
+AssetStreamUpdate(struct game_assets *assets)
+{
+  struct asset_stream *stream = &assets->stream;
+
+  for (u32 requestIndex = 0; requestIndex < stream->requestCount; /* handled in body */) {
+    struct asset_request *request = stream->requests + requestIndex;
+    struct asset *asset = assets->assets + request->assetIndex;
+
+    // loaded some other way, like immediately or with its bundle
+    if (asset->state != ASSET_STATE_UNLOADED) {
+      AssetRequestRemove(assets, requestIndex);
+      continue;
+    }
+
+    // not needed anymore, like when camera moved away
+    if (request->frameIndex != stream->frameIndex) {
+      AssetRequestRemove(assets, requestIndex);
+      stream->cancelledCount++;
+      continue;
+    }
+
+    requestIndex++;
+  }
+
+  // NOTE(e2dk4r): Work queue runs loads in order they are added, so only few
+  // are given to it. Rest wait here where they can still be reordered.
+  struct task_pool *taskPool = &assets->transientState->taskPool;
+  while (stream->requestCount > 0 && AtomicLoad(&taskPool->usedCount) < ASSET_STREAM_IN_FLIGHT_MAX) {
+    u32 mostUrgentIndex = 0;
+    for (u32 requestIndex = 1; requestIndex < stream->requestCount; requestIndex++) {
+      if (stream->requests[requestIndex].priority < stream->requests[mostUrgentIndex].priority)
+        mostUrgentIndex = requestIndex;
+    }
+
+    struct bitmap_id id = {stream->requests[mostUrgentIndex].assetIndex};
+    if (!_BitmapLoad(assets, id, 0))
+      break;
+
+    AssetRequestRemove(assets, mostUrgentIndex);
+    stream->dispatchedCount++;
+  }
+
+  AtomicStore(&stream->frameIndex, stream->frameIndex + 1);
+}
+
+void
+AssetTelemetryEndFrame(struct game_assets *assets, u32 missingResourceCount)
+{
+  struct asset_telemetry *telemetry = &assets->telemetry;
+
+  BeginAssetLock(assets);
+  telemetry->total.missingResourceCount += missingResourceCount;
+  struct asset_counters total = telemetry->total;
+  EndAssetLock(assets);
+
+  struct asset_counters *frameStart = &telemetry->frameStart;
+  telemetry->lastFrame = (struct asset_counters){
+      .hitCount = total.hitCount - frameStart->hitCount,
+      .missCount = total.missCount - frameStart->missCount,
+      .loadCount = total.loadCount - frameStart->loadCount,
+      .loadedBytes = total.loadedBytes - frameStart->loadedBytes,
+      .evictionCount = total.evictionCount - frameStart->evictionCount,
+      .evictedBytes = total.evictedBytes - frameStart->evictedBytes,
+      .missingResourceCount = total.missingResourceCount - frameStart->missingResourceCount,
+  };
+  *frameStart = total;
+
+  struct task_pool *taskPool = &assets->transientState->taskPool;
+  telemetry->queueDepth = assets->stream.requestCount + AtomicLoad(&taskPool->usedCount);
+  telemetry->queueDepthMax = Maximum(telemetry->queueDepthMax, telemetry->queueDepth);
+}
+
+#if HANDMADEHERO_DEBUG
+void
+AssetTraceWrite(struct game_assets *assets, char *path)
+{
+  struct asset_trace *trace = &assets->trace;
+  u32 eventCount = Minimum(trace->eventCount, ASSET_TRACE_EVENT_COUNT_MAX);
+
+  struct hha_trace_header *header =
+      Platform->AllocateMemory(sizeof(*header) + sizeof(struct hha_trace_event) * eventCount);
+  if (!header) {
+    // TODO: notify user
+    return;
+  }
+  struct hha_trace_event *events = (struct hha_trace_event *)(header + 1);
+  *header = (struct hha_trace_header){
+      .magic = HHA_TRACE_MAGIC,
+      .version = HHA_TRACE_VERSION,
+  };
+
+  // NOTE(e2dk4r): source hashes are only read here, loads of assets whose
+  // file has no source hashes are not written
+  u64 **fileSourceHashes = Platform->AllocateMemory(sizeof(*fileSourceHashes) * assets->fileCount);
+  if (!fileSourceHashes) {
+    // TODO: notify user
+    Platform->DeallocateMemory(header);
+    return;
+  }
+
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++) {
+    struct asset_file *file = assets->files + fileIndex;
+    struct hha_section *sourceHashesSection = file->sections + HHA_SECTION_TYPE_SOURCE_HASHES;
+    fileSourceHashes[fileIndex] = 0;
+    if (sourceHashesSection->size == 0 || sourceHashesSection->size != sizeof(u64) * file->header.assetCount)
+      continue;
+
+    u64 *sourceHashes = Platform->AllocateMemory(sourceHashesSection->size);
+    if (!sourceHashes)
+      continue;
+
+    Platform->ReadFromFile(sourceHashes, &file->handle, sourceHashesSection->offset, sourceHashesSection->size);
+    if (Platform->HasFileError(&file->handle) || !IsSectionChecksumValid(sourceHashesSection, sourceHashes)) {
+      Platform->DeallocateMemory(sourceHashes);
+      continue;
+    }
+
+    fileSourceHashes[fileIndex] = sourceHashes;
+  }
+
+  for (u32 eventIndex = 0; eventIndex < eventCount; eventIndex++) {
+    struct asset_trace_event *event = trace->events + eventIndex;
+    struct asset *asset = assets->assets + event->assetIndex;
+    u64 *sourceHashes = fileSourceHashes[asset->fileIndex];
+    if (!sourceHashes || sourceHashes[asset->fileAssetIndex] == 0)
+      continue;
+
+    events[header->eventCount++] = (struct hha_trace_event){
+        .sourceHash = sourceHashes[asset->fileAssetIndex],
+        .frameIndex = event->frameIndex,
+    };
+  }
+
+  for (u32 fileIndex = 0; fileIndex < assets->fileCount; fileIndex++)
+    Platform->DeallocateMemory(fileSourceHashes[fileIndex]);
+  Platform->DeallocateMemory(fileSourceHashes);
+
+  u64 size = sizeof(*header) + sizeof(*events) * header->eventCount;
+  if (!Platform->WriteEntireFile(path, size, header)) {
+    // TODO: notify user
+  }
+
+  Platform->DeallocateMemory(header);
+}
+#endif
+
+inline struct bundle_id
+BundleGetForBitmap(struct game_assets *assets, struct bitmap_id id)
+{
+  assert(id.value < assets->assetCount);
+  struct bundle_id result = {assets->assets[id.value].bundleIndex};
+  return result;
+}
+
+struct load_bundle_work {
+  struct asset_file *file;
+  u8 *data;
+  u64 offset;
+  u64 size;
+
+  u32 assetCount;
+  struct load_asset_work *assetWorks;
+  struct task_with_memory *task;
+};
+
+internal void
+DoLoadBundleWork(struct platform_work_queue *queue, void *data)
+{
+  struct load_bundle_work *work = data;
+  struct asset_file *file = work->file;
+
+  // NOTE(e2dk4r): one read for whole bundle, padding between assets is read too
+  Platform->ReadFromFile(work->data, &file->handle, work->offset, work->size);
+  b32 isRead = !Platform->HasFileError(&file->handle);
+
+  for (u32 assetIndex = 0; assetIndex < work->assetCount; assetIndex++) {
+    struct load_asset_work *assetWork = work->assetWorks + assetIndex;
+    struct asset *asset = assetWork->asset;
+
+    b32 isValid = isRead;
+    if (isValid && !IsAssetDataSizeValid(&asset->hhaAsset, assetWork->size, assetWork->capacity)) {
+      // TODO: notify user
+      assert(0 && "asset data size is invalid");
+      isValid = 0;
+    }
+
+    if (isValid) {
+      u8 *assetData = work->data + (assetWork->offset - work->offset);
+      isValid = AssetDataUnpack(assetWork, assetData, AssetDataStoredSize(assetWork));
+    }
+
+    if (!isValid) {
+      ZeroMemory(assetWork->dest, assetWork->size);
+    }
+
+    AssetLoadFinish(assetWork, AssetDataStoredSize(assetWork));
+  }
+
+  EndTaskWithMemory(work->task);
+}
+
+void
+BundleLoad(struct game_assets *assets, struct bundle_id id)
 {
-  BitmapLoad(assets, id);
+  if (id.value == 0)
+    return;
+
+  assert(id.value < assets->bundleCount);
+  struct asset_bundle *bundle = assets->bundles + id.value;
+
+  // claim assets that are not loaded yet
+  u32 claimedAssetIndexes[HHA_BUNDLE_ASSET_COUNT_MAX];
+  u32 claimedAssetCount = 0;
+  u64 spanBegin = U64_MAX;
+  u64 spanEnd = 0;
+  for (u32 bundleAssetIndex = bundle->assetIndexFirst; bundleAssetIndex < bundle->assetIndexOnePastLast;
+       bundleAssetIndex++) {
+    u32 assetIndex = assets->bundleAssets[bundleAssetIndex];
+    struct asset *asset = assets->assets + assetIndex;
+
+    // NOTE: bitmap in atlas has no data to read
+    if (asset->hhaAsset.bitmap.atlasId.value != 0)
+      continue;
+
+    enum asset_state expectedAssetState = ASSET_STATE_UNLOADED;
+    if (!AtomicCompareExchange(&asset->state, &expectedAssetState, ASSET_STATE_QUEUED))
+      continue;
+
+    claimedAssetIndexes[claimedAssetCount] = assetIndex;
+    claimedAssetCount++;
+
+    // NOTE: bundles are only in version 1 and later files, dataSize is known
+    struct hha_asset *info = &asset->hhaAsset;
+    spanBegin = Minimum(spanBegin, info->dataOffset);
+    spanEnd = Maximum(spanEnd, info->dataOffset + info->dataSize);
+  }
+
+  if (claimedAssetCount == 0)
+    return;
+
+  struct task_with_memory *task = BeginTaskWithMemory(assets->transientState);
+  u64 spanSize = spanEnd - spanBegin;
+  u64 workSize = sizeof(struct load_bundle_work) + sizeof(struct load_asset_work) * claimedAssetCount;
+  b32 isFit = task && workSize + spanSize + 16 <= MemoryArenaGetRemainingSize(&task->arena);
+  if (!isFit) {
+    // memory cannot obtained, revert back
+    for (u32 claimedIndex = 0; claimedIndex < claimedAssetCount; claimedIndex++) {
+      struct asset *asset = assets->assets + claimedAssetIndexes[claimedIndex];
+      AtomicStore(&asset->state, ASSET_STATE_UNLOADED);
+    }
+
+    if (task) {
+      // NOTE: bundle is too big for one task, load assets one by one
+      EndTaskWithMemory(task);
+      for (u32 claimedIndex = 0; claimedIndex < claimedAssetCount; claimedIndex++) {
+        struct bitmap_id bitmapId = {claimedAssetIndexes[claimedIndex]};
+        BitmapLoad(assets, bitmapId);
+      }
+    }
+
+    return;
+  }
+
+  struct load_bundle_work *work = MemoryArenaPush(&task->arena, sizeof(*work));
+  work->assetCount = claimedAssetCount;
+  work->assetWorks = MemoryArenaPush(&task->arena, sizeof(*work->assetWorks) * claimedAssetCount);
+  work->data = MemoryArenaPush(&task->arena, spanSize);
+  work->offset = spanBegin;
+  work->size = spanSize;
+  work->task = task;
+
+  for (u32 claimedIndex = 0; claimedIndex < claimedAssetCount; claimedIndex++) {
+    struct load_asset_work *assetWork = work->assetWorks + claimedIndex;
+    BitmapSetup(assets, claimedAssetIndexes[claimedIndex], assetWork);
+    assetWork->task = task;
+  }
+
+  work->file = work->assetWorks[0].file;
+
+  // queue the work
+  struct platform_work_queue *queue = assets->transientState->lowPriorityQueue;
+  Platform->WorkQueueAddEntry(queue, DoLoadBundleWork, work);
 }
 
 inline struct hha_bitmap *
@@ -714,7 +1994,7 @@ AudioLoad(struct game_assets *assets, struct audio_id id)
     struct asset_memory_size size = {};
     size.section = audioInfo->channelCount * sizeof(s16);
     size.data = audioInfo->sampleCount * size.section;
-    size.total = size.data + sizeof(*asset->header);
+    size.total = AssetDataCapacity(info, size.data) + sizeof(*asset->header);
 
     asset->header = AcquireAssetMemory(assets, size.total, id.value);
     void *memory = (asset->header + 1);
@@ -730,14 +2010,17 @@ AudioLoad(struct game_assets *assets, struct audio_id id)
 
     // setup work
     struct load_asset_work *work = MemoryArenaPush(&task->arena, sizeof(*work));
-    work->handle = AssetFileHandleGet(assets, asset->fileIndex);
+    work->assets = assets;
+    work->file = AssetFileGet(assets, asset->fileIndex);
     work->dest = audio->samples[0];
     work->offset = info->dataOffset;
     work->size = size.data;
+    work->capacity = size.total - sizeof(*asset->header);
 
     work->task = task;
     work->asset = asset;
     work->finalState = ASSET_STATE_LOADED;
+    work->font = 0;
 
     // queue the work
     struct platform_work_queue *queue = assets->transientState->lowPriorityQueue;
@@ -815,30 +2098,59 @@ FontLoad(struct game_assets *assets, struct font_id id)
     assert(info->dataOffset && "asset not setup properly");
     struct hha_font *fontInfo = &info->font;
 
-    u32 codepointsSize = fontInfo->codepointCount * sizeof(struct bitmap_id);
-    u32 horizontalAdvanceTableSize = fontInfo->codepointCount * fontInfo->codepointCount * sizeof(f32);
-    u32 dataSize = codepointsSize + horizontalAdvanceTableSize; // size of data in file
-    u32 totalSize = dataSize + sizeof(*asset->header);
+    struct asset_file *file = AssetFileGet(assets, asset->fileIndex);
+    b32 isVersion0 = file->header.version == 0;
+
+    u32 codepointsSize = 0;
+    u32 horizontalAdvancesSize = fontInfo->codepointCount * sizeof(f32);
+    if (isVersion0) {
+      // NOTE: advances are read as table, see FontAdvancesFromV0()
+      codepointsSize = fontInfo->codepointCount * sizeof(struct bitmap_id);
+      horizontalAdvancesSize *= fontInfo->codepointCount;
+    }
+    u32 kerningsSize = fontInfo->kerningCount * sizeof(struct hha_font_kerning);
+    u32 glyphsSize = 0;
+    u32 atlasSize = 0;
+    u32 glyphBitmapsSize = 0;
+    if (fontInfo->atlasWidth) {
+      glyphsSize = fontInfo->codepointCount * sizeof(struct hha_font_glyph);
+      atlasSize = (u32)fontInfo->atlasWidth * fontInfo->atlasHeight * BITMAP_BYTES_PER_PIXEL;
+      glyphBitmapsSize = fontInfo->codepointCount * sizeof(struct bitmap);
+    }
+    // size of data in file
+    u32 dataSize = codepointsSize + horizontalAdvancesSize + kerningsSize + glyphsSize + atlasSize;
+    // NOTE(e2dk4r): glyph views are after data, which may be decompressed in place
+    u32 dataCapacity = ALIGN(AssetDataCapacity(info, dataSize), 8);
+    u32 totalSize = (u32)sizeof(*asset->header) + dataCapacity + glyphBitmapsSize;
     asset->header = AcquireAssetMemory(assets, totalSize, id.value);
     void *memory = (asset->header + 1);
 
     // setup font
     struct font *font = &asset->header->font;
-    struct asset_file *file = AssetFileGet(assets, asset->fileIndex);
     font->bitmapIdOffset = file->fontBitmapIdOffset;
-    font->codepoints = memory;
-    font->horizontalAdvanceTable = (f32 *)((u8 *)font->codepoints + codepointsSize);
+    font->codepoints = isVersion0 ? memory : 0;
+    font->horizontalAdvances = (f32 *)((u8 *)memory + codepointsSize);
+    font->kernings = (struct hha_font_kerning *)((u8 *)font->horizontalAdvances + horizontalAdvancesSize);
+    font->glyphs = 0;
+    font->glyphBitmaps = 0;
+    if (fontInfo->atlasWidth) {
+      font->glyphs = (struct hha_font_glyph *)((u8 *)font->kernings + kerningsSize);
+      font->glyphBitmaps = (struct bitmap *)((u8 *)memory + dataCapacity);
+    }
 
     // setup work
     struct load_asset_work *work = MemoryArenaPush(&task->arena, sizeof(*work));
-    work->handle = &file->handle;
+    work->assets = assets;
+    work->file = file;
     work->dest = memory;
     work->offset = info->dataOffset;
     work->size = dataSize;
+    work->capacity = dataCapacity;
 
     work->task = task;
     work->asset = asset;
     work->finalState = ASSET_STATE_LOADED;
+    work->font = font;
 
     // queue the work
     struct platform_work_queue *queue = assets->transientState->lowPriorityQueue;
@@ -861,13 +2173,28 @@ FontGetClampedCodepoint(struct hha_font *fontInfo, u32 desiredCodepoint)
 struct bitmap_id
 FontGetBitmapGlyph(struct game_assets *assets, struct hha_font *fontInfo, struct font *font, u32 desiredCodepoint)
 {
+  struct bitmap_id bitmapId = {};
+  if (!font->codepoints)
+    return bitmapId;
+
   u32 codepoint = FontGetClampedCodepoint(fontInfo, desiredCodepoint);
   struct bitmap_id bitmapIdInFile = *(font->codepoints + codepoint);
-  struct bitmap_id bitmapId = {font->bitmapIdOffset + bitmapIdInFile.value};
+  bitmapId.value = font->bitmapIdOffset + bitmapIdInFile.value;
   assert(bitmapId.value < assets->assetCount);
   return bitmapId;
 }
 
+struct bitmap *
+FontGetGlyphBitmap(struct hha_font *fontInfo, struct font *font, u32 desiredCodepoint)
+{
+  if (!font->glyphBitmaps)
+    return 0;
+
+  u32 codepoint = FontGetClampedCodepoint(fontInfo, desiredCodepoint);
+  struct bitmap *result = font->glyphBitmaps + codepoint;
+  return result;
+}
+
 f32
 FontGetLineAdvance(struct hha_font *fontInfo)
 {
@@ -889,9 +2216,26 @@ FontGetHorizontalAdvanceForPair(struct hha_font *fontInfo, struct font *font, u3
   u32 prevCodepoint = FontGetClampedCodepoint(fontInfo, desiredPrevCodepoint);
   u32 codepoint = FontGetClampedCodepoint(fontInfo, desiredCodepoint);
 
-  u32 offset = (prevCodepoint * fontInfo->codepointCount) + codepoint;
-  assert(offset < fontInfo->codepointCount * fontInfo->codepointCount);
-  f32 result = *(font->horizontalAdvanceTable + offset);
+  f32 result = font->horizontalAdvances[prevCodepoint];
+
+  u32 kerningCount = fontInfo->kerningCount;
+  if (kerningCount == 0 || codepoint == 0)
+    return result;
+
+  u32 slot = HHAFontKerningSlot(prevCodepoint, codepoint, kerningCount);
+  for (u32 probeIndex = 0; probeIndex < kerningCount; probeIndex++) {
+    struct hha_font_kerning *kerning = font->kernings + slot;
+    if (kerning->codepoint == 0)
+      break;
+
+    if (kerning->prevCodepoint == prevCodepoint && kerning->codepoint == codepoint) {
+      result += kerning->advance;
+      break;
+    }
+
+    slot = (slot + 1) & (kerningCount - 1);
+  }
+
   return result;
 }
 
@@ -1,3 +1,4 @@
+#include <handmadehero/atomic.h>
 #include <handmadehero/audio.h>
 #include <handmadehero/memory_arena.h>
 #include <x86intrin.h>
@@ -9,39 +10,738 @@ AudioStateInit(struct audio_state *audioState, struct memory_arena *permanentAre
   audioState->firstPlayingAudio = 0;
   audioState->firstFreePlayingAudio = 0;
   audioState->masterVolume = v2(1.0f, 1.0f);
+  audioState->realAudioCountMax = REAL_AUDIO_COUNT_MAX_DEFAULT;
+  audioState->resampler = AUDIO_RESAMPLER_LINEAR;
+  SincTableInit(&audioState->sincTable);
+
+  audioState->commandWriteIndex = 0;
+  audioState->commandReadIndex = 0;
+  audioState->loadRequestWriteIndex = 0;
+  audioState->loadRequestReadIndex = 0;
+  audioState->nextPlayingAudioId = 0;
+  audioState->droppedCommandCount = 0;
+
+  audioState->streamUnderrunCount = 0;
+  audioState->streamUnderrunSampleCount = 0;
+  audioState->streamLateCount = 0;
+
+  audioState->snapshotLatest = 0;
+  audioState->snapshotInUse = 0;
+  for (u32 snapshotIndex = 0; snapshotIndex < AUDIO_SNAPSHOT_COUNT; snapshotIndex++) {
+    struct audio_snapshot *snapshot = audioState->snapshots + snapshotIndex;
+    snapshot->audioIndexFirst = 0;
+    snapshot->audioCount = 0;
+    snapshot->audios = MemoryArenaPush(permanentArena, sizeof(*snapshot->audios) * AUDIO_SNAPSHOT_AUDIO_COUNT_MAX);
+    snapshot->isLive = 0;
+    snapshot->generationId = 0;
+  }
+  memory_arena_size_t snapshotHoldsSize = sizeof(*audioState->snapshotHolds) * AUDIO_SNAPSHOT_AUDIO_COUNT_MAX;
+  audioState->snapshotHolds = MemoryArenaPush(permanentArena, snapshotHoldsSize);
+  ZeroMemory(audioState->snapshotHolds, snapshotHoldsSize);
+  audioState->playedCount = 0;
+
+  // NOTE(e2dk4r): mixer cannot push to arena that game thread also uses, so
+  // playing audios are allocated up front
+  struct playing_audio *playingAudios =
+      MemoryArenaPush(permanentArena, sizeof(*playingAudios) * PLAYING_AUDIO_COUNT_MAX);
+  for (u32 playingAudioIndex = 0; playingAudioIndex < PLAYING_AUDIO_COUNT_MAX; playingAudioIndex++) {
+    struct playing_audio *playingAudio = playingAudios + playingAudioIndex;
+    playingAudio->next = audioState->firstFreePlayingAudio;
+    audioState->firstFreePlayingAudio = playingAudio;
+  }
+
+  for (u32 busIndex = 0; busIndex < AUDIO_BUS_COUNT; busIndex++) {
+    struct audio_bus *bus = audioState->buses + busIndex;
+    bus->parent = AUDIO_BUS_MASTER;
+    bus->currentVolume = bus->targetVolume = v2(1.0f, 1.0f);
+    bus->dCurrentVolume = v2(0.0f, 0.0f);
+
+    bus->filterType = BIQUAD_TYPE_NONE;
+    bus->filterSampleRate = 0;
+    bus->filter.type = BIQUAD_TYPE_NONE;
+    bus->filterStates[0] = bus->filterStates[1] = (struct biquad_state){};
+
+    ReverbInit(&bus->reverb, MemoryArenaPush(permanentArena, sizeof(f32) * REVERB_MEMORY_COUNT));
+
+    bus->limiter.threshold = 0.0f;
+    bus->limiter.gain = 1.0f;
+  }
+}
+
+internal void
+AudioCommandPush(struct audio_state *audioState, struct audio_command *command)
+{
+  comptime u32 commandMask = AUDIO_COMMAND_COUNT - 1;
+  static_assert((AUDIO_COMMAND_COUNT & (AUDIO_COMMAND_COUNT - 1)) == 0);
+
+  u32 writeIndex = audioState->commandWriteIndex;
+  u32 readIndex = AtomicLoad(&audioState->commandReadIndex);
+  if (writeIndex - readIndex == AUDIO_COMMAND_COUNT) {
+    // mixer is not running or is behind
+    AtomicFetchAddRelaxed(&audioState->droppedCommandCount, 1);
+    return;
+  }
+
+  audioState->commands[writeIndex & commandMask] = *command;
+  AtomicStore(&audioState->commandWriteIndex, writeIndex + 1);
+}
+
+internal struct playing_audio *
+PlayingAudioGet(struct audio_state *audioState, struct playing_audio_id playingAudioId)
+{
+  for (struct playing_audio *playingAudio = audioState->firstPlayingAudio; playingAudio;
+       playingAudio = playingAudio->next) {
+    if (playingAudio->playingAudioId.value == playingAudioId.value)
+      return playingAudio;
+  }
+
+  // audio is finished
+  return 0;
+}
+
+/*
+ * Applies commands sent by game thread. Only called by mixer.
+ */
+internal void
+AudioCommandsProcess(struct audio_state *audioState)
+{
+  comptime u32 commandMask = AUDIO_COMMAND_COUNT - 1;
+
+  u32 writeIndex = AtomicLoad(&audioState->commandWriteIndex);
+  for (u32 readIndex = audioState->commandReadIndex; readIndex != writeIndex; readIndex++) {
+    struct audio_command *command = audioState->commands + (readIndex & commandMask);
+    switch (command->type) {
+    case AUDIO_COMMAND_TYPE_PLAY: {
+      struct playing_audio *playingAudio = audioState->firstFreePlayingAudio;
+      if (!playingAudio) {
+        // all playing audios are in use, audio is not played
+        break;
+      }
+
+      audioState->firstFreePlayingAudio = playingAudio->next;
+      playingAudio->playingAudioId = command->playingAudioId;
+      playingAudio->samplesPlayed = 0;
+      playingAudio->currentVolume = playingAudio->targetVolume = v2(1.0f, 1.0f);
+      playingAudio->dCurrentVolume = v2(0.0f, 0.0f);
+      playingAudio->dSample = 1.0f;
+      playingAudio->priority = command->priority;
+      playingAudio->isVirtual = 0;
+      playingAudio->virtualFade = 1.0f;
+      playingAudio->dVirtualFade = 0.0f;
+      playingAudio->isStreaming = command->isStreaming;
+      playingAudio->isStarted = 0;
+      playingAudio->busId = AUDIO_BUS_MASTER;
+      playingAudio->id = command->audioId;
+      playingAudio->previousId = (struct audio_id){};
+
+      playingAudio->next = audioState->firstPlayingAudio;
+      audioState->firstPlayingAudio = playingAudio;
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_VOLUME: {
+      struct playing_audio *playingAudio = PlayingAudioGet(audioState, command->playingAudioId);
+      if (!playingAudio)
+        break;
+
+      if (command->fadeDurationInSeconds <= 0.0f) {
+        playingAudio->currentVolume = playingAudio->targetVolume = command->volume;
+      } else {
+        playingAudio->targetVolume = command->volume;
+        playingAudio->dCurrentVolume = v2_mul(v2_sub(playingAudio->targetVolume, playingAudio->currentVolume),
+                                              1.0f / command->fadeDurationInSeconds);
+      }
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_PITCH: {
+      struct playing_audio *playingAudio = PlayingAudioGet(audioState, command->playingAudioId);
+      if (!playingAudio)
+        break;
+
+      playingAudio->dSample = command->dSample;
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_REAL_AUDIO_COUNT: {
+      audioState->realAudioCountMax = command->realAudioCountMax;
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_RESAMPLER: {
+      audioState->resampler = command->resampler;
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_BUS: {
+      struct playing_audio *playingAudio = PlayingAudioGet(audioState, command->playingAudioId);
+      if (!playingAudio)
+        break;
+
+      playingAudio->busId = command->busId;
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_BUS_VOLUME: {
+      struct audio_bus *bus = audioState->buses + command->busId;
+      if (command->fadeDurationInSeconds <= 0.0f) {
+        bus->currentVolume = bus->targetVolume = command->volume;
+        bus->dCurrentVolume = v2(0.0f, 0.0f);
+      } else {
+        bus->targetVolume = command->volume;
+        bus->dCurrentVolume =
+            v2_mul(v2_sub(bus->targetVolume, bus->currentVolume), 1.0f / command->fadeDurationInSeconds);
+      }
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_BUS_FILTER: {
+      struct audio_bus *bus = audioState->buses + command->busId;
+      bus->filterType = command->filterType;
+      bus->filterFrequency = command->filterFrequency;
+      bus->filterQ = command->filterQ;
+      bus->filterSampleRate = 0;
+      bus->filterStates[0] = bus->filterStates[1] = (struct biquad_state){};
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_BUS_REVERB: {
+      struct audio_bus *bus = audioState->buses + command->busId;
+      // NOTE(e2dk4r): lines keep whatever was in them when reverb was turned off
+      if (bus->reverb.wet <= 0.0f && command->reverbWet > 0.0f)
+        ReverbClear(&bus->reverb);
+      bus->reverb.wet = command->reverbWet;
+      // NOTE(e2dk4r): reverb rings forever at 1
+      bus->reverb.roomSize = Clamp(0.0f, 0.98f, command->reverbRoomSize);
+    } break;
+
+    case AUDIO_COMMAND_TYPE_CHANGE_BUS_LIMITER: {
+      struct audio_bus *bus = audioState->buses + command->busId;
+      bus->limiter.threshold = command->limiterThreshold * 32767.0f;
+    } break;
+    }
+  }
+
+  AtomicStore(&audioState->commandReadIndex, writeIndex);
+}
+
+/*
+ * Asks game thread to load and publish audio. Only called by mixer.
+ */
+internal void
+AudioLoadRequestPush(struct audio_state *audioState, struct audio_id id)
+{
+  comptime u32 loadRequestMask = AUDIO_LOAD_REQUEST_COUNT - 1;
+  static_assert((AUDIO_LOAD_REQUEST_COUNT & (AUDIO_LOAD_REQUEST_COUNT - 1)) == 0);
+
+  if (!IsAudioIdValid(id))
+    return;
+
+  u32 writeIndex = audioState->loadRequestWriteIndex;
+  u32 readIndex = AtomicLoad(&audioState->loadRequestReadIndex);
+  if (writeIndex - readIndex == AUDIO_LOAD_REQUEST_COUNT) {
+    // game thread is behind, request is sent again next time
+    return;
+  }
+
+  audioState->loadRequests[writeIndex & loadRequestMask] = id;
+  AtomicStore(&audioState->loadRequestWriteIndex, writeIndex + 1);
+}
+
+/*
+ * Publishes audio for next AUDIO_SNAPSHOT_HOLD_COUNT frames when it is
+ * loaded. Only called by game thread.
+ */
+internal void
+AudioSnapshotHold(struct audio_state *audioState, struct game_assets *assets, struct audio_id id)
+{
+  u32 audioIndexFirst = assets->assetTypes[ASSET_TYPE_BLOOP].assetIndexFirst;
+  u32 audioCount = assets->assetTypes[ASSET_TYPE_PUHP].assetIndexOnePastLast - audioIndexFirst;
+  u32 audioIndex = id.value - audioIndexFirst;
+  if (audioIndex >= audioCount || audioIndex >= AUDIO_SNAPSHOT_AUDIO_COUNT_MAX)
+    return;
+
+  audioState->snapshotHolds[audioIndex] = AUDIO_SNAPSHOT_HOLD_COUNT;
+}
+
+void
+AudioLoadRequestsProcess(struct audio_state *audioState, struct game_assets *assets)
+{
+  comptime u32 loadRequestMask = AUDIO_LOAD_REQUEST_COUNT - 1;
+
+  u32 writeIndex = AtomicLoad(&audioState->loadRequestWriteIndex);
+  for (u32 readIndex = audioState->loadRequestReadIndex; readIndex != writeIndex; readIndex++) {
+    struct audio_id id = audioState->loadRequests[readIndex & loadRequestMask];
+    AudioLoad(assets, id);
+    AudioSnapshotHold(audioState, assets, id);
+  }
+
+  AtomicStore(&audioState->loadRequestReadIndex, writeIndex);
+}
+
+/*
+ * Ends snapshots that mixer cannot read anymore. Only called by game
+ * thread.
+ */
+internal void
+AudioSnapshotsRetire(struct audio_state *audioState, struct game_assets *assets)
+{
+  /* NOTE(e2dk4r): Mixer that did not announce older snapshot before this
+   * point sees it is not latest anymore. Samples are stamped by newest
+   * snapshot that publishes them, so snapshots after one in use are not
+   * ended either.
+   */
+  u32 latestNumber = audioState->snapshotLatest;
+  u32 inUseNumber = AtomicLoadSeqCst(&audioState->snapshotInUse);
+  struct audio_snapshot *inUse = inUseNumber ? audioState->snapshots + inUseNumber - 1 : 0;
+  for (u32 snapshotIndex = 0; snapshotIndex < AUDIO_SNAPSHOT_COUNT; snapshotIndex++) {
+    struct audio_snapshot *snapshot = audioState->snapshots + snapshotIndex;
+    if (!snapshot->isLive || snapshotIndex + 1 == latestNumber ||
+        (inUse && snapshot->generationId >= inUse->generationId))
+      continue;
+
+    EndGeneration(assets, snapshot->generationId);
+    snapshot->isLive = 0;
+  }
+}
+
+void
+AudioSnapshotPublish(struct audio_state *audioState, struct game_assets *assets)
+{
+  AudioSnapshotsRetire(audioState, assets);
+
+  struct audio_snapshot *snapshot = 0;
+  for (u32 snapshotIndex = 0; snapshotIndex < AUDIO_SNAPSHOT_COUNT; snapshotIndex++) {
+    if (!audioState->snapshots[snapshotIndex].isLive) {
+      snapshot = audioState->snapshots + snapshotIndex;
+      break;
+    }
+  }
+  if (!snapshot) {
+    // mixer still reads snapshot older than latest, published again next frame
+    return;
+  }
+
+  u32 audioIndexFirst = assets->assetTypes[ASSET_TYPE_BLOOP].assetIndexFirst;
+  u32 audioCount = assets->assetTypes[ASSET_TYPE_PUHP].assetIndexOnePastLast - audioIndexFirst;
+  assert(audioCount <= AUDIO_SNAPSHOT_AUDIO_COUNT_MAX);
+
+  for (u32 playedIndex = 0; playedIndex < audioState->playedCount; playedIndex++)
+    AudioSnapshotHold(audioState, assets, audioState->playedIds[playedIndex]);
+  audioState->playedCount = 0;
+
+  snapshot->generationId = BeginGeneration(assets);
+  snapshot->isLive = 1;
+  snapshot->audioIndexFirst = audioIndexFirst;
+  snapshot->audioCount = audioCount;
+  for (u32 audioIndex = 0; audioIndex < audioCount; audioIndex++) {
+    struct audio_id id = {audioIndexFirst + audioIndex};
+    u32 hold = audioState->snapshotHolds[audioIndex];
+    for (u32 snapshotIndex = 0; snapshotIndex < AUDIO_SNAPSHOT_COUNT; snapshotIndex++) {
+      struct audio_snapshot *live = audioState->snapshots + snapshotIndex;
+      if (live->isLive && live != snapshot && AtomicLoadRelaxed(&live->audios[audioIndex].isUsed))
+        hold = AUDIO_SNAPSHOT_HOLD_COUNT;
+    }
+
+    struct hha_audio *audioInfo = AudioInfoGet(assets, id);
+    struct audio_snapshot_audio *audio = snapshot->audios + audioIndex;
+    audio->samples[0] = audio->samples[1] = 0;
+    audio->sampleCount = audioInfo->sampleCount;
+    audio->channelCount = audioInfo->channelCount;
+    audio->nextInChain = AudioGetNextInChain(assets, id);
+    audio->isUsed = 0;
+
+    if (hold > 0) {
+      // NOTE(e2dk4r): stamps audio with generation of this snapshot
+      struct audio *loadedAudio = AudioGet(assets, id, snapshot->generationId);
+      if (loadedAudio) {
+        audio->samples[0] = loadedAudio->samples[0];
+        audio->samples[1] = loadedAudio->samples[1];
+      }
+    }
+
+    audioState->snapshotHolds[audioIndex] = (u8)(hold > 0 ? hold - 1 : 0);
+  }
+
+  u32 snapshotNumber = (u32)(snapshot - audioState->snapshots) + 1;
+  AtomicStoreSeqCst(&audioState->snapshotLatest, snapshotNumber);
+
+  AudioSnapshotsRetire(audioState, assets);
+}
+
+void
+AudioSnapshotWithdraw(struct audio_state *audioState, struct game_assets *assets)
+{
+  AtomicStoreSeqCst(&audioState->snapshotLatest, 0);
+
+  // NOTE(e2dk4r): mixer stops reading snapshot at end of every output
+  while (AtomicLoadSeqCst(&audioState->snapshotInUse) != 0)
+    _mm_pause();
+
+  for (u32 snapshotIndex = 0; snapshotIndex < AUDIO_SNAPSHOT_COUNT; snapshotIndex++) {
+    struct audio_snapshot *snapshot = audioState->snapshots + snapshotIndex;
+    if (!snapshot->isLive)
+      continue;
+
+    EndGeneration(assets, snapshot->generationId);
+    snapshot->isLive = 0;
+  }
+}
+
+/*
+ * Latest snapshot, mixer reads it until AudioSnapshotEnd(). Returns 0 when
+ * there is none. Only called by mixer.
+ */
+internal struct audio_snapshot *
+AudioSnapshotBegin(struct audio_state *audioState)
+{
+  // NOTE(e2dk4r): game thread can publish new snapshot before announcement is seen, so latest is checked again
+  u32 snapshotNumber;
+  do {
+    snapshotNumber = AtomicLoadSeqCst(&audioState->snapshotLatest);
+    AtomicStoreSeqCst(&audioState->snapshotInUse, snapshotNumber);
+  } while (AtomicLoadSeqCst(&audioState->snapshotLatest) != snapshotNumber);
+
+  return snapshotNumber ? audioState->snapshots + snapshotNumber - 1 : 0;
+}
+
+internal void
+AudioSnapshotEnd(struct audio_state *audioState)
+{
+  AtomicStore(&audioState->snapshotInUse, 0);
+}
+
+/*
+ * Published info of audio, samples are 0 when they are not published.
+ * Returns 0 when there is no snapshot. Only called by mixer.
+ */
+internal struct audio_snapshot_audio *
+AudioSnapshotAudioGet(struct audio_snapshot *snapshot, struct audio_id id)
+{
+  if (!snapshot || !IsAudioIdValid(id))
+    return 0;
+
+  u32 audioIndex = id.value - snapshot->audioIndexFirst;
+  if (audioIndex >= snapshot->audioCount)
+    return 0;
+
+  return snapshot->audios + audioIndex;
+}
+
+/*
+ * Audio whose samples are published, and keeps it published. Asks game
+ * thread for audio when its samples are not published. Only called by
+ * mixer.
+ */
+internal struct audio_snapshot_audio *
+AudioSnapshotUse(struct audio_state *audioState, struct audio_snapshot *snapshot, struct audio_id id)
+{
+  struct audio_snapshot_audio *audio = AudioSnapshotAudioGet(snapshot, id);
+  if (!audio || !audio->samples[0]) {
+    AudioLoadRequestPush(audioState, id);
+    return 0;
+  }
+
+  if (!AtomicLoadRelaxed(&audio->isUsed))
+    AtomicStoreRelaxed(&audio->isUsed, 1);
+  return audio;
+}
+
+/*
+ * Picks playing audios that are mixed this time, rest become virtual.
+ */
+internal void
+PlayingAudiosVirtualize(struct audio_state *audioState, struct audio_snapshot *snapshot)
+{
+  struct playing_audio *audibles[PLAYING_AUDIO_COUNT_MAX];
+  f32 scores[PLAYING_AUDIO_COUNT_MAX];
+  u32 audibleCount = 0;
+
+  // NOTE(e2dk4r): gain of bus is its volume scaled with gain of its parent, parent always comes before it
+  struct v2 busGains[AUDIO_BUS_COUNT];
+  for (u32 busIndex = 0; busIndex < AUDIO_BUS_COUNT; busIndex++) {
+    struct audio_bus *bus = audioState->buses + busIndex;
+    struct v2 parentGain = busIndex == AUDIO_BUS_MASTER ? audioState->masterVolume : busGains[bus->parent];
+    for (u32 channelIndex = 0; channelIndex < 2; channelIndex++) {
+      f32 volume = Maximum(bus->currentVolume.e[channelIndex], bus->targetVolume.e[channelIndex]);
+      busGains[busIndex].e[channelIndex] = volume * parentGain.e[channelIndex];
+    }
+  }
+
+  for (struct playing_audio *playingAudio = audioState->firstPlayingAudio; playingAudio;
+       playingAudio = playingAudio->next) {
+    struct v2 busGain = busGains[playingAudio->busId];
+    f32 volume0 = Maximum(playingAudio->currentVolume.e[0], playingAudio->targetVolume.e[0]);
+    f32 volume1 = Maximum(playingAudio->currentVolume.e[1], playingAudio->targetVolume.e[1]);
+    f32 loudness = Maximum(volume0 * busGain.e[0], volume1 * busGain.e[1]);
+
+    if (loudness < AUDIO_VOLUME_AUDIBLE_MIN) {
+      // cannot be heard, so it does not need to fade out
+      playingAudio->isVirtual = 1;
+      playingAudio->virtualFade = 0.0f;
+      playingAudio->dVirtualFade = 0.0f;
+      continue;
+    }
+
+    f32 score = loudness * playingAudio->priority;
+    // NOTE(e2dk4r): favor audios that are already mixed, so audios with close
+    // scores do not swap every time
+    b32 isReal = !playingAudio->isVirtual && playingAudio->dVirtualFade >= 0.0f;
+    if (isReal)
+      score *= 1.125f;
+
+    // insertion sort, loudest first
+    u32 insertIndex = audibleCount;
+    while (insertIndex > 0 && scores[insertIndex - 1] < score) {
+      audibles[insertIndex] = audibles[insertIndex - 1];
+      scores[insertIndex] = scores[insertIndex - 1];
+      insertIndex--;
+    }
+    audibles[insertIndex] = playingAudio;
+    scores[insertIndex] = score;
+    audibleCount++;
+  }
+
+  u32 realAudioCount = Minimum(audibleCount, audioState->realAudioCountMax);
+  for (u32 audibleIndex = 0; audibleIndex < realAudioCount; audibleIndex++) {
+    struct playing_audio *playingAudio = audibles[audibleIndex];
+    if (playingAudio->isVirtual) {
+      playingAudio->isVirtual = 0;
+      playingAudio->virtualFade = 0.0f;
+    }
+    playingAudio->dVirtualFade = playingAudio->virtualFade < 1.0f ? 1.0f / AUDIO_VIRTUAL_FADE_SECONDS : 0.0f;
+  }
+
+  for (u32 audibleIndex = realAudioCount; audibleIndex < audibleCount; audibleIndex++) {
+    struct playing_audio *playingAudio = audibles[audibleIndex];
+    if (!playingAudio->isStarted) {
+      // nothing is mixed yet, so it does not need to fade out
+      playingAudio->isVirtual = 1;
+      playingAudio->virtualFade = 0.0f;
+      playingAudio->dVirtualFade = 0.0f;
+    } else if (!playingAudio->isVirtual) {
+      // mixer makes it virtual when it faded out
+      playingAudio->dVirtualFade = -1.0f / AUDIO_VIRTUAL_FADE_SECONDS;
+    }
+
+    // NOTE(e2dk4r): audible virtual audios can be mixed soon, keep their samples around
+    AudioSnapshotUse(audioState, snapshot, playingAudio->id);
+  }
+}
+
+/*
+ * Advances play cursor and volume of virtual playing audio as if it was
+ * mixed. Returns whether audio is finished.
+ */
+internal b32
+PlayingAudioAdvance(struct playing_audio *playingAudio, struct audio_snapshot *snapshot, u32 sampleCount,
+                    f32 secondsPerSample)
+{
+  f32 seconds = (f32)sampleCount * secondsPerSample;
+  for (u32 channelIndex = 0; channelIndex < 2; channelIndex++) {
+    f32 dVolume = playingAudio->dCurrentVolume.e[channelIndex];
+    if (dVolume == 0.0f)
+      continue;
+
+    f32 targetVolume = playingAudio->targetVolume.e[channelIndex];
+    f32 volume = playingAudio->currentVolume.e[channelIndex] + dVolume * seconds;
+    if ((dVolume > 0.0f && volume >= targetVolume) || (dVolume < 0.0f && volume <= targetVolume)) {
+      volume = targetVolume;
+      playingAudio->dCurrentVolume.e[channelIndex] = 0.0f;
+    }
+    playingAudio->currentVolume.e[channelIndex] = volume;
+  }
+
+  f32 samplesToAdvance = (f32)sampleCount * playingAudio->dSample;
+  while (1) {
+    struct audio_snapshot_audio *audio = AudioSnapshotAudioGet(snapshot, playingAudio->id);
+    if (!audio) {
+      // nothing is published while assets are reloaded, audio waits where it is
+      break;
+    }
+
+    f32 samplesRemaining = (f32)audio->sampleCount - playingAudio->samplesPlayed;
+    if (samplesToAdvance < samplesRemaining) {
+      playingAudio->samplesPlayed += samplesToAdvance;
+      break;
+    }
+    samplesToAdvance -= Maximum(samplesRemaining, 0.0f);
+
+    struct audio_id nextAudioInChain = audio->nextInChain;
+    if (!IsAudioIdValid(nextAudioInChain) || audio->sampleCount == 0)
+      return 1;
+
+    playingAudio->previousId = playingAudio->id;
+    playingAudio->id = nextAudioInChain;
+    playingAudio->samplesPlayed = 0.0f;
+  }
+
+  return 0;
+}
+
+/*
+ * Asks for audios ahead in chain of streaming playing audio, and keeps
+ * published ones published.
+ */
+internal void
+AudioStreamKeepAhead(struct audio_state *audioState, struct playing_audio *playingAudio,
+                     struct audio_snapshot *snapshot, u32 sampleRate)
+{
+  struct audio_snapshot_audio *audio = AudioSnapshotAudioGet(snapshot, playingAudio->id);
+  if (!audio)
+    return;
+
+  f32 samplesUntilNeeded = (f32)audio->sampleCount - playingAudio->samplesPlayed;
+  for (u32 aheadIndex = 0; aheadIndex < AUDIO_STREAM_AHEAD_COUNT; aheadIndex++) {
+    struct audio_id id = audio->nextInChain;
+    audio = AudioSnapshotAudioGet(snapshot, id);
+    if (!audio)
+      break;
+
+    if (!AudioSnapshotUse(audioState, snapshot, id)) {
+      f32 secondsUntilNeeded = samplesUntilNeeded / ((f32)sampleRate * playingAudio->dSample);
+      if (playingAudio->dSample > 0.0f && secondsUntilNeeded < AUDIO_STREAM_LATE_SECONDS)
+        AtomicFetchAddRelaxed(&audioState->streamLateCount, 1);
+    }
+
+    samplesUntilNeeded += (f32)audio->sampleCount;
+  }
+}
+
+/*
+ * Audio chained before or after audio that is mixed, for taps of sinc
+ * resampler past its edges. Audios that are not published, or have different
+ * channel count, are read as silence.
+ */
+internal struct sinc_neighbor
+SincNeighbor(struct audio_snapshot_audio *audio, u32 channelCount)
+{
+  struct sinc_neighbor neighbor = {};
+  if (!audio || !audio->samples[0] || audio->channelCount != channelCount)
+    return neighbor;
+
+  neighbor.samples[0] = audio->samples[0];
+  neighbor.samples[1] = channelCount == 2 ? audio->samples[1] : audio->samples[0];
+  neighbor.sampleCount = audio->sampleCount;
+  return neighbor;
+}
+
+internal inline __m256
+VirtualFadeClamp(__m256 virtualFade)
+{
+  return _mm256_min_ps(_mm256_max_ps(virtualFade, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+}
+
+internal inline void
+MixChunk(__m256 *dest0, __m256 *dest1, __m256 volume0, __m256 volume1, __m256 sampleValue0, __m256 sampleValue1)
+{
+  __m256 d0 = _mm256_load_ps((f32 *)dest0);
+  __m256 d1 = _mm256_load_ps((f32 *)dest1);
+
+  d0 = _mm256_add_ps(d0, _mm256_mul_ps(volume0, sampleValue0));
+  d1 = _mm256_add_ps(d1, _mm256_mul_ps(volume1, sampleValue1));
+
+  _mm256_store_ps((f32 *)dest0, d0);
+  _mm256_store_ps((f32 *)dest1, d1);
+}
+
+/*
+ * Scales channels of bus with its volume, while ramping volume to its
+ * target.
+ */
+internal void
+AudioBusVolume(struct audio_bus *bus, __m256 **channels, u32 chunkCount, f32 secondsPerSample)
+{
+  __m256 sampleLane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  for (u32 channelIndex = 0; channelIndex < 2; channelIndex++) {
+    f32 volume = bus->currentVolume.e[channelIndex];
+    f32 dVolume = bus->dCurrentVolume.e[channelIndex] * secondsPerSample;
+    f32 targetVolume = bus->targetVolume.e[channelIndex];
+    if (dVolume == 0.0f && volume == 1.0f)
+      continue;
+
+    __m256 *samples = channels[channelIndex];
+    __m256 volumes = _mm256_fmadd_ps(sampleLane, _mm256_set1_ps(dVolume), _mm256_set1_ps(volume));
+    __m256 dVolumeChunk = _mm256_set1_ps(dVolume * 8.0f);
+    __m256 targetVolumes = _mm256_set1_ps(targetVolume);
+    for (u32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+      __m256 chunkVolume = volumes;
+      if (dVolume > 0.0f)
+        chunkVolume = _mm256_min_ps(chunkVolume, targetVolumes);
+      else if (dVolume < 0.0f)
+        chunkVolume = _mm256_max_ps(chunkVolume, targetVolumes);
+      samples[chunkIndex] = _mm256_mul_ps(samples[chunkIndex], chunkVolume);
+      volumes = _mm256_add_ps(volumes, dVolumeChunk);
+    }
+
+    volume += dVolume * (f32)(chunkCount * 8);
+    if ((dVolume > 0.0f && volume >= targetVolume) || (dVolume < 0.0f && volume <= targetVolume)) {
+      volume = targetVolume;
+      bus->dCurrentVolume.e[channelIndex] = 0.0f;
+    }
+    bus->currentVolume.e[channelIndex] = volume;
+  }
+}
+
+internal void
+AudioBusProcess(struct audio_bus *bus, __m256 **channels, u32 chunkCount, u32 sampleRate)
+{
+  if (bus->filterType != BIQUAD_TYPE_NONE) {
+    if (bus->filterSampleRate != sampleRate) {
+      BiquadInit(&bus->filter, bus->filterType, bus->filterFrequency, bus->filterQ, sampleRate);
+      bus->filterSampleRate = sampleRate;
+    }
+    for (u32 channelIndex = 0; channelIndex < 2; channelIndex++)
+      BiquadProcess(&bus->filter, &bus->filterStates[channelIndex], channels[channelIndex], chunkCount);
+  }
+
+  if (bus->reverb.wet > 0.0f) {
+    for (u32 channelIndex = 0; channelIndex < 2; channelIndex++)
+      ReverbProcess(&bus->reverb, channelIndex, channels[channelIndex], chunkCount);
+  }
+
+  AudioBusVolume(bus, channels, chunkCount, 1.0f / (f32)sampleRate);
+
+  if (bus->limiter.threshold > 0.0f)
+    LimiterProcess(&bus->limiter, channels[0], channels[1], chunkCount, sampleRate);
 }
 
 b32
-OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *audioBuffer, struct game_assets *assets)
+OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *audioBuffer)
 {
   b32 isWritten = 0;
-  struct memory_temp mixerMemory = BeginTemporaryMemory(audioState->permanentArena);
+  AudioCommandsProcess(audioState);
+  struct audio_snapshot *snapshot = AudioSnapshotBegin(audioState);
+  PlayingAudiosVirtualize(audioState, snapshot);
 
-  u32 generationId = BeginGeneration(assets);
+  struct memory_temp mixerMemory = BeginTemporaryMemory(audioState->permanentArena);
 
-  assert(IS_ALIGNED(audioBuffer->sampleCount, 4));
-  u32 chunkCount = audioBuffer->sampleCount / 4;
+  // NOTE(e2dk4r): mixer works on 8 samples at a time, one chunk fills one __m256
+  assert(IS_ALIGNED(audioBuffer->sampleCount, 8));
+  u32 chunkCount = audioBuffer->sampleCount / 8;
 
-  __m128 *mixerChannel0 = MemoryArenaPushAlignment(audioState->permanentArena, sizeof(*mixerChannel0) * chunkCount, 16);
-  __m128 *mixerChannel1 = MemoryArenaPushAlignment(audioState->permanentArena, sizeof(*mixerChannel1) * chunkCount, 16);
+  // NOTE(e2dk4r): master bus channels are mixer channels
+  __m256 *busChannels[AUDIO_BUS_COUNT][2];
+  for (u32 busIndex = 0; busIndex < AUDIO_BUS_COUNT; busIndex++) {
+    for (u32 channelIndex = 0; channelIndex < 2; channelIndex++)
+      busChannels[busIndex][channelIndex] =
+          MemoryArenaPushAlignment(audioState->permanentArena, sizeof(__m256) * chunkCount, 32);
+  }
+  __m256 *mixerChannel0 = busChannels[AUDIO_BUS_MASTER][0];
+  __m256 *mixerChannel1 = busChannels[AUDIO_BUS_MASTER][1];
 
   f32 secondsPerSample = 1.0f / (f32)audioBuffer->sampleRate;
 
-  __m128 masterVolume0 = _mm_set1_ps(audioState->masterVolume.e[0]);
-  __m128 masterVolume1 = _mm_set1_ps(audioState->masterVolume.e[1]);
+  __m256 masterVolume0 = _mm256_set1_ps(audioState->masterVolume.e[0]);
+  __m256 masterVolume1 = _mm256_set1_ps(audioState->masterVolume.e[1]);
+  __m256 sampleLane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  __m256i one = _mm256_set1_epi32(1);
+  enum audio_resampler resampler = audioState->resampler;
 
   enum { outputChannelCount = 2 };
 
   BEGIN_TIMER_BLOCK(AudioMixer);
 
-  // clear out mixer channels
-  __m128 zero = _mm_set1_ps(0.0f);
-  {
-    __m128 *dest0 = mixerChannel0;
-    __m128 *dest1 = mixerChannel1;
+  // clear out bus channels
+  __m256 zero = _mm256_setzero_ps();
+  for (u32 busIndex = 0; busIndex < AUDIO_BUS_COUNT; busIndex++) {
+    __m256 *dest0 = busChannels[busIndex][0];
+    __m256 *dest1 = busChannels[busIndex][1];
     for (u32 sampleIndex = 0; sampleIndex < chunkCount; sampleIndex++) {
-      _mm_store_ps((f32 *)dest0++, zero);
-      _mm_store_ps((f32 *)dest1++, zero);
+      _mm256_store_ps((f32 *)dest0++, zero);
+      _mm256_store_ps((f32 *)dest1++, zero);
     }
   }
 
@@ -49,40 +749,73 @@ OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *au
   for (struct playing_audio **playingAudioPtr = &audioState->firstPlayingAudio; *playingAudioPtr;) {
     struct playing_audio *playingAudio = *playingAudioPtr;
     b32 isAudioFinished = 0;
+    if (playingAudio->isVirtual)
+      isAudioFinished = PlayingAudioAdvance(playingAudio, snapshot, audioBuffer->sampleCount, secondsPerSample);
+
+    __m256 *dest0 = busChannels[playingAudio->busId][0];
+    __m256 *dest1 = busChannels[playingAudio->busId][1];
+    u32 totalChunksToMix = playingAudio->isVirtual ? 0 : chunkCount;
+    if (playingAudio->isStreaming && !isAudioFinished)
+      AudioStreamKeepAhead(audioState, playingAudio, snapshot, audioBuffer->sampleRate);
+
+    // NOTE(e2dk4r): fade between virtual and real scales master volume, it is 1 when audio is not fading
+    f32 dVirtualFade = playingAudio->dVirtualFade * secondsPerSample;
+    b32 isFading = dVirtualFade != 0.0f;
+    __m256 virtualFade = _mm256_fmadd_ps(sampleLane, _mm256_set1_ps(dVirtualFade),
+                                         _mm256_set1_ps(playingAudio->virtualFade));
+    __m256 dVirtualFadeChunk = _mm256_set1_ps(dVirtualFade * 8.0f);
+    __m256 gain0 = _mm256_mul_ps(masterVolume0, VirtualFadeClamp(virtualFade));
+    __m256 gain1 = _mm256_mul_ps(masterVolume1, VirtualFadeClamp(virtualFade));
+
+    /* NOTE(e2dk4r): Sinc neighbours are entries mixer already has. Audio
+     * before is looked up once per voice, after that chain advance hands
+     * over audio that was mixed.
+     */
+    struct audio_snapshot_audio *previousAudio = 0;
+    if (resampler == AUDIO_RESAMPLER_SINC)
+      previousAudio = AudioSnapshotAudioGet(snapshot, playingAudio->previousId);
 
-    __m128 *dest0 = mixerChannel0;
-    __m128 *dest1 = mixerChannel1;
-    u32 totalChunksToMix = chunkCount;
     while (totalChunksToMix && !isAudioFinished) {
-      struct audio *loadedAudio = AudioGet(assets, playingAudio->id, generationId);
+      struct audio_snapshot_audio *loadedAudio = AudioSnapshotUse(audioState, snapshot, playingAudio->id);
       if (!loadedAudio) {
-        // audio is not in cache
-        AudioLoad(assets, playingAudio->id);
+        // audio is not published
+        if (playingAudio->isStreaming && playingAudio->isStarted) {
+          AtomicFetchAddRelaxed(&audioState->streamUnderrunCount, 1);
+          AtomicFetchAddRelaxed(&audioState->streamUnderrunSampleCount, totalChunksToMix * 8);
+        }
         break;
       }
 
-      struct audio_id nextAudioInChain = AudioGetNextInChain(assets, playingAudio->id);
-      AudioPrefetch(assets, nextAudioInChain);
+      struct audio_id nextAudioInChain = loadedAudio->nextInChain;
+      struct audio_snapshot_audio *nextAudio = AudioSnapshotUse(audioState, snapshot, nextAudioInChain);
 
       struct v2 volume = playingAudio->currentVolume;
       struct v2 dVolume = v2_mul(playingAudio->dCurrentVolume, secondsPerSample);
-      struct v2 dVolumeChunk = v2_mul(dVolume, 4.0f);
+      struct v2 dVolumeChunk = v2_mul(dVolume, 8.0f);
       f32 dSample = playingAudio->dSample;
-      f32 dSampleChunk = dSample * 4.0f;
+      f32 dSampleChunk = dSample * 8.0f;
+
+      __m256i sampleCount = _mm256_set1_epi32((s32)loadedAudio->sampleCount);
 
-      __m128i sampleCount = _mm_set1_epi32((s32)loadedAudio->sampleCount);
+      /* NOTE(e2dk4r): Every source channel is mixed into its output channel.
+       * Mono audio is read once and mixed into both.
+       */
+      assert(loadedAudio->channelCount == 1 || loadedAudio->channelCount == 2);
+      b32 isStereo = loadedAudio->channelCount == 2;
+      s16 *samples0 = loadedAudio->samples[0];
+      s16 *samples1 = isStereo ? loadedAudio->samples[1] : samples0;
+      __m256 sampleOffset = _mm256_mul_ps(sampleLane, _mm256_set1_ps(dSample));
+      f32 *sincCoefficients = SincTableCoefficients(&audioState->sincTable, dSample);
 
       // channel 0
-      __m128 volume0 = _mm_setr_ps(volume.e[0] + 0.0f * dVolume.e[0], volume.e[0] + 1.0f * dVolume.e[0],
-                                   volume.e[0] + 2.0f * dVolume.e[0], volume.e[0] + 3.0f * dVolume.e[0]);
-      __m128 dVolume0 = _mm_set1_ps(dVolume.e[0]);
-      __m128 dVolumeChunk0 = _mm_set1_ps(dVolumeChunk.e[0]);
+      __m256 volume0 =
+          _mm256_add_ps(_mm256_set1_ps(volume.e[0]), _mm256_mul_ps(sampleLane, _mm256_set1_ps(dVolume.e[0])));
+      __m256 dVolumeChunk0 = _mm256_set1_ps(dVolumeChunk.e[0]);
 
       // channel 1
-      __m128 volume1 = _mm_setr_ps(volume.e[1] + 0.0f * dVolume.e[1], volume.e[1] + 1.0f * dVolume.e[1],
-                                   volume.e[1] + 2.0f * dVolume.e[1], volume.e[1] + 3.0f * dVolume.e[1]);
-      __m128 dVolume1 = _mm_set1_ps(dVolume.e[1]);
-      __m128 dVolumeChunk1 = _mm_set1_ps(dVolumeChunk.e[1]);
+      __m256 volume1 =
+          _mm256_add_ps(_mm256_set1_ps(volume.e[1]), _mm256_mul_ps(sampleLane, _mm256_set1_ps(dVolume.e[1])));
+      __m256 dVolumeChunk1 = _mm256_set1_ps(dVolumeChunk.e[1]);
 
       assert(playingAudio->samplesPlayed >= 0.0f);
 
@@ -106,67 +839,93 @@ OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *au
         }
       }
 
-      // TODO(e2dk4r): handle stereo
       f32 beginSamplePosition = playingAudio->samplesPlayed;
       f32 endSamplePosition = beginSamplePosition + ((f32)chunksToMix * dSampleChunk);
       f32 loopIndexC = (endSamplePosition - beginSamplePosition) / (f32)chunksToMix;
-      for (u32 loopIndex = 0; loopIndex < chunksToMix; loopIndex++) {
+      u32 loopIndex = 0;
+
+      /* NOTE(e2dk4r): At unity pitch from whole sample position every lane
+       * lands on a sample, so interpolation is identity and samples can be
+       * loaded contiguously. Only chunks whose samples and next samples are
+       * all inside audio take this path, rest go through general path below
+       * which masks samples past the end. They are read with nearest in
+       * every mode, so they are not filtered unlike the rest of audio.
+       */
+      u32 firstSampleIndex = (u32)beginSamplePosition;
+      b32 isUnityPitch = dSample == 1.0f && (f32)firstSampleIndex == beginSamplePosition;
+      enum audio_resampler chunkResampler = isUnityPitch ? AUDIO_RESAMPLER_NEAREST : resampler;
+      if (isUnityPitch && firstSampleIndex < loadedAudio->sampleCount) {
+        u32 contiguousChunkCount = (loadedAudio->sampleCount - 1 - firstSampleIndex) / 8;
+        if (contiguousChunkCount > chunksToMix)
+          contiguousChunkCount = chunksToMix;
+
+        s16 *source0 = samples0 + firstSampleIndex;
+        s16 *source1 = samples1 + firstSampleIndex;
+        for (; loopIndex < contiguousChunkCount; loopIndex++) {
+          __m256 sampleValue0 = SampleContiguous(source0);
+          __m256 sampleValue1 = sampleValue0;
+          if (isStereo)
+            sampleValue1 = SampleContiguous(source1);
+          source0 += 8;
+          source1 += 8;
+
+          MixChunk(dest0++, dest1++, _mm256_mul_ps(gain0, volume0), _mm256_mul_ps(gain1, volume1), sampleValue0,
+                   sampleValue1);
+
+          volume0 = _mm256_add_ps(volume0, dVolumeChunk0);
+          volume1 = _mm256_add_ps(volume1, dVolumeChunk1);
+          if (isFading) {
+            virtualFade = _mm256_add_ps(virtualFade, dVirtualFadeChunk);
+            gain0 = _mm256_mul_ps(masterVolume0, VirtualFadeClamp(virtualFade));
+            gain1 = _mm256_mul_ps(masterVolume1, VirtualFadeClamp(virtualFade));
+          }
+        }
+      }
+
+      struct sinc_neighbor sincBefore = {};
+      struct sinc_neighbor sincAfter = {};
+      if (chunkResampler == AUDIO_RESAMPLER_SINC) {
+        sincBefore = SincNeighbor(previousAudio, loadedAudio->channelCount);
+        sincAfter = SincNeighbor(nextAudio, loadedAudio->channelCount);
+      }
+
+      for (; loopIndex < chunksToMix; loopIndex++) {
         f32 samplePosition = beginSamplePosition + loopIndexC * (f32)loopIndex;
-#if 1
-        // linear interpolation
-        __m128 samplePos = _mm_setr_ps(samplePosition + 0.0f * dSample, samplePosition + 1.0f * dSample,
-                                       samplePosition + 2.0f * dSample, samplePosition + 3.0f * dSample);
-        __m128i sampleIndex = _mm_cvttps_epi32(samplePos);
-        __m128 frac = _mm_sub_ps(samplePos, _mm_cvtepi32_ps(sampleIndex));
-
-        union m128i {
-          __m128i value;
-          struct {
-            s32 a;
-            s32 b;
-            s32 c;
-            s32 d;
-          };
-        };
-        __m128 sampleValue0 = _mm_setr_ps(loadedAudio->samples[0][((union m128i)sampleIndex).a],
-                                          loadedAudio->samples[0][((union m128i)sampleIndex).b],
-                                          loadedAudio->samples[0][((union m128i)sampleIndex).c],
-                                          loadedAudio->samples[0][((union m128i)sampleIndex).d]);
-
-        sampleIndex = _mm_add_epi32(sampleIndex, _mm_set1_epi32(1));
-        __m128 sampleValue1 = _mm_setr_ps(loadedAudio->samples[0][((union m128i)sampleIndex).a],
-                                          loadedAudio->samples[0][((union m128i)sampleIndex).b],
-                                          loadedAudio->samples[0][((union m128i)sampleIndex).c],
-                                          loadedAudio->samples[0][((union m128i)sampleIndex).d]);
-
-#define _mm_lerp(a, b, t) _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), t), a), _mm_mul_ps(t, b));
-        __m128 sampleValue = _mm_lerp(sampleValue0, sampleValue1, frac);
-#else
-        __m128 sampleValue = _mm_setr_ps(loadedAudio->samples[0][roundf32tou32(samplePosition + 0.0f * dSample)],
-                                         loadedAudio->samples[0][roundf32tou32(samplePosition + 1.0f * dSample)],
-                                         loadedAudio->samples[0][roundf32tou32(samplePosition + 2.0f * dSample)],
-                                         loadedAudio->samples[0][roundf32tou32(samplePosition + 3.0f * dSample)]);
-
-#endif
-
-        __m128 sampleMask =
-            _mm_cvtepi32_ps(_mm_and_si128(_mm_cmplt_epi32(sampleIndex, sampleCount), _mm_set1_epi32(1)));
-        sampleValue = _mm_mul_ps(sampleValue, sampleMask);
-
-        __m128 d0 = _mm_load_ps((f32 *)&dest0[0]);
-        __m128 d1 = _mm_load_ps((f32 *)&dest1[0]);
-
-        d0 = _mm_add_ps(d0, _mm_mul_ps(_mm_mul_ps(masterVolume0, volume0), sampleValue));
-        d1 = _mm_add_ps(d1, _mm_mul_ps(_mm_mul_ps(masterVolume1, volume1), sampleValue));
-
-        _mm_store_ps((f32 *)&dest0[0], d0);
-        _mm_store_ps((f32 *)&dest1[0], d1);
-
-        dest0++;
-        dest1++;
-
-        volume0 = _mm_add_ps(volume0, dVolumeChunk0);
-        volume1 = _mm_add_ps(volume1, dVolumeChunk1);
+        __m256 samplePos = _mm256_add_ps(_mm256_set1_ps(samplePosition), sampleOffset);
+        __m256 sampleValue0;
+        __m256 sampleValue1;
+        if (chunkResampler == AUDIO_RESAMPLER_SINC) {
+          SampleSinc(sincCoefficients, samples0, samples1, isStereo, loadedAudio->sampleCount, &sincBefore,
+                     &sincAfter, samplePos, &sampleValue0, &sampleValue1);
+        } else if (chunkResampler == AUDIO_RESAMPLER_LINEAR) {
+          __m256i sampleIndex = _mm256_cvttps_epi32(samplePos);
+          __m256 frac = _mm256_sub_ps(samplePos, _mm256_cvtepi32_ps(sampleIndex));
+          __m256i sampleMask = _mm256_cmpgt_epi32(sampleCount, _mm256_add_epi32(sampleIndex, one));
+
+          sampleValue0 = SampleLinear(samples0, sampleIndex, sampleMask, frac);
+          sampleValue1 = sampleValue0;
+          if (isStereo)
+            sampleValue1 = SampleLinear(samples1, sampleIndex, sampleMask, frac);
+        } else {
+          __m256i sampleIndex = _mm256_cvtps_epi32(samplePos);
+          __m256i sampleMask = _mm256_cmpgt_epi32(sampleCount, sampleIndex);
+
+          sampleValue0 = SampleNearest(samples0, sampleIndex, sampleMask);
+          sampleValue1 = sampleValue0;
+          if (isStereo)
+            sampleValue1 = SampleNearest(samples1, sampleIndex, sampleMask);
+        }
+
+        MixChunk(dest0++, dest1++, _mm256_mul_ps(gain0, volume0), _mm256_mul_ps(gain1, volume1), sampleValue0,
+                 sampleValue1);
+
+        volume0 = _mm256_add_ps(volume0, dVolumeChunk0);
+        volume1 = _mm256_add_ps(volume1, dVolumeChunk1);
+        if (isFading) {
+          virtualFade = _mm256_add_ps(virtualFade, dVirtualFadeChunk);
+          gain0 = _mm256_mul_ps(masterVolume0, VirtualFadeClamp(virtualFade));
+          gain1 = _mm256_mul_ps(masterVolume1, VirtualFadeClamp(virtualFade));
+        }
       }
 
       playingAudio->currentVolume.e[0] = volume0[0];
@@ -185,10 +944,13 @@ OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *au
       totalChunksToMix -= chunksToMix;
 
       isWritten = 1;
+      playingAudio->isStarted = 1;
 
       if (chunksToMix == chunksRemainingInAudio) {
         if (IsAudioIdValid(nextAudioInChain)) {
+          playingAudio->previousId = playingAudio->id;
           playingAudio->id = nextAudioInChain;
+          previousAudio = loadedAudio;
 
           assert(playingAudio->samplesPlayed >= (f32)loadedAudio->sampleCount);
           playingAudio->samplesPlayed -= (f32)loadedAudio->sampleCount;
@@ -201,6 +963,19 @@ OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *au
       }
     }
 
+    if (isFading) {
+      f32 fade = playingAudio->virtualFade + dVirtualFade * (f32)audioBuffer->sampleCount;
+      if (fade >= 1.0f) {
+        fade = 1.0f;
+        playingAudio->dVirtualFade = 0.0f;
+      } else if (fade <= 0.0f) {
+        fade = 0.0f;
+        playingAudio->dVirtualFade = 0.0f;
+        playingAudio->isVirtual = 1;
+      }
+      playingAudio->virtualFade = fade;
+    }
+
     if (isAudioFinished) {
       *playingAudioPtr = playingAudio->next;
       playingAudio->next = audioState->firstFreePlayingAudio;
@@ -210,76 +985,216 @@ OutputPlayingAudios(struct audio_state *audioState, struct game_audio_buffer *au
     }
   }
 
+  // mix buses down to master
+  for (u32 busIndex = AUDIO_BUS_COUNT - 1; busIndex < AUDIO_BUS_COUNT; busIndex--) {
+    struct audio_bus *bus = audioState->buses + busIndex;
+    __m256 **channels = busChannels[busIndex];
+    AudioBusProcess(bus, channels, chunkCount, audioBuffer->sampleRate);
+
+    // reverb keeps ringing after its audios stop
+    if (bus->reverb.wet > 0.0f)
+      isWritten = 1;
+
+    if (busIndex == AUDIO_BUS_MASTER)
+      continue;
+
+    assert(bus->parent < busIndex);
+    __m256 **parentChannels = busChannels[bus->parent];
+    for (u32 channelIndex = 0; channelIndex < 2; channelIndex++) {
+      __m256 *source = channels[channelIndex];
+      __m256 *dest = parentChannels[channelIndex];
+      for (u32 sampleIndex = 0; sampleIndex < chunkCount; sampleIndex++)
+        dest[sampleIndex] = _mm256_add_ps(dest[sampleIndex], source[sampleIndex]);
+    }
+  }
+
   // convert to 16-bit
   if (isWritten) {
-    __m128 *source0 = mixerChannel0;
-    __m128 *source1 = mixerChannel1;
+    __m256 *source0 = mixerChannel0;
+    __m256 *source1 = mixerChannel1;
 
-    __m128i *sampleOut = (__m128i *)audioBuffer->samples;
+    __m256i *sampleOut = (__m256i *)audioBuffer->samples;
     for (u32 sampleIndex = 0; sampleIndex < chunkCount; sampleIndex++) {
-      __m128 s0 = _mm_load_ps((f32 *)source0++);
-      __m128 s1 = _mm_load_ps((f32 *)source1++);
+      __m256 s0 = _mm256_load_ps((f32 *)source0++);
+      __m256 s1 = _mm256_load_ps((f32 *)source1++);
 
-      __m128i l = _mm_cvtps_epi32(s0);
-      __m128i r = _mm_cvtps_epi32(s1);
+      __m256i l = _mm256_cvtps_epi32(s0);
+      __m256i r = _mm256_cvtps_epi32(s1);
 
-      __m128i lr0 = _mm_unpacklo_epi32(l, r);
-      __m128i lr1 = _mm_unpackhi_epi32(l, r);
+      // NOTE(e2dk4r): unpack and pack work within 128-bit lanes, so samples stay in order
+      __m256i lr0 = _mm256_unpacklo_epi32(l, r);
+      __m256i lr1 = _mm256_unpackhi_epi32(l, r);
 
-      __m128i s01 = _mm_packs_epi32(lr0, lr1);
+      __m256i s01 = _mm256_packs_epi32(lr0, lr1);
 
-      *sampleOut++ = s01;
+      _mm256_storeu_si256(sampleOut++, s01);
     }
   }
 
   END_TIMER_BLOCK(AudioMixer);
 
-  EndGeneration(assets, generationId);
   EndTemporaryMemory(&mixerMemory);
+  AudioSnapshotEnd(audioState);
   return isWritten;
 }
 
-struct playing_audio *
-PlayAudio(struct audio_state *audioState, struct audio_id id)
+internal struct playing_audio_id
+PlayAudioCommand(struct audio_state *audioState, struct audio_id id, f32 priority, b32 isStreaming)
 {
-  if (!audioState->firstFreePlayingAudio) {
-    audioState->firstFreePlayingAudio =
-        MemoryArenaPush(audioState->permanentArena, sizeof(*audioState->firstPlayingAudio));
-    audioState->firstFreePlayingAudio->next = 0;
-  }
+  audioState->nextPlayingAudioId++;
+  if (audioState->nextPlayingAudioId == 0)
+    audioState->nextPlayingAudioId = 1;
+
+  // NOTE(e2dk4r): when it is full, audio is published after mixer asks for it
+  if (audioState->playedCount < AUDIO_PLAYED_COUNT_MAX)
+    audioState->playedIds[audioState->playedCount++] = id;
 
-  struct playing_audio *playingAudio = audioState->firstFreePlayingAudio;
-  audioState->firstFreePlayingAudio = playingAudio->next;
-  playingAudio->samplesPlayed = 0;
-  playingAudio->currentVolume = playingAudio->targetVolume = v2(1.0f, 1.0f);
-  playingAudio->dCurrentVolume = v2(0.0f, 0.0f);
-  playingAudio->dSample = 1.0f;
-  playingAudio->id = id;
+  struct playing_audio_id playingAudioId = {audioState->nextPlayingAudioId};
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_PLAY,
+      .playingAudioId = playingAudioId,
+      .audioId = id,
+      .priority = priority,
+      .isStreaming = isStreaming,
+  };
+  AudioCommandPush(audioState, &command);
 
-  playingAudio->next = audioState->firstPlayingAudio;
-  audioState->firstPlayingAudio = playingAudio;
+  return playingAudioId;
+}
+
+struct playing_audio_id
+PlayAudio(struct audio_state *audioState, struct audio_id id)
+{
+  return PlayAudioCommand(audioState, id, AUDIO_PRIORITY_DEFAULT, 0);
+}
+
+struct playing_audio_id
+PlayAudioPriority(struct audio_state *audioState, struct audio_id id, f32 priority)
+{
+  return PlayAudioCommand(audioState, id, priority, 0);
+}
 
-  return playingAudio;
+struct playing_audio_id
+PlayAudioStream(struct audio_state *audioState, struct audio_id id, f32 priority)
+{
+  return PlayAudioCommand(audioState, id, priority, 1);
 }
 
 void
-ChangeVolume(struct audio_state *audioState, struct playing_audio *playingAudio, f32 fadeDurationInSeconds,
+ChangeVolume(struct audio_state *audioState, struct playing_audio_id playingAudioId, f32 fadeDurationInSeconds,
              struct v2 volume)
 {
-  if (!playingAudio)
+  if (!playingAudioId.value)
     return;
 
-  if (fadeDurationInSeconds <= 0.0f) {
-    playingAudio->currentVolume = playingAudio->targetVolume = volume;
-  } else {
-    playingAudio->targetVolume = volume;
-    playingAudio->dCurrentVolume =
-        v2_mul(v2_sub(playingAudio->targetVolume, playingAudio->currentVolume), 1.0f / fadeDurationInSeconds);
-  }
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_VOLUME,
+      .playingAudioId = playingAudioId,
+      .fadeDurationInSeconds = fadeDurationInSeconds,
+      .volume = volume,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangePitch(struct audio_state *audioState, struct playing_audio_id playingAudioId, f32 dSample)
+{
+  if (!playingAudioId.value)
+    return;
+
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_PITCH,
+      .playingAudioId = playingAudioId,
+      .dSample = dSample,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangeRealAudioCount(struct audio_state *audioState, u32 realAudioCountMax)
+{
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_REAL_AUDIO_COUNT,
+      .realAudioCountMax = realAudioCountMax,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangeResampler(struct audio_state *audioState, enum audio_resampler resampler)
+{
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_RESAMPLER,
+      .resampler = resampler,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangeBus(struct audio_state *audioState, struct playing_audio_id playingAudioId, enum audio_bus_id busId)
+{
+  if (!playingAudioId.value)
+    return;
+
+  assert(busId < AUDIO_BUS_COUNT);
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_BUS,
+      .playingAudioId = playingAudioId,
+      .busId = busId,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangeBusVolume(struct audio_state *audioState, enum audio_bus_id busId, f32 fadeDurationInSeconds, struct v2 volume)
+{
+  assert(busId < AUDIO_BUS_COUNT);
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_BUS_VOLUME,
+      .busId = busId,
+      .fadeDurationInSeconds = fadeDurationInSeconds,
+      .volume = volume,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangeBusFilter(struct audio_state *audioState, enum audio_bus_id busId, enum biquad_type type, f32 frequency, f32 q)
+{
+  assert(busId < AUDIO_BUS_COUNT);
+  // NOTE(e2dk4r): frequency is also clamped below nyquist when filter is built
+  assert(type == BIQUAD_TYPE_NONE || (frequency > 0.0f && q > 0.0f));
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_BUS_FILTER,
+      .busId = busId,
+      .filterType = type,
+      .filterFrequency = frequency,
+      .filterQ = q,
+  };
+  AudioCommandPush(audioState, &command);
+}
+
+void
+ChangeBusReverb(struct audio_state *audioState, enum audio_bus_id busId, f32 wet, f32 roomSize)
+{
+  assert(busId < AUDIO_BUS_COUNT);
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_BUS_REVERB,
+      .busId = busId,
+      .reverbWet = wet,
+      .reverbRoomSize = roomSize,
+  };
+  AudioCommandPush(audioState, &command);
 }
 
 void
-ChangePitch(struct audio_state *audioState, struct playing_audio *playingAudio, f32 dSample)
+ChangeBusLimiter(struct audio_state *audioState, enum audio_bus_id busId, f32 threshold)
 {
-  playingAudio->dSample = dSample;
+  assert(busId < AUDIO_BUS_COUNT);
+  struct audio_command command = {
+      .type = AUDIO_COMMAND_TYPE_CHANGE_BUS_LIMITER,
+      .busId = busId,
+      .limiterThreshold = threshold,
+  };
+  AudioCommandPush(audioState, &command);
 }
@@ -19,6 +19,7 @@
 #include <pipewire/pipewire.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <spa/node/io.h>
 #include <spa/param/audio/format-utils.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -56,6 +57,7 @@
 #define PAUSE_WHEN_SURFACE_OUT_OF_FOCUS 0
 #define RESOLUTION 1080
 #define DISABLE_SURFACE_SCALING 0
+#define AUDIO_LOW_LATENCY 0
 
 /*****************************************************************
  * platform layer implementation
@@ -64,6 +66,8 @@
 struct linux_file_handle {
   s64 lastError;
   s32 fd;
+  // NOTE(e2dk4r): kept for opening file again when it is replaced
+  char path[256];
 };
 
 struct linux_file_group {
@@ -102,11 +106,10 @@ LinuxDeallocateMemory(void *memory)
   memory = 0;
 }
 
-struct platform_file_handle
-LinuxOpenNextFile(struct platform_file_group *platformFileGroup)
+internal struct platform_file_handle
+LinuxOpenFile(char *path)
 {
   struct platform_file_handle platformFileHandle = {};
-  struct linux_file_group *fileGroup = platformFileGroup->data;
 
   struct linux_file_handle *fileHandle =
       mmap(0, sizeof(*fileHandle), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
@@ -115,13 +118,12 @@ LinuxOpenNextFile(struct platform_file_group *platformFileGroup)
   }
   platformFileHandle.data = fileHandle;
 
-  long direntIndex = fileGroup->direntIndexes[fileGroup->fileIndex];
-  seekdir(fileGroup->dir, direntIndex);
-  struct dirent *dirent = readdir(fileGroup->dir);
-  assert(dirent != 0);
-
-  char *path = dirent->d_name;
-  fileGroup->fileIndex++;
+  u64 pathLength = 0;
+  while (path[pathLength] && pathLength + 1 < sizeof(fileHandle->path)) {
+    fileHandle->path[pathLength] = path[pathLength];
+    pathLength++;
+  }
+  fileHandle->path[pathLength] = 0;
 
   s32 fd = open(path, O_RDONLY);
   if (fd < 0) {
@@ -151,6 +153,8 @@ LinuxOpenNextFile(struct platform_file_group *platformFileGroup)
 onError:
   // TODO: unmap failed?
   munmap(fileHandle, sizeof(*fileHandle));
+  // NOTE(e2dk4r): handle with error can still be closed
+  platformFileHandle.data = 0;
 
   if (fd >= 0) {
     // TODO: is file closed?
@@ -159,45 +163,83 @@ onError:
   return platformFileHandle;
 }
 
+struct platform_file_handle
+LinuxOpenNextFile(struct platform_file_group *platformFileGroup)
+{
+  struct linux_file_group *fileGroup = platformFileGroup->data;
+
+  long direntIndex = fileGroup->direntIndexes[fileGroup->fileIndex];
+  seekdir(fileGroup->dir, direntIndex);
+  struct dirent *dirent = readdir(fileGroup->dir);
+  assert(dirent != 0);
+
+  char *path = dirent->d_name;
+  fileGroup->fileIndex++;
+
+  return LinuxOpenFile(path);
+}
+
+struct platform_file_handle
+LinuxReopenFile(struct platform_file_handle *platformFileHandle)
+{
+  struct linux_file_handle *fileHandle = platformFileHandle->data;
+  return LinuxOpenFile(fileHandle->path);
+}
+
+b32
+LinuxIsSameFile(struct platform_file_handle *platformFileHandle, struct platform_file_handle *otherPlatformFileHandle)
+{
+  struct linux_file_handle *fileHandle = platformFileHandle->data;
+  struct linux_file_handle *otherFileHandle = otherPlatformFileHandle->data;
+  if (!fileHandle || !otherFileHandle)
+    return 0;
+
+  return strcmp(fileHandle->path, otherFileHandle->path) == 0;
+}
+
+void
+LinuxCloseFile(struct platform_file_handle *platformFileHandle)
+{
+  struct linux_file_handle *fileHandle = platformFileHandle->data;
+  if (!fileHandle)
+    return;
+
+  close(fileHandle->fd);
+
+  // TODO: unmap failed?
+  munmap(fileHandle, sizeof(*fileHandle));
+  platformFileHandle->data = 0;
+}
+
 void
 LinuxReadFromFile(void *dest, struct platform_file_handle *platformFileHandle, u64 offset, u64 size)
 {
-  // TODO: use io_uring instead of locking
   struct linux_file_handle *fileHandle = platformFileHandle->data;
 
-  global_variable pthread_mutex_t fileReadLock;
-  pthread_mutex_lock(&fileReadLock);
+  // NOTE(e2dk4r): pread does not use file offset, so any thread can read from same file without locking
+  u8 *destination = dest;
+  while (size) {
+    ssize_t bytesRead = pread64(fileHandle->fd, destination, size, (off64_t)offset);
+    if (bytesRead < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
 
-  u64 seekTry = 100;
-  while (seekTry) {
-    off64_t lseekResult = lseek64(fileHandle->fd, (off64_t)offset, SEEK_SET);
-    if (lseekResult == -1 && errno != EAGAIN) {
-      platformFileHandle->error = HANDMADEHERO_ERROR_FILE_SEEK;
+      platformFileHandle->error = HANDMADEHERO_ERROR_READ_FROM_FILE;
       fileHandle->lastError = errno;
-      goto end;
-    } else if (lseekResult == (off64_t)offset) {
-      break;
+      return;
     }
 
-    seekTry--;
-  }
+    if (bytesRead == 0) {
+      // end of file reached before size
+      platformFileHandle->error = HANDMADEHERO_ERROR_READ_FROM_FILE;
+      fileHandle->lastError = 0;
+      return;
+    }
 
-  if (seekTry == 0) {
-    // tried so hard, got so far
-    platformFileHandle->error = HANDMADEHERO_ERROR_FILE_SEEK;
-    fileHandle->lastError = EAGAIN;
-    goto end;
+    destination += bytesRead;
+    offset += (u64)bytesRead;
+    size -= (u64)bytesRead;
   }
-
-  ssize_t bytesRead = read(fileHandle->fd, dest, size);
-  if (bytesRead < 0) {
-    platformFileHandle->error = HANDMADEHERO_ERROR_PATH_IS_NOT_FILE;
-    fileHandle->lastError = errno;
-    goto end;
-  }
-
-end:
-  pthread_mutex_unlock(&fileReadLock);
 }
 
 struct platform_file_group
@@ -299,6 +341,8 @@ LinuxFileError(struct platform_file_handle *platformFileHandle, enum handmadeher
 
       "file is not hha",
       "hha version is not supported",
+      "hha is malformed",
+      "hha checksum mismatch",
   };
   char *errorMessage = errorMessages[error];
 
@@ -341,7 +385,7 @@ PlatformReadEntireFile(char *path)
 u8
 PlatformWriteEntireFile(char *path, u64 size, void *data)
 {
-  int fd = open(path, O_WRONLY);
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
   if (fd < 0)
     return 0;
 
@@ -368,8 +412,8 @@ HandleCycleCounters(struct game_memory *memory)
 #if HANDMADEHERO_INTERNAL
   debugf("CYCLE COUNTS:\n");
 
-  char *counterNameTable[] = {"GameUpdateAndRender", "DrawRenderGroup",      "DrawRectangleSlowly",
-                              "ProcessPixel",        "DrawRectangleQuickly", "AudioMixer"};
+  char *counterNameTable[] = {"GameUpdateAndRender",  "DrawRenderGroup", "DrawRectangleSlowly", "ProcessPixel",
+                              "DrawRectangleQuickly", "AudioMixer",      "AudioCallback"};
   static_assert(ARRAY_COUNT(counterNameTable) == CYCLE_COUNTER_COUNT);
 
   for (u32 counterIndex = 0; counterIndex < ARRAY_COUNT(memory->counters); counterIndex++) {
@@ -384,6 +428,11 @@ HandleCycleCounters(struct game_memory *memory)
     counter->hitCount = 0;
     counter->cycleCount = 0;
   }
+
+  struct platform_audio_telemetry *audio = &memory->audioTelemetry;
+  debugf("  audio: quantum %u requested %u max %u underrun %u latency %" PRIu64 "us max %" PRIu64 "us\n",
+         audio->quantum, audio->requestedSampleCount, audio->requestedSampleCountMax, audio->underrunCount,
+         audio->latencyNanoseconds / 1000, audio->latencyNanosecondsMax / 1000);
 #endif
 }
 
@@ -422,12 +471,15 @@ struct game_code {
   time_t time;
   void *module;
   volatile u32 isReloading;
+  // audio thread is running game code
+  volatile u32 isAudioRunning;
 
   struct linux_work_queue *highPriorityQueue;
   struct linux_work_queue *lowPriorityQueue;
 
   pfnGameUpdateAndRender GameUpdateAndRender;
   pfnGameOutputAudio GameOutputAudio;
+  pfnGameShutdown GameShutdown;
 };
 
 internal u8
@@ -445,7 +497,11 @@ ReloadGameCode(struct game_code *lib)
     return 0;
   }
 
-  __atomic_store_n(&lib->isReloading, 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&lib->isReloading, 1, __ATOMIC_SEQ_CST);
+  // NOTE(e2dk4r): audio thread does not wait for reload, only game code it
+  // already entered must return before unloading
+  while (__atomic_load_n(&lib->isAudioRunning, __ATOMIC_SEQ_CST))
+    ;
   LinuxWorkQueueCompleteAllWork(lib->highPriorityQueue);
   LinuxWorkQueueCompleteAllWork(lib->lowPriorityQueue);
 
@@ -469,6 +525,9 @@ ReloadGameCode(struct game_code *lib)
   lib->GameOutputAudio = dlsym(lib->module, "GameOutputAudio");
   assert(lib->GameOutputAudio != 0 && "wrong module format");
 
+  lib->GameShutdown = dlsym(lib->module, "GameShutdown");
+  assert(lib->GameShutdown != 0 && "wrong module format");
+
   // update module time
   lib->time = sb.st_mtime;
   debugf("[ReloadGameCode] reloaded @%d\n", lib->time);
@@ -509,6 +568,9 @@ struct linux_state {
   struct pw_thread_loop *pw_thread_loop;
   struct pw_stream *pw_stream;
   struct memory_arena pw_arena;
+  // clock of graph stream is in, set by audio server
+  struct spa_io_position *pw_position;
+  u64 pw_lastCycleNanoseconds;
 
   struct game_input gameInputs[2];
   struct game_input *input;
@@ -520,6 +582,9 @@ struct linux_state {
   u32 surfaceWidth;
   u32 surfaceHeight;
 
+  /* set by inotify when an asset pack is written, consumed on next frame */
+  u8 assetFilesChanged : 1;
+
 #if HANDMADEHERO_DEBUG
   struct game_code lib;
   u8 recordInputIndex;
@@ -647,23 +712,66 @@ begin:
  *****************************************************************/
 comptime u32 SAMPLE_RATE = 48000;
 comptime u32 SAMPLE_CHANNELS = 2;
+/* NOTE(e2dk4r): Audio server runs graph in cycles of quantum samples, picked
+ * from latencies streams ask for. Other streams can make it bigger than ours,
+ * up to clock.max-quantum which is 8192 by default, so buffers are sized for
+ * that instead of a second of audio.
+ */
+comptime u32 AUDIO_QUANTUM_MAX = 8192;
+#if AUDIO_LOW_LATENCY
+comptime u32 AUDIO_LATENCY_SAMPLE_COUNT = 128;
+#else
+comptime u32 AUDIO_LATENCY_SAMPLE_COUNT = 512;
+#endif
+
+// samples at stream rate in one cycle of graph
+internal u32
+AudioGraphSampleCount(struct spa_io_position *position)
+{
+  struct spa_fraction rate = position->clock.rate;
+  if (rate.denom == 0)
+    return 0;
+  return (u32)(position->clock.duration * SAMPLE_RATE * rate.num / rate.denom);
+}
 
 internal void
 pw_stream_process(void *data)
 {
   struct linux_state *state = data;
-#if HANDMADEHERO_DEBUG
-  while (state->lib.isReloading)
-    ; // spin lock
+#if HANDMADEHERO_INTERNAL
+  u64 startCycleCount = rdtsc();
+  struct platform_audio_telemetry *telemetry = &state->game_memory.audioTelemetry;
+#endif
+
+  u32 quantum = 0;
+  struct spa_io_position *position = state->pw_position;
+  if (position) {
+    quantum = AudioGraphSampleCount(position);
 
-  // from game layer
-  pfnGameOutputAudio GameOutputAudio = state->lib.GameOutputAudio;
+#if HANDMADEHERO_INTERNAL
+    u64 cycleNanoseconds = position->clock.nsec;
+    if (state->pw_lastCycleNanoseconds && cycleNanoseconds > state->pw_lastCycleNanoseconds) {
+      u64 interval = cycleNanoseconds - state->pw_lastCycleNanoseconds;
+      telemetry->cycleIntervalNanoseconds = interval;
+      telemetry->cycleIntervalNanosecondsMax = Maximum(telemetry->cycleIntervalNanosecondsMax, interval);
+
+      // graph went on without us at least once
+      u64 quantumNanoseconds = (u64)quantum * 1000000000 / SAMPLE_RATE;
+      if (quantumNanoseconds && interval > quantumNanoseconds + quantumNanoseconds / 2)
+        telemetry->underrunCount++;
+    }
+    state->pw_lastCycleNanoseconds = cycleNanoseconds;
+    telemetry->quantum = quantum;
 #endif
+  }
 
   // Obtain a buffer to write into.
   struct pw_buffer *pwBuffer = pw_stream_dequeue_buffer(state->pw_stream);
   if (!pwBuffer) {
     debug("[pw_stream_events::process] out of buffers\n");
+#if HANDMADEHERO_INTERNAL
+    telemetry->underrunCount++;
+#endif
     return;
   }
 
@@ -678,12 +786,23 @@ pw_stream_process(void *data)
 
   u32 stride = sizeof(u16) * SAMPLE_CHANNELS;
   u32 sampleCount = datas[0].maxsize / stride;
+  u32 requestedSampleCount = quantum;
 #if PW_CHECK_VERSION(0, 3, 49)
   if (pwBuffer->requested) {
-    sampleCount = Minimum((u32)pwBuffer->requested, sampleCount);
+    requestedSampleCount = (u32)pwBuffer->requested;
   }
 #endif
-  sampleCount = ALIGN4(sampleCount);
+  if (requestedSampleCount) {
+    sampleCount = Minimum(requestedSampleCount, sampleCount);
+  }
+#if HANDMADEHERO_INTERNAL
+  telemetry->requestedSampleCount = requestedSampleCount;
+  telemetry->requestedSampleCountMax = Maximum(telemetry->requestedSampleCountMax, requestedSampleCount);
+#endif
+  // NOTE(e2dk4r): game mixes 8 samples at a time
+  sampleCount = ALIGN8(sampleCount);
+  if (sampleCount * stride > datas[0].maxsize)
+    sampleCount -= 8;
 
   // Write data into buffer.
   struct game_audio_buffer gameAudioBuffer = {
@@ -691,7 +810,24 @@ pw_stream_process(void *data)
       .sampleCount = sampleCount,
       .samples = samples,
   };
-  b32 isWritten = GameOutputAudio(&state->game_memory, &gameAudioBuffer);
+  b32 isWritten = 0;
+#if HANDMADEHERO_DEBUG
+  /* NOTE(e2dk4r): Realtime thread never waits for game code to reload, it
+   * outputs silence instead. Reloader waits for game code this thread
+   * entered to return.
+   */
+  __atomic_store_n(&state->lib.isAudioRunning, 1, __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&state->lib.isReloading, __ATOMIC_SEQ_CST)) {
+    // from game layer
+    pfnGameOutputAudio GameOutputAudio = state->lib.GameOutputAudio;
+    isWritten = GameOutputAudio(&state->game_memory, &gameAudioBuffer);
+  } else {
+    telemetry->underrunCount++;
+  }
+  __atomic_store_n(&state->lib.isAudioRunning, 0, __ATOMIC_RELEASE);
+#else
+  isWritten = GameOutputAudio(&state->game_memory, &gameAudioBuffer);
+#endif
 
   // Adjust buffer with number of written bytes, offset, stride.
   if (isWritten) {
@@ -701,9 +837,30 @@ pw_stream_process(void *data)
   } else {
     datas[0].chunk->size = 0;
   }
+  // NOTE(e2dk4r): queued time of stream is sum of sizes, in samples for audio
+  pwBuffer->size = isWritten ? sampleCount : 0;
+
+#if HANDMADEHERO_INTERNAL && PW_CHECK_VERSION(0, 3, 50)
+  /* NOTE(e2dk4r): Samples written now are heard after what is queued in
+   * stream, buffered in its converter, and delay of graph to device.
+   */
+  struct pw_time time;
+  if (pw_stream_get_time_n(state->pw_stream, &time, sizeof(time)) == 0 && time.rate.denom && time.delay >= 0) {
+    u64 delayNanoseconds = (u64)time.delay * 1000000000 * time.rate.num / time.rate.denom;
+    u64 queuedNanoseconds = (time.queued + time.buffered) * 1000000000 / SAMPLE_RATE;
+    telemetry->latencyNanoseconds = delayNanoseconds + queuedNanoseconds;
+    telemetry->latencyNanosecondsMax = Maximum(telemetry->latencyNanosecondsMax, telemetry->latencyNanoseconds);
+  }
+#endif
 
   // Queue the buffer for playback.
   pw_stream_queue_buffer(state->pw_stream, pwBuffer);
+
+#if HANDMADEHERO_INTERNAL
+  struct cycle_counter *counter = state->game_memory.counters + CYCLE_COUNTER_AudioCallback;
+  counter->cycleCount += rdtsc() - startCycleCount;
+  counter->hitCount += 1;
+#endif
 }
 
 struct pw_stream_buffer_state {
@@ -740,7 +897,7 @@ pw_stream_add_buffer(void *data, struct pw_buffer *pwBuffer)
   }
 
   bufferState->temp = BeginTemporaryMemory(&bufferState->arena);
-  u32 bufferSize = SAMPLE_RATE * SAMPLE_CHANNELS * sizeof(s16);
+  u32 bufferSize = AUDIO_QUANTUM_MAX * SAMPLE_CHANNELS * sizeof(s16);
   datas[0].maxsize = bufferSize;
   datas[0].data = MemoryArenaPushAlignment(&bufferState->arena, bufferSize, 4);
 }
@@ -754,8 +911,17 @@ pw_stream_remove_buffer(void *data, struct pw_buffer *buffer)
   EndTemporaryMemory(&bufferState->temp);
 }
 
+internal void
+pw_stream_io_changed(void *data, u32 id, void *area, u32 size)
+{
+  struct linux_state *state = data;
+  if (id == SPA_IO_Position)
+    state->pw_position = area;
+}
+
 comptime struct pw_stream_events pw_stream_events = {
     PW_VERSION_STREAM_EVENTS,
+    .io_changed = pw_stream_io_changed,
     .process = pw_stream_process,
     .add_buffer = pw_stream_add_buffer,
     .remove_buffer = pw_stream_remove_buffer,
@@ -1231,6 +1397,9 @@ wp_presentation_feedback_presented(void *data, struct wp_presentation_feedback *
     pfnGameUpdateAndRender GameUpdateAndRender = state->lib.GameUpdateAndRender;
 #endif
 
+    newInput->assetFilesChanged = state->assetFilesChanged;
+    state->assetFilesChanged = 0;
+
     struct game_backbuffer *backbuffer = &state->backbuffer;
     GameUpdateAndRender(&state->game_memory, newInput, backbuffer);
     HandleCycleCounters(&state->game_memory);
@@ -1581,12 +1750,14 @@ LinuxWorkQueueInit(struct linux_work_queue *queue, u32 threadCount)
 int
 main(int argc, char *argv[])
 {
+  comptime u32 highPriorityWorkerCount = 6;
   struct linux_work_queue highPriorityQueue;
-  if (LinuxWorkQueueInit(&highPriorityQueue, 6))
+  if (LinuxWorkQueueInit(&highPriorityQueue, highPriorityWorkerCount))
     return HANDMADEHERO_ERROR_THREAD_INIT;
 
+  comptime u32 lowPriorityWorkerCount = 2;
   struct linux_work_queue lowPriorityQueue;
-  if (LinuxWorkQueueInit(&lowPriorityQueue, 2))
+  if (LinuxWorkQueueInit(&lowPriorityQueue, lowPriorityWorkerCount))
     return HANDMADEHERO_ERROR_THREAD_INIT;
 
   int error_code = 0;
@@ -1672,10 +1843,15 @@ main(int argc, char *argv[])
 #endif
   game_memory->highPriorityQueue = (struct platform_work_queue *)&highPriorityQueue;
   game_memory->lowPriorityQueue = (struct platform_work_queue *)&lowPriorityQueue;
+  game_memory->highPriorityWorkerCount = highPriorityWorkerCount;
+  game_memory->lowPriorityWorkerCount = lowPriorityWorkerCount;
   game_memory->platform.WorkQueueAddEntry = (pfnPlatformWorkQueueAddEntry)LinuxWorkQueueAddEntry;
   game_memory->platform.WorkQueueCompleteAllWork = (pfnPlatformWorkQueueCompleteAllWork)LinuxWorkQueueCompleteAllWork;
 
   game_memory->platform.OpenNextFile = (pfnPlatformOpenNextFile)LinuxOpenNextFile;
+  game_memory->platform.ReopenFile = (pfnPlatformReopenFile)LinuxReopenFile;
+  game_memory->platform.CloseFile = (pfnPlatformCloseFile)LinuxCloseFile;
+  game_memory->platform.IsSameFile = (pfnPlatformIsSameFile)LinuxIsSameFile;
   game_memory->platform.ReadFromFile = (pfnPlatformReadFromFile)LinuxReadFromFile;
   game_memory->platform.HasFileError = (pfnPlatformHasFileError)LinuxHasFileError;
   game_memory->platform.FileError = (pfnPlatformFileError)LinuxFileError;
@@ -1731,10 +1907,12 @@ main(int argc, char *argv[])
     goto xkb_context_exit;
   }
 
-  state.pw_stream = pw_stream_new_simple(
-      pw_thread_loop_get_loop(state.pw_thread_loop), "handmadehero",
-      pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY, "Playback", PW_KEY_MEDIA_ROLE, "Game", NULL),
-      &pw_stream_events, &state);
+  struct pw_properties *pw_properties =
+      pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY, "Playback", PW_KEY_MEDIA_ROLE, "Game", NULL);
+  // asks graph to run at most this many samples per cycle
+  pw_properties_setf(pw_properties, PW_KEY_NODE_LATENCY, "%u/%u", AUDIO_LATENCY_SAMPLE_COUNT, SAMPLE_RATE);
+  state.pw_stream = pw_stream_new_simple(pw_thread_loop_get_loop(state.pw_thread_loop), "handmadehero", pw_properties,
+                                         &pw_stream_events, &state);
   if (!state.pw_stream) {
     error_code = HANDMADEHERO_ERROR_PIPEWIRE;
     goto xkb_context_exit;
@@ -1904,6 +2082,11 @@ main(int argc, char *argv[])
     goto inotify_exit;
   }
 
+  /* asset packs in working directory, for reloading them while running */
+  int fd_asset_watch = inotify_add_watch(fd_inotify, ".", IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (fd_asset_watch < 0)
+    debug("asset packs are not watched\n");
+
   if (fd_inotify >= 0) {
     sqe = io_uring_get_sqe(&ring);
     struct op *submitOp = &(struct op){.type = OP_INOTIFY_WATCH, .fd = fd_inotify};
@@ -2047,35 +2230,48 @@ main(int argc, char *argv[])
         goto cqe_seen;
       }
 
-      struct inotify_event *event = (struct inotify_event *)buf;
-      if (event->len <= 0)
-        goto cqe_seen;
+      for (u8 *eventCursor = buf; eventCursor < buf + readBytes;) {
+        struct inotify_event *event = (struct inotify_event *)eventCursor;
+        eventCursor += sizeof(*event) + event->len;
 
-      if (event->mask & IN_ISDIR)
-        goto cqe_seen;
+        if (event->len <= 0)
+          continue;
 
-      /* get full path */
-      char path[32] = "/dev/input/";
-      for (char *dest = path + 11, *src = event->name; *src; src++, dest++) {
-        *dest = *src;
-      }
+        if (event->mask & IN_ISDIR)
+          continue;
 
-      if (event->mask & IN_DELETE)
-        goto cqe_seen;
+        /* asset pack written or replaced */
+        if (event->wd == fd_asset_watch) {
+          struct string filename = StringFromZeroTerminated((u8 *)event->name, event->len);
+          struct string extension = StringFromZeroTerminated((u8 *)"hha", 255);
+          if (PathHasExtension(filename, extension))
+            state.assetFilesChanged = 1;
+          continue;
+        }
 
-      struct op_device_open *submitOp = MemoryChunkPush(MemoryForDeviceOpenEvents);
-      submitOp->type = OP_DEVICE_OPEN;
-      for (char *dest = (char *)submitOp->path, *src = path; *src; src++, dest++)
-        *dest = *src;
+        /* get full path */
+        char path[32] = "/dev/input/";
+        for (char *dest = path + 11, *src = event->name; *src; src++, dest++) {
+          *dest = *src;
+        }
 
-      /* wait for device initialization */
-      sqe = io_uring_get_sqe(&ring);
-      struct __kernel_timespec *ts = &(struct __kernel_timespec){
-          .tv_nsec = 75000000, /* 750ms */
-      };
-      io_uring_prep_timeout(sqe, ts, 0, 0);
-      io_uring_sqe_set_data(sqe, submitOp);
-      io_uring_submit(&ring);
+        if (event->mask & IN_DELETE)
+          continue;
+
+        struct op_device_open *submitOp = MemoryChunkPush(MemoryForDeviceOpenEvents);
+        submitOp->type = OP_DEVICE_OPEN;
+        for (char *dest = (char *)submitOp->path, *src = path; *src; src++, dest++)
+          *dest = *src;
+
+        /* wait for device initialization */
+        sqe = io_uring_get_sqe(&ring);
+        struct __kernel_timespec *ts = &(struct __kernel_timespec){
+            .tv_nsec = 75000000, /* 750ms */
+        };
+        io_uring_prep_timeout(sqe, ts, 0, 0);
+        io_uring_sqe_set_data(sqe, submitOp);
+        io_uring_submit(&ring);
+      }
     }
 
     /* on device open events */
@@ -2163,6 +2359,11 @@ main(int argc, char *argv[])
   }
 
   /* finished */
+#if HANDMADEHERO_DEBUG
+  pfnGameShutdown GameShutdown = state.lib.GameShutdown;
+#endif
+  GameShutdown(&state.game_memory);
+
 inotify_watch_exit:
   close(fd_watch);
 
@@ -211,6 +211,52 @@ PushBitmapEntry(struct render_group *renderGroup, struct bitmap *bitmap, struct
   entry->color = color;
 }
 
+internal inline void
+PushBitmapRegionEntry(struct render_group *renderGroup, struct bitmap *bitmap, struct rect2s sourceRect,
+                      struct v2 alignPercentage, struct v3 offset, f32 height, struct v4 color)
+{
+  if (sourceRect.maxX <= sourceRect.minX || sourceRect.maxY <= sourceRect.minY)
+    return;
+
+  f32 widthOverHeight = (f32)(sourceRect.maxX - sourceRect.minX) / (f32)(sourceRect.maxY - sourceRect.minY);
+  struct v2 size = v2(height * widthOverHeight, height);
+  struct v2 alignPixel = v2_hadamard(alignPercentage, size);
+  struct v3 position = v3_sub(offset, v2_to_v3(alignPixel, 0.0f));
+
+  struct render_entity_basis_p_result basis = GetRenderEntityBasisP(&renderGroup->transform, position);
+  if (!basis.valid || basis.scale <= 0.0f)
+    return;
+
+  struct render_group_entry_bitmap_region *entry =
+      PushRenderEntry(renderGroup, sizeof(*entry), RENDER_GROUP_ENTRY_TYPE_BITMAP_REGION);
+  entry->bitmap = bitmap;
+  entry->sourceRect = sourceRect;
+  entry->size = v2_mul(size, basis.scale);
+  entry->position = basis.p;
+  entry->color = color;
+}
+
+internal inline void
+PushBitmapSDFEntry(struct render_group *renderGroup, struct bitmap *bitmap, struct v3 offset, f32 height,
+                   struct v4 color, f32 sdfSpread)
+{
+  struct v2 size = v2(height * bitmap->widthOverHeight, height);
+  struct v2 alignPixel = v2_hadamard(bitmap->alignPercentage, size);
+  struct v3 position = v3_sub(offset, v2_to_v3(alignPixel, 0.0f));
+
+  struct render_entity_basis_p_result basis = GetRenderEntityBasisP(&renderGroup->transform, position);
+  if (!basis.valid || basis.scale <= 0.0f)
+    return;
+
+  struct render_group_entry_bitmap_sdf *entry =
+      PushRenderEntry(renderGroup, sizeof(*entry), RENDER_GROUP_ENTRY_TYPE_BITMAP_SDF);
+  entry->bitmap = bitmap;
+  entry->size = v2_mul(size, basis.scale);
+  entry->position = basis.p;
+  entry->color = color;
+  entry->sdfSpread = sdfSpread;
+}
+
 internal inline void
 PushRectangleEntry(struct render_group *renderGroup, struct v3 offset, struct v2 dim, struct v4 color)
 {
@@ -282,10 +328,27 @@ BitmapAsset(struct render_group *renderGroup, struct bitmap_id id, struct v3 off
   }
 
   if (bitmap) {
-    BitmapWithColor(renderGroup, bitmap, offset, height, color);
+    struct hha_bitmap *bitmapInfo = BitmapInfoGet(renderGroup->assets, id);
+    if (bitmapInfo->atlasId.value != 0) {
+      // NOTE(e2dk4r): bitmap is got as its atlas, only its rectangle is drawn
+      struct rect2s sourceRect = {
+          .minX = bitmapInfo->atlasX,
+          .minY = bitmapInfo->atlasY,
+          .maxX = bitmapInfo->atlasX + (s32)bitmapInfo->width,
+          .maxY = bitmapInfo->atlasY + (s32)bitmapInfo->height,
+      };
+      struct v2 alignPercentage = v2(bitmapInfo->alignPercentage[0], bitmapInfo->alignPercentage[1]);
+      color.a *= renderGroup->alpha;
+      PushBitmapRegionEntry(renderGroup, bitmap, sourceRect, alignPercentage, offset, height, color);
+    } else {
+      BitmapWithColor(renderGroup, bitmap, offset, height, color);
+    }
   } else {
     assert(!renderGroup->isRenderingInBackground);
-    BitmapLoad(renderGroup->assets, id);
+    // NOTE(e2dk4r): closer to camera, sooner it is loaded
+    struct v3 position = v3_add(renderGroup->transform.offsetP, offset);
+    f32 priority = Minimum(v2_length(position.xy), ASSET_PRIORITY_PREFETCH);
+    BitmapRequest(renderGroup->assets, id, priority);
     renderGroup->missingResourceCount += 1;
   }
 }
@@ -303,6 +366,15 @@ BitmapWithColor(struct render_group *renderGroup, struct bitmap *bitmap, struct
   PushBitmapEntry(renderGroup, bitmap, offset, height, color);
 }
 
+inline void
+BitmapSDF(struct render_group *renderGroup, struct bitmap *bitmap, struct v3 offset, f32 height, struct v4 color,
+          f32 sdfSpread)
+{
+  assert(sdfSpread > 0.0f);
+  color.a *= renderGroup->alpha;
+  PushBitmapSDFEntry(renderGroup, bitmap, offset, height, color, sdfSpread);
+}
+
 inline void
 Rect(struct render_group *renderGroup, struct v3 offset, struct v2 dim, struct v4 color)
 {
@@ -394,12 +466,25 @@ DEBUGTextLine(char *line)
       f32 advanceX = fontScale * FontGetHorizontalAdvanceForPair(fontInfo, font, prevCodepoint, codepoint);
       atX += advanceX;
 
-      if (codepoint != ' ') {
+      struct bitmap *glyphBitmap = FontGetGlyphBitmap(fontInfo, font, codepoint);
+      if (glyphBitmap) {
+        // NOTE(e2dk4r): glyph is drawn from font's atlas, it is loaded with font
+        if (glyphBitmap->width != 0) {
+          f32 height = fontScale * (f32)(glyphBitmap->height * fontInfo->atlasDownscale);
+          if (fontInfo->sdfSpread)
+            BitmapSDF(renderGroup, glyphBitmap, v3(atX, atY, 0.0f), height, color, (f32)fontInfo->sdfSpread);
+          else
+            BitmapWithColor(renderGroup, glyphBitmap, v3(atX, atY, 0.0f), height, color);
+        }
+      } else if (codepoint != ' ') {
+        // NOTE(e2dk4r): fonts of version 0 files have no atlas, only glyph bitmaps
         struct bitmap_id bitmapId = FontGetBitmapGlyph(assets, fontInfo, font, codepoint);
-        struct hha_bitmap *bitmapInfo = BitmapInfoGet(assets, bitmapId);
+        if (bitmapId.value != 0) {
+          struct hha_bitmap *bitmapInfo = BitmapInfoGet(assets, bitmapId);
 
-        f32 height = fontScale * (f32)bitmapInfo->height;
-        BitmapAsset(renderGroup, bitmapId, v3(atX, atY, 0.0f), height, color);
+          f32 height = fontScale * (f32)bitmapInfo->height;
+          BitmapAsset(renderGroup, bitmapId, v3(atX, atY, 0.0f), height, color);
+        }
       }
 
       prevCodepoint = codepoint;
@@ -806,9 +891,13 @@ DrawRectangleSlowly(struct bitmap *buffer, struct v2 origin, struct v2 xAxis, st
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
 #endif
+/*
+ * sdfSpread is 0 when texture has colors. Otherwise alpha of texture is signed
+ * distance to edge of shape, see hha_font_glyph, and shape is filled with color.
+ */
 internal inline void
 DrawRectangleQuickly(struct bitmap *buffer, struct v2 origin, struct v2 xAxis, struct v2 yAxis, struct v4 color,
-                     struct bitmap *texture, f32 pixelsToMeters, struct rect2s clipRect, b32 even)
+                     struct bitmap *texture, f32 sdfSpread, f32 pixelsToMeters, struct rect2s clipRect, b32 even)
 {
   BEGIN_TIMER_BLOCK(DrawRectangleQuickly);
 
@@ -907,6 +996,22 @@ DrawRectangleQuickly(struct bitmap *buffer, struct v2 origin, struct v2 xAxis, s
 
   f32 inv255 = 1.0f / 255.0f;
 
+  // NOTE(e2dk4r): mode is decided once for whole rectangle, not per pixel
+  b32 isSDF = sdfSpread > 0.0f;
+
+  // NOTE(e2dk4r): coverage of signed distance is smoothed over one pixel on
+  // screen, coverage = (alpha - 127.5) / alphaPerPixel + 0.5
+  f32 sdfScale = 0.0f;
+  f32 sdfBias = 0.0f;
+  if (isSDF) {
+    f32 texelsPerPixel = 0.5f * ((f32)texture->width / xAxisLength + (f32)texture->height / yAxisLength);
+    f32 alphaPerPixel = texelsPerPixel * 127.5f / sdfSpread;
+    sdfScale = 1.0f / alphaPerPixel;
+    sdfBias = 0.5f - 127.5f * sdfScale;
+  }
+
+#define mmSquare(a) (a * a)
+
   BEGIN_TIMER_BLOCK(ProcessPixel);
   for (s32 y = fillRect.minY; y < fillRect.maxY; y += 2) {
     u32 *pixel = (u32 *)row;
@@ -999,24 +1104,6 @@ DrawRectangleQuickly(struct bitmap *buffer, struct v2 origin, struct v2 xAxis, s
       __m128 destb = _mm_cvtepi32_ps(originalDest >> 0x00 & _mm_set1_epi32(0xff));
       __m128 desta = _mm_cvtepi32_ps(originalDest >> 0x18 & _mm_set1_epi32(0xff));
 
-#define mmSquare(a) (a * a)
-      // sRGBBilinearBlend - sRGB255toLinear1()
-      texelAr = mmSquare(texelAr);
-      texelAg = mmSquare(texelAg);
-      texelAb = mmSquare(texelAb);
-
-      texelBr = mmSquare(texelBr);
-      texelBg = mmSquare(texelBg);
-      texelBb = mmSquare(texelBb);
-
-      texelCr = mmSquare(texelCr);
-      texelCg = mmSquare(texelCg);
-      texelCb = mmSquare(texelCb);
-
-      texelDr = mmSquare(texelDr);
-      texelDg = mmSquare(texelDg);
-      texelDb = mmSquare(texelDb);
-
       // sRGBBilinearBlend - v4_lerp()
       __m128 invfX = 1.0f - fX;
       __m128 invfY = 1.0f - fY;
@@ -1026,11 +1113,42 @@ DrawRectangleQuickly(struct bitmap *buffer, struct v2 origin, struct v2 xAxis, s
       __m128 l2 = invfX * fY;
       __m128 l3 = fX * fY;
 
-      __m128 texelr = texelAr * l0 + texelBr * l1 + texelCr * l2 + texelDr * l3;
-      __m128 texelg = texelAg * l0 + texelBg * l1 + texelCg * l2 + texelDg * l3;
-      __m128 texelb = texelAb * l0 + texelBb * l1 + texelCb * l2 + texelDb * l3;
+      __m128 texelr;
+      __m128 texelg;
+      __m128 texelb;
       __m128 texela = texelAa * l0 + texelBa * l1 + texelCa * l2 + texelDa * l3;
 
+      if (isSDF) {
+        // smoothstep of signed distance, white pre-multiplied with coverage
+        __m128 t = mmClamp01(texela * sdfScale + sdfBias);
+        __m128 coverage = t * t * (3.0f - 2.0f * t);
+        texelr = coverage * Square(255.0f);
+        texelg = texelr;
+        texelb = texelr;
+        texela = coverage * 255.0f;
+      } else {
+        // sRGBBilinearBlend - sRGB255toLinear1()
+        texelAr = mmSquare(texelAr);
+        texelAg = mmSquare(texelAg);
+        texelAb = mmSquare(texelAb);
+
+        texelBr = mmSquare(texelBr);
+        texelBg = mmSquare(texelBg);
+        texelBb = mmSquare(texelBb);
+
+        texelCr = mmSquare(texelCr);
+        texelCg = mmSquare(texelCg);
+        texelCb = mmSquare(texelCb);
+
+        texelDr = mmSquare(texelDr);
+        texelDg = mmSquare(texelDg);
+        texelDb = mmSquare(texelDb);
+
+        texelr = texelAr * l0 + texelBr * l1 + texelCr * l2 + texelDr * l3;
+        texelg = texelAg * l0 + texelBg * l1 + texelCg * l2 + texelDg * l3;
+        texelb = texelAb * l0 + texelBb * l1 + texelCb * l2 + texelDb * l3;
+      }
+
       // v4_hadamard(texel, color)
       texelr = texelr * color.r;
       texelg = texelg * color.g;
@@ -1281,10 +1399,43 @@ DrawRenderGroupInterleaved(struct render_group *renderGroup, struct bitmap *outp
       struct v2 xAxis = v2(1.0f, 0.0f);
       struct v2 yAxis = v2_perp(xAxis);
       DrawRectangleQuickly(outputTarget, entry->position, v2_mul(xAxis, entry->size.x), v2_mul(yAxis, entry->size.y),
-                           entry->color, entry->bitmap, pixelsToMeters, clipRect, even);
+                           entry->color, entry->bitmap, 0.0f, pixelsToMeters, clipRect, even);
 #endif
     }
 
+    else if (header->type & RENDER_GROUP_ENTRY_TYPE_BITMAP_REGION) {
+      struct render_group_entry_bitmap_region *entry = data;
+      pushBufferIndex += sizeof(*entry);
+
+      assert(entry->bitmap);
+
+      // NOTE(e2dk4r): region is sampled as bitmap that starts at its corner
+      // and steps rows with stride of whole bitmap
+      struct rect2s sourceRect = entry->sourceRect;
+      struct bitmap region = *entry->bitmap;
+      region.width = (u32)(sourceRect.maxX - sourceRect.minX);
+      region.height = (u32)(sourceRect.maxY - sourceRect.minY);
+      region.memory = (u8 *)region.memory + (s64)sourceRect.minY * region.stride +
+                      (s64)sourceRect.minX * BITMAP_BYTES_PER_PIXEL;
+
+      struct v2 xAxis = v2(1.0f, 0.0f);
+      struct v2 yAxis = v2_perp(xAxis);
+      DrawRectangleQuickly(outputTarget, entry->position, v2_mul(xAxis, entry->size.x), v2_mul(yAxis, entry->size.y),
+                           entry->color, &region, 0.0f, pixelsToMeters, clipRect, even);
+    }
+
+    else if (header->type & RENDER_GROUP_ENTRY_TYPE_BITMAP_SDF) {
+      struct render_group_entry_bitmap_sdf *entry = data;
+      pushBufferIndex += sizeof(*entry);
+
+      assert(entry->bitmap);
+
+      struct v2 xAxis = v2(1.0f, 0.0f);
+      struct v2 yAxis = v2_perp(xAxis);
+      DrawRectangleQuickly(outputTarget, entry->position, v2_mul(xAxis, entry->size.x), v2_mul(yAxis, entry->size.y),
+                           entry->color, entry->bitmap, entry->sdfSpread, pixelsToMeters, clipRect, even);
+    }
+
     else if (header->type & RENDER_GROUP_ENTRY_TYPE_RECTANGLE) {
       struct render_group_entry_rectangle *entry = data;
       pushBufferIndex += sizeof(*entry);
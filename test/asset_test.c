@@ -0,0 +1,319 @@
+// NOTE(e2dk4r): asset code is included to reach its internal functions,
+// some of them are only used in asserts
+#pragma GCC diagnostic ignored "-Wunused-function"
+#include "../src/handmadehero_asset.c"
+
+enum asset_test_error {
+  ASSET_TEST_ERROR_NONE = 0,
+  ASSET_TEST_ERROR_NO_ASSETS,
+  ASSET_TEST_ERROR_NO_WEIGHTS,
+  ASSET_TEST_ERROR_TAGS_MISMATCH,
+  ASSET_TEST_ERROR_UNTAGGED_MISMATCH,
+  ASSET_TEST_ERROR_CODEPOINT_LOOKUP_MISSING,
+  ASSET_TEST_ERROR_CODEPOINT_LOOKUP_UNEXPECTED,
+  ASSET_TEST_ERROR_CODEPOINT_MISMATCH,
+  ASSET_TEST_ERROR_CODEPOINT_TIE,
+};
+
+// only reached from asset loading, which is not tested here
+struct platform_api *Platform;
+
+struct task_with_memory *
+BeginTaskWithMemory(struct transient_state *transientState)
+{
+  return 0;
+}
+
+void
+EndTaskWithMemory(struct task_with_memory *task)
+{
+}
+
+#define ASSET_COUNT_MAX 256
+#define TAG_COUNT_MAX 1024
+global_variable struct game_assets assets;
+global_variable struct asset assetArray[ASSET_COUNT_MAX];
+global_variable struct hha_tag tagArray[TAG_COUNT_MAX];
+global_variable u8 arenaMemory[1 << 20];
+
+internal u32
+XorShift32(u32 *state)
+{
+  u32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// multiple of 0.25 in [-2, 2], so weighted sums are exact
+internal f32
+RandomTagValue(u32 *state)
+{
+  return (f32)((s32)(XorShift32(state) % 17) - 8) * 0.25f;
+}
+
+internal f32
+RandomWeight(u32 *state)
+{
+  f32 weights[] = {0.0f, 0.5f, 1.0f, 2.0f};
+  return weights[XorShift32(state) % ARRAY_COUNT(weights)];
+}
+
+internal void
+AssetAdd(u32 tagCount, struct hha_tag *tags)
+{
+  assert(assets.assetCount < ASSET_COUNT_MAX);
+  assert(assets.tagCount + tagCount <= TAG_COUNT_MAX);
+  struct asset *asset = assets.assets + assets.assetCount;
+  assets.assetCount++;
+
+  asset->hhaAsset.tagIndexFirst = assets.tagCount;
+  for (u32 tagIndex = 0; tagIndex < tagCount; tagIndex++)
+    assets.tags[assets.tagCount++] = tags[tagIndex];
+  asset->hhaAsset.tagIndexOnePastLast = assets.tagCount;
+}
+
+// asset with random subset of smoothness, flatness and facing direction tags
+internal void
+AssetAddRandom(u32 *state, b32 isUntaggedAllowed)
+{
+  struct hha_tag tags[3];
+  u32 tagCount;
+  do {
+    tagCount = 0;
+    u32 tagMask = XorShift32(state);
+    // facing direction is first sometimes, tags are not sorted in file
+    if (tagMask & (1 << 3) && tagMask & (1 << 2))
+      tags[tagCount++] = (struct hha_tag){ASSET_TAG_FACING_DIRECTION, RandomTagValue(state) * 1.5f};
+    if (tagMask & (1 << 0))
+      tags[tagCount++] = (struct hha_tag){ASSET_TAG_SMOOTHNESS, RandomTagValue(state)};
+    if (tagMask & (1 << 1))
+      tags[tagCount++] = (struct hha_tag){ASSET_TAG_FLATNESS, RandomTagValue(state)};
+    if (!(tagMask & (1 << 3)) && tagMask & (1 << 2))
+      tags[tagCount++] = (struct hha_tag){ASSET_TAG_FACING_DIRECTION, RandomTagValue(state) * 1.5f};
+  } while (tagCount == 0 && !isUntaggedAllowed);
+
+  AssetAdd(tagCount, tags);
+}
+
+internal void
+AssetAddCodepoint(u32 codepoint)
+{
+  struct hha_tag tag = {ASSET_TAG_UNICODE_CODEPOINT, (f32)codepoint};
+  AssetAdd(1, &tag);
+}
+
+internal void
+AssetTypeBegin(enum asset_type_id typeId)
+{
+  assets.assetTypes[typeId].assetIndexFirst = assets.assetCount;
+}
+
+internal void
+AssetTypeEnd(enum asset_type_id typeId)
+{
+  assets.assetTypes[typeId].assetIndexOnePastLast = assets.assetCount;
+}
+
+/*
+ * Scores every asset one tag at a time, like BestMatchAsset did before
+ * tags were laid out in lanes. Tags are summed in tag id order as
+ * BestMatchAsset does, so totals are bit exact and ties resolve same way.
+ */
+internal u32
+BestMatchAssetScalar(struct game_assets *assets, enum asset_type_id typeId, struct asset_vector *matchVector,
+                     struct asset_vector *weightVector)
+{
+  u32 result = 0;
+  f32 bestTotalDiff = F32_MAX;
+
+  struct asset_type *type = assets->assetTypes + typeId;
+  for (u32 assetIndex = type->assetIndexFirst; assetIndex < type->assetIndexOnePastLast; assetIndex++) {
+    struct asset *asset = assets->assets + assetIndex;
+
+    f32 totalWeightedDiff = 0.0f;
+    for (u32 tagId = 0; tagId < ASSET_TAG_COUNT; tagId++) {
+      f32 weight = weightVector->e[tagId];
+      if (weight == 0.0f)
+        continue;
+
+      for (u32 tagIndex = asset->hhaAsset.tagIndexFirst; tagIndex < asset->hhaAsset.tagIndexOnePastLast; tagIndex++) {
+        struct hha_tag *tag = assets->tags + tagIndex;
+        if (tag->id != tagId)
+          continue;
+
+        f32 a = matchVector->e[tagId];
+        f32 b = tag->value;
+        f32 d0 = Absolute(a - b);
+        f32 aWrapped = a - assets->tagRanges[tagId] * SignOf(a);
+        f32 d1 = Absolute(aWrapped - b);
+        f32 diff = Minimum(d0, d1);
+
+        f32 weightedDiff = weight * diff;
+        totalWeightedDiff += weightedDiff;
+      }
+    }
+
+    if (totalWeightedDiff < bestTotalDiff) {
+      bestTotalDiff = totalWeightedDiff;
+      result = assetIndex;
+    }
+  }
+
+  return result;
+}
+
+internal b32
+IsBestMatchSame(enum asset_type_id typeId, struct asset_vector *matchVector, struct asset_vector *weightVector)
+{
+  u32 expected = BestMatchAssetScalar(&assets, typeId, matchVector, weightVector);
+  u32 got = BestMatchAsset(&assets, typeId, matchVector, weightVector);
+  return expected == got;
+}
+
+int
+main(void)
+{
+  enum asset_test_error errorCode = ASSET_TEST_ERROR_NONE;
+
+  struct memory_arena arena;
+  MemoryArenaInit(&arena, arenaMemory, sizeof(arenaMemory));
+
+  // first asset is always null, see GameAssetsAllocate()
+  assets.assetCount = 1;
+  assets.assets = assetArray;
+  assets.tags = tagArray;
+  for (u32 tagId = 0; tagId < ASSET_TAG_COUNT; tagId++)
+    assets.tagRanges[tagId] = 1000000.0f;
+  assets.tagRanges[ASSET_TAG_FACING_DIRECTION] = TAU32;
+
+  u32 state = 0x2545f491;
+
+  // every asset tagged, count is not multiple of 4 so last lanes are padding
+  AssetTypeBegin(ASSET_TYPE_HEAD);
+  for (u32 index = 0; index < 37; index++)
+    AssetAddRandom(&state, 0);
+  // same tags as earlier asset, earlier one wins
+  {
+    struct asset *asset = assets.assets + assets.assetTypes[ASSET_TYPE_HEAD].assetIndexFirst + 5;
+    AssetAdd(asset->hhaAsset.tagIndexOnePastLast - asset->hhaAsset.tagIndexFirst,
+             assets.tags + asset->hhaAsset.tagIndexFirst);
+  }
+  AssetTypeEnd(ASSET_TYPE_HEAD);
+
+  // asset without tags scores 0 on everything
+  AssetTypeBegin(ASSET_TYPE_TORSO);
+  for (u32 index = 0; index < 10; index++)
+    AssetAddRandom(&state, index == 3 || index == 7);
+  AssetTypeEnd(ASSET_TYPE_TORSO);
+
+  // codepoints with gap at 'M' and 'Q' twice, first 'Q' wins
+  AssetTypeBegin(ASSET_TYPE_FONT_GLYPH);
+  for (u32 codepoint = 'A'; codepoint <= 'Z'; codepoint++) {
+    if (codepoint == 'M')
+      continue;
+    AssetAddCodepoint(codepoint);
+  }
+  u32 firstQ = assets.assetTypes[ASSET_TYPE_FONT_GLYPH].assetIndexFirst + ('Q' - 'A' - 1);
+  AssetAddCodepoint('Q');
+  AssetTypeEnd(ASSET_TYPE_FONT_GLYPH);
+
+  // one asset without codepoint, so no direct lookup
+  AssetTypeBegin(ASSET_TYPE_CAPE);
+  for (u32 codepoint = '0'; codepoint <= '9'; codepoint++) {
+    if (codepoint == '5')
+      AssetAdd(0, 0);
+    else
+      AssetAddCodepoint(codepoint);
+  }
+  AssetTypeEnd(ASSET_TYPE_CAPE);
+
+  AssetTagIndexBuild(&assets, &arena);
+
+  // type without assets
+  {
+    struct asset_vector matchVector = {};
+    struct asset_vector weightVector = {};
+    weightVector.e[ASSET_TAG_SMOOTHNESS] = 1.0f;
+    if (BestMatchAsset(&assets, ASSET_TYPE_SHADOW, &matchVector, &weightVector) != 0) {
+      errorCode = ASSET_TEST_ERROR_NO_ASSETS;
+      goto end;
+    }
+  }
+
+  // nothing weighted, every asset ties so first one wins
+  {
+    struct asset_vector matchVector = {};
+    struct asset_vector weightVector = {};
+    matchVector.e[ASSET_TAG_SMOOTHNESS] = 1.0f;
+    if (BestMatchAsset(&assets, ASSET_TYPE_HEAD, &matchVector, &weightVector) !=
+        assets.assetTypes[ASSET_TYPE_HEAD].assetIndexFirst) {
+      errorCode = ASSET_TEST_ERROR_NO_WEIGHTS;
+      goto end;
+    }
+  }
+
+  // mixed tag vectors
+  for (u32 query = 0; query < 4096; query++) {
+    enum asset_type_id typeId = query & 1 ? ASSET_TYPE_TORSO : ASSET_TYPE_HEAD;
+    struct asset_vector matchVector = {};
+    struct asset_vector weightVector = {};
+    for (u32 tagId = 0; tagId < ASSET_TAG_UNICODE_CODEPOINT; tagId++) {
+      matchVector.e[tagId] = RandomTagValue(&state);
+      weightVector.e[tagId] = RandomWeight(&state);
+    }
+    matchVector.e[ASSET_TAG_FACING_DIRECTION] *= 1.5f;
+
+    if (!IsBestMatchSame(typeId, &matchVector, &weightVector)) {
+      errorCode = typeId == ASSET_TYPE_HEAD ? ASSET_TEST_ERROR_TAGS_MISMATCH : ASSET_TEST_ERROR_UNTAGGED_MISMATCH;
+      goto end;
+    }
+  }
+
+  if (!assets.tagIndexes[ASSET_TYPE_FONT_GLYPH].codepointAssets) {
+    errorCode = ASSET_TEST_ERROR_CODEPOINT_LOOKUP_MISSING;
+    goto end;
+  }
+
+  if (assets.tagIndexes[ASSET_TYPE_CAPE].codepointAssets) {
+    errorCode = ASSET_TEST_ERROR_CODEPOINT_LOOKUP_UNEXPECTED;
+    goto end;
+  }
+
+  // in range, in gap, out of range and between codepoints, with direct lookup and without
+  for (f32 codepoint = '0' - 2.0f; codepoint <= 'Z' + 2.0f; codepoint += 0.5f) {
+    struct asset_vector matchVector = {};
+    matchVector.e[ASSET_TAG_UNICODE_CODEPOINT] = codepoint;
+    matchVector.e[ASSET_TAG_SMOOTHNESS] = 1.0f;
+
+    struct asset_vector weightVectors[3] = {};
+    weightVectors[0].e[ASSET_TAG_UNICODE_CODEPOINT] = 1.0f;
+    weightVectors[1].e[ASSET_TAG_UNICODE_CODEPOINT] = 2.0f;
+    weightVectors[2].e[ASSET_TAG_UNICODE_CODEPOINT] = 1.0f;
+    weightVectors[2].e[ASSET_TAG_SMOOTHNESS] = 1.0f;
+
+    for (u32 weightIndex = 0; weightIndex < ARRAY_COUNT(weightVectors); weightIndex++) {
+      if (!IsBestMatchSame(ASSET_TYPE_FONT_GLYPH, &matchVector, weightVectors + weightIndex) ||
+          !IsBestMatchSame(ASSET_TYPE_CAPE, &matchVector, weightVectors + weightIndex)) {
+        errorCode = ASSET_TEST_ERROR_CODEPOINT_MISMATCH;
+        goto end;
+      }
+    }
+  }
+
+  {
+    struct asset_vector matchVector = {};
+    struct asset_vector weightVector = {};
+    matchVector.e[ASSET_TAG_UNICODE_CODEPOINT] = 'Q';
+    weightVector.e[ASSET_TAG_UNICODE_CODEPOINT] = 1.0f;
+    if (BestMatchAsset(&assets, ASSET_TYPE_FONT_GLYPH, &matchVector, &weightVector) != firstQ) {
+      errorCode = ASSET_TEST_ERROR_CODEPOINT_TIE;
+      goto end;
+    }
+  }
+
+end:
+  return (s32)errorCode;
+}
@@ -0,0 +1,169 @@
+#include <handmadehero/audio_effect.h>
+#include <handmadehero/types.h>
+
+enum audio_effect_test_error {
+  AUDIO_EFFECT_TEST_ERROR_NONE = 0,
+  AUDIO_EFFECT_TEST_ERROR_BIQUAD_BLOCK,
+  AUDIO_EFFECT_TEST_ERROR_BIQUAD_LOWPASS,
+  AUDIO_EFFECT_TEST_ERROR_LIMITER_OVER,
+  AUDIO_EFFECT_TEST_ERROR_LIMITER_RELEASE,
+  AUDIO_EFFECT_TEST_ERROR_REVERB_TAIL,
+  AUDIO_EFFECT_TEST_ERROR_REVERB_DECAY,
+};
+
+#define SAMPLE_RATE 48000
+#define CHUNK_COUNT 600
+global_variable __m256 samples0[CHUNK_COUNT];
+global_variable __m256 samples1[CHUNK_COUNT];
+global_variable f32 reverbMemory[REVERB_MEMORY_COUNT];
+
+internal u32
+XorShift32(u32 *state)
+{
+  u32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+internal void
+FillSine(__m256 *samples, f32 frequency, f32 amplitude)
+{
+  f32 *values = (f32 *)samples;
+  for (u32 index = 0; index < CHUNK_COUNT * 8; index++)
+    values[index] = amplitude * Sin(TAU32 * frequency * (f32)index / (f32)SAMPLE_RATE);
+}
+
+internal f32
+RootMeanSquare(__m256 *samples, u32 firstChunk, u32 chunkCount)
+{
+  f32 *values = (f32 *)(samples + firstChunk);
+  f32 sum = 0.0f;
+  for (u32 index = 0; index < chunkCount * 8; index++)
+    sum += values[index] * values[index];
+  return SquareRoot(sum / (f32)(chunkCount * 8));
+}
+
+int
+main(void)
+{
+  enum audio_effect_test_error errorCode = AUDIO_EFFECT_TEST_ERROR_NONE;
+
+  // block form gives same output as running filter one sample at a time
+  {
+    u32 state = 0x1234567;
+    f32 *values = (f32 *)samples0;
+    for (u32 index = 0; index < CHUNK_COUNT * 8; index++)
+      values[index] = (f32)(s32)(XorShift32(&state) & 0xffff) - 32768.0f;
+    __builtin_memcpy(samples1, samples0, sizeof(samples0));
+
+    struct biquad biquad;
+    BiquadInit(&biquad, BIQUAD_TYPE_HIGHPASS, 300.0f, 2.0f, SAMPLE_RATE);
+    struct biquad_state biquadState = {};
+    // processed in two calls, state carries over
+    BiquadProcess(&biquad, &biquadState, samples0, CHUNK_COUNT / 2);
+    BiquadProcess(&biquad, &biquadState, samples0 + CHUNK_COUNT / 2, CHUNK_COUNT / 2);
+
+    // coefficients are impulse response, b0 is first sample, and rest from response to states
+    f32 b0 = biquad.input[0][0];
+    f32 b1 = biquad.state[0][0];
+    f32 b2 = biquad.state[1][0];
+    f32 a1 = -biquad.state[2][0];
+    f32 a2 = -biquad.state[3][0];
+    struct biquad_state reference = {};
+    f32 *input = (f32 *)samples1;
+    f32 *output = (f32 *)samples0;
+    for (u32 index = 0; index < CHUNK_COUNT * 8; index += 8) {
+      f32 expected[8];
+      BiquadRun(b0, b1, b2, a1, a2, input + index, reference, expected);
+      reference.x2 = input[index + 6];
+      reference.x1 = input[index + 7];
+      reference.y2 = expected[6];
+      reference.y1 = expected[7];
+
+      // rounding differs as block form adds in different order, -70dB of full scale
+      for (u32 lane = 0; lane < 8; lane++) {
+        if (Absolute(output[index + lane] - expected[lane]) > 32768.0f * 3e-4f) {
+          errorCode = AUDIO_EFFECT_TEST_ERROR_BIQUAD_BLOCK;
+          goto end;
+        }
+      }
+    }
+  }
+
+  // lowpass keeps low frequencies and removes high ones
+  {
+    struct biquad biquad;
+    BiquadInit(&biquad, BIQUAD_TYPE_LOWPASS, 1000.0f, 0.7071f, SAMPLE_RATE);
+
+    struct biquad_state lowState = {};
+    FillSine(samples0, 100.0f, 10000.0f);
+    BiquadProcess(&biquad, &lowState, samples0, CHUNK_COUNT);
+
+    struct biquad_state highState = {};
+    FillSine(samples1, 12000.0f, 10000.0f);
+    BiquadProcess(&biquad, &highState, samples1, CHUNK_COUNT);
+
+    f32 amplitudeRms = 10000.0f * 0.7071f;
+    if (RootMeanSquare(samples0, CHUNK_COUNT / 2, CHUNK_COUNT / 2) < amplitudeRms * 0.95f ||
+        RootMeanSquare(samples1, CHUNK_COUNT / 2, CHUNK_COUNT / 2) > amplitudeRms * 0.02f) {
+      errorCode = AUDIO_EFFECT_TEST_ERROR_BIQUAD_LOWPASS;
+      goto end;
+    }
+  }
+
+  // limiter never lets peaks over threshold, and releases when signal is quiet
+  {
+    struct limiter limiter = {.threshold = 16000.0f, .gain = 1.0f};
+    FillSine(samples0, 440.0f, 30000.0f);
+    FillSine(samples1, 660.0f, 20000.0f);
+    LimiterProcess(&limiter, samples0, samples1, CHUNK_COUNT, SAMPLE_RATE);
+
+    f32 *values0 = (f32 *)samples0;
+    f32 *values1 = (f32 *)samples1;
+    for (u32 index = 0; index < CHUNK_COUNT * 8; index++) {
+      if (Absolute(values0[index]) > limiter.threshold + 0.5f || Absolute(values1[index]) > limiter.threshold + 0.5f) {
+        errorCode = AUDIO_EFFECT_TEST_ERROR_LIMITER_OVER;
+        goto end;
+      }
+    }
+
+    FillSine(samples0, 440.0f, 1000.0f);
+    FillSine(samples1, 440.0f, 1000.0f);
+    for (u32 run = 0; run < 2; run++)
+      LimiterProcess(&limiter, samples0, samples1, CHUNK_COUNT, SAMPLE_RATE);
+    if (limiter.gain != 1.0f) {
+      errorCode = AUDIO_EFFECT_TEST_ERROR_LIMITER_RELEASE;
+      goto end;
+    }
+  }
+
+  // reverb rings after impulse, and dies down
+  {
+    struct reverb reverb;
+    ReverbInit(&reverb, reverbMemory);
+    reverb.wet = 1.0f;
+    reverb.roomSize = 0.8f;
+
+    __builtin_memset(samples0, 0, sizeof(samples0));
+    ((f32 *)samples0)[0] = 10000.0f;
+    ReverbProcess(&reverb, 0, samples0, CHUNK_COUNT);
+
+    f32 early = RootMeanSquare(samples0, 150, 150);
+    f32 late = RootMeanSquare(samples0, CHUNK_COUNT - 150, 150);
+    if (early == 0.0f) {
+      errorCode = AUDIO_EFFECT_TEST_ERROR_REVERB_TAIL;
+      goto end;
+    }
+
+    if (late >= early) {
+      errorCode = AUDIO_EFFECT_TEST_ERROR_REVERB_DECAY;
+      goto end;
+    }
+  }
+
+end:
+  return (s32)errorCode;
+}
@@ -0,0 +1,55 @@
+#include <handmadehero/checksum.h>
+#include <handmadehero/types.h>
+
+enum checksum_test_error {
+  CHECKSUM_TEST_ERROR_NONE = 0,
+  CHECKSUM_TEST_ERROR_CRC32C_EMPTY,
+  CHECKSUM_TEST_ERROR_CRC32C,
+  CHECKSUM_TEST_ERROR_CRC32C_ACCUMULATE,
+};
+
+int
+main(void)
+{
+  enum checksum_test_error errorCode = CHECKSUM_TEST_ERROR_NONE;
+
+  // Crc32c
+  {
+    u32 result = Crc32c(0, 0);
+    u32 expected = 0;
+    if (result != expected) {
+      errorCode = CHECKSUM_TEST_ERROR_CRC32C_EMPTY;
+      goto end;
+    }
+  }
+
+  {
+    // check value from Castagnoli paper
+    char input[] = "123456789";
+    u32 result = Crc32c(input, sizeof(input) - 1);
+    u32 expected = 0xe3069283;
+    if (result != expected) {
+      errorCode = CHECKSUM_TEST_ERROR_CRC32C;
+      goto end;
+    }
+  }
+
+  // Crc32cAccumulate
+  {
+    char input[] = "The quick brown fox jumps over the lazy dog";
+    u64 inputSize = sizeof(input) - 1;
+    u32 expected = Crc32c(input, inputSize);
+
+    for (u64 split = 0; split <= inputSize; split++) {
+      u32 result = Crc32cAccumulate(0, input, split);
+      result = Crc32cAccumulate(result, input + split, inputSize - split);
+      if (result != expected) {
+        errorCode = CHECKSUM_TEST_ERROR_CRC32C_ACCUMULATE;
+        goto end;
+      }
+    }
+  }
+
+end:
+  return (s32)errorCode;
+}
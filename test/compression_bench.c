@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 199309L
+#include <handmadehero/compression.h>
+#include <handmadehero/types.h>
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Measures throughput of LzCompress and LzDecompressInPlace on data that
+ * looks like what asset packs store.
+ *   - bitmap: 32-bit ARGB sprite, transparent border around noisy shape
+ *   - audio: s16 sine with noise, close to incompressible
+ */
+
+#define INPUT_SIZE (8 * 1024 * 1024)
+global_variable u8 input[INPUT_SIZE];
+global_variable u8 compressed[INPUT_SIZE + INPUT_SIZE / 255 + 16];
+global_variable u8 output[INPUT_SIZE + INPUT_SIZE / 255 + 32];
+
+internal u32
+XorShift32(u32 *state)
+{
+  u32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+internal f64
+Now(void)
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (f64)time.tv_sec + (f64)time.tv_nsec * 1e-9;
+}
+
+internal void
+FillBitmap(u8 *memory, u64 size)
+{
+  u32 state = 0xdeadbeef;
+  u32 width = 512;
+  u32 *pixels = (u32 *)memory;
+  u64 pixelCount = size / sizeof(u32);
+  for (u64 index = 0; index < pixelCount; index++) {
+    s32 x = (s32)(index % width) - (s32)width / 2;
+    s32 y = (s32)((index / width) % width) - (s32)width / 2;
+    b32 isInside = x * x + y * y < (s32)(width * width / 9);
+    u32 noise = XorShift32(&state) & 0x0f0f0f;
+    pixels[index] = isInside ? 0xff000000 | 0x406080 | noise : 0;
+  }
+}
+
+internal void
+FillAudio(u8 *memory, u64 size)
+{
+  u32 state = 0xcafebabe;
+  s16 *samples = (s16 *)memory;
+  u64 sampleCount = size / sizeof(s16);
+  f32 phase = 0.0f;
+  for (u64 index = 0; index < sampleCount; index++) {
+    phase += 0.0626f;
+    if (phase > 6.2831853f)
+      phase -= 6.2831853f;
+    // parabolic sine approximation
+    f32 t = phase < 3.1415926f ? phase : phase - 3.1415926f;
+    f32 value = 4.0f * t * (3.1415926f - t) / (3.1415926f * 3.1415926f);
+    if (phase >= 3.1415926f)
+      value = -value;
+    s32 noise = (s32)(XorShift32(&state) & 0x3ff) - 0x200;
+    samples[index] = (s16)((s32)(value * 12000.0f) + noise);
+  }
+}
+
+internal void
+Benchmark(char *name, void (*Fill)(u8 *memory, u64 size))
+{
+  Fill(input, INPUT_SIZE);
+
+  u32 runCount = 8;
+  f64 compressTime = 0.0;
+  f64 decompressTime = 0.0;
+  u64 compressedSize = 0;
+  u64 bufferSize = INPUT_SIZE + LzInPlaceMargin(INPUT_SIZE);
+  for (u32 run = 0; run < runCount; run++) {
+    f64 start = Now();
+    compressedSize = LzCompress(compressed, input, INPUT_SIZE);
+    compressTime += Now() - start;
+
+    __builtin_memcpy(output + bufferSize - compressedSize, compressed, compressedSize);
+    start = Now();
+    b32 isDecompressed = LzDecompressInPlace(output, bufferSize, INPUT_SIZE, compressedSize);
+    decompressTime += Now() - start;
+
+    if (!isDecompressed) {
+      printf("%s: decompression failed\n", name);
+      return;
+    }
+  }
+
+  f64 megabytes = (f64)INPUT_SIZE * runCount / (1024.0 * 1024.0);
+  printf("%-8s ratio %5.1f%%  compress %7.1f MiB/s  decompress %7.1f MiB/s\n", name,
+         100.0 * (f64)compressedSize / (f64)INPUT_SIZE, megabytes / compressTime, megabytes / decompressTime);
+}
+
+int
+main(void)
+{
+  Benchmark("bitmap", FillBitmap);
+  Benchmark("audio", FillAudio);
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include <handmadehero/compression.h>
+#include <handmadehero/types.h>
+
+enum compression_test_error {
+  COMPRESSION_TEST_ERROR_NONE = 0,
+  COMPRESSION_TEST_ERROR_BOUND,
+  COMPRESSION_TEST_ERROR_NOT_COMPRESSED,
+  COMPRESSION_TEST_ERROR_DECOMPRESS,
+  COMPRESSION_TEST_ERROR_DECOMPRESS_IN_PLACE,
+  COMPRESSION_TEST_ERROR_DECOMPRESS_TRUNCATED,
+  COMPRESSION_TEST_ERROR_DECOMPRESS_WRONG_SIZE,
+};
+
+#define INPUT_SIZE_MAX (256 * 1024)
+global_variable u8 input[INPUT_SIZE_MAX];
+global_variable u8 compressed[INPUT_SIZE_MAX + INPUT_SIZE_MAX / 255 + 16];
+global_variable u8 output[INPUT_SIZE_MAX + INPUT_SIZE_MAX / 255 + 32];
+
+internal u32
+XorShift32(u32 *state)
+{
+  u32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+internal b32
+IsEqual(u8 *a, u8 *b, u64 size)
+{
+  for (u64 index = 0; index < size; index++) {
+    if (a[index] != b[index])
+      return 0;
+  }
+  return 1;
+}
+
+internal enum compression_test_error
+RoundTrip(u64 inputSize)
+{
+  u64 compressedSize = LzCompress(compressed, input, inputSize);
+  if (compressedSize > LzCompressBound(inputSize))
+    return COMPRESSION_TEST_ERROR_BOUND;
+
+  if (!LzDecompress(output, inputSize, compressed, compressedSize) || !IsEqual(input, output, inputSize))
+    return COMPRESSION_TEST_ERROR_DECOMPRESS;
+
+  u64 bufferSize = inputSize + LzInPlaceMargin(inputSize);
+  __builtin_memcpy(output + bufferSize - compressedSize, compressed, compressedSize);
+  if (!LzDecompressInPlace(output, bufferSize, inputSize, compressedSize) || !IsEqual(input, output, inputSize))
+    return COMPRESSION_TEST_ERROR_DECOMPRESS_IN_PLACE;
+
+  if (compressedSize > 1 && LzDecompress(output, inputSize, compressed, compressedSize - 1))
+    return COMPRESSION_TEST_ERROR_DECOMPRESS_TRUNCATED;
+
+  if (LzDecompress(output, inputSize + 1, compressed, compressedSize))
+    return COMPRESSION_TEST_ERROR_DECOMPRESS_WRONG_SIZE;
+
+  return COMPRESSION_TEST_ERROR_NONE;
+}
+
+int
+main(void)
+{
+  enum compression_test_error errorCode = COMPRESSION_TEST_ERROR_NONE;
+
+  // empty and short inputs are stored as literals
+  {
+    char text[] = "handmade hero";
+    for (u64 size = 0; size < sizeof(text); size++) {
+      __builtin_memcpy(input, text, size);
+      errorCode = RoundTrip(size);
+      if (errorCode != COMPRESSION_TEST_ERROR_NONE)
+        goto end;
+    }
+  }
+
+  // zeros, long match
+  {
+    u64 size = INPUT_SIZE_MAX;
+    __builtin_memset(input, 0, size);
+    errorCode = RoundTrip(size);
+    if (errorCode != COMPRESSION_TEST_ERROR_NONE)
+      goto end;
+
+    if (LzCompress(compressed, input, size) > size / 100) {
+      errorCode = COMPRESSION_TEST_ERROR_NOT_COMPRESSED;
+      goto end;
+    }
+  }
+
+  // random bytes, long literals
+  {
+    u32 state = 0x1234567;
+    u64 size = INPUT_SIZE_MAX;
+    for (u64 index = 0; index < size; index++)
+      input[index] = (u8)XorShift32(&state);
+
+    errorCode = RoundTrip(size);
+    if (errorCode != COMPRESSION_TEST_ERROR_NONE)
+      goto end;
+  }
+
+  // repeating patterns with short offsets, mixed with noise
+  {
+    u32 state = 0x7654321;
+    for (u64 period = 1; period <= 17; period++) {
+      u64 size = 4096 + period * 31;
+      for (u64 index = 0; index < size; index++) {
+        u32 random = XorShift32(&state);
+        input[index] = (random & 0xff) < 8 ? (u8)(random >> 8) : (u8)(index % period);
+      }
+
+      errorCode = RoundTrip(size);
+      if (errorCode != COMPRESSION_TEST_ERROR_NONE)
+        goto end;
+    }
+  }
+
+end:
+  return (s32)errorCode;
+}
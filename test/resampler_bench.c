@@ -0,0 +1,111 @@
+#include <handmadehero/resampler.h>
+#include <handmadehero/types.h>
+
+#include <stdio.h>
+
+/*
+ * Measures cycles per output sample of mixer resamplers, reading a second
+ * of 48kHz audio at different pitches, and error on a 9.6kHz sine.
+ */
+
+#define SAMPLE_COUNT (48000 * 4)
+#define OUTPUT_SAMPLE_COUNT 48000
+global_variable s16 samples0[SAMPLE_COUNT];
+global_variable s16 samples1[SAMPLE_COUNT];
+global_variable __m256 output0[OUTPUT_SAMPLE_COUNT / 8];
+global_variable __m256 output1[OUTPUT_SAMPLE_COUNT / 8];
+global_variable struct sinc_table table;
+global_variable struct sinc_neighbor noNeighbor;
+
+enum resampler {
+  RESAMPLER_NEAREST,
+  RESAMPLER_LINEAR,
+  RESAMPLER_SINC,
+};
+
+internal void
+Resample(enum resampler resampler, b32 isStereo, f32 dSample)
+{
+  f32 *coefficients = SincTableCoefficients(&table, dSample);
+  __m256 sampleLane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  __m256 sampleOffset = _mm256_mul_ps(sampleLane, _mm256_set1_ps(dSample));
+  __m256i sampleCount = _mm256_set1_epi32(SAMPLE_COUNT);
+  __m256i one = _mm256_set1_epi32(1);
+
+  for (u32 chunkIndex = 0; chunkIndex < OUTPUT_SAMPLE_COUNT / 8; chunkIndex++) {
+    f32 samplePosition = (f32)chunkIndex * 8.0f * dSample;
+    __m256 samplePos = _mm256_add_ps(_mm256_set1_ps(samplePosition), sampleOffset);
+    __m256 sampleValue0;
+    __m256 sampleValue1;
+    if (resampler == RESAMPLER_SINC) {
+      SampleSinc(coefficients, samples0, samples1, isStereo, SAMPLE_COUNT, &noNeighbor, &noNeighbor, samplePos,
+                 &sampleValue0, &sampleValue1);
+    } else if (resampler == RESAMPLER_LINEAR) {
+      __m256i sampleIndex = _mm256_cvttps_epi32(samplePos);
+      __m256 frac = _mm256_sub_ps(samplePos, _mm256_cvtepi32_ps(sampleIndex));
+      __m256i sampleMask = _mm256_cmpgt_epi32(sampleCount, _mm256_add_epi32(sampleIndex, one));
+      sampleValue0 = SampleLinear(samples0, sampleIndex, sampleMask, frac);
+      sampleValue1 = isStereo ? SampleLinear(samples1, sampleIndex, sampleMask, frac) : sampleValue0;
+    } else {
+      __m256i sampleIndex = _mm256_cvtps_epi32(samplePos);
+      __m256i sampleMask = _mm256_cmpgt_epi32(sampleCount, sampleIndex);
+      sampleValue0 = SampleNearest(samples0, sampleIndex, sampleMask);
+      sampleValue1 = isStereo ? SampleNearest(samples1, sampleIndex, sampleMask) : sampleValue0;
+    }
+
+    output0[chunkIndex] = _mm256_add_ps(output0[chunkIndex], sampleValue0);
+    output1[chunkIndex] = _mm256_add_ps(output1[chunkIndex], sampleValue1);
+  }
+}
+
+// root mean square of difference of first channel from sine wave, relative to its amplitude
+internal f32
+SineError(f32 dSample, f32 frequency)
+{
+  f32 sum = 0.0f;
+  for (u32 index = 0; index < OUTPUT_SAMPLE_COUNT; index++) {
+    f32 expected = Sin(TAU32 * frequency * (f32)index * dSample);
+    f32 difference = ((f32 *)output0)[index] / 16384.0f - expected;
+    sum += difference * difference;
+  }
+  return SquareRoot(sum / OUTPUT_SAMPLE_COUNT);
+}
+
+int
+main(void)
+{
+  SincTableInit(&table);
+
+  f32 frequency = 0.2f;
+  for (u32 index = 0; index < SAMPLE_COUNT; index++) {
+    samples0[index] = (s16)(16384.0f * Sin(TAU32 * frequency * (f32)index));
+    samples1[index] = samples0[index];
+  }
+
+  char *names[] = {"nearest", "linear", "sinc"};
+  f32 pitches[] = {0.73f, 1.41f, 2.2f};
+  for (u32 resampler = RESAMPLER_NEAREST; resampler <= RESAMPLER_SINC; resampler++) {
+    for (u32 pitchIndex = 0; pitchIndex < ARRAY_COUNT(pitches); pitchIndex++) {
+      f32 dSample = pitches[pitchIndex];
+      f64 cycles[2];
+      for (u32 isStereo = 0; isStereo < 2; isStereo++) {
+        u32 runCount = 16;
+        u64 start = __rdtsc();
+        for (u32 run = 0; run < runCount; run++)
+          Resample(resampler, isStereo, dSample);
+        cycles[isStereo] = (f64)(__rdtsc() - start) / ((f64)runCount * OUTPUT_SAMPLE_COUNT);
+      }
+
+      printf("%-8s pitch %4.2f  mono %5.2f  stereo %5.2f cycles/sample", names[resampler], (f64)dSample, cycles[0],
+             cycles[1]);
+      if (dSample < 1.0f) {
+        __builtin_memset(output0, 0, sizeof(output0));
+        Resample(resampler, 0, dSample);
+        printf("  error %6.4f", (f64)SineError(dSample, frequency));
+      }
+      printf("\n");
+    }
+  }
+
+  return 0;
+}
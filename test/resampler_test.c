@@ -0,0 +1,165 @@
+#include <handmadehero/resampler.h>
+#include <handmadehero/types.h>
+
+enum resampler_test_error {
+  RESAMPLER_TEST_ERROR_NONE = 0,
+  RESAMPLER_TEST_ERROR_GAIN,
+  RESAMPLER_TEST_ERROR_PASSBAND,
+  RESAMPLER_TEST_ERROR_STOPBAND,
+  RESAMPLER_TEST_ERROR_EDGE,
+  RESAMPLER_TEST_ERROR_NEIGHBOR,
+};
+
+#define SAMPLE_COUNT 16384
+global_variable s16 samples[SAMPLE_COUNT];
+global_variable struct sinc_table table;
+global_variable struct sinc_neighbor noNeighbor;
+
+internal void
+FillSine(f32 frequency, f32 amplitude)
+{
+  for (u32 index = 0; index < SAMPLE_COUNT; index++)
+    samples[index] = (s16)(amplitude * Sin(TAU32 * frequency * (f32)index));
+}
+
+/*
+ * Resamples sine wave made by FillSine() from middle of samples. Returns
+ * root mean square of output when amplitude is 0, otherwise of difference
+ * from sine wave at same positions.
+ */
+internal f32
+Resample(f32 dSample, f32 frequency, f32 amplitude)
+{
+  f32 *coefficients = SincTableCoefficients(&table, dSample);
+  __m256 sampleLane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  f32 sum = 0.0f;
+  u32 chunkCount = 512;
+  for (u32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+    f32 samplePosition = 1000.0f + (f32)chunkIndex * 8.0f * dSample;
+    __m256 sampleOffset = _mm256_mul_ps(sampleLane, _mm256_set1_ps(dSample));
+    __m256 samplePos = _mm256_add_ps(_mm256_set1_ps(samplePosition), sampleOffset);
+
+    __m256 sampleValue0;
+    __m256 sampleValue1;
+    SampleSinc(coefficients, samples, samples, 0, SAMPLE_COUNT, &noNeighbor, &noNeighbor, samplePos, &sampleValue0,
+               &sampleValue1);
+
+    for (u32 lane = 0; lane < 8; lane++) {
+      f32 expected = amplitude * Sin(TAU32 * frequency * samplePos[lane]);
+      f32 difference = sampleValue0[lane] - expected;
+      sum += difference * difference;
+    }
+  }
+
+  return SquareRoot(sum / (f32)(chunkCount * 8));
+}
+
+int
+main(void)
+{
+  enum resampler_test_error errorCode = RESAMPLER_TEST_ERROR_NONE;
+  SincTableInit(&table);
+
+  // every phase has unity gain at DC
+  for (u32 tableIndex = 0; tableIndex < SINC_TABLE_COUNT; tableIndex++) {
+    for (u32 phase = 0; phase <= SINC_PHASE_COUNT; phase++) {
+      f32 sum = 0.0f;
+      for (u32 tap = 0; tap < SINC_TAP_COUNT; tap++)
+        sum += table.coefficients[tableIndex][phase][tap];
+
+      if (Absolute(sum - 1.0f) > 1e-5f) {
+        errorCode = RESAMPLER_TEST_ERROR_GAIN;
+        goto end;
+      }
+    }
+  }
+
+  // frequencies below cutoff are kept, at any pitch down
+  {
+    f32 amplitude = 10000.0f;
+    f32 frequencies[] = {0.01f, 0.1f, 0.3f};
+    for (u32 frequencyIndex = 0; frequencyIndex < ARRAY_COUNT(frequencies); frequencyIndex++) {
+      f32 frequency = frequencies[frequencyIndex];
+      FillSine(frequency, amplitude);
+      if (Resample(0.73f, frequency, amplitude) > 20.0f || Resample(0.5f, frequency, amplitude) > 20.0f) {
+        errorCode = RESAMPLER_TEST_ERROR_PASSBAND;
+        goto end;
+      }
+    }
+  }
+
+  // pitching up by 2 filters frequencies that would fold back
+  {
+    FillSine(0.4f, 10000.0f);
+    if (Resample(2.0f, 0.4f, 0.0f) > 50.0f) {
+      errorCode = RESAMPLER_TEST_ERROR_STOPBAND;
+      goto end;
+    }
+  }
+
+  // samples outside of audio are zero
+  {
+    for (u32 index = 0; index < SAMPLE_COUNT; index++)
+      samples[index] = 1000;
+
+    f32 *coefficients = SincTableCoefficients(&table, 1.0f);
+    __m256 sampleValue0;
+    __m256 sampleValue1;
+    __m256 samplePos = _mm256_setr_ps(0.0f, 0.5f, 100.25f, (f32)SAMPLE_COUNT - 100.5f, (f32)SAMPLE_COUNT - 1.0f,
+                                      (f32)SAMPLE_COUNT + 7.0f, (f32)SAMPLE_COUNT + 8.0f, (f32)SAMPLE_COUNT + 100.0f);
+    SampleSinc(coefficients, samples, samples, 0, SAMPLE_COUNT, &noNeighbor, &noNeighbor, samplePos, &sampleValue0,
+               &sampleValue1);
+
+    if (Absolute(sampleValue0[2] - 1000.0f) > 0.5f || Absolute(sampleValue0[3] - 1000.0f) > 0.5f ||
+        sampleValue0[0] <= 0.0f || sampleValue0[0] >= 1000.0f || sampleValue0[4] <= 0.0f ||
+        sampleValue0[4] >= 1000.0f || sampleValue0[5] != 0.0f || sampleValue0[6] != 0.0f || sampleValue0[7] != 0.0f) {
+      errorCode = RESAMPLER_TEST_ERROR_EDGE;
+      goto end;
+    }
+  }
+
+  // audio split in two reads same as whole audio, taps past edges are read from neighbor
+  {
+    FillSine(0.05f, 10000.0f);
+    f32 dSample = 0.73f;
+    u32 splitSampleCount = SAMPLE_COUNT / 2;
+    struct sinc_neighbor before = {.samples = {samples, samples}, .sampleCount = splitSampleCount};
+    struct sinc_neighbor after = {.samples = {samples + splitSampleCount, samples + splitSampleCount},
+                                  .sampleCount = SAMPLE_COUNT - splitSampleCount};
+    f32 *coefficients = SincTableCoefficients(&table, dSample);
+    __m256 sampleOffset = _mm256_mul_ps(_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f),
+                                        _mm256_set1_ps(dSample));
+
+    // chunks that end before split are read from first half, ones that start after from second
+    f32 offsets[] = {-12.5f, -6.25f, 0.0f, 0.5f, 3.25f};
+    for (u32 offsetIndex = 0; offsetIndex < ARRAY_COUNT(offsets); offsetIndex++) {
+      f32 offset = offsets[offsetIndex];
+      __m256 samplePos = _mm256_add_ps(_mm256_set1_ps((f32)splitSampleCount + offset), sampleOffset);
+      __m256 sampleValue0;
+      __m256 sampleValue1;
+      SampleSinc(coefficients, samples, samples, 0, SAMPLE_COUNT, &noNeighbor, &noNeighbor, samplePos, &sampleValue0,
+                 &sampleValue1);
+
+      __m256 halfValue0;
+      __m256 halfValue1;
+      if (offset < 0.0f) {
+        SampleSinc(coefficients, samples, samples, 0, splitSampleCount, &noNeighbor, &after, samplePos, &halfValue0,
+                   &halfValue1);
+      } else {
+        __m256 halfPos = _mm256_sub_ps(samplePos, _mm256_set1_ps((f32)splitSampleCount));
+        SampleSinc(coefficients, after.samples[0], after.samples[1], 0, after.sampleCount, &before, &noNeighbor,
+                   halfPos, &halfValue0, &halfValue1);
+      }
+
+      for (u32 lane = 0; lane < 8; lane++) {
+        if (Absolute(halfValue0[lane] - sampleValue0[lane]) > 0.5f) {
+          errorCode = RESAMPLER_TEST_ERROR_NEIGHBOR;
+          goto end;
+        }
+      }
+    }
+  }
+
+end:
+  return (s32)errorCode;
+}
@@ -11,8 +11,21 @@ enum text_test_error {
   TEXT_TEST_ERROR_PATH_HAS_EXTENSION,
   TEXT_TEST_ERROR_PATH_HAS_EXTENSION_EXPECTED_FALSE,
   TEXT_TEST_ERROR_PATH_HAS_EXTENSION_WHEN_EXTENSION_IS_BIGGER,
+  TEXT_TEST_ERROR_STRING_BUILDER,
+  TEXT_TEST_ERROR_STRING_BUILDER_U64,
+  TEXT_TEST_ERROR_STRING_BUILDER_TRUNCATED,
 };
 
+internal b32
+IsStringEqual(char *a, char *b)
+{
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return *a == *b;
+}
+
 int
 main(void)
 {
@@ -111,6 +124,49 @@ main(void)
     }
   }
 
+  // StringBuilder
+  {
+    u8 memory[64];
+    struct string_builder builder = StringBuilder(memory, sizeof(memory));
+    StringBuilderAppendZeroTerminated(&builder, "tasks ");
+    StringBuilderAppend(&builder, StringFromZeroTerminated((u8 *)"used", 1024));
+    char *result = StringBuilderTerminate(&builder);
+    char *expected = "tasks used";
+    if (!IsStringEqual(result, expected) || builder.length != 10) {
+      errorCode = TEXT_TEST_ERROR_STRING_BUILDER;
+      goto end;
+    }
+  }
+
+  {
+    u8 memory[64];
+    struct string_builder builder = StringBuilder(memory, sizeof(memory));
+    StringBuilderAppendU64(&builder, 0);
+    StringBuilderAppendZeroTerminated(&builder, " ");
+    StringBuilderAppendU64(&builder, 1234567890);
+    StringBuilderAppendZeroTerminated(&builder, " ");
+    StringBuilderAppendU64(&builder, U64_MAX);
+    char *result = StringBuilderTerminate(&builder);
+    char *expected = "0 1234567890 18446744073709551615";
+    if (!IsStringEqual(result, expected)) {
+      errorCode = TEXT_TEST_ERROR_STRING_BUILDER_U64;
+      goto end;
+    }
+  }
+
+  {
+    u8 memory[6];
+    struct string_builder builder = StringBuilder(memory, sizeof(memory));
+    StringBuilderAppendZeroTerminated(&builder, "abc");
+    StringBuilderAppendU64(&builder, 12345);
+    char *result = StringBuilderTerminate(&builder);
+    char *expected = "abc12";
+    if (!IsStringEqual(result, expected)) {
+      errorCode = TEXT_TEST_ERROR_STRING_BUILDER_TRUNCATED;
+      goto end;
+    }
+  }
+
 end:
   return (s32)errorCode;
 }
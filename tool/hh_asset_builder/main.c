@@ -11,11 +11,16 @@
 #pragma GCC diagnostic ignored "-Wsign-compare"
 
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <handmadehero/assert.h>
+#include <handmadehero/atomic.h>
+#include <handmadehero/checksum.h>
+#include <handmadehero/compression.h>
 #include <handmadehero/fileformats.h>
 #include <handmadehero/types.h>
 
@@ -25,6 +30,7 @@
 #define STB_SPRINTF_IMPLEMENTATION
 #include "stb_sprintf.h"
 #define PRIu32 "u"
+#define PRIu64 "lu"
 #define PRIs32 "d"
 
 // TRUETYPE_BACKEND_XXX
@@ -245,6 +251,7 @@ enum hh_asset_builder_error {
   HH_ASSET_BUILDER_ERROR_MALLOC,
   HH_ASSET_BUILDER_ERROR_IO_READ,
   HH_ASSET_BUILDER_ERROR_IO_SEEK,
+  HH_ASSET_BUILDER_ERROR_IO_RENAME,
   HH_ASSET_BUILDER_ERROR_WAV_INVALID_MAGIC,
   HH_ASSET_BUILDER_ERROR_WAV_MALFORMED,
   HH_ASSET_BUILDER_ERROR_WAV_FORMAT_IS_NOT_PCM,
@@ -255,12 +262,21 @@ enum hh_asset_builder_error {
   HH_ASSET_BUILDER_ERROR_BMP_MALFORMED,
   HH_ASSET_BUILDER_ERROR_BMP_IS_NOT_ENCODED_PROPERLY,
   HH_ASSET_BUILDER_ERROR_TTF_MALFORMED,
+  HH_ASSET_BUILDER_ERROR_ATLAS_TOO_BIG,
+  HH_ASSET_BUILDER_ERROR_TRACE_MALFORMED,
 };
 
 struct bitmap_info {
   char *filename;
   f32 alignPercentageX;
   f32 alignPercentageY;
+  // 0 when bitmap has its own pixels
+  struct bitmap_id atlasId;
+};
+
+struct atlas_info {
+  // bitmap in atlas that made packing fail, to be reported
+  u32 errorAssetIndex;
 };
 
 struct audio_info {
@@ -273,13 +289,19 @@ struct audio_info {
 struct font_info {
   char *fontPath;
   u32 codepointCount;
+  // codepoints below it have no glyph in atlas
+  u32 glyphCodepointFirst;
 
-  struct bitmap_id *codepoints; // codepoints[codepointCount]
-  f32 *horizontalAdvanceTable;  // horizontalAdvanceTable[codepointCount][codepointCount]
+  f32 *horizontalAdvances; // horizontalAdvances[codepointCount]
+
+  // 0 when atlas has coverage of glyphs, see SetFontAtlasSDF()
+  u32 sdfSpread;
+  u32 atlasDownscale;
 
   // to be used with font_glyph_info
   struct loaded_font *loadedFont;
-  u32 writtenCodepointCount;
+  // set when font cannot be loaded, font and its glyphs are not packed
+  enum hh_asset_builder_error loadError;
 };
 
 struct font_glyph_info {
@@ -292,6 +314,7 @@ enum asset_metadata_type {
   ASSET_METADATA_TYPE_BITMAP,
   ASSET_METADATA_TYPE_FONT,
   ASSET_METADATA_TYPE_FONT_GLYPH,
+  ASSET_METADATA_TYPE_ATLAS,
 };
 
 struct asset_metadata {
@@ -300,18 +323,43 @@ struct asset_metadata {
   u32 tagIndexFirst;
   u32 tagIndexOnePastLast;
 
+  // 0 when asset is not in a bundle
+  struct bundle_id bundleId;
+
   union {
     struct bitmap_info bitmapInfo;
     struct audio_info audioInfo;
     struct font_info fontInfo;
     struct font_glyph_info fontGlyphInfo;
+    struct atlas_info atlasInfo;
   };
 };
 
 #define TAG_COUNT 0x1000
 #define ASSET_COUNT 0x1000
+#define BUNDLE_COUNT 0x100
+
+struct asset_trace_slot {
+  // 0 when slot is empty
+  u64 sourceHash;
+  // frame index in high bits, event index in low bits
+  u64 firstUse;
+};
+
+/* NOTE(e2dk4r): First use of every asset in trace written by game, see
+ * hha_trace_header. Open addressing hash table of source hashes, at most
+ * half of slots are used.
+ */
+struct asset_trace {
+  // power of 2
+  u32 slotCount;
+  struct asset_trace_slot *slots;
+};
 
 struct asset_context {
+  // 0 when data is written in order assets are added
+  struct asset_trace *trace;
+
   u32 tagCount;
   struct hha_tag tags[TAG_COUNT];
 
@@ -322,6 +370,9 @@ struct asset_context {
   struct asset_metadata assetMetadatas[ASSET_COUNT];
   struct hha_asset assets[ASSET_COUNT];
 
+  // bundle ids are 1 to bundleCount
+  u32 bundleCount;
+
   struct hha_asset_type *currentAssetType;
   struct asset_metadata *currentAsset;
 };
@@ -392,6 +443,18 @@ AddBitmapAsset(struct asset_context *context, char *filename, f32 alignPercentag
   return id;
 }
 
+// atlas has pixels of bitmaps added to it with AddAssetToAtlas()
+internal struct bitmap_id
+AddAtlasAsset(struct asset_context *context)
+{
+  struct added_asset asset = AddAsset(context);
+  struct asset_metadata *metadata = asset.metadata;
+  metadata->type = ASSET_METADATA_TYPE_ATLAS;
+
+  struct bitmap_id id = {asset.id};
+  return id;
+}
+
 internal struct audio_id
 AddAudioAssetTrimmed(struct asset_context *context, char *filename, u32 sampleIndex, u32 sampleCount)
 {
@@ -415,10 +478,10 @@ AddAudioAsset(struct asset_context *context, char *filename)
   return AddAudioAssetTrimmed(context, filename, 0, 0);
 }
 
-// fontInfo.codepoints is allocated on heap, after used call DeallocateMemory() on it.
-// fontInfo.horizontalAdvanceTable is allocated on heap, after used call DeallocateMemory() on it.
+// glyphs from glyphCodepointFirst up to codepointCount are packed in atlas of font
+// fontInfo.horizontalAdvances is allocated on heap, after used call DeallocateMemory() on it.
 internal struct font_id
-AddFontAsset(struct asset_context *context, char *fontPath, u32 codepointCount)
+AddFontAsset(struct asset_context *context, char *fontPath, u32 glyphCodepointFirst, u32 codepointCount)
 {
   struct added_asset asset = AddAsset(context);
   struct asset_metadata *metadata = asset.metadata;
@@ -428,16 +491,32 @@ AddFontAsset(struct asset_context *context, char *fontPath, u32 codepointCount)
   struct font_info *fontInfo = &metadata->fontInfo;
   fontInfo->fontPath = fontPath;
   fontInfo->codepointCount = codepointCount;
+  fontInfo->glyphCodepointFirst = glyphCodepointFirst;
 
-  u32 codepointsSize = fontInfo->codepointCount * sizeof(struct bitmap_id);
-  fontInfo->codepoints = AllocateMemory(codepointsSize);
-
-  u32 horizontalAdvanceTableSize = fontInfo->codepointCount * fontInfo->codepointCount * sizeof(f32);
-  fontInfo->horizontalAdvanceTable = AllocateMemory(horizontalAdvanceTableSize);
+  u32 horizontalAdvancesSize = fontInfo->codepointCount * sizeof(f32);
+  fontInfo->horizontalAdvances = AllocateMemory(horizontalAdvancesSize);
 
   return id;
 }
 
+/*
+ * Makes glyph atlas of font have signed distances instead of coverage. Atlas
+ * is atlasDownscale times smaller than font, distances span sdfSpread texels
+ * around edges. See hha_font_glyph.
+ */
+internal void
+SetFontAtlasSDF(struct asset_context *context, struct font_id fontId, u32 sdfSpread, u32 atlasDownscale)
+{
+  assert(fontId.value != 0 && fontId.value < context->assetCount &&
+         context->assetMetadatas[fontId.value].type == ASSET_METADATA_TYPE_FONT && "font is invalid");
+  assert(sdfSpread > 0 && sdfSpread <= 0xff && "spread is invalid");
+  assert(atlasDownscale > 0 && atlasDownscale <= 0xff && "downscale is invalid");
+
+  struct font_info *fontInfo = &context->assetMetadatas[fontId.value].fontInfo;
+  fontInfo->sdfSpread = sdfSpread;
+  fontInfo->atlasDownscale = atlasDownscale;
+}
+
 internal struct bitmap_id
 AddFontGlyphAsset(struct asset_context *context, struct font_id fontId, u32 codepoint)
 {
@@ -469,6 +548,43 @@ AddAssetTag(struct asset_context *context, enum asset_tag_id tagId, f32 value)
   context->tagCount++;
 }
 
+internal struct bundle_id
+AddBundle(struct asset_context *context)
+{
+  assert(context->bundleCount < BUNDLE_COUNT && "bundle count exceeded");
+  context->bundleCount++;
+
+  struct bundle_id id = {context->bundleCount};
+  return id;
+}
+
+// adds last added asset to bundle, assets of a bundle can be from different types
+internal void
+AddAssetToBundle(struct asset_context *context, struct bundle_id bundleId)
+{
+  assert(context->currentAsset && "you must call one of Add...Asset()");
+  assert(context->currentAsset->type == ASSET_METADATA_TYPE_BITMAP && "only bitmaps can be bundled");
+  assert(context->currentAsset->bitmapInfo.atlasId.value == 0 && "bitmap in atlas cannot be bundled");
+  assert(bundleId.value != 0 && bundleId.value <= context->bundleCount && "bundle is invalid");
+
+  context->currentAsset->bundleId = bundleId;
+}
+
+// puts last added bitmap into atlas, bitmap in atlas cannot be bundled
+internal void
+AddAssetToAtlas(struct asset_context *context, struct bitmap_id atlasId)
+{
+  assert(context->currentAsset && "you must call one of Add...Asset()");
+  assert(context->currentAsset->type == ASSET_METADATA_TYPE_BITMAP && "only bitmaps can be put into atlas");
+  assert(context->currentAsset->bundleId.value == 0 && "bundled bitmap cannot be put into atlas");
+  assert(atlasId.value != 0 && atlasId.value < context->assetCount &&
+         context->assetMetadatas[atlasId.value].type == ASSET_METADATA_TYPE_ATLAS && "atlas is invalid");
+
+  context->currentAsset->bitmapInfo.atlasId = atlasId;
+  u32 assetIndex = (u32)(context->currentAsset - context->assetMetadatas);
+  context->assets[assetIndex].bitmap.atlasId = atlasId;
+}
+
 internal void
 EndAssetType(struct asset_context *context)
 {
@@ -483,11 +599,16 @@ usage(void)
 {
   // clang-format off
   char usageMessage[] =
-      "hh_asset_builder [output]" "\n"
+      "hh_asset_builder [--trace path] [output]" "\n"
       "\n"
 
-      "  output @type    filename" "\n"
-      "         @default test.hha" "\n"
+      "  --trace @type    filename" "\n"
+      "          asset trace written by debug build of game," "\n"
+      "          data of packs is laid out in order game used it" "\n"
+      "\n"
+
+      "  output  @type    filename" "\n"
+      "          @default test.hha" "\n"
       "\n"
   ;
 
@@ -546,12 +667,89 @@ ReadEntireFile(char *path)
   return result;
 }
 
+internal inline u32
+AssetTraceSlot(u64 sourceHash, u32 slotCount)
+{
+  u64 hash = sourceHash ^ (sourceHash >> 32);
+  return (u32)hash & (slotCount - 1);
+}
+
+// trace.slots is allocated on heap, after used call DeallocateMemory() on it.
+internal enum hh_asset_builder_error
+LoadAssetTrace(char *path, struct asset_trace *trace)
+{
+  struct read_file_result traceFile = ReadEntireFile(path);
+  if (traceFile.error != HH_ASSET_BUILDER_ERROR_NONE)
+    return traceFile.error;
+
+  enum hh_asset_builder_error errorCode = HH_ASSET_BUILDER_ERROR_NONE;
+  struct hha_trace_header *header = traceFile.data;
+  struct hha_trace_event *events = (struct hha_trace_event *)(header + 1);
+  if (traceFile.size < sizeof(*header) || header->magic != HHA_TRACE_MAGIC || header->version != HHA_TRACE_VERSION ||
+      traceFile.size != sizeof(*header) + (u64)header->eventCount * sizeof(*events)) {
+    errorCode = HH_ASSET_BUILDER_ERROR_TRACE_MALFORMED;
+    goto cleanup;
+  }
+
+  trace->slotCount = 16;
+  while (trace->slotCount < 2 * header->eventCount)
+    trace->slotCount *= 2;
+  trace->slots = AllocateMemory(trace->slotCount * sizeof(*trace->slots));
+  if (!trace->slots) {
+    errorCode = HH_ASSET_BUILDER_ERROR_MALLOC;
+    goto cleanup;
+  }
+
+  for (u32 eventIndex = 0; eventIndex < header->eventCount; eventIndex++) {
+    struct hha_trace_event *event = events + eventIndex;
+    if (event->sourceHash == 0)
+      continue;
+
+    u32 slotIndex = AssetTraceSlot(event->sourceHash, trace->slotCount);
+    while (trace->slots[slotIndex].sourceHash != 0 && trace->slots[slotIndex].sourceHash != event->sourceHash)
+      slotIndex = (slotIndex + 1) & (trace->slotCount - 1);
+
+    struct asset_trace_slot *slot = trace->slots + slotIndex;
+    u64 use = (u64)event->frameIndex << 32 | eventIndex;
+    if (slot->sourceHash == 0) {
+      slot->sourceHash = event->sourceHash;
+      slot->firstUse = use;
+    } else if (slot->firstUse > use) {
+      slot->firstUse = use;
+    }
+  }
+
+  // cleanup
+cleanup:
+  DeallocateMemory(traceFile.data);
+
+  return errorCode;
+}
+
+// U64_MAX when asset is not in trace
+internal u64
+AssetTraceFirstUse(struct asset_trace *trace, u64 sourceHash)
+{
+  if (sourceHash == 0)
+    return U64_MAX;
+
+  u32 slotIndex = AssetTraceSlot(sourceHash, trace->slotCount);
+  while (trace->slots[slotIndex].sourceHash != 0) {
+    if (trace->slots[slotIndex].sourceHash == sourceHash)
+      return trace->slots[slotIndex].firstUse;
+    slotIndex = (slotIndex + 1) & (trace->slotCount - 1);
+  }
+
+  return U64_MAX;
+}
+
 /*****************************************************************
  * LOADING WAV FILES
  *****************************************************************/
 
 struct loaded_audio {
   void *_filememory;
+  void *_samplememory;
 
   u32 channelCount;
   u32 sampleCount;
@@ -638,6 +836,8 @@ FreeWav(struct loaded_audio *audio)
 {
   DeallocateMemory(audio->_filememory);
   audio->_filememory = 0;
+  DeallocateMemory(audio->_samplememory);
+  audio->_samplememory = 0;
 }
 
 internal struct load_wav_result
@@ -711,18 +911,23 @@ LoadWav(char *filename, u32 sectionSampleIndex, u32 sectionSampleCount)
     loadedAudio->samples[1] = 0;
     break;
 
-  case 2:
-    loadedAudio->samples[0] = sampleData;
-    loadedAudio->samples[1] = sampleData + sampleCount;
+  case 2: {
+    // NOTE(e2dk4r): wav interleaves channels, packs store every channel after
+    // another. Channels are padded for zeroing past end of buffer below.
+    s16 *planarSamples = AllocateMemory(2 * (sampleCount + 8) * sizeof(*planarSamples));
+    if (!planarSamples) {
+      result.error = HH_ASSET_BUILDER_ERROR_MALLOC;
+      goto onError;
+    }
+    loadedAudio->_samplememory = planarSamples;
+    loadedAudio->samples[0] = planarSamples;
+    loadedAudio->samples[1] = planarSamples + sampleCount + 8;
 
     for (u32 sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++) {
-      s16 source = sampleData[sampleIndex * 2];
-      sampleData[sampleIndex * 2] = sampleData[sampleIndex];
-      sampleData[sampleIndex] = source;
+      loadedAudio->samples[0][sampleIndex] = sampleData[sampleIndex * 2 + 0];
+      loadedAudio->samples[1][sampleIndex] = sampleData[sampleIndex * 2 + 1];
     }
-
-    // TODO(e2dk4r): load right channels
-    break;
+  } break;
 
   default:
     assert(0 && "Unsupported number of channels");
@@ -920,15 +1125,62 @@ onError:
  * LOADING TTF FILES
  *****************************************************************/
 
+// see hha_font_kerning
+struct kerning_table {
+  u32 usedCount;
+  // 0 or power of 2
+  u32 kerningCount;
+  struct hha_font_kerning *kernings;
+};
+
+internal void
+KerningTableInsert(struct kerning_table *table, u32 prevCodepoint, u32 codepoint, f32 advance)
+{
+  assert(codepoint != 0 && "codepoint 0 marks empty slot");
+
+  // NOTE: at most half of slots are used, so probes at runtime stay short
+  if (2 * (table->usedCount + 1) > table->kerningCount) {
+    struct kerning_table grownTable = {};
+    grownTable.kerningCount = table->kerningCount ? 2 * table->kerningCount : 64;
+    grownTable.kernings = AllocateMemory(grownTable.kerningCount * sizeof(*grownTable.kernings));
+    assert(grownTable.kernings && "cannot allocate memory");
+
+    for (u32 slot = 0; slot < table->kerningCount; slot++) {
+      struct hha_font_kerning *kerning = table->kernings + slot;
+      if (kerning->codepoint != 0)
+        KerningTableInsert(&grownTable, kerning->prevCodepoint, kerning->codepoint, kerning->advance);
+    }
+
+    DeallocateMemory(table->kernings);
+    *table = grownTable;
+  }
+
+  u32 slot = HHAFontKerningSlot(prevCodepoint, codepoint, table->kerningCount);
+  while (table->kernings[slot].codepoint != 0) {
+    assert(!(table->kernings[slot].prevCodepoint == prevCodepoint && table->kernings[slot].codepoint == codepoint) &&
+           "pair is already in table");
+    slot = (slot + 1) & (table->kerningCount - 1);
+  }
+
+  struct hha_font_kerning *kerning = table->kernings + slot;
+  kerning->prevCodepoint = prevCodepoint;
+  kerning->codepoint = codepoint;
+  kerning->advance = advance;
+  table->usedCount++;
+}
+
 struct loaded_font {
   void *_filememory;
   f32 ascent;
   f32 descent;
   f32 lineGap;
+  struct kerning_table kerningTable;
 
 #if TRUETYPE_BACKEND_FREETYPE
   FT_Library library;
   FT_Face face;
+  // FT_Face can only be used by one thread at a time
+  pthread_mutex_t glyphLock;
 #elif TRUETYPE_BACKEND_STBTT
   stbtt_fontinfo font;
   f32 scale;
@@ -950,17 +1202,22 @@ struct load_font_glyph_result {
 
 // loadedFont is allocated on heap, after used call DeallocateMemory() on it.
 // loadedFont._filememory is allocated on heap, after used call DeallocateMemory() on it.
+// horizontalAdvances[codepointCount] must be initialized to zero.
 internal struct load_font_result
-LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvanceTable);
+LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvances);
 
 // loadedBitmap.memory is allocated on heap, after used call DeallocateMemory() on it.
+// can be called from multiple threads with same loadedFont.
 internal struct load_font_glyph_result
 LoadFontGlyph(struct loaded_font *loadedFont, u32 codepoint);
 
+internal void
+FreeFont(struct loaded_font *loadedFont);
+
 #if TRUETYPE_BACKEND_FREETYPE
 
 internal struct load_font_result
-LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvanceTable)
+LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvances)
 {
   struct load_font_result result = {};
 
@@ -1003,8 +1260,14 @@ LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvanceTable)
   loadedFont->descent = (f32)(-metrics->descender >> 6);
   loadedFont->lineGap = (f32)((metrics->height - (metrics->ascender - metrics->descender)) >> 6);
 
-  // started from 1 because 0 is used for empty,
-  // for this to work horizontalAdvanceTable must be initialized to zero
+  // NOTE: glyph index 0 is missing glyph
+  FT_UInt *glyphIndices = AllocateMemory(codepointCount * sizeof(*glyphIndices));
+  if (!glyphIndices) {
+    result.error = HH_ASSET_BUILDER_ERROR_MALLOC;
+    goto cleanupFace;
+  }
+
+  // started from 1 because 0 is used for empty
   for (u32 codepointIndex = 1; codepointIndex < codepointCount; codepointIndex++) {
     /* retrieve glyph index from character code */
     FT_UInt glyphIndex = FT_Get_Char_Index(face, codepointIndex);
@@ -1014,31 +1277,41 @@ LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvanceTable)
     if (error)
       continue; /* ignore errors */
 
-    f32 horizontalAdvance = (f32)(face->glyph->advance.x >> 6);
-
-    for (u32 otherCodepointIndex = 0; otherCodepointIndex < codepointCount; otherCodepointIndex++) {
-      u32 offset = (codepointIndex * codepointCount) + otherCodepointIndex;
-      *(horizontalAdvanceTable + offset) = horizontalAdvance;
-    }
+    glyphIndices[codepointIndex] = glyphIndex;
+    horizontalAdvances[codepointIndex] = (f32)(face->glyph->advance.x >> 6);
   }
 
   b32 hasKerning = FT_HAS_KERNING(face);
   if (hasKerning) {
-    for (u32 codepointIndex = 0; codepointIndex < codepointCount; codepointIndex++) {
-      for (u32 otherCodepointIndex = 0; otherCodepointIndex < codepointCount; otherCodepointIndex++) {
+    for (u32 codepointIndex = 1; codepointIndex < codepointCount; codepointIndex++) {
+      FT_UInt glyphIndex = glyphIndices[codepointIndex];
+      if (glyphIndex == 0)
+        continue;
+
+      for (u32 otherCodepointIndex = 1; otherCodepointIndex < codepointCount; otherCodepointIndex++) {
+        FT_UInt otherGlyphIndex = glyphIndices[otherCodepointIndex];
+        if (otherGlyphIndex == 0)
+          continue;
+
         FT_Vector delta;
-        FT_Get_Kerning(face, codepointIndex, otherCodepointIndex, FT_KERNING_DEFAULT, &delta);
+        FT_Get_Kerning(face, glyphIndex, otherGlyphIndex, FT_KERNING_DEFAULT, &delta);
         // f32 kerningAdvance = delta.x;
         if (delta.x == 0)
           continue;
 
         f32 kerningAdvanceScaled = (f32)(FT_MulFix(delta.x, metrics->y_scale) >> 6);
-        u32 offset = (codepointIndex * codepointCount) + otherCodepointIndex;
-        *(horizontalAdvanceTable + offset) += kerningAdvanceScaled;
+        if (kerningAdvanceScaled == 0.0f)
+          continue;
+
+        // codepoint followed by other codepoint
+        KerningTableInsert(&loadedFont->kerningTable, codepointIndex, otherCodepointIndex, kerningAdvanceScaled);
       }
     }
   }
 
+  DeallocateMemory(glyphIndices);
+
+  pthread_mutex_init(&loadedFont->glyphLock, 0);
   result.loadedFont = loadedFont;
 
   return result;
@@ -1059,11 +1332,13 @@ LoadFontGlyph(struct loaded_font *loadedFont, u32 codepoint)
 {
   struct load_font_glyph_result result = {};
 
+  pthread_mutex_lock(&loadedFont->glyphLock);
+
   FT_Face face = loadedFont->face;
   FT_Error error = FT_Load_Char(face, codepoint, FT_LOAD_RENDER);
   if (error) {
     result.error = HH_ASSET_BUILDER_ERROR_TTF_MALFORMED;
-    return result;
+    goto unlockFace;
   }
 
   assert(FT_HAS_HORIZONTAL(face));
@@ -1088,7 +1363,7 @@ LoadFontGlyph(struct loaded_font *loadedFont, u32 codepoint)
   loadedBitmap.memory = AllocateMemory(loadedBitmap.height * loadedBitmap.stride);
   if (!loadedBitmap.memory) {
     result.error = HH_ASSET_BUILDER_ERROR_MALLOC;
-    return result;
+    goto unlockFace;
   }
 
   u8 *srcRow = bitmap->buffer + (((s32)bitmap->rows - 1) * bitmap->pitch); // start at bottom left
@@ -1110,13 +1385,28 @@ LoadFontGlyph(struct loaded_font *loadedFont, u32 codepoint)
 
   result.loadedBitmap = loadedBitmap;
 
+  // cleanup
+unlockFace:
+  pthread_mutex_unlock(&loadedFont->glyphLock);
+
   return result;
 }
 
+internal void
+FreeFont(struct loaded_font *loadedFont)
+{
+  pthread_mutex_destroy(&loadedFont->glyphLock);
+  DeallocateMemory(loadedFont->kerningTable.kernings);
+  FT_Done_Face(loadedFont->face);
+  FT_Done_FreeType(loadedFont->library);
+  DeallocateMemory(loadedFont->_filememory);
+  DeallocateMemory(loadedFont);
+}
+
 #elif TRUETYPE_BACKEND_STBTT
 
 internal struct load_font_result
-LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvanceTable)
+LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvances)
 {
   struct load_font_result result = {};
   struct read_file_result ttfFile = ReadEntireFile(fontPath);
@@ -1149,31 +1439,47 @@ LoadFont(char *fontPath, u32 codepointCount, f32 *horizontalAdvanceTable)
   loadedFont->descent = (f32)-descent * loadedFont->scale;
   loadedFont->lineGap = (f32)lineGap * loadedFont->scale;
 
-  // started from 1 because 0 is used for empty,
-  // for this to work horizontalAdvanceTable must be initialized to zero
+  // NOTE: glyph index 0 is missing glyph
+  s32 *glyphIndices = AllocateMemory(codepointCount * sizeof(*glyphIndices));
+  if (!glyphIndices) {
+    result.error = HH_ASSET_BUILDER_ERROR_MALLOC;
+    DeallocateMemory(loadedFont->_filememory);
+    DeallocateMemory(loadedFont);
+    return result;
+  }
+
+  // started from 1 because 0 is used for empty
   for (u32 codepointIndex = 1; codepointIndex < codepointCount; codepointIndex++) {
-    int advance;
-    stbtt_GetCodepointHMetrics(font, (int)codepointIndex, &advance, 0);
-    f32 horizontalAdvance = (f32)advance * loadedFont->scale;
+    s32 glyphIndex = stbtt_FindGlyphIndex(font, (int)codepointIndex);
+    glyphIndices[codepointIndex] = glyphIndex;
 
-    for (u32 otherCodepointIndex = 0; otherCodepointIndex < codepointCount; otherCodepointIndex++) {
-      u32 offset = (codepointIndex * codepointCount) + otherCodepointIndex;
-      *(horizontalAdvanceTable + offset) = horizontalAdvance;
-    }
+    int advance;
+    stbtt_GetGlyphHMetrics(font, glyphIndex, &advance, 0);
+    horizontalAdvances[codepointIndex] = (f32)advance * loadedFont->scale;
   }
 
-  for (u32 codepointIndex = 0; codepointIndex < codepointCount; codepointIndex++) {
-    for (u32 otherCodepointIndex = 0; otherCodepointIndex < codepointCount; otherCodepointIndex++) {
-      int kerningAdvance = stbtt_GetCodepointKernAdvance(font, (int)otherCodepointIndex, (int)codepointIndex);
+  for (u32 codepointIndex = 1; codepointIndex < codepointCount; codepointIndex++) {
+    s32 glyphIndex = glyphIndices[codepointIndex];
+    if (glyphIndex == 0)
+      continue;
+
+    for (u32 otherCodepointIndex = 1; otherCodepointIndex < codepointCount; otherCodepointIndex++) {
+      s32 otherGlyphIndex = glyphIndices[otherCodepointIndex];
+      if (otherGlyphIndex == 0)
+        continue;
+
+      int kerningAdvance = stbtt_GetGlyphKernAdvance(font, glyphIndex, otherGlyphIndex);
       if (kerningAdvance == 0)
         continue;
       f32 kerningAdvanceScaled = (f32)kerningAdvance * loadedFont->scale;
 
-      u32 offset = (codepointIndex * codepointCount) + otherCodepointIndex;
-      *(horizontalAdvanceTable + offset) += kerningAdvanceScaled;
+      // codepoint followed by other codepoint
+      KerningTableInsert(&loadedFont->kerningTable, codepointIndex, otherCodepointIndex, kerningAdvanceScaled);
     }
   }
 
+  DeallocateMemory(glyphIndices);
+
   result.loadedFont = loadedFont;
 
   return result;
@@ -1264,371 +1570,1499 @@ cleanupCodepointBitmap:
   return result;
 }
 
+internal void
+FreeFont(struct loaded_font *loadedFont)
+{
+  DeallocateMemory(loadedFont->kerningTable.kernings);
+  DeallocateMemory(loadedFont->_filememory);
+  DeallocateMemory(loadedFont);
+}
+
 #endif
 /*****************************************************************
- * PACKING
+ * WORKERS
  *****************************************************************/
 
-internal enum hh_asset_builder_error
-WriteHHAFile(char *filename, struct asset_context *context)
-{
-  enum hh_asset_builder_error errorCode = HH_ASSET_BUILDER_ERROR_NONE;
+#define WORKER_COUNT_MAX 32
 
-  char logBuffer[256];
-  s64 logLength;
+typedef void (*pfnJob)(void *data, u32 workerIndex, u32 jobIndex);
 
-  int outFd = -1;
-  outFd = open(filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
-  if (outFd < 0) {
-    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot open file\n  filename: %s\n", filename);
-    assert(logLength > 0);
-    fatal(logBuffer, (u64)logLength);
+struct job_batch {
+  pfnJob Job;
+  void *data;
+  u32 jobCount;
+  u32 nextJobIndex;
+};
 
-    errorCode = HH_ASSET_BUILDER_ERROR_IO_OPEN;
-    goto exitWithErrorCode;
+struct worker {
+  pthread_t thread;
+  u32 workerIndex;
+  struct job_batch *batch;
+};
+
+internal void *
+WorkerThread(void *data)
+{
+  struct worker *worker = data;
+  struct job_batch *batch = worker->batch;
+
+  while (1) {
+    u32 jobIndex = AtomicFetchAdd(&batch->nextJobIndex, 1);
+    if (jobIndex >= batch->jobCount)
+      break;
+
+    batch->Job(batch->data, worker->workerIndex, jobIndex);
   }
 
-  struct hha_header header = {
-      .magic = HHA_MAGIC,
-      .version = HHA_VERSION,
-  };
+  return 0;
+}
 
-  // TODO: First tag is null always. Should it be written to file? => count -1
-  header.tagCount = context->tagCount;
-  header.assetCount = context->assetCount;
-  // TODO: sparseness?
-  header.assetTypeCount = ASSET_TYPE_COUNT;
-  header.tagsOffset = sizeof(header);
-  header.assetTypesOffset = header.tagsOffset + (header.tagCount * sizeof(*context->tags));
-  header.assetsOffset = header.assetTypesOffset + (header.assetTypeCount * sizeof(*context->assetTypes));
+internal u32
+WorkerCount(void)
+{
+  s64 processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+  if (processorCount < 1)
+    return 1;
+  if (processorCount > WORKER_COUNT_MAX)
+    return WORKER_COUNT_MAX;
+  return (u32)processorCount;
+}
 
-  s64 writtenBytes = write(outFd, &header, sizeof(header));
-  assert(writtenBytes > 0);
+/*
+ * Calls Job for every job index from workerCount threads, returns after all
+ * jobs are finished. Calling thread is worker 0.
+ */
+internal void
+RunJobs(u32 workerCount, pfnJob Job, void *data, u32 jobCount)
+{
+  assert(workerCount >= 1 && workerCount <= WORKER_COUNT_MAX);
 
-  // 1 - tags
-  struct hha_tag *tags = context->tags;
-  if (header.tagCount) {
-    // TODO: Should first tag be null?
-    u64 tagArraySize = sizeof(*tags) * header.tagCount;
-    writtenBytes = write(outFd, tags, tagArraySize);
-    assert(writtenBytes > 0);
+  struct job_batch batch = {
+      .Job = Job,
+      .data = data,
+      .jobCount = jobCount,
+  };
 
-    logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " tags written\n", header.tagCount);
-    assert(logLength > 0);
-    info(logBuffer, (u64)logLength);
+  struct worker workers[WORKER_COUNT_MAX];
+  u32 startedWorkerCount = 1;
+  for (u32 workerIndex = 1; workerIndex < workerCount; workerIndex++) {
+    struct worker *worker = workers + startedWorkerCount;
+    worker->workerIndex = startedWorkerCount;
+    worker->batch = &batch;
+
+    // NOTE: when thread cannot be created, jobs are done by started ones
+    if (pthread_create(&worker->thread, 0, WorkerThread, worker) != 0)
+      break;
+
+    startedWorkerCount++;
   }
 
-  // 2 - assetTypes
-  struct hha_asset_type *assetTypes = context->assetTypes;
-  u64 assetTypeArraySize = sizeof(*assetTypes) * header.assetTypeCount;
-  writtenBytes = write(outFd, assetTypes, assetTypeArraySize);
-  assert(writtenBytes > 0);
+  struct worker *mainWorker = workers + 0;
+  mainWorker->workerIndex = 0;
+  mainWorker->batch = &batch;
+  WorkerThread(mainWorker);
 
-  logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " asset types written\n", header.assetTypeCount);
-  assert(logLength > 0);
-  info(logBuffer, (u64)logLength);
+  for (u32 workerIndex = 1; workerIndex < startedWorkerCount; workerIndex++) {
+    pthread_join(workers[workerIndex].thread, 0);
+  }
+}
 
-  // 3 - assets
-  u64 assetArraySize = sizeof(struct hha_asset) * header.assetCount;
-  s64 seekResult = lseek64(outFd, (s64)assetArraySize, SEEK_CUR);
-  assert(seekResult != -1 && "file seek failed");
-  for (u32 assetIndex = 1; assetIndex < header.assetCount; assetIndex++) {
-    struct asset_metadata *src = context->assetMetadatas + assetIndex;
-    struct hha_asset *dest = context->assets + assetIndex;
+/*****************************************************************
+ * SOURCE HASHES
+ *****************************************************************/
 
-    dest->tagIndexFirst = src->tagIndexFirst;
-    dest->tagIndexOnePastLast = src->tagIndexOnePastLast;
+/* NOTE(e2dk4r): Every asset is hashed with the content of its source file
+ * and the parameters it is built with. Packs keep these hashes, so when
+ * previous pack has an asset with same hash its data is copied instead of
+ * loading and compressing source again.
+ * Bump SOURCE_HASH_VERSION when loaders or packing produce different data.
+ */
+#define SOURCE_HASH_VERSION 3
+
+// FNV-1a
+internal u64
+SourceHashAccumulate(u64 hash, void *data, u64 size)
+{
+  u8 *bytes = data;
+  for (u64 index = 0; index < size; index++) {
+    hash ^= bytes[index];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
 
-    s64 lseekResult = lseek64(outFd, 0, SEEK_CUR);
-    assert(lseekResult != -1);
-    dest->dataOffset = (u64)lseekResult;
-
-    switch (src->type) {
-    case ASSET_METADATA_TYPE_AUDIO: {
-      struct audio_info *audioInfo = &src->audioInfo;
-      struct load_wav_result loadWavResult =
-          LoadWav(audioInfo->filename, audioInfo->sampleIndex, audioInfo->sampleCount);
-      if (loadWavResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
-        switch (loadWavResult.error) {
-        case HH_ASSET_BUILDER_ERROR_IO_OPEN:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "file cannot be opened\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_IS_NOT_FILE:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "given path is not file\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_STAT:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "stat failed\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_MALLOC:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot allocate memory\n");
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_READ:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "cannot read file.\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_SEEK:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "cannot seek file.\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_BMP_INVALID_MAGIC:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "file is not bmp.\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_BMP_MALFORMED:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "bmp is malformed.\n  filename: %s\n", audioInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_BMP_IS_NOT_ENCODED_PROPERLY:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "bmp could not encoded properly.\n  filename: %s\n",
-                               audioInfo->filename);
-          break;
-
-        default:
-          assert(0 && "error not presented to user");
-          break;
-        };
-        assert(logLength > 0);
-        error(logBuffer, (u64)logLength);
-
-        errorCode = loadWavResult.error;
-        continue;
-      }
+internal u64
+SourceHashBegin(void)
+{
+  u32 version = SOURCE_HASH_VERSION;
+  return SourceHashAccumulate(0xcbf29ce484222325, &version, sizeof(version));
+}
 
-      struct loaded_audio *loadedAudio = &loadWavResult.loadedAudio;
+struct source_file {
+  char *path;
+  // 0 when file cannot be read
+  u64 hash;
+};
 
-      dest->audio.channelCount = loadedAudio->channelCount;
-      dest->audio.sampleCount = loadedAudio->sampleCount;
+struct source_files {
+  u32 count;
+  struct source_file files[ASSET_COUNT];
+};
 
-      for (u32 channelIndex = 0; channelIndex < loadedAudio->channelCount; channelIndex++) {
-        writtenBytes = write(outFd, loadedAudio->samples[channelIndex], loadedAudio->sampleCount * sizeof(s16));
-        assert(writtenBytes > 0);
-      }
+internal b32
+IsPathEqual(char *left, char *right)
+{
+  while (*left && *left == *right) {
+    left++;
+    right++;
+  }
+  return *left == *right;
+}
 
-      FreeWav(loadedAudio);
-    } break;
-
-    case ASSET_METADATA_TYPE_BITMAP: {
-      struct bitmap_info *bitmapInfo = &src->bitmapInfo;
-      struct load_bmp_result loadBmpResult = LoadBmp(bitmapInfo->filename);
-      if (loadBmpResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
-        switch (loadBmpResult.error) {
-        case HH_ASSET_BUILDER_ERROR_IO_OPEN:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "file cannot be opened\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_IS_NOT_FILE:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "given path is not file\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_STAT:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "stat failed\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_MALLOC:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot allocate memory\n");
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_READ:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "cannot read file.\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_SEEK:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "cannot seek file.\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_WAV_INVALID_MAGIC:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "file is not wav.\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_WAV_MALFORMED:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "wav is malformed.\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_WAV_FORMAT_IS_NOT_PCM:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "wav format is not PCM.\n  filename: %s\n", bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_WAV_SAMPLE_RATE_IS_NOT_48000:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "wav sample rate is not 48000.\n  filename: %s\n",
-                               bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_WAV_FORMAT_IS_NOT_S16LE:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "wav format is not S16LE.\n  filename: %s\n",
-                               bitmapInfo->filename);
-          break;
-        case HH_ASSET_BUILDER_ERROR_WAV_NUM_CHANNELS_IS_BIGGER_THAN_2:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "wav has more channels than 2.\n  filename: %s\n",
-                               bitmapInfo->filename);
-          break;
-
-        default:
-          assert(0 && "error not presented to user");
-          break;
-        };
-        assert(logLength > 0);
-        error(logBuffer, (u64)logLength);
-
-        errorCode = loadBmpResult.error;
-        continue;
-      }
+// hashes content of file once, even when many assets are built from it
+internal u64
+SourceFileHash(struct source_files *sourceFiles, char *path)
+{
+  for (u32 fileIndex = 0; fileIndex < sourceFiles->count; fileIndex++) {
+    struct source_file *file = sourceFiles->files + fileIndex;
+    if (IsPathEqual(file->path, path))
+      return file->hash;
+  }
 
-      struct loaded_bitmap *loadedBitmap = &loadBmpResult.loadedBitmap;
+  assert(sourceFiles->count < ARRAY_COUNT(sourceFiles->files));
+  struct source_file *file = sourceFiles->files + sourceFiles->count;
+  sourceFiles->count++;
+  file->path = path;
+  file->hash = 0;
 
-      dest->bitmap.width = loadedBitmap->width;
-      dest->bitmap.height = loadedBitmap->height;
-      dest->bitmap.alignPercentage[0] = bitmapInfo->alignPercentageX;
-      dest->bitmap.alignPercentage[1] = bitmapInfo->alignPercentageY;
+  struct read_file_result readFileResult = ReadEntireFile(path);
+  if (readFileResult.error != HH_ASSET_BUILDER_ERROR_NONE)
+    return file->hash;
 
-      writtenBytes = write(outFd, loadedBitmap->memory, (size_t)(loadedBitmap->stride * loadedBitmap->height));
-      assert(writtenBytes > 0);
-
-      FreeBmp(loadedBitmap);
-    } break;
-
-    case ASSET_METADATA_TYPE_FONT: {
-      struct font_info *fontInfo = &src->fontInfo;
-      struct load_font_result loadFontResult =
-          LoadFont(fontInfo->fontPath, fontInfo->codepointCount, fontInfo->horizontalAdvanceTable);
-
-      if (loadFontResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
-        switch (loadFontResult.error) {
-        case HH_ASSET_BUILDER_ERROR_IO_OPEN:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "file cannot be opened\n  filename: %s\n", fontInfo->fontPath);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_IS_NOT_FILE:
-          logLength =
-              snprintf(logBuffer, sizeof(logBuffer), "given path is not file\n  filename: %s\n", fontInfo->fontPath);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_STAT:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "stat failed\n  filename: %s\n", fontInfo->fontPath);
-          break;
-        case HH_ASSET_BUILDER_ERROR_MALLOC:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot allocate memory\n");
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_READ:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot read file.\n  filename: %s\n", fontInfo->fontPath);
-          break;
-        case HH_ASSET_BUILDER_ERROR_IO_SEEK:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot seek file.\n  filename: %s\n", fontInfo->fontPath);
-          break;
-        case HH_ASSET_BUILDER_ERROR_TTF_MALFORMED:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "file is not ttf or malformed.\n  filename: %s\n",
-                               fontInfo->fontPath);
-          break;
-        default:
-          assert(0 && "error not presented to user");
-          break;
-        };
-        assert(logLength > 0);
-        error(logBuffer, (u64)logLength);
-
-        errorCode = loadFontResult.error;
-        continue;
-      }
+  file->hash = SourceHashAccumulate(SourceHashBegin(), readFileResult.data, readFileResult.size);
+  // NOTE: 0 is reserved for assets that cannot be reused
+  if (file->hash == 0)
+    file->hash = 1;
+  DeallocateMemory(readFileResult.data);
 
-      struct loaded_font *loadedFont = loadFontResult.loadedFont;
-      dest->font.codepointCount = fontInfo->codepointCount;
-      dest->font.ascent = loadedFont->ascent;
-      dest->font.descent = loadedFont->descent;
-      dest->font.lineGap = loadedFont->lineGap;
-
-      u32 codepointsSize = fontInfo->codepointCount * sizeof(struct bitmap_id);
-      writtenBytes = write(outFd, fontInfo->codepoints, codepointsSize);
-      assert(writtenBytes > 0);
-
-      u32 horizontalAdvanceTableSize = fontInfo->codepointCount * fontInfo->codepointCount * sizeof(f32);
-      writtenBytes = write(outFd, fontInfo->horizontalAdvanceTable, horizontalAdvanceTableSize);
-      assert(writtenBytes > 0);
-
-      DeallocateMemory(fontInfo->codepoints);
-      DeallocateMemory(fontInfo->horizontalAdvanceTable);
-
-      fontInfo->loadedFont = loadedFont;
-    } break;
-
-    case ASSET_METADATA_TYPE_FONT_GLYPH: {
-      struct font_glyph_info *fontGlyphInfo = &src->fontGlyphInfo;
-      struct font_info *fontInfo = &(context->assetMetadatas + fontGlyphInfo->fontId.value)->fontInfo;
-      struct load_font_glyph_result loadFontGlyphResult = LoadFontGlyph(fontInfo->loadedFont, fontGlyphInfo->codepoint);
-      if (loadFontGlyphResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
-        switch (loadFontGlyphResult.error) {
-        case HH_ASSET_BUILDER_ERROR_MALLOC:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot allocate memory\n");
-          break;
-        case HH_ASSET_BUILDER_ERROR_TTF_MALFORMED:
-          logLength = snprintf(logBuffer, sizeof(logBuffer), "file is not ttf or malformed.\n  filename: %s\n",
-                               fontInfo->fontPath);
-          break;
-        default:
-          assert(0 && "error not presented to user");
-          break;
-        };
-        assert(logLength > 0);
-        error(logBuffer, (u64)logLength);
-
-        errorCode = loadFontGlyphResult.error;
-        continue;
-      }
+  return file->hash;
+}
 
-      struct loaded_bitmap *loadedBitmap = &loadFontGlyphResult.loadedBitmap;
-      dest->bitmap.width = loadedBitmap->width;
-      dest->bitmap.height = loadedBitmap->height;
-      dest->bitmap.alignPercentage[0] = loadFontGlyphResult.alignPercentageX;
-      dest->bitmap.alignPercentage[1] = loadFontGlyphResult.alignPercentageY;
+// returns 0 when source of asset cannot be read
+internal u64
+AssetSourceHash(struct source_files *sourceFiles, struct asset_context *context, u32 assetIndex)
+{
+  struct asset_metadata *metadata = context->assetMetadatas + assetIndex;
+  u64 hash = SourceHashBegin();
+  hash = SourceHashAccumulate(hash, &metadata->type, sizeof(metadata->type));
+
+  u64 fileHash = 0;
+  switch (metadata->type) {
+  case ASSET_METADATA_TYPE_AUDIO: {
+    struct audio_info *audioInfo = &metadata->audioInfo;
+    fileHash = SourceFileHash(sourceFiles, audioInfo->filename);
+    hash = SourceHashAccumulate(hash, &audioInfo->sampleIndex, sizeof(audioInfo->sampleIndex));
+    hash = SourceHashAccumulate(hash, &audioInfo->sampleCount, sizeof(audioInfo->sampleCount));
+  } break;
 
-      writtenBytes = write(outFd, loadedBitmap->memory, (size_t)(loadedBitmap->stride * loadedBitmap->height));
-      assert(writtenBytes > 0);
+  case ASSET_METADATA_TYPE_BITMAP: {
+    struct bitmap_info *bitmapInfo = &metadata->bitmapInfo;
+    fileHash = SourceFileHash(sourceFiles, bitmapInfo->filename);
+    hash = SourceHashAccumulate(hash, &bitmapInfo->alignPercentageX, sizeof(bitmapInfo->alignPercentageX));
+    hash = SourceHashAccumulate(hash, &bitmapInfo->alignPercentageY, sizeof(bitmapInfo->alignPercentageY));
+    hash = SourceHashAccumulate(hash, &bitmapInfo->atlasId, sizeof(bitmapInfo->atlasId));
+  } break;
 
-      DeallocateMemory(loadedBitmap->memory);
+  case ASSET_METADATA_TYPE_ATLAS: {
+    // NOTE: atlas changes when any of its bitmaps changes
+    fileHash = SourceHashBegin();
+    for (u32 memberIndex = 1; memberIndex < context->assetCount; memberIndex++) {
+      struct asset_metadata *member = context->assetMetadatas + memberIndex;
+      if (member->type != ASSET_METADATA_TYPE_BITMAP || member->bitmapInfo.atlasId.value != assetIndex)
+        continue;
 
-      if (fontInfo->writtenCodepointCount == fontInfo->codepointCount) {
-        // on last codepoint from file close it
-        DeallocateMemory(fontInfo->loadedFont->_filememory);
-        DeallocateMemory(fontInfo->loadedFont);
-      }
-      fontInfo->writtenCodepointCount++;
-    } break;
+      u64 memberHash = AssetSourceHash(sourceFiles, context, memberIndex);
+      if (memberHash == 0)
+        return 0;
+      fileHash = SourceHashAccumulate(fileHash, &memberIndex, sizeof(memberIndex));
+      fileHash = SourceHashAccumulate(fileHash, &memberHash, sizeof(memberHash));
     }
+  } break;
+
+  case ASSET_METADATA_TYPE_FONT: {
+    struct font_info *fontInfo = &metadata->fontInfo;
+    fileHash = SourceFileHash(sourceFiles, fontInfo->fontPath);
+    hash = SourceHashAccumulate(hash, &fontInfo->codepointCount, sizeof(fontInfo->codepointCount));
+    hash = SourceHashAccumulate(hash, &fontInfo->glyphCodepointFirst, sizeof(fontInfo->glyphCodepointFirst));
+    hash = SourceHashAccumulate(hash, &fontInfo->sdfSpread, sizeof(fontInfo->sdfSpread));
+    hash = SourceHashAccumulate(hash, &fontInfo->atlasDownscale, sizeof(fontInfo->atlasDownscale));
+  } break;
+
+  case ASSET_METADATA_TYPE_FONT_GLYPH: {
+    struct font_glyph_info *fontGlyphInfo = &metadata->fontGlyphInfo;
+    struct font_info *fontInfo = &(context->assetMetadatas + fontGlyphInfo->fontId.value)->fontInfo;
+    fileHash = SourceFileHash(sourceFiles, fontInfo->fontPath);
+    hash = SourceHashAccumulate(hash, &fontGlyphInfo->codepoint, sizeof(fontGlyphInfo->codepoint));
+  } break;
   }
 
-  seekResult = lseek64(outFd, (s64)header.assetsOffset, SEEK_SET);
-  if (seekResult == -1) {
-    logLength = snprintf(logBuffer, sizeof(logBuffer), "file seek failed\n  filename: '%s'\n", filename);
-    assert(logLength > 0);
-    fatal(logBuffer, (u64)logLength);
+  if (fileHash == 0)
+    return 0;
 
-    errorCode = HH_ASSET_BUILDER_ERROR_IO_SEEK;
-    goto fsyncOutFd;
+  // NOTE: truetype backends rasterize glyphs differently
+  if (metadata->type == ASSET_METADATA_TYPE_FONT || metadata->type == ASSET_METADATA_TYPE_FONT_GLYPH) {
+    u32 truetypeBackend = TRUETYPE_BACKEND_FREETYPE;
+    hash = SourceHashAccumulate(hash, &truetypeBackend, sizeof(truetypeBackend));
   }
 
-  struct hha_asset *assets = context->assets;
-  writtenBytes = write(outFd, assets, assetArraySize);
-  assert(writtenBytes > 0);
-  assert(writtenBytes > 0);
+  hash = SourceHashAccumulate(hash, &fileHash, sizeof(fileHash));
+  if (hash == 0)
+    hash = 1;
 
-  logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " assets written\n", header.assetCount);
-  assert(logLength > 0);
-  info(logBuffer, (u64)logLength);
+  return hash;
+}
 
-  // Packing finished
-  s32 fsyncResult;
-fsyncOutFd:
-  fsyncResult = fsync(outFd);
-  if (fsyncResult != 0) {
-    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot sync data\n");
-    assert(logLength > 0);
-    warn(logBuffer, (u64)logLength);
-  }
+/*****************************************************************
+ * PACKING
+ *****************************************************************/
 
-  s32 closeResult = close(outFd);
-  if (closeResult != 0) {
-    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot close the file.\n  filename: '%s'\n", filename);
-    assert(logLength > 0);
-    warn(logBuffer, (u64)logLength);
+struct asset_data {
+  u8 *memory;
+  u64 size;
+  u64 capacity;
+};
+
+// grows memory to at least capacity, keeping contents
+internal void
+AssetDataReserve(struct asset_data *assetData, u64 capacity)
+{
+  if (capacity <= assetData->capacity)
+    return;
+
+  u8 *memory = AllocateMemory(capacity);
+  assert(memory && "cannot allocate memory");
+  if (assetData->memory) {
+    __builtin_memcpy(memory, assetData->memory, assetData->size);
+    DeallocateMemory(assetData->memory);
+  }
+
+  assetData->memory = memory;
+  assetData->capacity = capacity;
+}
+
+internal void
+AssetDataAppend(struct asset_data *assetData, void *data, u64 size)
+{
+  AssetDataReserve(assetData, assetData->size + size);
+  __builtin_memcpy(assetData->memory + assetData->size, data, size);
+  assetData->size += size;
+}
+
+/*
+ * Compresses data of asset in place when it pays off. Updates asset's codec,
+ * size and checksum.
+ * scratch is used for compressing and checking that runtime can decompress
+ * it in place.
+ */
+internal void
+CompressAssetData(struct hha_asset *dest, struct asset_data *assetData, struct asset_data *scratch)
+{
+  u8 *data = assetData->memory;
+  u64 size = assetData->size;
+
+  u64 compressBound = LzCompressBound(size);
+  u64 inPlaceSize = size + LzInPlaceMargin(size);
+  AssetDataReserve(scratch, compressBound + inPlaceSize);
+  u8 *compressed = scratch->memory;
+  u8 *inPlace = scratch->memory + compressBound;
+
+  dest->codec = HHA_CODEC_NONE;
+
+  // NOTE(e2dk4r): Only compress when it saves at least 1/8 of data, audio
+  // usually does not compress, while sprites have lots of transparent pixels.
+  u64 compressedSize = LzCompress(compressed, data, size);
+  if (compressedSize <= size - size / 8) {
+    __builtin_memcpy(inPlace + inPlaceSize - compressedSize, compressed, compressedSize);
+    if (LzDecompressInPlace(inPlace, inPlaceSize, size, compressedSize) && __builtin_memcmp(inPlace, data, size) == 0) {
+      dest->codec = HHA_CODEC_LZ;
+      __builtin_memcpy(data, compressed, compressedSize);
+      assetData->size = compressedSize;
+    }
+  }
+
+  dest->dataSize = (u32)assetData->size;
+  dest->dataChecksum = Crc32c(assetData->memory, assetData->size);
+}
+
+// size of asset's data when it is decompressed
+internal u64
+AssetDataSize(struct asset_metadata *metadata, struct hha_asset *asset)
+{
+  switch (metadata->type) {
+  case ASSET_METADATA_TYPE_AUDIO:
+    return (u64)asset->audio.channelCount * asset->audio.sampleCount * sizeof(s16);
+  case ASSET_METADATA_TYPE_BITMAP:
+  case ASSET_METADATA_TYPE_FONT_GLYPH:
+  case ASSET_METADATA_TYPE_ATLAS:
+    if (asset->bitmap.atlasId.value != 0)
+      return 0;
+    return (u64)asset->bitmap.width * asset->bitmap.height * BITMAP_BYTES_PER_PIXEL;
+  case ASSET_METADATA_TYPE_FONT: {
+    u64 size = (u64)asset->font.codepointCount * sizeof(f32) +
+               (u64)asset->font.kerningCount * sizeof(struct hha_font_kerning);
+    if (asset->font.atlasWidth)
+      size += (u64)asset->font.codepointCount * sizeof(struct hha_font_glyph) +
+              (u64)asset->font.atlasWidth * asset->font.atlasHeight * BITMAP_BYTES_PER_PIXEL;
+    return size;
+  }
+  }
+
+  return 0;
+}
+
+// font asset that font and font glyph assets are built from, 0 for others
+internal struct asset_metadata *
+AssetFontMetadata(struct asset_context *context, struct asset_metadata *metadata)
+{
+  if (metadata->type == ASSET_METADATA_TYPE_FONT)
+    return metadata;
+  if (metadata->type == ASSET_METADATA_TYPE_FONT_GLYPH)
+    return context->assetMetadatas + metadata->fontGlyphInfo.fontId.value;
+  return 0;
+}
+
+internal void
+LogAssetError(struct asset_context *context, struct asset_metadata *metadata, enum hh_asset_builder_error errorCode)
+{
+  char logBuffer[256];
+  s64 logLength = 0;
+
+  char *path = 0;
+  switch (metadata->type) {
+  case ASSET_METADATA_TYPE_AUDIO:
+    path = metadata->audioInfo.filename;
+    break;
+  case ASSET_METADATA_TYPE_BITMAP:
+    path = metadata->bitmapInfo.filename;
+    break;
+  case ASSET_METADATA_TYPE_FONT:
+  case ASSET_METADATA_TYPE_FONT_GLYPH:
+    path = AssetFontMetadata(context, metadata)->fontInfo.fontPath;
+    break;
+  case ASSET_METADATA_TYPE_ATLAS:
+    path = context->assetMetadatas[metadata->atlasInfo.errorAssetIndex].bitmapInfo.filename;
+    break;
+  }
+
+  switch (errorCode) {
+  case HH_ASSET_BUILDER_ERROR_IO_OPEN:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "file cannot be opened\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_IO_IS_NOT_FILE:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "given path is not file\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_IO_STAT:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "stat failed\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_MALLOC:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot allocate memory\n");
+    break;
+  case HH_ASSET_BUILDER_ERROR_IO_READ:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot read file.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_IO_SEEK:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot seek file.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_WAV_INVALID_MAGIC:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "file is not wav.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_WAV_MALFORMED:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "wav is malformed.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_WAV_FORMAT_IS_NOT_PCM:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "wav format is not PCM.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_WAV_SAMPLE_RATE_IS_NOT_48000:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "wav sample rate is not 48000.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_WAV_FORMAT_IS_NOT_S16LE:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "wav format is not S16LE.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_WAV_NUM_CHANNELS_IS_BIGGER_THAN_2:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "wav has more channels than 2.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_BMP_INVALID_MAGIC:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "file is not bmp.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_BMP_MALFORMED:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "bmp is malformed.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_BMP_IS_NOT_ENCODED_PROPERLY:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "bmp could not encoded properly.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_TTF_MALFORMED:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "file is not ttf or malformed.\n  filename: %s\n", path);
+    break;
+  case HH_ASSET_BUILDER_ERROR_ATLAS_TOO_BIG:
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "bitmaps do not fit in atlas.\n  filename: %s\n", path);
+    break;
+
+  default:
+    assert(0 && "error not presented to user");
+    break;
+  };
+  assert(logLength > 0);
+  error(logBuffer, (u64)logLength);
+}
+
+// space between bitmaps in atlas, so filtering does not bleed neighbours in
+#define ATLAS_PADDING 1
+#define ATLAS_WIDTH_MIN 64
+#define ATLAS_WIDTH_MAX 4096
+// position in atlas is stored in u16
+#define ATLAS_HEIGHT_MAX 0xffff
+
+struct atlas_rect {
+  u32 width;
+  u32 height;
+  // set by PackAtlas()
+  u32 x;
+  u32 y;
+};
+
+struct atlas_size {
+  enum hh_asset_builder_error error;
+  // 0 when there is nothing to pack or rects do not fit in atlas
+  u32 width;
+  u32 height;
+};
+
+/*
+ * Places rects into atlas in rows, tallest first, with padding around them.
+ * Rects with zero width or height are not placed.
+ */
+internal struct atlas_size
+PackAtlas(struct atlas_rect *rects, u32 rectCount)
+{
+  struct atlas_size result = {};
+  u32 padding = ATLAS_PADDING;
+
+  // rects that are placed, tallest first
+  u32 *order = AllocateMemory(rectCount * sizeof(*order));
+  if (!order) {
+    result.error = HH_ASSET_BUILDER_ERROR_MALLOC;
+    return result;
+  }
+
+  u32 orderCount = 0;
+  u64 area = 0;
+  u32 rectWidthMax = 0;
+  for (u32 rectIndex = 0; rectIndex < rectCount; rectIndex++) {
+    struct atlas_rect *rect = rects + rectIndex;
+    if (rect->width == 0 || rect->height == 0)
+      continue;
+
+    area += (u64)(rect->width + padding) * (rect->height + padding);
+    if (rectWidthMax < rect->width)
+      rectWidthMax = rect->width;
+
+    u32 orderIndex = orderCount++;
+    while (orderIndex > 0 && rects[order[orderIndex - 1]].height < rect->height) {
+      order[orderIndex] = order[orderIndex - 1];
+      orderIndex--;
+    }
+    order[orderIndex] = rectIndex;
+  }
+
+  if (orderCount == 0 || rectWidthMax + 2 * padding > ATLAS_WIDTH_MAX)
+    goto cleanup;
+
+  u32 atlasWidth = ATLAS_WIDTH_MIN;
+  while ((u64)atlasWidth * atlasWidth < area && atlasWidth < ATLAS_WIDTH_MAX)
+    atlasWidth *= 2;
+  while (atlasWidth < rectWidthMax + 2 * padding)
+    atlasWidth *= 2;
+
+  u32 x = padding;
+  u32 y = padding;
+  u32 rowHeight = 0;
+  for (u32 orderIndex = 0; orderIndex < orderCount; orderIndex++) {
+    struct atlas_rect *rect = rects + order[orderIndex];
+    if (x + rect->width + padding > atlasWidth) {
+      x = padding;
+      y += rowHeight + padding;
+      rowHeight = 0;
+    }
+
+    rect->x = x;
+    rect->y = y;
+    x += rect->width + padding;
+    if (rowHeight < rect->height)
+      rowHeight = rect->height;
+  }
+
+  u32 atlasHeight = y + rowHeight + padding;
+  if (atlasHeight > ATLAS_HEIGHT_MAX)
+    goto cleanup;
+
+  result.width = atlasWidth;
+  result.height = atlasHeight;
+
+  // cleanup
+cleanup:
+  DeallocateMemory(order);
+
+  return result;
+}
+
+internal void
+AtlasCopyBitmap(u8 *atlasPixels, struct atlas_size *atlasSize, struct atlas_rect *rect,
+                struct loaded_bitmap *loadedBitmap)
+{
+  u32 atlasStride = atlasSize->width * BITMAP_BYTES_PER_PIXEL;
+  u8 *srcRow = loadedBitmap->memory;
+  u8 *destRow = atlasPixels + rect->y * atlasStride + rect->x * BITMAP_BYTES_PER_PIXEL;
+  for (u32 row = 0; row < rect->height; row++) {
+    __builtin_memcpy(destRow, srcRow, rect->width * BITMAP_BYTES_PER_PIXEL);
+    srcRow += loadedBitmap->stride;
+    destRow += atlasStride;
+  }
+}
+
+internal inline b32
+IsGlyphCoverageInside(struct loaded_bitmap *coverage, s32 x, s32 y)
+{
+  if (x < 0 || y < 0 || x >= (s32)coverage->width || y >= (s32)coverage->height)
+    return 0;
+
+  u32 texel = *(u32 *)((u8 *)coverage->memory + (u32)y * coverage->stride + (u32)x * BITMAP_BYTES_PER_PIXEL);
+  u32 alpha = texel >> 0x18;
+  return alpha >= 0x80;
+}
+
+/*
+ * Turns coverage of rasterized glyph into signed distances, see
+ * hha_font_glyph. Distance of texel is to nearest pixel of coverage on other
+ * side of edge, searched at most sdfSpread texels away.
+ */
+internal struct load_font_glyph_result
+FontGlyphSDF(struct load_font_glyph_result *glyph, u32 sdfSpread, u32 atlasDownscale)
+{
+  struct load_font_glyph_result result = {};
+  struct loaded_bitmap *coverage = &glyph->loadedBitmap;
+  if (coverage->width == 0 || coverage->height == 0)
+    return result;
+
+  struct loaded_bitmap loadedBitmap = {};
+  loadedBitmap.width = (coverage->width + atlasDownscale - 1) / atlasDownscale + 2 * sdfSpread;
+  loadedBitmap.height = (coverage->height + atlasDownscale - 1) / atlasDownscale + 2 * sdfSpread;
+  loadedBitmap.stride = loadedBitmap.width * sizeof(u32);
+  loadedBitmap.memory = AllocateMemory(loadedBitmap.height * loadedBitmap.stride);
+  if (!loadedBitmap.memory) {
+    result.error = HH_ASSET_BUILDER_ERROR_MALLOC;
+    return result;
+  }
+
+  // NOTE: search is done in coverage pixels
+  s32 searchRadius = (s32)(sdfSpread * atlasDownscale);
+  f32 distanceMax = (f32)searchRadius;
+
+  u8 *destRow = loadedBitmap.memory;
+  for (u32 y = 0; y < loadedBitmap.height; y++) {
+    u32 *dest = (u32 *)destRow;
+    s32 centerY = ((s32)y - (s32)sdfSpread) * (s32)atlasDownscale + (s32)atlasDownscale / 2;
+    for (u32 x = 0; x < loadedBitmap.width; x++) {
+      s32 centerX = ((s32)x - (s32)sdfSpread) * (s32)atlasDownscale + (s32)atlasDownscale / 2;
+      b32 isInside = IsGlyphCoverageInside(coverage, centerX, centerY);
+
+      s32 distanceSquare = searchRadius * searchRadius;
+      for (s32 offsetY = -searchRadius; offsetY <= searchRadius; offsetY++) {
+        for (s32 offsetX = -searchRadius; offsetX <= searchRadius; offsetX++) {
+          s32 offsetSquare = offsetX * offsetX + offsetY * offsetY;
+          if (offsetSquare >= distanceSquare)
+            continue;
+
+          if (IsGlyphCoverageInside(coverage, centerX + offsetX, centerY + offsetY) != isInside)
+            distanceSquare = offsetSquare;
+        }
+      }
+
+      // NOTE: edge is halfway between pixel and its neighbour on other side
+      f32 distance = SquareRoot((f32)distanceSquare) - 0.5f;
+      if (!isInside)
+        distance = -distance;
+
+      f32 alpha = 127.5f + 127.5f * distance / distanceMax;
+      if (alpha < 0.0f)
+        alpha = 0.0f;
+      if (alpha > 255.0f)
+        alpha = 255.0f;
+      u32 value = (u32)(alpha + 0.5f);
+      *dest++ = value << 0x18 | value << 0x10 | value << 0x08 | value << 0x00;
+    }
+
+    destRow += loadedBitmap.stride;
+  }
+
+  // NOTE: align point stays where it is in glyph, glyph is moved by padding
+  f32 alignX = glyph->alignPercentageX * (f32)coverage->width / (f32)atlasDownscale + (f32)sdfSpread;
+  f32 alignY = glyph->alignPercentageY * (f32)coverage->height / (f32)atlasDownscale + (f32)sdfSpread;
+  result.alignPercentageX = alignX / (f32)loadedBitmap.width;
+  result.alignPercentageY = alignY / (f32)loadedBitmap.height;
+  result.loadedBitmap = loadedBitmap;
+
+  return result;
+}
+
+/*
+ * Rasterizes every glyph of font and packs them into one atlas. Appends
+ * glyphs and atlas pixels, fills atlas dimensions of dest. Font without any
+ * glyph or that does not fit gets no atlas.
+ */
+internal enum hh_asset_builder_error
+AppendFontAtlas(struct font_info *fontInfo, struct hha_font *dest, struct asset_data *assetData)
+{
+  enum hh_asset_builder_error errorCode = HH_ASSET_BUILDER_ERROR_NONE;
+  u32 codepointCount = fontInfo->codepointCount;
+
+  struct hha_font_glyph *glyphs = AllocateMemory(codepointCount * sizeof(*glyphs));
+  struct loaded_bitmap *glyphBitmaps = AllocateMemory(codepointCount * sizeof(*glyphBitmaps));
+  struct atlas_rect *rects = AllocateMemory(codepointCount * sizeof(*rects));
+  u8 *atlasPixels = 0;
+  if (!glyphs || !glyphBitmaps || !rects) {
+    errorCode = HH_ASSET_BUILDER_ERROR_MALLOC;
+    goto cleanup;
+  }
+
+  // rasterize
+  for (u32 codepoint = fontInfo->glyphCodepointFirst; codepoint < codepointCount; codepoint++) {
+    struct load_font_glyph_result loadFontGlyphResult = LoadFontGlyph(fontInfo->loadedFont, codepoint);
+    if (loadFontGlyphResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
+      errorCode = loadFontGlyphResult.error;
+      goto cleanup;
+    }
+
+    if (fontInfo->sdfSpread) {
+      struct load_font_glyph_result sdfResult =
+          FontGlyphSDF(&loadFontGlyphResult, fontInfo->sdfSpread, fontInfo->atlasDownscale);
+      DeallocateMemory(loadFontGlyphResult.loadedBitmap.memory);
+      if (sdfResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
+        errorCode = sdfResult.error;
+        goto cleanup;
+      }
+      loadFontGlyphResult = sdfResult;
+    }
+
+    struct loaded_bitmap *loadedBitmap = &loadFontGlyphResult.loadedBitmap;
+    glyphBitmaps[codepoint] = *loadedBitmap;
+    rects[codepoint].width = loadedBitmap->width;
+    rects[codepoint].height = loadedBitmap->height;
+
+    struct hha_font_glyph *glyph = glyphs + codepoint;
+    glyph->alignPercentage[0] = loadFontGlyphResult.alignPercentageX;
+    glyph->alignPercentage[1] = loadFontGlyphResult.alignPercentageY;
+  }
+
+  struct atlas_size atlasSize = PackAtlas(rects, codepointCount);
+  if (atlasSize.error != HH_ASSET_BUILDER_ERROR_NONE) {
+    errorCode = atlasSize.error;
+    goto cleanup;
+  }
+
+  if (atlasSize.width == 0)
+    goto cleanup;
+
+  u64 atlasPixelsSize = (u64)atlasSize.width * atlasSize.height * BITMAP_BYTES_PER_PIXEL;
+  atlasPixels = AllocateMemory(atlasPixelsSize);
+  if (!atlasPixels) {
+    errorCode = HH_ASSET_BUILDER_ERROR_MALLOC;
+    goto cleanup;
+  }
+
+  for (u32 codepoint = 0; codepoint < codepointCount; codepoint++) {
+    struct atlas_rect *rect = rects + codepoint;
+    if (rect->width == 0 || rect->height == 0)
+      continue;
+
+    struct hha_font_glyph *glyph = glyphs + codepoint;
+    glyph->x = (u16)rect->x;
+    glyph->y = (u16)rect->y;
+    glyph->width = (u16)rect->width;
+    glyph->height = (u16)rect->height;
+    AtlasCopyBitmap(atlasPixels, &atlasSize, rect, glyphBitmaps + codepoint);
+  }
+
+  dest->atlasWidth = (u16)atlasSize.width;
+  dest->atlasHeight = (u16)atlasSize.height;
+  if (fontInfo->sdfSpread) {
+    dest->sdfSpread = (u16)fontInfo->sdfSpread;
+    dest->atlasDownscale = (u16)fontInfo->atlasDownscale;
+  }
+  AssetDataAppend(assetData, glyphs, codepointCount * sizeof(*glyphs));
+  AssetDataAppend(assetData, atlasPixels, atlasPixelsSize);
+
+  // cleanup
+cleanup:
+  DeallocateMemory(atlasPixels);
+  if (glyphBitmaps) {
+    for (u32 codepoint = 0; codepoint < codepointCount; codepoint++)
+      DeallocateMemory(glyphBitmaps[codepoint].memory);
+  }
+  DeallocateMemory(rects);
+  DeallocateMemory(glyphBitmaps);
+  DeallocateMemory(glyphs);
+
+  return errorCode;
+}
+
+/*
+ * Loads every bitmap in atlas and packs them. Appends atlas pixels, fills
+ * where bitmaps are in atlas.
+ * NOTE: Bitmaps in atlas have no data, their jobs do not touch their
+ * dimensions, so they are filled here.
+ */
+internal enum hh_asset_builder_error
+AppendAtlas(struct asset_context *context, u32 atlasIndex, struct asset_data *assetData)
+{
+  enum hh_asset_builder_error errorCode = HH_ASSET_BUILDER_ERROR_NONE;
+  struct atlas_info *atlasInfo = &context->assetMetadatas[atlasIndex].atlasInfo;
+  struct hha_bitmap *dest = &context->assets[atlasIndex].bitmap;
+
+  u32 *memberIndexes = AllocateMemory(context->assetCount * sizeof(*memberIndexes));
+  struct loaded_bitmap *memberBitmaps = AllocateMemory(context->assetCount * sizeof(*memberBitmaps));
+  struct atlas_rect *rects = AllocateMemory(context->assetCount * sizeof(*rects));
+  u8 *atlasPixels = 0;
+  u32 memberCount = 0;
+  if (!memberIndexes || !memberBitmaps || !rects) {
+    errorCode = HH_ASSET_BUILDER_ERROR_MALLOC;
+    goto cleanup;
+  }
+
+  for (u32 assetIndex = 1; assetIndex < context->assetCount; assetIndex++) {
+    struct asset_metadata *member = context->assetMetadatas + assetIndex;
+    if (member->type != ASSET_METADATA_TYPE_BITMAP || member->bitmapInfo.atlasId.value != atlasIndex)
+      continue;
+
+    struct load_bmp_result loadBmpResult = LoadBmp(member->bitmapInfo.filename);
+    if (loadBmpResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
+      atlasInfo->errorAssetIndex = assetIndex;
+      errorCode = loadBmpResult.error;
+      goto cleanup;
+    }
+
+    struct loaded_bitmap *loadedBitmap = &loadBmpResult.loadedBitmap;
+    memberIndexes[memberCount] = assetIndex;
+    memberBitmaps[memberCount] = *loadedBitmap;
+    rects[memberCount].width = loadedBitmap->width;
+    rects[memberCount].height = loadedBitmap->height;
+    memberCount++;
+  }
+
+  struct atlas_size atlasSize = PackAtlas(rects, memberCount);
+  if (atlasSize.error != HH_ASSET_BUILDER_ERROR_NONE) {
+    errorCode = atlasSize.error;
+    goto cleanup;
+  }
+
+  if (atlasSize.width == 0) {
+    if (memberCount != 0) {
+      atlasInfo->errorAssetIndex = memberIndexes[0];
+      errorCode = HH_ASSET_BUILDER_ERROR_ATLAS_TOO_BIG;
+    }
+    goto cleanup;
+  }
+
+  u64 atlasPixelsSize = (u64)atlasSize.width * atlasSize.height * BITMAP_BYTES_PER_PIXEL;
+  atlasPixels = AllocateMemory(atlasPixelsSize);
+  if (!atlasPixels) {
+    errorCode = HH_ASSET_BUILDER_ERROR_MALLOC;
+    goto cleanup;
+  }
+
+  for (u32 memberIndex = 0; memberIndex < memberCount; memberIndex++) {
+    struct atlas_rect *rect = rects + memberIndex;
+    AtlasCopyBitmap(atlasPixels, &atlasSize, rect, memberBitmaps + memberIndex);
+
+    struct hha_bitmap *memberDest = &context->assets[memberIndexes[memberIndex]].bitmap;
+    memberDest->width = rect->width;
+    memberDest->height = rect->height;
+    memberDest->atlasX = (u16)rect->x;
+    memberDest->atlasY = (u16)rect->y;
+  }
+
+  dest->width = atlasSize.width;
+  dest->height = atlasSize.height;
+  AssetDataAppend(assetData, atlasPixels, atlasPixelsSize);
+
+  // cleanup
+cleanup:
+  DeallocateMemory(atlasPixels);
+  if (memberBitmaps) {
+    for (u32 memberIndex = 0; memberIndex < memberCount; memberIndex++)
+      FreeBmp(memberBitmaps + memberIndex);
+  }
+  DeallocateMemory(rects);
+  DeallocateMemory(memberBitmaps);
+  DeallocateMemory(memberIndexes);
+
+  return errorCode;
+}
+
+/*
+ * Loads source of asset and appends its data as runtime reads it. Fills
+ * asset's info that comes from source.
+ * Fonts must be loaded before, glyphs are rasterized from them.
+ */
+internal enum hh_asset_builder_error
+LoadAssetData(struct asset_context *context, u32 assetIndex, struct asset_data *assetData)
+{
+  struct asset_metadata *src = context->assetMetadatas + assetIndex;
+  struct hha_asset *dest = context->assets + assetIndex;
+
+  switch (src->type) {
+  case ASSET_METADATA_TYPE_AUDIO: {
+    struct audio_info *audioInfo = &src->audioInfo;
+    struct load_wav_result loadWavResult = LoadWav(audioInfo->filename, audioInfo->sampleIndex, audioInfo->sampleCount);
+    if (loadWavResult.error != HH_ASSET_BUILDER_ERROR_NONE)
+      return loadWavResult.error;
+
+    struct loaded_audio *loadedAudio = &loadWavResult.loadedAudio;
+
+    dest->audio.channelCount = loadedAudio->channelCount;
+    dest->audio.sampleCount = loadedAudio->sampleCount;
+
+    for (u32 channelIndex = 0; channelIndex < loadedAudio->channelCount; channelIndex++) {
+      AssetDataAppend(assetData, loadedAudio->samples[channelIndex], loadedAudio->sampleCount * sizeof(s16));
+    }
+
+    FreeWav(loadedAudio);
+  } break;
+
+  case ASSET_METADATA_TYPE_BITMAP: {
+    struct bitmap_info *bitmapInfo = &src->bitmapInfo;
+    if (bitmapInfo->atlasId.value != 0) {
+      // NOTE: pixels and dimensions are filled while packing atlas
+      dest->bitmap.alignPercentage[0] = bitmapInfo->alignPercentageX;
+      dest->bitmap.alignPercentage[1] = bitmapInfo->alignPercentageY;
+      break;
+    }
+
+    struct load_bmp_result loadBmpResult = LoadBmp(bitmapInfo->filename);
+    if (loadBmpResult.error != HH_ASSET_BUILDER_ERROR_NONE)
+      return loadBmpResult.error;
+
+    struct loaded_bitmap *loadedBitmap = &loadBmpResult.loadedBitmap;
+
+    dest->bitmap.width = loadedBitmap->width;
+    dest->bitmap.height = loadedBitmap->height;
+    dest->bitmap.alignPercentage[0] = bitmapInfo->alignPercentageX;
+    dest->bitmap.alignPercentage[1] = bitmapInfo->alignPercentageY;
+
+    AssetDataAppend(assetData, loadedBitmap->memory, loadedBitmap->stride * loadedBitmap->height);
+
+    FreeBmp(loadedBitmap);
+  } break;
+
+  case ASSET_METADATA_TYPE_FONT: {
+    struct font_info *fontInfo = &src->fontInfo;
+    if (fontInfo->loadError != HH_ASSET_BUILDER_ERROR_NONE)
+      return fontInfo->loadError;
+
+    struct loaded_font *loadedFont = fontInfo->loadedFont;
+    dest->font.codepointCount = fontInfo->codepointCount;
+    dest->font.ascent = loadedFont->ascent;
+    dest->font.descent = loadedFont->descent;
+    dest->font.lineGap = loadedFont->lineGap;
+    dest->font.atlasDownscale = 1;
+
+    u32 horizontalAdvancesSize = fontInfo->codepointCount * sizeof(f32);
+    AssetDataAppend(assetData, fontInfo->horizontalAdvances, horizontalAdvancesSize);
+
+    struct kerning_table *kerningTable = &loadedFont->kerningTable;
+    dest->font.kerningCount = kerningTable->kerningCount;
+    AssetDataAppend(assetData, kerningTable->kernings, kerningTable->kerningCount * sizeof(*kerningTable->kernings));
+
+    enum hh_asset_builder_error atlasError = AppendFontAtlas(fontInfo, &dest->font, assetData);
+    if (atlasError != HH_ASSET_BUILDER_ERROR_NONE)
+      return atlasError;
+  } break;
+
+  case ASSET_METADATA_TYPE_FONT_GLYPH: {
+    struct font_glyph_info *fontGlyphInfo = &src->fontGlyphInfo;
+    struct font_info *fontInfo = &AssetFontMetadata(context, src)->fontInfo;
+    if (fontInfo->loadError != HH_ASSET_BUILDER_ERROR_NONE)
+      return fontInfo->loadError;
+
+    struct load_font_glyph_result loadFontGlyphResult = LoadFontGlyph(fontInfo->loadedFont, fontGlyphInfo->codepoint);
+    if (loadFontGlyphResult.error != HH_ASSET_BUILDER_ERROR_NONE)
+      return loadFontGlyphResult.error;
+
+    struct loaded_bitmap *loadedBitmap = &loadFontGlyphResult.loadedBitmap;
+    dest->bitmap.width = loadedBitmap->width;
+    dest->bitmap.height = loadedBitmap->height;
+    dest->bitmap.alignPercentage[0] = loadFontGlyphResult.alignPercentageX;
+    dest->bitmap.alignPercentage[1] = loadFontGlyphResult.alignPercentageY;
+
+    AssetDataAppend(assetData, loadedBitmap->memory, loadedBitmap->stride * loadedBitmap->height);
+
+    DeallocateMemory(loadedBitmap->memory);
+  } break;
+
+  case ASSET_METADATA_TYPE_ATLAS: {
+    enum hh_asset_builder_error atlasError = AppendAtlas(context, assetIndex, assetData);
+    if (atlasError != HH_ASSET_BUILDER_ERROR_NONE)
+      return atlasError;
+  } break;
+  }
+
+  return HH_ASSET_BUILDER_ERROR_NONE;
+}
+
+struct pack_job {
+  u32 assetIndex;
+  // data is copied from previous pack
+  b32 isReused;
+  enum hh_asset_builder_error error;
+  // data as it is written to file
+  struct asset_data data;
+};
+
+struct pack_context {
+  struct asset_context *context;
+  int outFd;
+
+  // in order data is written to file
+  u32 jobCount;
+  struct pack_job jobs[ASSET_COUNT];
+
+  // indexed by asset index
+  u64 sourceHashes[ASSET_COUNT];
+
+  // indexed by worker index
+  struct asset_data scratches[WORKER_COUNT_MAX];
+};
+
+internal b32
+ReadSection(int fd, struct hha_section *section, void *data)
+{
+  s64 readBytes = pread64(fd, data, section->size, (s64)section->offset);
+  if (readBytes != (s64)section->size)
+    return 0;
+
+  return section->checksum == Crc32c(data, section->size);
+}
+
+/*
+ * Copies data of assets that are built from same sources as in previous pack
+ * at path. Returns count of reused assets, 0 when there is no previous pack.
+ */
+internal u32
+ReusePreviousPack(char *path, struct pack_context *pack)
+{
+  struct asset_context *context = pack->context;
+  u32 reusedAssetCount = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return reusedAssetCount;
+
+  struct hha_asset *assets = 0;
+  u64 *sourceHashes = 0;
+
+  struct hha_header header;
+  s64 readBytes = pread64(fd, &header, sizeof(header), 0);
+  if (readBytes != sizeof(header) || header.magic != HHA_MAGIC || header.version != HHA_VERSION)
+    goto closeFile;
+
+  struct hha_section sections[16];
+  if (header.sectionCount > ARRAY_COUNT(sections))
+    goto closeFile;
+
+  u64 sectionsSize = header.sectionCount * sizeof(*sections);
+  readBytes = pread64(fd, sections, sectionsSize, (s64)header.sectionsOffset);
+  if (readBytes != (s64)sectionsSize)
+    goto closeFile;
+
+  struct hha_section *assetsSection = 0;
+  struct hha_section *sourceHashesSection = 0;
+  for (u32 sectionIndex = 0; sectionIndex < header.sectionCount; sectionIndex++) {
+    struct hha_section *section = sections + sectionIndex;
+    if (section->type == HHA_SECTION_TYPE_ASSETS)
+      assetsSection = section;
+    else if (section->type == HHA_SECTION_TYPE_SOURCE_HASHES)
+      sourceHashesSection = section;
+  }
+
+  // NOTE: packs from older builders do not have source hashes
+  if (!assetsSection || !sourceHashesSection || assetsSection->size != header.assetCount * sizeof(*assets) ||
+      sourceHashesSection->size != header.assetCount * sizeof(*sourceHashes))
+    goto closeFile;
+
+  assets = AllocateMemory(assetsSection->size);
+  sourceHashes = AllocateMemory(sourceHashesSection->size);
+  if (!assets || !sourceHashes)
+    goto freeMemory;
+
+  if (!ReadSection(fd, assetsSection, assets) || !ReadSection(fd, sourceHashesSection, sourceHashes))
+    goto freeMemory;
+
+  for (u32 jobIndex = 0; jobIndex < pack->jobCount; jobIndex++) {
+    struct pack_job *job = pack->jobs + jobIndex;
+    u64 sourceHash = pack->sourceHashes[job->assetIndex];
+    if (sourceHash == 0)
+      continue;
+
+    u32 previousAssetIndex = 0;
+    for (u32 assetIndex = 1; assetIndex < header.assetCount; assetIndex++) {
+      if (sourceHashes[assetIndex] == sourceHash) {
+        previousAssetIndex = assetIndex;
+        break;
+      }
+    }
+
+    if (previousAssetIndex == 0)
+      continue;
+
+    struct hha_asset *previousAsset = assets + previousAssetIndex;
+    if (previousAsset->codec != HHA_CODEC_NONE && previousAsset->codec != HHA_CODEC_LZ)
+      continue;
+
+    struct asset_data *assetData = &job->data;
+    AssetDataReserve(assetData, previousAsset->dataSize);
+    readBytes = pread64(fd, assetData->memory, previousAsset->dataSize, (s64)previousAsset->dataOffset);
+    if (readBytes != (s64)previousAsset->dataSize ||
+        Crc32c(assetData->memory, previousAsset->dataSize) != previousAsset->dataChecksum)
+      continue;
+    assetData->size = previousAsset->dataSize;
+
+    struct hha_asset *dest = context->assets + job->assetIndex;
+    dest->codec = previousAsset->codec;
+    dest->dataSize = previousAsset->dataSize;
+    dest->dataChecksum = previousAsset->dataChecksum;
+
+    switch (context->assetMetadatas[job->assetIndex].type) {
+    case ASSET_METADATA_TYPE_AUDIO:
+      // NOTE: chain is not from source, it is set while adding asset
+      dest->audio.channelCount = previousAsset->audio.channelCount;
+      dest->audio.sampleCount = previousAsset->audio.sampleCount;
+      break;
+    case ASSET_METADATA_TYPE_BITMAP:
+    case ASSET_METADATA_TYPE_FONT_GLYPH:
+    case ASSET_METADATA_TYPE_ATLAS:
+      dest->bitmap = previousAsset->bitmap;
+      break;
+    case ASSET_METADATA_TYPE_FONT:
+      dest->font = previousAsset->font;
+      break;
+    }
+
+    job->isReused = 1;
+    reusedAssetCount++;
+  }
+
+freeMemory:
+  DeallocateMemory(sourceHashes);
+  DeallocateMemory(assets);
+closeFile:
+  close(fd);
+
+  return reusedAssetCount;
+}
+
+/*
+ * Orders data of assets by their first use in trace, so assets used together
+ * are adjacent in file and read ahead together. Bundles are kept together,
+ * at first use of any of their assets. Assets that are not in trace keep
+ * their order after traced ones. Returns count of traced assets.
+ */
+internal u32
+OrderByAssetTrace(struct asset_context *context, u64 *sourceHashes, u32 *writeOrder, u32 writeOrderCount)
+{
+  struct asset_trace *trace = context->trace;
+  u32 tracedAssetCount = 0;
+
+  u64 firstUses[ASSET_COUNT];
+  u64 bundleFirstUses[BUNDLE_COUNT];
+  for (u32 bundleIndex = 0; bundleIndex < context->bundleCount; bundleIndex++)
+    bundleFirstUses[bundleIndex] = U64_MAX;
+
+  for (u32 assetIndex = 1; assetIndex < context->assetCount; assetIndex++) {
+    u64 firstUse = AssetTraceFirstUse(trace, sourceHashes[assetIndex]);
+    firstUses[assetIndex] = firstUse;
+    if (firstUse == U64_MAX)
+      continue;
+
+    tracedAssetCount++;
+    u32 bundleId = context->assetMetadatas[assetIndex].bundleId.value;
+    if (bundleId && bundleFirstUses[bundleId - 1] > firstUse)
+      bundleFirstUses[bundleId - 1] = firstUse;
+  }
+
+  for (u32 assetIndex = 1; assetIndex < context->assetCount; assetIndex++) {
+    u32 bundleId = context->assetMetadatas[assetIndex].bundleId.value;
+    if (bundleId)
+      firstUses[assetIndex] = bundleFirstUses[bundleId - 1];
+  }
+
+  // NOTE: sort is stable, so assets of bundle stay contiguous
+  for (u32 writeIndex = 1; writeIndex < writeOrderCount; writeIndex++) {
+    u32 assetIndex = writeOrder[writeIndex];
+    u32 orderIndex = writeIndex;
+    while (orderIndex > 0 && firstUses[writeOrder[orderIndex - 1]] > firstUses[assetIndex]) {
+      writeOrder[orderIndex] = writeOrder[orderIndex - 1];
+      orderIndex--;
+    }
+    writeOrder[orderIndex] = assetIndex;
+  }
+
+  return tracedAssetCount;
+}
+
+internal void
+PackAssetJob(void *data, u32 workerIndex, u32 jobIndex)
+{
+  struct pack_context *pack = data;
+  struct pack_job *job = pack->jobs + jobIndex;
+  if (job->isReused)
+    return;
+
+  struct asset_context *context = pack->context;
+  job->error = LoadAssetData(context, job->assetIndex, &job->data);
+  if (job->error != HH_ASSET_BUILDER_ERROR_NONE)
+    return;
+
+  CompressAssetData(context->assets + job->assetIndex, &job->data, pack->scratches + workerIndex);
+}
+
+internal void
+WriteAssetJob(void *data, u32 workerIndex, u32 jobIndex)
+{
+  struct pack_context *pack = data;
+  struct pack_job *job = pack->jobs + jobIndex;
+  struct hha_asset *dest = pack->context->assets + job->assetIndex;
+
+  if (dest->dataSize) {
+    s64 writtenBytes = pwrite64(pack->outFd, job->data.memory, dest->dataSize, (s64)dest->dataOffset);
+    assert(writtenBytes == (s64)dest->dataSize);
+  }
+
+  DeallocateMemory(job->data.memory);
+  job->data = (struct asset_data){};
+}
+
+internal enum hh_asset_builder_error
+WriteHHAFile(char *filename, struct asset_context *context)
+{
+  enum hh_asset_builder_error errorCode = HH_ASSET_BUILDER_ERROR_NONE;
+
+  char logBuffer[256];
+  s64 logLength;
+
+  // NOTE(e2dk4r): Pack is written next to previous one and renamed over it
+  // when finished. Previous pack stays readable for reusing its data, and
+  // game never sees a pack that is half written.
+  char tempFilename[256];
+  logLength = snprintf(tempFilename, sizeof(tempFilename), "%s.tmp", filename);
+  assert(logLength > 0 && (u64)logLength < sizeof(tempFilename));
+
+  int outFd = -1;
+  outFd = open(tempFilename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+  if (outFd < 0) {
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot open file\n  filename: %s\n", tempFilename);
+    assert(logLength > 0);
+    fatal(logBuffer, (u64)logLength);
+
+    errorCode = HH_ASSET_BUILDER_ERROR_IO_OPEN;
+    goto exitWithErrorCode;
+  }
+
+  struct hha_header header = {
+      .magic = HHA_MAGIC,
+      .version = HHA_VERSION,
+  };
+
+  // TODO: First tag is null always. Should it be written to file? => count -1
+  header.tagCount = context->tagCount;
+  header.assetCount = context->assetCount;
+  // TODO: sparseness?
+  header.assetTypeCount = ASSET_TYPE_COUNT;
+  header.sectionCount = HHA_SECTION_TYPE_COUNT;
+  header.sectionsOffset = sizeof(header);
+
+  struct hha_section sections[HHA_SECTION_TYPE_COUNT] = {};
+  for (u32 sectionType = 0; sectionType < HHA_SECTION_TYPE_COUNT; sectionType++) {
+    sections[sectionType].type = sectionType;
+  }
+
+  struct hha_section *tagsSection = sections + HHA_SECTION_TYPE_TAGS;
+  tagsSection->offset = ALIGN(header.sectionsOffset + sizeof(sections), HHA_ALIGNMENT);
+  tagsSection->size = header.tagCount * sizeof(*context->tags);
+  tagsSection->checksum = Crc32c(context->tags, tagsSection->size);
+
+  struct hha_section *assetTypesSection = sections + HHA_SECTION_TYPE_ASSET_TYPES;
+  assetTypesSection->offset = ALIGN(tagsSection->offset + tagsSection->size, HHA_ALIGNMENT);
+  assetTypesSection->size = header.assetTypeCount * sizeof(*context->assetTypes);
+  assetTypesSection->checksum = Crc32c(context->assetTypes, assetTypesSection->size);
+
+  // NOTE: assets checksum is calculated after data is written
+  struct hha_section *assetsSection = sections + HHA_SECTION_TYPE_ASSETS;
+  assetsSection->offset = ALIGN(assetTypesSection->offset + assetTypesSection->size, HHA_ALIGNMENT);
+  assetsSection->size = header.assetCount * sizeof(*context->assets);
+
+  // NOTE: data is checked per asset
+  struct hha_section *dataSection = sections + HHA_SECTION_TYPE_DATA;
+  dataSection->offset = ALIGN(assetsSection->offset + assetsSection->size, HHA_ALIGNMENT);
+
+  s64 writtenBytes;
+
+  // 1 - tags
+  struct hha_tag *tags = context->tags;
+  if (header.tagCount) {
+    // TODO: Should first tag be null?
+    writtenBytes = pwrite64(outFd, tags, tagsSection->size, (s64)tagsSection->offset);
+    assert(writtenBytes == (s64)tagsSection->size);
+
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " tags written\n", header.tagCount);
+    assert(logLength > 0);
+    info(logBuffer, (u64)logLength);
+  }
+
+  // 2 - assetTypes
+  struct hha_asset_type *assetTypes = context->assetTypes;
+  writtenBytes = pwrite64(outFd, assetTypes, assetTypesSection->size, (s64)assetTypesSection->offset);
+  assert(writtenBytes == (s64)assetTypesSection->size);
+
+  logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " asset types written\n", header.assetTypeCount);
+  assert(logLength > 0);
+  info(logBuffer, (u64)logLength);
+
+  // 3 - assets
+  // NOTE: data of bundled assets is written first, bundle by bundle, so
+  // every bundle is contiguous in file
+  struct hha_bundle bundles[BUNDLE_COUNT];
+  u32 bundleAssets[ASSET_COUNT];
+  u32 bundleAssetCount = 0;
+  u32 writeOrder[ASSET_COUNT];
+  u32 writeOrderCount = 0;
+  for (u32 bundleIndex = 0; bundleIndex < context->bundleCount; bundleIndex++) {
+    struct hha_bundle *bundle = bundles + bundleIndex;
+    bundle->assetIndexFirst = bundleAssetCount;
+    for (u32 assetIndex = 1; assetIndex < header.assetCount; assetIndex++) {
+      if (context->assetMetadatas[assetIndex].bundleId.value != bundleIndex + 1)
+        continue;
+
+      bundleAssets[bundleAssetCount++] = assetIndex;
+      writeOrder[writeOrderCount++] = assetIndex;
+    }
+    bundle->assetIndexOnePastLast = bundleAssetCount;
+    assert(bundle->assetIndexOnePastLast - bundle->assetIndexFirst <= HHA_BUNDLE_ASSET_COUNT_MAX &&
+           "bundle has too many assets");
+  }
+
+  for (u32 assetIndex = 1; assetIndex < header.assetCount; assetIndex++) {
+    if (context->assetMetadatas[assetIndex].bundleId.value == 0)
+      writeOrder[writeOrderCount++] = assetIndex;
+  }
+  assert(writeOrderCount == header.assetCount - 1);
+
+  struct pack_context *pack = AllocateMemory(sizeof(*pack));
+  struct source_files *sourceFiles = AllocateMemory(sizeof(*sourceFiles));
+  assert(pack && sourceFiles && "cannot allocate memory");
+  pack->context = context;
+  pack->outFd = outFd;
+  pack->jobCount = writeOrderCount;
+  u32 workerCount = WorkerCount();
+
+  for (u32 assetIndex = 1; assetIndex < header.assetCount; assetIndex++)
+    pack->sourceHashes[assetIndex] = AssetSourceHash(sourceFiles, context, assetIndex);
+  DeallocateMemory(sourceFiles);
+
+  if (context->trace) {
+    u32 tracedAssetCount = OrderByAssetTrace(context, pack->sourceHashes, writeOrder, writeOrderCount);
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " assets ordered by trace\n", tracedAssetCount);
+    assert(logLength > 0);
+    info(logBuffer, (u64)logLength);
+  }
+
+  for (u32 writeIndex = 0; writeIndex < writeOrderCount; writeIndex++) {
+    u32 assetIndex = writeOrder[writeIndex];
+    struct asset_metadata *src = context->assetMetadatas + assetIndex;
+    struct hha_asset *dest = context->assets + assetIndex;
+
+    dest->tagIndexFirst = src->tagIndexFirst;
+    dest->tagIndexOnePastLast = src->tagIndexOnePastLast;
+    dest->codec = HHA_CODEC_NONE;
+    dest->dataSize = 0;
+    dest->dataChecksum = 0;
+
+    struct pack_job *job = pack->jobs + writeIndex;
+    job->assetIndex = assetIndex;
+  }
+
+  u32 reusedAssetCount = ReusePreviousPack(filename, pack);
+
+  // NOTE: fonts are loaded once, then their glyphs are rasterized in parallel
+  for (u32 jobIndex = 0; jobIndex < pack->jobCount; jobIndex++) {
+    struct pack_job *job = pack->jobs + jobIndex;
+    struct asset_metadata *fontMetadata = AssetFontMetadata(context, context->assetMetadatas + job->assetIndex);
+    if (job->isReused || !fontMetadata)
+      continue;
+
+    struct font_info *fontInfo = &fontMetadata->fontInfo;
+    if (fontInfo->loadedFont || fontInfo->loadError != HH_ASSET_BUILDER_ERROR_NONE)
+      continue;
+
+    struct load_font_result loadFontResult =
+        LoadFont(fontInfo->fontPath, fontInfo->codepointCount, fontInfo->horizontalAdvances);
+    if (loadFontResult.error != HH_ASSET_BUILDER_ERROR_NONE) {
+      LogAssetError(context, fontMetadata, loadFontResult.error);
+      fontInfo->loadError = loadFontResult.error;
+      continue;
+    }
+
+    fontInfo->loadedFont = loadFontResult.loadedFont;
+  }
+
+  RunJobs(workerCount, PackAssetJob, pack, pack->jobCount);
+
+  // NOTE: start of asset's data is aligned, gap is left as hole which reads as zeros
+  u64 dataOffset = dataSection->offset;
+  u64 totalDataSize = 0;
+  u64 totalWrittenDataSize = 0;
+  u32 compressedAssetCount = 0;
+  for (u32 jobIndex = 0; jobIndex < pack->jobCount; jobIndex++) {
+    struct pack_job *job = pack->jobs + jobIndex;
+    struct asset_metadata *src = context->assetMetadatas + job->assetIndex;
+    struct hha_asset *dest = context->assets + job->assetIndex;
+
+    if (job->error != HH_ASSET_BUILDER_ERROR_NONE) {
+      // NOTE: errors of fonts are reported once while loading them
+      struct asset_metadata *fontMetadata = AssetFontMetadata(context, src);
+      if (!fontMetadata || fontMetadata->fontInfo.loadError == HH_ASSET_BUILDER_ERROR_NONE)
+        LogAssetError(context, src, job->error);
+
+      errorCode = job->error;
+      pack->sourceHashes[job->assetIndex] = 0;
+    }
+
+    dest->dataOffset = ALIGN(dataOffset, HHA_ALIGNMENT);
+    dataOffset = dest->dataOffset + dest->dataSize;
+
+    totalDataSize += AssetDataSize(src, dest);
+    totalWrittenDataSize += dest->dataSize;
+    if (dest->codec != HHA_CODEC_NONE)
+      compressedAssetCount++;
+  }
+  dataSection->size = dataOffset - dataSection->offset;
+
+  RunJobs(workerCount, WriteAssetJob, pack, pack->jobCount);
+
+  for (u32 assetIndex = 1; assetIndex < header.assetCount; assetIndex++) {
+    struct asset_metadata *metadata = context->assetMetadatas + assetIndex;
+    if (metadata->type != ASSET_METADATA_TYPE_FONT)
+      continue;
+
+    struct font_info *fontInfo = &metadata->fontInfo;
+    if (fontInfo->loadedFont)
+      FreeFont(fontInfo->loadedFont);
+    fontInfo->loadedFont = 0;
+
+    DeallocateMemory(fontInfo->horizontalAdvances);
+  }
+
+  for (u32 workerIndex = 0; workerIndex < ARRAY_COUNT(pack->scratches); workerIndex++) {
+    DeallocateMemory(pack->scratches[workerIndex].memory);
+  }
+
+  u64 sectionsEnd = dataSection->offset + dataSection->size;
+
+  // 4 - bundles
+  if (context->bundleCount) {
+    struct hha_section *bundlesSection = sections + HHA_SECTION_TYPE_BUNDLES;
+    bundlesSection->offset = ALIGN(sectionsEnd, HHA_ALIGNMENT);
+    bundlesSection->size = context->bundleCount * sizeof(*bundles);
+    bundlesSection->checksum = Crc32c(bundles, bundlesSection->size);
+
+    struct hha_section *bundleAssetsSection = sections + HHA_SECTION_TYPE_BUNDLE_ASSETS;
+    bundleAssetsSection->offset = ALIGN(bundlesSection->offset + bundlesSection->size, HHA_ALIGNMENT);
+    bundleAssetsSection->size = bundleAssetCount * sizeof(*bundleAssets);
+    bundleAssetsSection->checksum = Crc32c(bundleAssets, bundleAssetsSection->size);
+    sectionsEnd = bundleAssetsSection->offset + bundleAssetsSection->size;
+
+    writtenBytes = pwrite64(outFd, bundles, bundlesSection->size, (s64)bundlesSection->offset);
+    assert(writtenBytes == (s64)bundlesSection->size);
+
+    writtenBytes = pwrite64(outFd, bundleAssets, bundleAssetsSection->size, (s64)bundleAssetsSection->offset);
+    assert(writtenBytes == (s64)bundleAssetsSection->size);
+
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " bundles written\n", context->bundleCount);
+    assert(logLength > 0);
+    info(logBuffer, (u64)logLength);
+  }
+
+  // 5 - source hashes
+  struct hha_section *sourceHashesSection = sections + HHA_SECTION_TYPE_SOURCE_HASHES;
+  sourceHashesSection->offset = ALIGN(sectionsEnd, HHA_ALIGNMENT);
+  sourceHashesSection->size = header.assetCount * sizeof(*pack->sourceHashes);
+  sourceHashesSection->checksum = Crc32c(pack->sourceHashes, sourceHashesSection->size);
+
+  writtenBytes = pwrite64(outFd, pack->sourceHashes, sourceHashesSection->size, (s64)sourceHashesSection->offset);
+  assert(writtenBytes == (s64)sourceHashesSection->size);
+
+  DeallocateMemory(pack);
+  pack = 0;
+
+  struct hha_asset *assets = context->assets;
+  assetsSection->checksum = Crc32c(assets, assetsSection->size);
+  writtenBytes = pwrite64(outFd, assets, assetsSection->size, (s64)assetsSection->offset);
+  assert(writtenBytes == (s64)assetsSection->size);
+
+  // 6 - header and sections
+  writtenBytes = pwrite64(outFd, &header, sizeof(header), 0);
+  assert(writtenBytes == sizeof(header));
+
+  writtenBytes = pwrite64(outFd, sections, sizeof(sections), (s64)header.sectionsOffset);
+  assert(writtenBytes == sizeof(sections));
+
+  logLength = snprintf(logBuffer, sizeof(logBuffer), "%" PRIu32 " assets written, %" PRIu32 " reused from '%s'\n",
+                       header.assetCount, reusedAssetCount, filename);
+  assert(logLength > 0);
+  info(logBuffer, (u64)logLength);
+
+  logLength = snprintf(logBuffer, sizeof(logBuffer),
+                       "%" PRIu32 " assets compressed, %" PRIu64 " bytes of data written as %" PRIu64 " bytes\n",
+                       compressedAssetCount, totalDataSize, totalWrittenDataSize);
+  assert(logLength > 0);
+  info(logBuffer, (u64)logLength);
+
+  // Packing finished
+  s32 fsyncResult = fsync(outFd);
+  if (fsyncResult != 0) {
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot sync data\n");
+    assert(logLength > 0);
+    warn(logBuffer, (u64)logLength);
+  }
+
+  s32 closeResult = close(outFd);
+  if (closeResult != 0) {
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot close the file.\n  filename: '%s'\n", tempFilename);
+    assert(logLength > 0);
+    warn(logBuffer, (u64)logLength);
+  }
+  outFd = -1;
+
+  if (errorCode == HH_ASSET_BUILDER_ERROR_NONE && rename(tempFilename, filename) != 0) {
+    logLength = snprintf(logBuffer, sizeof(logBuffer), "cannot rename file\n  from: '%s'\n  to: '%s'\n", tempFilename,
+                         filename);
+    assert(logLength > 0);
+    error(logBuffer, (u64)logLength);
+
+    errorCode = HH_ASSET_BUILDER_ERROR_IO_RENAME;
   }
-  outFd = -1;
 
   if (errorCode != HH_ASSET_BUILDER_ERROR_NONE) {
+    unlink(tempFilename);
+
     logLength = snprintf(logBuffer, sizeof(logBuffer), "Assets could NOT be packed into '%s'!\n", filename);
     assert(logLength > 0);
     fatal(logBuffer, (u64)logLength);
@@ -1644,12 +3078,13 @@ exitWithErrorCode:
 }
 
 internal enum hh_asset_builder_error
-WriteAll(char *outFilename)
+WriteAll(char *outFilename, struct asset_trace *trace)
 {
   /*----------------------------------------------------------------
    * INGEST
    *----------------------------------------------------------------*/
   struct asset_context *context = &(struct asset_context){};
+  context->trace = trace;
 
   context->tagCount = 0;
   context->assetCount = 1;
@@ -1666,22 +3101,36 @@ WriteAll(char *outFilename)
   AddBitmapAsset(context, "test2/rock03.bmp", 0.5f, 0.65625f);
   EndAssetType(context);
 
+  // NOTE: stamps are small and drawn together into ground chunks
+  BeginAssetType(context, ASSET_TYPE_ATLAS);
+  struct bitmap_id stampAtlas = AddAtlasAsset(context);
+  EndAssetType(context);
+
   BeginAssetType(context, ASSET_TYPE_GRASS);
   AddBitmapAsset(context, "test2/grass00.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/grass01.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   EndAssetType(context);
 
   BeginAssetType(context, ASSET_TYPE_GROUND);
   AddBitmapAsset(context, "test2/ground00.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/ground01.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/ground02.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/ground03.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   EndAssetType(context);
 
   BeginAssetType(context, ASSET_TYPE_TUFT);
   AddBitmapAsset(context, "test2/tuft00.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/tuft01.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/tuft02.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   EndAssetType(context);
 
   f32 angleRight = 0.00f * TAU32;
@@ -1689,19 +3138,29 @@ WriteAll(char *outFilename)
   f32 angleLeft = 0.50f * TAU32;
   f32 angleFront = 0.75f * TAU32;
 
+  // NOTE: parts of hero facing same direction are drawn together
+  struct bundle_id bundleRight = AddBundle(context);
+  struct bundle_id bundleBack = AddBundle(context);
+  struct bundle_id bundleLeft = AddBundle(context);
+  struct bundle_id bundleFront = AddBundle(context);
+
   BeginAssetType(context, ASSET_TYPE_HEAD);
 
   AddBitmapAsset(context, "test/test_hero_right_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleRight);
+  AddAssetToBundle(context, bundleRight);
 
   AddBitmapAsset(context, "test/test_hero_back_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleBack);
+  AddAssetToBundle(context, bundleBack);
 
   AddBitmapAsset(context, "test/test_hero_left_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleLeft);
+  AddAssetToBundle(context, bundleLeft);
 
   AddBitmapAsset(context, "test/test_hero_front_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleFront);
+  AddAssetToBundle(context, bundleFront);
 
   EndAssetType(context);
 
@@ -1709,15 +3168,19 @@ WriteAll(char *outFilename)
 
   AddBitmapAsset(context, "test/test_hero_right_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleRight);
+  AddAssetToBundle(context, bundleRight);
 
   AddBitmapAsset(context, "test/test_hero_back_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleBack);
+  AddAssetToBundle(context, bundleBack);
 
   AddBitmapAsset(context, "test/test_hero_left_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleLeft);
+  AddAssetToBundle(context, bundleLeft);
 
   AddBitmapAsset(context, "test/test_hero_front_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleFront);
+  AddAssetToBundle(context, bundleFront);
 
   EndAssetType(context);
 
@@ -1725,15 +3188,19 @@ WriteAll(char *outFilename)
 
   AddBitmapAsset(context, "test/test_hero_right_cape.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleRight);
+  AddAssetToBundle(context, bundleRight);
 
   AddBitmapAsset(context, "test/test_hero_back_cape.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleBack);
+  AddAssetToBundle(context, bundleBack);
 
   AddBitmapAsset(context, "test/test_hero_left_cape.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleLeft);
+  AddAssetToBundle(context, bundleLeft);
 
   AddBitmapAsset(context, "test/test_hero_front_cape.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleFront);
+  AddAssetToBundle(context, bundleFront);
 
   EndAssetType(context);
 
@@ -1790,9 +3257,10 @@ WriteAll(char *outFilename)
 }
 
 internal enum hh_asset_builder_error
-WriteOnlyHero1(void)
+WriteOnlyHero1(struct asset_trace *trace)
 {
   struct asset_context *context = &(struct asset_context){};
+  context->trace = trace;
 
   context->tagCount = 0;
   context->assetCount = 1;
@@ -1806,38 +3274,54 @@ WriteOnlyHero1(void)
   f32 angleLeft = 0.50f * TAU32;
   f32 angleFront = 0.75f * TAU32;
 
+  // NOTE: parts of hero facing same direction are drawn together
+  struct bundle_id bundleRight = AddBundle(context);
+  struct bundle_id bundleBack = AddBundle(context);
+  struct bundle_id bundleLeft = AddBundle(context);
+  struct bundle_id bundleFront = AddBundle(context);
+
   BeginAssetType(context, ASSET_TYPE_HEAD);
 
   AddBitmapAsset(context, "test/test_hero_right_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleRight);
+  AddAssetToBundle(context, bundleRight);
 
   AddBitmapAsset(context, "test/test_hero_back_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleBack);
+  AddAssetToBundle(context, bundleBack);
 
   AddBitmapAsset(context, "test/test_hero_left_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleLeft);
+  AddAssetToBundle(context, bundleLeft);
 
   AddBitmapAsset(context, "test/test_hero_front_head.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleFront);
+  AddAssetToBundle(context, bundleFront);
 
   EndAssetType(context);
 
   BeginAssetType(context, ASSET_TYPE_TORSO);
   AddBitmapAsset(context, "test/test_hero_right_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleRight);
+  AddAssetToBundle(context, bundleRight);
   AddBitmapAsset(context, "test/test_hero_back_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleBack);
+  AddAssetToBundle(context, bundleBack);
   AddBitmapAsset(context, "test/test_hero_left_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleLeft);
+  AddAssetToBundle(context, bundleLeft);
   AddBitmapAsset(context, "test/test_hero_front_torso.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleFront);
+  AddAssetToBundle(context, bundleFront);
   EndAssetType(context);
 
   BeginAssetType(context, ASSET_TYPE_CAPE);
   AddBitmapAsset(context, "test/test_hero_right_cape.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleRight);
+  AddAssetToBundle(context, bundleRight);
   AddBitmapAsset(context, "test/test_hero_back_cape.bmp", 0.5f, 0.156682029f);
   AddAssetTag(context, ASSET_TAG_FACING_DIRECTION, angleBack);
+  AddAssetToBundle(context, bundleBack);
   EndAssetType(context);
 
   /*----------------------------------------------------------------
@@ -1849,9 +3333,10 @@ WriteOnlyHero1(void)
 }
 
 internal enum hh_asset_builder_error
-WriteOnlyHero2(void)
+WriteOnlyHero2(struct asset_trace *trace)
 {
   struct asset_context *context = &(struct asset_context){};
+  context->trace = trace;
 
   context->tagCount = 0;
   context->assetCount = 1;
@@ -1880,12 +3365,13 @@ WriteOnlyHero2(void)
 }
 
 internal enum hh_asset_builder_error
-WriteNoneHero(void)
+WriteNoneHero(struct asset_trace *trace)
 {
   /*----------------------------------------------------------------
    * INGEST
    *----------------------------------------------------------------*/
   struct asset_context *context = &(struct asset_context){};
+  context->trace = trace;
 
   context->tagCount = 0;
   context->assetCount = 1;
@@ -1898,22 +3384,36 @@ WriteNoneHero(void)
   AddBitmapAsset(context, "test2/rock03.bmp", 0.5f, 0.65625f);
   EndAssetType(context);
 
+  // NOTE: stamps are small and drawn together into ground chunks
+  BeginAssetType(context, ASSET_TYPE_ATLAS);
+  struct bitmap_id stampAtlas = AddAtlasAsset(context);
+  EndAssetType(context);
+
   BeginAssetType(context, ASSET_TYPE_GRASS);
   AddBitmapAsset(context, "test2/grass00.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/grass01.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   EndAssetType(context);
 
   BeginAssetType(context, ASSET_TYPE_GROUND);
   AddBitmapAsset(context, "test2/ground00.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/ground01.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/ground02.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/ground03.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   EndAssetType(context);
 
   BeginAssetType(context, ASSET_TYPE_TUFT);
   AddBitmapAsset(context, "test2/tuft00.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/tuft01.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   AddBitmapAsset(context, "test2/tuft02.bmp", 0.5f, 0.5f);
+  AddAssetToAtlas(context, stampAtlas);
   EndAssetType(context);
 
   /*----------------------------------------------------------------
@@ -1925,12 +3425,13 @@ WriteNoneHero(void)
 }
 
 internal enum hh_asset_builder_error
-WriteAudios(void)
+WriteAudios(struct asset_trace *trace)
 {
   /*----------------------------------------------------------------
    * INGEST
    *----------------------------------------------------------------*/
   struct asset_context *context = &(struct asset_context){};
+  context->trace = trace;
 
   context->tagCount = 0;
   context->assetCount = 1;
@@ -1989,12 +3490,13 @@ WriteAudios(void)
 }
 
 internal enum hh_asset_builder_error
-WriteFonts(void)
+WriteFonts(struct asset_trace *trace)
 {
   /*----------------------------------------------------------------
    * INGEST
    *----------------------------------------------------------------*/
   struct asset_context *context = &(struct asset_context){};
+  context->trace = trace;
 
   context->tagCount = 0;
   context->assetCount = 1;
@@ -2002,14 +3504,19 @@ WriteFonts(void)
   // fonts
   BeginAssetType(context, ASSET_TYPE_FONT);
   char *fontPath = "/usr/share/fonts/liberation-fonts/LiberationSerif-Regular.ttf";
-  struct font_id fontId = AddFontAsset(context, fontPath, ('~' + 1));
+  struct font_id fontId = AddFontAsset(context, fontPath, '!', ('~' + 1));
+  // NOTE: glyphs are drawn at many sizes, signed distances stay sharp when scaled
+  SetFontAtlasSDF(context, fontId, 4, 4);
   EndAssetType(context);
 
+  /* NOTE: Text is drawn from atlas of font. Glyphs are also standalone
+   * bitmaps, because particles pick them by codepoint tag and draw them like
+   * any other bitmap.
+   */
   BeginAssetType(context, ASSET_TYPE_FONT_GLYPH);
-  struct font_info *fontInfo = &(context->assetMetadatas + fontId.value)->fontInfo;
   for (u32 codepoint = '!'; codepoint <= '~'; codepoint++) {
-    struct bitmap_id bitmapId = AddFontGlyphAsset(context, fontId, codepoint);
-    fontInfo->codepoints[codepoint] = bitmapId;
+    AddFontGlyphAsset(context, fontId, codepoint);
+    AddAssetTag(context, ASSET_TAG_UNICODE_CODEPOINT, (f32)codepoint);
   }
   EndAssetType(context);
 
@@ -2036,6 +3543,13 @@ main(int argc, char *argv[])
   argv++;
 
   // parse arguments
+  char *tracePath = 0;
+  if (argc >= 2 && __builtin_strcmp(argv[0], "--trace") == 0) {
+    tracePath = argv[1];
+    argc -= 2;
+    argv += 2;
+  }
+
   if (argc >= 2) {
     usage();
     errorCode = HH_ASSET_BUILDER_ERROR_ARGUMENTS;
@@ -2046,28 +3560,45 @@ main(int argc, char *argv[])
   if (argc == 1)
     outFilename = argv[1];
 
-  // errorCode = (s32)WriteAll(outFilename);
+  struct asset_trace *trace = 0;
+  struct asset_trace loadedTrace = {};
+  if (tracePath) {
+    errorCode = (s32)LoadAssetTrace(tracePath, &loadedTrace);
+    if (errorCode != HH_ASSET_BUILDER_ERROR_NONE) {
+      char logBuffer[256];
+      s64 logLength =
+          snprintf(logBuffer, sizeof(logBuffer), "cannot load asset trace.\n  filename: %s\n", tracePath);
+      assert(logLength > 0);
+      fatal(logBuffer, (u64)logLength);
+      goto end;
+    }
+    trace = &loadedTrace;
+  }
 
-  errorCode = (s32)WriteOnlyHero1();
+  // errorCode = (s32)WriteAll(outFilename, trace);
+
+  errorCode = (s32)WriteOnlyHero1(trace);
   if (errorCode != HH_ASSET_BUILDER_ERROR_NONE)
-    goto end;
+    goto freeTrace;
 
-  errorCode = (s32)WriteOnlyHero2();
+  errorCode = (s32)WriteOnlyHero2(trace);
   if (errorCode != HH_ASSET_BUILDER_ERROR_NONE)
-    goto end;
+    goto freeTrace;
 
-  errorCode = (s32)WriteNoneHero();
+  errorCode = (s32)WriteNoneHero(trace);
   if (errorCode != HH_ASSET_BUILDER_ERROR_NONE)
-    goto end;
+    goto freeTrace;
 
-  errorCode = (s32)WriteAudios();
+  errorCode = (s32)WriteAudios(trace);
   if (errorCode != HH_ASSET_BUILDER_ERROR_NONE)
-    goto end;
+    goto freeTrace;
 
-  errorCode = (s32)WriteFonts();
+  errorCode = (s32)WriteFonts(trace);
   if (errorCode != HH_ASSET_BUILDER_ERROR_NONE)
-    goto end;
+    goto freeTrace;
 
+freeTrace:
+  DeallocateMemory(loadedTrace.slots);
 end:
   return errorCode;
 }
@@ -0,0 +1,1116 @@
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include <handmadehero/asset.h>
+#include <handmadehero/atomic.h>
+#include <handmadehero/audio.h>
+#include <handmadehero/checksum.h>
+#include <handmadehero/handmadehero.h>
+#include <handmadehero/memory_arena.h>
+#include <handmadehero/platform.h>
+#include <handmadehero/text.h>
+
+/*
+ * Renders audio mixer offline, without sound server. Loads asset packs in
+ * working directory like game does, replays script of audio commands and
+ * mixes fixed size buffers into a WAV file. Reports cycles mixer spent per
+ * output sample and checksum of output, which can be compared against a
+ * golden file.
+ *
+ * Everything runs on one thread, work queued by game code is done right
+ * away, so same packs and script always give same output.
+ *
+ * Script has one command per line, run before mixing buffer at frame:
+ *
+ *   # comment
+ *   <frame> play <slot> <type> <index>
+ *   <frame> stream <slot> <type> <index>
+ *   <frame> volume <slot> <fadeSeconds> <left> <right>
+ *   <frame> pitch <slot> <dSample>
+ *   <frame> bus <slot> <bus>
+ *   <frame> resampler nearest|linear|sinc
+ *   <frame> busvolume <bus> <fadeSeconds> <left> <right>
+ *   <frame> filter <bus> none|lowpass|highpass <frequency> <q>
+ *   <frame> reverb <bus> <wet> <roomSize>
+ *   <frame> limiter <bus> <threshold>
+ *   <frame> end
+ *
+ * Type is one of bloop, crack, drop, glide, music, puhp; index is audio
+ * inside type. Bus is one of master, music, sound, interface. Slot names
+ * playing audio for later commands. Frames must not decrease, and rendering
+ * stops at end.
+ *
+ * Packs of game need art that is not in repository. Tool can write a pack
+ * of generated audios instead, see WriteSyntheticPack(), so mixer can be
+ * checked anywhere the tool builds.
+ */
+
+#define NEWLINE "\n"
+
+internal void
+usage(void)
+{
+  fprintf(stderr, "hh_audio_render [--buffer <sampleCount>] [--golden <path> [--update-golden]] <script> [output.wav]" NEWLINE
+                  "hh_audio_render --synthetic-pack <output.hha>" NEWLINE
+                  NEWLINE
+                  "  --buffer          samples mixed at once, multiple of 8, default 800" NEWLINE
+                  "  --golden          compares checksum with file, fails when it is missing" NEWLINE
+                  "  --update-golden   writes checksum to golden file instead" NEWLINE
+                  "  --synthetic-pack  writes pack of generated audios and exits" NEWLINE);
+}
+
+enum hh_audio_render_error {
+  HH_AUDIO_RENDER_ERROR_NONE = 0,
+  HH_AUDIO_RENDER_ERROR_ARGUMENTS,
+  HH_AUDIO_RENDER_ERROR_IO_OPEN,
+  HH_AUDIO_RENDER_ERROR_IO_READ,
+  HH_AUDIO_RENDER_ERROR_IO_WRITE,
+  HH_AUDIO_RENDER_ERROR_MALLOC,
+  HH_AUDIO_RENDER_ERROR_SCRIPT_MALFORMED,
+  HH_AUDIO_RENDER_ERROR_SCRIPT_TOO_LONG,
+  HH_AUDIO_RENDER_ERROR_NO_ASSET_FILES,
+  HH_AUDIO_RENDER_ERROR_AUDIO_NOT_FOUND,
+  HH_AUDIO_RENDER_ERROR_GOLDEN_MISMATCH,
+  HH_AUDIO_RENDER_ERROR_GOLDEN_MISSING,
+};
+
+comptime u32 SAMPLE_RATE = 48000;
+comptime u32 SAMPLE_CHANNELS = 2;
+
+/*****************************************************************
+ * PLATFORM
+ *****************************************************************/
+
+struct render_file_handle {
+  s32 fd;
+  // NOTE(e2dk4r): kept for opening file again when it is replaced
+  char path[256];
+};
+
+struct render_file_group {
+  struct dirent **entries;
+  s32 entryCount;
+  s32 entryIndex;
+};
+
+internal void
+RenderWorkQueueAddEntry(struct platform_work_queue *queue, pfnPlatformWorkQueueCallback callback, void *data)
+{
+  callback(queue, data);
+}
+
+internal void
+RenderWorkQueueCompleteAllWork(struct platform_work_queue *queue)
+{
+  // NOTE(e2dk4r): work is done when added
+}
+
+internal struct platform_file_handle
+RenderOpenFile(char *path)
+{
+  struct platform_file_handle platformFileHandle = {};
+
+  struct render_file_handle *fileHandle = malloc(sizeof(*fileHandle));
+  if (!fileHandle) {
+    platformFileHandle.error = HANDMADEHERO_ERROR_OPEN_FILE;
+    return platformFileHandle;
+  }
+  snprintf(fileHandle->path, sizeof(fileHandle->path), "%s", path);
+
+  fileHandle->fd = open(path, O_RDONLY);
+  if (fileHandle->fd < 0)
+    platformFileHandle.error = HANDMADEHERO_ERROR_OPEN_FILE;
+
+  platformFileHandle.data = fileHandle;
+  return platformFileHandle;
+}
+
+internal s32
+IsAssetFile(const struct dirent *dirent)
+{
+  struct string filename = StringFromZeroTerminated((u8 *)dirent->d_name, 255);
+  struct string extension = StringFromZeroTerminated((u8 *)"hha", 255);
+  return dirent->d_type == DT_REG && PathHasExtension(filename, extension);
+}
+
+internal struct platform_file_group
+RenderGetAllFilesOfTypeBegin(enum platform_file_type type)
+{
+  struct platform_file_group platformFileGroup = {};
+  if (type != PLATFORM_FILE_TYPE_ASSET_FILE)
+    return platformFileGroup;
+
+  struct render_file_group *fileGroup = calloc(1, sizeof(*fileGroup));
+  if (!fileGroup)
+    return platformFileGroup;
+
+  // NOTE(e2dk4r): sorted, so asset ids do not depend on directory order
+  fileGroup->entryCount = scandir(".", &fileGroup->entries, IsAssetFile, alphasort);
+  if (fileGroup->entryCount < 0)
+    fileGroup->entryCount = 0;
+
+  platformFileGroup.fileCount = (u32)fileGroup->entryCount;
+  platformFileGroup.data = fileGroup;
+  return platformFileGroup;
+}
+
+internal void
+RenderGetAllFilesOfTypeEnd(struct platform_file_group *platformFileGroup)
+{
+  struct render_file_group *fileGroup = platformFileGroup->data;
+  if (!fileGroup)
+    return;
+
+  for (s32 entryIndex = 0; entryIndex < fileGroup->entryCount; entryIndex++)
+    free(fileGroup->entries[entryIndex]);
+  free(fileGroup->entries);
+  free(fileGroup);
+  platformFileGroup->data = 0;
+}
+
+internal struct platform_file_handle
+RenderOpenNextFile(struct platform_file_group *platformFileGroup)
+{
+  struct render_file_group *fileGroup = platformFileGroup->data;
+  assert(fileGroup->entryIndex < fileGroup->entryCount);
+  return RenderOpenFile(fileGroup->entries[fileGroup->entryIndex++]->d_name);
+}
+
+internal struct platform_file_handle
+RenderReopenFile(struct platform_file_handle *platformFileHandle)
+{
+  struct render_file_handle *fileHandle = platformFileHandle->data;
+  return RenderOpenFile(fileHandle->path);
+}
+
+internal b32
+RenderIsSameFile(struct platform_file_handle *platformFileHandle, struct platform_file_handle *otherPlatformFileHandle)
+{
+  struct render_file_handle *fileHandle = platformFileHandle->data;
+  struct render_file_handle *otherFileHandle = otherPlatformFileHandle->data;
+  if (!fileHandle || !otherFileHandle)
+    return 0;
+
+  return strcmp(fileHandle->path, otherFileHandle->path) == 0;
+}
+
+internal void
+RenderCloseFile(struct platform_file_handle *platformFileHandle)
+{
+  struct render_file_handle *fileHandle = platformFileHandle->data;
+  if (!fileHandle)
+    return;
+
+  if (fileHandle->fd >= 0)
+    close(fileHandle->fd);
+  free(fileHandle);
+  platformFileHandle->data = 0;
+}
+
+internal void
+RenderReadFromFile(void *dest, struct platform_file_handle *platformFileHandle, u64 offset, u64 size)
+{
+  struct render_file_handle *fileHandle = platformFileHandle->data;
+
+  u8 *destination = dest;
+  while (size) {
+    ssize_t bytesRead = pread(fileHandle->fd, destination, size, (off_t)offset);
+    if (bytesRead < 0 && errno == EINTR)
+      continue;
+
+    if (bytesRead <= 0) {
+      platformFileHandle->error = HANDMADEHERO_ERROR_READ_FROM_FILE;
+      return;
+    }
+
+    destination += bytesRead;
+    offset += (u64)bytesRead;
+    size -= (u64)bytesRead;
+  }
+}
+
+internal b32
+RenderHasFileError(struct platform_file_handle *platformFileHandle)
+{
+  return platformFileHandle->error != HANDMADEHERO_ERROR_NONE;
+}
+
+internal void
+RenderFileError(struct platform_file_handle *platformFileHandle, enum handmadehero_error error)
+{
+  platformFileHandle->error = error;
+}
+
+internal void *
+RenderAllocateMemory(memory_arena_size_t size)
+{
+  return calloc(1, (size_t)size);
+}
+
+internal void
+RenderDeallocateMemory(void *memory)
+{
+  free(memory);
+}
+
+/*****************************************************************
+ * SCRIPT
+ *****************************************************************/
+
+enum render_command_type {
+  RENDER_COMMAND_TYPE_PLAY,
+  RENDER_COMMAND_TYPE_STREAM,
+  RENDER_COMMAND_TYPE_VOLUME,
+  RENDER_COMMAND_TYPE_PITCH,
+  RENDER_COMMAND_TYPE_BUS,
+  RENDER_COMMAND_TYPE_RESAMPLER,
+  RENDER_COMMAND_TYPE_BUS_VOLUME,
+  RENDER_COMMAND_TYPE_BUS_FILTER,
+  RENDER_COMMAND_TYPE_BUS_REVERB,
+  RENDER_COMMAND_TYPE_BUS_LIMITER,
+  RENDER_COMMAND_TYPE_END,
+};
+
+struct render_command {
+  u32 frame;
+  enum render_command_type type;
+  u32 slot;
+  union {
+    // play, stream
+    struct {
+      enum asset_type_id typeId;
+      u32 index;
+    };
+    // volume
+    struct {
+      f32 fadeDurationInSeconds;
+      struct v2 volume;
+    };
+    // pitch
+    f32 dSample;
+    // resampler
+    enum audio_resampler resampler;
+    // bus, busvolume, filter, reverb, limiter
+    struct {
+      enum audio_bus_id busId;
+      union {
+        // busvolume
+        struct {
+          f32 busFadeDurationInSeconds;
+          struct v2 busVolume;
+        };
+        // filter
+        struct {
+          enum biquad_type filterType;
+          f32 filterFrequency;
+          f32 filterQ;
+        };
+        // reverb
+        struct {
+          f32 reverbWet;
+          f32 reverbRoomSize;
+        };
+        // limiter
+        f32 limiterThreshold;
+      };
+    };
+  };
+};
+
+#define RENDER_COMMAND_COUNT_MAX 4096
+#define RENDER_SLOT_COUNT 256
+
+struct render_script {
+  u32 commandCount;
+  struct render_command commands[RENDER_COMMAND_COUNT_MAX];
+  // number of frames to render, frame of end command
+  u32 frameCount;
+};
+
+struct render_name {
+  char *name;
+  u32 value;
+};
+
+comptime struct render_name AudioTypeNames[] = {
+    {"bloop", ASSET_TYPE_BLOOP}, {"crack", ASSET_TYPE_CRACK}, {"drop", ASSET_TYPE_DROP},
+    {"glide", ASSET_TYPE_GLIDE}, {"music", ASSET_TYPE_MUSIC}, {"puhp", ASSET_TYPE_PUHP},
+};
+
+comptime struct render_name BusNames[] = {
+    {"master", AUDIO_BUS_MASTER},
+    {"music", AUDIO_BUS_MUSIC},
+    {"sound", AUDIO_BUS_SOUND},
+    {"interface", AUDIO_BUS_INTERFACE},
+};
+
+comptime struct render_name ResamplerNames[] = {
+    {"nearest", AUDIO_RESAMPLER_NEAREST},
+    {"linear", AUDIO_RESAMPLER_LINEAR},
+    {"sinc", AUDIO_RESAMPLER_SINC},
+};
+
+comptime struct render_name FilterNames[] = {
+    {"none", BIQUAD_TYPE_NONE},
+    {"lowpass", BIQUAD_TYPE_LOWPASS},
+    {"highpass", BIQUAD_TYPE_HIGHPASS},
+};
+
+internal b32
+FindName(const struct render_name *names, u32 nameCount, char *name, u32 *value)
+{
+  for (u32 nameIndex = 0; nameIndex < nameCount; nameIndex++) {
+    if (__builtin_strcmp(names[nameIndex].name, name) == 0) {
+      *value = names[nameIndex].value;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// parses one line of script into command, returns 0 when line is malformed
+internal b32
+ParseCommand(char *line, struct render_command *command)
+{
+  char name[16];
+  char argument[16];
+  s32 length = 0;
+  if (sscanf(line, "%u %15s %n", &command->frame, name, &length) != 2)
+    return 0;
+  char *arguments = line + length;
+
+  u32 value;
+  if (__builtin_strcmp(name, "play") == 0 || __builtin_strcmp(name, "stream") == 0) {
+    command->type = name[0] == 'p' ? RENDER_COMMAND_TYPE_PLAY : RENDER_COMMAND_TYPE_STREAM;
+    if (sscanf(arguments, "%u %15s %u", &command->slot, argument, &command->index) != 3)
+      return 0;
+    if (!FindName(AudioTypeNames, ARRAY_COUNT(AudioTypeNames), argument, &value))
+      return 0;
+    command->typeId = (enum asset_type_id)value;
+  } else if (__builtin_strcmp(name, "volume") == 0) {
+    command->type = RENDER_COMMAND_TYPE_VOLUME;
+    if (sscanf(arguments, "%u %f %f %f", &command->slot, &command->fadeDurationInSeconds, &command->volume.x,
+               &command->volume.y) != 4)
+      return 0;
+  } else if (__builtin_strcmp(name, "pitch") == 0) {
+    command->type = RENDER_COMMAND_TYPE_PITCH;
+    if (sscanf(arguments, "%u %f", &command->slot, &command->dSample) != 2)
+      return 0;
+  } else if (__builtin_strcmp(name, "bus") == 0) {
+    command->type = RENDER_COMMAND_TYPE_BUS;
+    if (sscanf(arguments, "%u %15s", &command->slot, argument) != 2)
+      return 0;
+    if (!FindName(BusNames, ARRAY_COUNT(BusNames), argument, &value))
+      return 0;
+    command->busId = (enum audio_bus_id)value;
+  } else if (__builtin_strcmp(name, "resampler") == 0) {
+    command->type = RENDER_COMMAND_TYPE_RESAMPLER;
+    if (sscanf(arguments, "%15s", argument) != 1)
+      return 0;
+    if (!FindName(ResamplerNames, ARRAY_COUNT(ResamplerNames), argument, &value))
+      return 0;
+    command->resampler = (enum audio_resampler)value;
+  } else if (__builtin_strcmp(name, "busvolume") == 0 || __builtin_strcmp(name, "filter") == 0 ||
+             __builtin_strcmp(name, "reverb") == 0 || __builtin_strcmp(name, "limiter") == 0) {
+    if (sscanf(arguments, "%15s %n", argument, &length) != 1)
+      return 0;
+    if (!FindName(BusNames, ARRAY_COUNT(BusNames), argument, &value))
+      return 0;
+    command->busId = (enum audio_bus_id)value;
+    arguments += length;
+
+    if (name[0] == 'b') {
+      command->type = RENDER_COMMAND_TYPE_BUS_VOLUME;
+      if (sscanf(arguments, "%f %f %f", &command->busFadeDurationInSeconds, &command->busVolume.x,
+                 &command->busVolume.y) != 3)
+        return 0;
+    } else if (name[0] == 'f') {
+      command->type = RENDER_COMMAND_TYPE_BUS_FILTER;
+      if (sscanf(arguments, "%15s %f %f", argument, &command->filterFrequency, &command->filterQ) != 3)
+        return 0;
+      if (!FindName(FilterNames, ARRAY_COUNT(FilterNames), argument, &value))
+        return 0;
+      command->filterType = (enum biquad_type)value;
+      if (command->filterType != BIQUAD_TYPE_NONE && (command->filterFrequency <= 0.0f || command->filterQ <= 0.0f))
+        return 0;
+    } else if (name[0] == 'r') {
+      command->type = RENDER_COMMAND_TYPE_BUS_REVERB;
+      if (sscanf(arguments, "%f %f", &command->reverbWet, &command->reverbRoomSize) != 2)
+        return 0;
+    } else {
+      command->type = RENDER_COMMAND_TYPE_BUS_LIMITER;
+      if (sscanf(arguments, "%f", &command->limiterThreshold) != 1)
+        return 0;
+    }
+  } else if (__builtin_strcmp(name, "end") == 0) {
+    command->type = RENDER_COMMAND_TYPE_END;
+  } else {
+    return 0;
+  }
+
+  return command->slot < RENDER_SLOT_COUNT;
+}
+
+internal enum hh_audio_render_error
+LoadScript(char *path, struct render_script *script)
+{
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "cannot open script." NEWLINE "  filename: %s" NEWLINE, path);
+    return HH_AUDIO_RENDER_ERROR_IO_OPEN;
+  }
+
+  enum hh_audio_render_error errorCode = HH_AUDIO_RENDER_ERROR_NONE;
+  script->commandCount = 0;
+  script->frameCount = 0;
+
+  char line[256];
+  u32 lineNumber = 0;
+  b32 isEnded = 0;
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+
+    char *c = line;
+    while (*c == ' ' || *c == '\t')
+      c++;
+    if (*c == '#' || *c == '\n' || *c == 0)
+      continue;
+
+    if (script->commandCount == RENDER_COMMAND_COUNT_MAX) {
+      fprintf(stderr, "script has more than %u commands." NEWLINE, RENDER_COMMAND_COUNT_MAX);
+      errorCode = HH_AUDIO_RENDER_ERROR_SCRIPT_TOO_LONG;
+      goto end;
+    }
+
+    struct render_command *command = script->commands + script->commandCount;
+    ZeroMemory(command, sizeof(*command));
+    if (isEnded || !ParseCommand(c, command) ||
+        (script->commandCount > 0 && command->frame < script->commands[script->commandCount - 1].frame)) {
+      fprintf(stderr, "malformed script." NEWLINE "  %s:%u: %s", path, lineNumber, c);
+      errorCode = HH_AUDIO_RENDER_ERROR_SCRIPT_MALFORMED;
+      goto end;
+    }
+    script->commandCount++;
+
+    if (command->type == RENDER_COMMAND_TYPE_END) {
+      script->frameCount = command->frame;
+      isEnded = 1;
+    }
+  }
+
+  if (ferror(file)) {
+    errorCode = HH_AUDIO_RENDER_ERROR_IO_READ;
+    goto end;
+  }
+
+  if (!isEnded) {
+    fprintf(stderr, "script has no end command." NEWLINE "  filename: %s" NEWLINE, path);
+    errorCode = HH_AUDIO_RENDER_ERROR_SCRIPT_MALFORMED;
+    goto end;
+  }
+
+end:
+  fclose(file);
+  return errorCode;
+}
+
+/*****************************************************************
+ * OUTPUT
+ *****************************************************************/
+
+#pragma pack(push, 1)
+
+struct wave_header {
+  u32 riffId;
+  u32 fileSize;
+  u32 waveId;
+
+  u32 fmtId;
+  u32 fmtSize;
+  u16 audioFormat;
+  u16 numChannels;
+  u32 sampleRate;
+  u32 byteRate;
+  u16 blockAlign;
+  u16 bitsPerSample;
+
+  u32 dataId;
+  u32 dataSize;
+};
+
+#pragma pack(pop)
+
+#define WAVE_CHUNKID(a, b, c, d) ((u32)(a) << 0x00 | (u32)(b) << 0x08 | (u32)(c) << 0x10 | (u32)(d) << 0x18)
+#define WAVE_FORMAT_PCM 0x0001
+
+internal enum hh_audio_render_error
+WriteWave(char *path, s16 *samples, u32 sampleCount)
+{
+  u32 dataSize = sampleCount * SAMPLE_CHANNELS * sizeof(*samples);
+  struct wave_header header = {
+      .riffId = WAVE_CHUNKID('R', 'I', 'F', 'F'),
+      .fileSize = sizeof(header) - 8 + dataSize,
+      .waveId = WAVE_CHUNKID('W', 'A', 'V', 'E'),
+
+      .fmtId = WAVE_CHUNKID('f', 'm', 't', ' '),
+      .fmtSize = 16,
+      .audioFormat = WAVE_FORMAT_PCM,
+      .numChannels = SAMPLE_CHANNELS,
+      .sampleRate = SAMPLE_RATE,
+      .byteRate = SAMPLE_RATE * SAMPLE_CHANNELS * sizeof(*samples),
+      .blockAlign = SAMPLE_CHANNELS * sizeof(*samples),
+      .bitsPerSample = 16,
+
+      .dataId = WAVE_CHUNKID('d', 'a', 't', 'a'),
+      .dataSize = dataSize,
+  };
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "cannot open output." NEWLINE "  filename: %s" NEWLINE, path);
+    return HH_AUDIO_RENDER_ERROR_IO_OPEN;
+  }
+
+  enum hh_audio_render_error errorCode = HH_AUDIO_RENDER_ERROR_NONE;
+  if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(samples, dataSize, 1, file) != 1)
+    errorCode = HH_AUDIO_RENDER_ERROR_IO_WRITE;
+  if (fclose(file) != 0)
+    errorCode = HH_AUDIO_RENDER_ERROR_IO_WRITE;
+
+  if (errorCode != HH_AUDIO_RENDER_ERROR_NONE)
+    fprintf(stderr, "cannot write output." NEWLINE "  filename: %s" NEWLINE, path);
+  return errorCode;
+}
+
+// writes checksum to golden file, replacing what it had
+internal enum hh_audio_render_error
+UpdateGolden(char *path, u32 checksum)
+{
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "cannot open golden." NEWLINE "  filename: %s" NEWLINE, path);
+    return HH_AUDIO_RENDER_ERROR_IO_OPEN;
+  }
+
+  b32 isWritten = fprintf(file, "%08x" NEWLINE, checksum) > 0;
+  if (fclose(file) != 0 || !isWritten) {
+    fprintf(stderr, "cannot write golden." NEWLINE "  filename: %s" NEWLINE, path);
+    return HH_AUDIO_RENDER_ERROR_IO_WRITE;
+  }
+
+  printf("golden  written to %s" NEWLINE, path);
+  return HH_AUDIO_RENDER_ERROR_NONE;
+}
+
+/*
+ * Compares checksum against the one in golden file. Missing golden file is
+ * failure, it is only written with --update-golden.
+ */
+internal enum hh_audio_render_error
+CheckGolden(char *path, u32 checksum)
+{
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "golden is missing, run with --update-golden to write it." NEWLINE "  filename: %s" NEWLINE,
+            path);
+    return HH_AUDIO_RENDER_ERROR_GOLDEN_MISSING;
+  }
+
+  u32 expected;
+  b32 isRead = fscanf(file, "%x", &expected) == 1;
+  fclose(file);
+  if (!isRead) {
+    fprintf(stderr, "malformed golden." NEWLINE "  filename: %s" NEWLINE, path);
+    return HH_AUDIO_RENDER_ERROR_IO_READ;
+  }
+
+  if (expected != checksum) {
+    fprintf(stderr, "output does not match golden." NEWLINE "  expected: %08x" NEWLINE "  got:      %08x" NEWLINE,
+            expected, checksum);
+    return HH_AUDIO_RENDER_ERROR_GOLDEN_MISMATCH;
+  }
+
+  printf("golden  matches %s" NEWLINE, path);
+  return HH_AUDIO_RENDER_ERROR_NONE;
+}
+
+/*****************************************************************
+ * SYNTHETIC PACK
+ *****************************************************************/
+
+/* NOTE(e2dk4r): Audios are made with integer math only, so pack is same on
+ * every machine and golden checksum of a script does not depend on libm.
+ * Phase is 16.16 fixed point, one cycle is 1 << 16.
+ */
+
+#define SYNTHETIC_PHASE_ONE (1u << 16)
+
+enum synthetic_wave {
+  SYNTHETIC_WAVE_TRIANGLE,
+  SYNTHETIC_WAVE_SQUARE,
+  SYNTHETIC_WAVE_NOISE,
+};
+
+struct synthetic_voice {
+  enum synthetic_wave wave;
+  // cycles per second at start and end of audio
+  u32 frequencyStart;
+  u32 frequencyEnd;
+  s32 amplitude;
+  // amplitude falls to 0 at end of audio
+  b32 isDecaying;
+};
+
+struct synthetic_audio {
+  enum asset_type_id typeId;
+  enum hha_audio_chain chain;
+  u32 sampleCount;
+  // one voice per channel
+  u32 channelCount;
+  struct synthetic_voice voices[2];
+};
+
+// NOTE(e2dk4r): music is one piece cut into chunks that advance into each other
+comptime struct synthetic_audio SyntheticAudios[] = {
+    {ASSET_TYPE_BLOOP, HHA_AUDIO_CHAIN_NONE, 12000, 1, {{SYNTHETIC_WAVE_TRIANGLE, 440, 440, 12000, 1}}},
+    {ASSET_TYPE_BLOOP, HHA_AUDIO_CHAIN_NONE, 9000, 1, {{SYNTHETIC_WAVE_TRIANGLE, 660, 880, 12000, 1}}},
+    {ASSET_TYPE_CRACK, HHA_AUDIO_CHAIN_NONE, 4800, 1, {{SYNTHETIC_WAVE_NOISE, 0, 0, 9000, 1}}},
+    {ASSET_TYPE_DROP, HHA_AUDIO_CHAIN_NONE, 24000, 1, {{SYNTHETIC_WAVE_TRIANGLE, 880, 110, 14000, 0}}},
+    {ASSET_TYPE_GLIDE,
+     HHA_AUDIO_CHAIN_NONE,
+     24000,
+     2,
+     {{SYNTHETIC_WAVE_TRIANGLE, 220, 660, 10000, 0}, {SYNTHETIC_WAVE_SQUARE, 110, 330, 4000, 0}}},
+    {ASSET_TYPE_MUSIC,
+     HHA_AUDIO_CHAIN_ADVANCE,
+     48000,
+     2,
+     {{SYNTHETIC_WAVE_TRIANGLE, 262, 262, 8000, 0}, {SYNTHETIC_WAVE_TRIANGLE, 330, 330, 8000, 0}}},
+    {ASSET_TYPE_MUSIC,
+     HHA_AUDIO_CHAIN_ADVANCE,
+     48000,
+     2,
+     {{SYNTHETIC_WAVE_TRIANGLE, 294, 294, 8000, 0}, {SYNTHETIC_WAVE_TRIANGLE, 392, 392, 8000, 0}}},
+    {ASSET_TYPE_MUSIC,
+     HHA_AUDIO_CHAIN_NONE,
+     48000,
+     2,
+     {{SYNTHETIC_WAVE_TRIANGLE, 262, 262, 8000, 1}, {SYNTHETIC_WAVE_TRIANGLE, 330, 330, 8000, 1}}},
+    {ASSET_TYPE_PUHP,
+     HHA_AUDIO_CHAIN_NONE,
+     7200,
+     2,
+     {{SYNTHETIC_WAVE_SQUARE, 80, 60, 10000, 1}, {SYNTHETIC_WAVE_NOISE, 0, 0, 6000, 1}}},
+};
+
+internal s16
+SyntheticSample(struct synthetic_voice *voice, u32 *phase, u32 *noise, u32 sampleIndex, u32 sampleCount)
+{
+  s32 amplitude = voice->amplitude;
+  if (voice->isDecaying)
+    amplitude = (s32)((s64)amplitude * (sampleCount - sampleIndex) / sampleCount);
+
+  s32 value = 0;
+  u32 cyclePosition = *phase & (SYNTHETIC_PHASE_ONE - 1);
+  switch (voice->wave) {
+  case SYNTHETIC_WAVE_TRIANGLE: {
+    // -1 to 1 in first half of cycle, back to -1 in second half
+    u32 halfCycle = SYNTHETIC_PHASE_ONE / 2;
+    s32 ramp = cyclePosition < halfCycle ? (s32)cyclePosition : (s32)(SYNTHETIC_PHASE_ONE - cyclePosition);
+    value = (s32)((s64)amplitude * (2 * ramp - (s32)halfCycle) / (s32)halfCycle);
+  } break;
+
+  case SYNTHETIC_WAVE_SQUARE: {
+    value = cyclePosition < SYNTHETIC_PHASE_ONE / 2 ? amplitude : -amplitude;
+  } break;
+
+  case SYNTHETIC_WAVE_NOISE: {
+    // xorshift32
+    *noise ^= *noise << 13;
+    *noise ^= *noise >> 17;
+    *noise ^= *noise << 5;
+    value = (s32)((s64)amplitude * (s32)(*noise >> 16) / 0x8000) - amplitude;
+  } break;
+  }
+
+  u32 frequency = voice->frequencyStart +
+                  (u32)(((s64)voice->frequencyEnd - (s64)voice->frequencyStart) * sampleIndex / sampleCount);
+  *phase += (u32)((u64)frequency * SYNTHETIC_PHASE_ONE / SAMPLE_RATE);
+
+  // NOTE(e2dk4r): amplitudes are below s16 range
+  assert(value >= -32768 && value <= 32767);
+  return (s16)value;
+}
+
+/*
+ * Writes pack of SyntheticAudios to path. Audios of same type are next to
+ * each other in pack, in order they are listed.
+ */
+internal enum hh_audio_render_error
+WriteSyntheticPack(char *path)
+{
+  enum hh_audio_render_error errorCode = HH_AUDIO_RENDER_ERROR_NONE;
+
+  u32 assetCount = 1 + ARRAY_COUNT(SyntheticAudios);
+  struct hha_asset_type assetTypes[ASSET_TYPE_COUNT] = {};
+  struct hha_asset assets[1 + ARRAY_COUNT(SyntheticAudios)] = {};
+
+  struct hha_header header = {
+      .magic = HHA_MAGIC,
+      .version = HHA_VERSION,
+      .tagCount = 0,
+      .assetCount = assetCount,
+      .assetTypeCount = ASSET_TYPE_COUNT,
+      .sectionCount = 4,
+      .sectionsOffset = sizeof(header),
+  };
+
+  struct hha_section sections[4] = {
+      {.type = HHA_SECTION_TYPE_TAGS},
+      {.type = HHA_SECTION_TYPE_ASSET_TYPES},
+      {.type = HHA_SECTION_TYPE_ASSETS},
+      {.type = HHA_SECTION_TYPE_DATA},
+  };
+  struct hha_section *tagsSection = sections + 0;
+  struct hha_section *assetTypesSection = sections + 1;
+  struct hha_section *assetsSection = sections + 2;
+  struct hha_section *dataSection = sections + 3;
+
+  tagsSection->offset = ALIGN(header.sectionsOffset + sizeof(sections), HHA_ALIGNMENT);
+  assetTypesSection->offset = tagsSection->offset;
+  assetTypesSection->size = sizeof(assetTypes);
+  assetsSection->offset = ALIGN(assetTypesSection->offset + assetTypesSection->size, HHA_ALIGNMENT);
+  assetsSection->size = sizeof(assets);
+  dataSection->offset = ALIGN(assetsSection->offset + assetsSection->size, HHA_ALIGNMENT);
+
+  u64 dataOffset = dataSection->offset;
+  for (u32 audioIndex = 0; audioIndex < ARRAY_COUNT(SyntheticAudios); audioIndex++) {
+    const struct synthetic_audio *audio = SyntheticAudios + audioIndex;
+    struct hha_asset *asset = assets + 1 + audioIndex;
+    assert(audioIndex == 0 || audio->typeId >= SyntheticAudios[audioIndex - 1].typeId);
+
+    struct hha_asset_type *type = assetTypes + audio->typeId;
+    if (type->assetIndexFirst == type->assetIndexOnePastLast)
+      type->assetIndexFirst = 1 + audioIndex;
+    type->assetIndexOnePastLast = 2 + audioIndex;
+
+    asset->dataOffset = dataOffset;
+    asset->dataSize = audio->channelCount * audio->sampleCount * (u32)sizeof(s16);
+    asset->codec = HHA_CODEC_NONE;
+    asset->audio.channelCount = audio->channelCount;
+    asset->audio.sampleCount = audio->sampleCount;
+    asset->audio.chain = audio->chain;
+    dataOffset = ALIGN(dataOffset + asset->dataSize, HHA_ALIGNMENT);
+  }
+  for (u32 typeId = 0; typeId < ASSET_TYPE_COUNT; typeId++)
+    assetTypes[typeId].typeId = typeId;
+  dataSection->size = dataOffset - dataSection->offset;
+
+  // NOTE(e2dk4r): whole pack is made in memory, padding is left zero
+  u64 packSize = dataSection->offset + dataSection->size;
+  u8 *pack = calloc(1, packSize);
+  if (!pack) {
+    errorCode = HH_AUDIO_RENDER_ERROR_MALLOC;
+    goto end;
+  }
+
+  // NOTE(e2dk4r): phase of music carries over its chunks, so they join
+  // without a click like cut piece of music does
+  u32 phases[2] = {};
+  u32 noise = 0x2545f491;
+  for (u32 audioIndex = 0; audioIndex < ARRAY_COUNT(SyntheticAudios); audioIndex++) {
+    const struct synthetic_audio *audio = SyntheticAudios + audioIndex;
+    struct hha_asset *asset = assets + 1 + audioIndex;
+    s16 *samples = (s16 *)(pack + asset->dataOffset);
+
+    b32 isChainedFromPrevious = audioIndex > 0 && SyntheticAudios[audioIndex - 1].chain == HHA_AUDIO_CHAIN_ADVANCE;
+    if (!isChainedFromPrevious)
+      phases[0] = phases[1] = 0;
+
+    for (u32 channelIndex = 0; channelIndex < audio->channelCount; channelIndex++) {
+      struct synthetic_voice voice = audio->voices[channelIndex];
+      for (u32 sampleIndex = 0; sampleIndex < audio->sampleCount; sampleIndex++)
+        *samples++ = SyntheticSample(&voice, phases + channelIndex, &noise, sampleIndex, audio->sampleCount);
+    }
+
+    asset->dataChecksum = Crc32c(pack + asset->dataOffset, asset->dataSize);
+  }
+
+  tagsSection->checksum = 0;
+  assetTypesSection->checksum = Crc32c(assetTypes, assetTypesSection->size);
+  assetsSection->checksum = Crc32c(assets, assetsSection->size);
+
+  __builtin_memcpy(pack, &header, sizeof(header));
+  __builtin_memcpy(pack + header.sectionsOffset, sections, sizeof(sections));
+  __builtin_memcpy(pack + assetTypesSection->offset, assetTypes, sizeof(assetTypes));
+  __builtin_memcpy(pack + assetsSection->offset, assets, sizeof(assets));
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "cannot open pack." NEWLINE "  filename: %s" NEWLINE, path);
+    errorCode = HH_AUDIO_RENDER_ERROR_IO_OPEN;
+    goto end;
+  }
+
+  b32 isWritten = fwrite(pack, packSize, 1, file) == 1;
+  if (fclose(file) != 0 || !isWritten) {
+    fprintf(stderr, "cannot write pack." NEWLINE "  filename: %s" NEWLINE, path);
+    errorCode = HH_AUDIO_RENDER_ERROR_IO_WRITE;
+    goto end;
+  }
+
+  printf("pack    %u audios written to %s" NEWLINE, (u32)ARRAY_COUNT(SyntheticAudios), path);
+
+end:
+  free(pack);
+  return errorCode;
+}
+
+/*****************************************************************
+ * STARTING POINT
+ *****************************************************************/
+
+global_variable struct render_script script;
+
+int
+main(int argc, char *argv[])
+{
+  enum hh_audio_render_error errorCode = HH_AUDIO_RENDER_ERROR_NONE;
+
+  // argc 0 is program path
+  argc--;
+  argv++;
+
+  // parse arguments
+  u32 bufferSampleCount = 800;
+  char *goldenPath = 0;
+  b32 isGoldenUpdated = 0;
+  while (argc >= 1 && argv[0][0] == '-') {
+    if (__builtin_strcmp(argv[0], "--update-golden") == 0) {
+      isGoldenUpdated = 1;
+      argc--;
+      argv++;
+      continue;
+    }
+
+    if (argc < 2)
+      break;
+
+    if (__builtin_strcmp(argv[0], "--buffer") == 0) {
+      bufferSampleCount = (u32)strtoul(argv[1], 0, 10);
+    } else if (__builtin_strcmp(argv[0], "--golden") == 0) {
+      goldenPath = argv[1];
+    } else if (__builtin_strcmp(argv[0], "--synthetic-pack") == 0) {
+      errorCode = WriteSyntheticPack(argv[1]);
+      goto end;
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  // NOTE(e2dk4r): game mixes 8 samples at a time
+  if (argc < 1 || argc > 2 || bufferSampleCount == 0 || bufferSampleCount % 8 != 0 ||
+      (isGoldenUpdated && !goldenPath)) {
+    usage();
+    errorCode = HH_AUDIO_RENDER_ERROR_ARGUMENTS;
+    goto end;
+  }
+
+  char *scriptPath = argv[0];
+  char *outputPath = argc == 2 ? argv[1] : "audio_render.wav";
+
+  errorCode = LoadScript(scriptPath, &script);
+  if (errorCode != HH_AUDIO_RENDER_ERROR_NONE)
+    goto end;
+
+  struct platform_api platform = {
+      .WorkQueueAddEntry = RenderWorkQueueAddEntry,
+      .WorkQueueCompleteAllWork = RenderWorkQueueCompleteAllWork,
+      .OpenNextFile = RenderOpenNextFile,
+      .ReopenFile = RenderReopenFile,
+      .CloseFile = RenderCloseFile,
+      .IsSameFile = RenderIsSameFile,
+      .ReadFromFile = RenderReadFromFile,
+      .HasFileError = RenderHasFileError,
+      .FileError = RenderFileError,
+      .GetAllFilesOfTypeBegin = RenderGetAllFilesOfTypeBegin,
+      .GetAllFilesOfTypeEnd = RenderGetAllFilesOfTypeEnd,
+      .AllocateMemory = RenderAllocateMemory,
+      .DeallocateMemory = RenderDeallocateMemory,
+  };
+  Platform = &platform;
+
+  /* memory */
+  u64 permanentSize = 64 * MEGABYTES;
+  u64 transientSize = 512 * MEGABYTES;
+  u64 outputSize = (u64)script.frameCount * bufferSampleCount * SAMPLE_CHANNELS * sizeof(s16);
+  u64 memorySize = permanentSize + transientSize + outputSize;
+  void *memory = mmap(0, memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    errorCode = HH_AUDIO_RENDER_ERROR_MALLOC;
+    goto end;
+  }
+
+  struct memory_arena permanentArena;
+  MemoryArenaInit(&permanentArena, memory, permanentSize);
+  struct transient_state *transientState = MemoryArenaPush(&permanentArena, sizeof(*transientState));
+  MemoryArenaInit(&transientState->transientArena, memory + permanentSize, transientSize);
+  s16 *output = memory + permanentSize + transientSize;
+
+  // NOTE(e2dk4r): one worker, game code is run on main thread
+  TaskPoolInit(&transientState->taskPool, &transientState->transientArena, 1);
+  transientState->highPriorityQueue = 0;
+  transientState->lowPriorityQueue = 0;
+
+  /* assets */
+  struct game_assets *assets = GameAssetsAllocate(&transientState->transientArena, 256 * MEGABYTES, transientState);
+  transientState->assets = assets;
+  if (assets->fileCount == 0) {
+    fprintf(stderr, "no asset files in working directory." NEWLINE);
+    errorCode = HH_AUDIO_RENDER_ERROR_NO_ASSET_FILES;
+    goto unmap;
+  }
+
+  for (u32 commandIndex = 0; commandIndex < script.commandCount; commandIndex++) {
+    struct render_command *command = script.commands + commandIndex;
+    if (command->type != RENDER_COMMAND_TYPE_PLAY && command->type != RENDER_COMMAND_TYPE_STREAM)
+      continue;
+
+    struct asset_type *type = assets->assetTypes + command->typeId;
+    if (type->assetIndexFirst + command->index >= type->assetIndexOnePastLast) {
+      fprintf(stderr, "audio not found in asset files." NEWLINE "  type: %s index: %u" NEWLINE,
+              AudioTypeNames[command->typeId - ASSET_TYPE_BLOOP].name, command->index);
+      errorCode = HH_AUDIO_RENDER_ERROR_AUDIO_NOT_FOUND;
+      goto unmap;
+    }
+  }
+
+  /* NOTE(e2dk4r): Loads every audio before mixing, so loading is not
+   * counted as mixer cycles. Streams chain into next audios of same type.
+   */
+  for (u32 typeId = ASSET_TYPE_BLOOP; typeId <= ASSET_TYPE_PUHP; typeId++) {
+    struct asset_type *type = assets->assetTypes + typeId;
+    for (u32 assetIndex = type->assetIndexFirst; assetIndex < type->assetIndexOnePastLast; assetIndex++)
+      AudioLoad(assets, (struct audio_id){assetIndex});
+  }
+
+  /* render */
+  struct audio_state audioState;
+  AudioStateInit(&audioState, &permanentArena);
+  struct playing_audio_id slots[RENDER_SLOT_COUNT] = {};
+
+  u32 commandIndex = 0;
+  u64 cycleCount = 0;
+  u64 frameCycleCountMax = 0;
+  for (u32 frame = 0; frame < script.frameCount; frame++) {
+    for (; commandIndex < script.commandCount && script.commands[commandIndex].frame == frame; commandIndex++) {
+      struct render_command *command = script.commands + commandIndex;
+      struct playing_audio_id *slot = slots + command->slot;
+
+      switch (command->type) {
+      case RENDER_COMMAND_TYPE_PLAY:
+      case RENDER_COMMAND_TYPE_STREAM: {
+        struct asset_type *type = assets->assetTypes + command->typeId;
+        struct audio_id id = {type->assetIndexFirst + command->index};
+        if (command->type == RENDER_COMMAND_TYPE_PLAY)
+          *slot = PlayAudio(&audioState, id);
+        else
+          *slot = PlayAudioStream(&audioState, id, AUDIO_PRIORITY_DEFAULT);
+      } break;
+
+      case RENDER_COMMAND_TYPE_VOLUME: {
+        ChangeVolume(&audioState, *slot, command->fadeDurationInSeconds, command->volume);
+      } break;
+
+      case RENDER_COMMAND_TYPE_PITCH: {
+        ChangePitch(&audioState, *slot, command->dSample);
+      } break;
+
+      case RENDER_COMMAND_TYPE_BUS: {
+        ChangeBus(&audioState, *slot, command->busId);
+      } break;
+
+      case RENDER_COMMAND_TYPE_RESAMPLER: {
+        ChangeResampler(&audioState, command->resampler);
+      } break;
+
+      case RENDER_COMMAND_TYPE_BUS_VOLUME: {
+        ChangeBusVolume(&audioState, command->busId, command->busFadeDurationInSeconds, command->busVolume);
+      } break;
+
+      case RENDER_COMMAND_TYPE_BUS_FILTER: {
+        ChangeBusFilter(&audioState, command->busId, command->filterType, command->filterFrequency,
+                        command->filterQ);
+      } break;
+
+      case RENDER_COMMAND_TYPE_BUS_REVERB: {
+        ChangeBusReverb(&audioState, command->busId, command->reverbWet, command->reverbRoomSize);
+      } break;
+
+      case RENDER_COMMAND_TYPE_BUS_LIMITER: {
+        ChangeBusLimiter(&audioState, command->busId, command->limiterThreshold);
+      } break;
+
+      case RENDER_COMMAND_TYPE_END: {
+      } break;
+      }
+    }
+
+    // NOTE(e2dk4r): game thread loads what mixer asked for and publishes audios once every frame
+    AudioLoadRequestsProcess(&audioState, assets);
+    AudioSnapshotPublish(&audioState, assets);
+
+    struct game_audio_buffer audioBuffer = {
+        .sampleRate = SAMPLE_RATE,
+        .sampleCount = bufferSampleCount,
+        .samples = output + (u64)frame * bufferSampleCount * SAMPLE_CHANNELS,
+    };
+
+    u64 startCycleCount = __rdtsc();
+    b32 isWritten = OutputPlayingAudios(&audioState, &audioBuffer);
+    u64 frameCycleCount = __rdtsc() - startCycleCount;
+    cycleCount += frameCycleCount;
+    frameCycleCountMax = Maximum(frameCycleCountMax, frameCycleCount);
+
+    // NOTE(e2dk4r): platform plays silence when nothing is written
+    if (!isWritten)
+      ZeroMemory(audioBuffer.samples, bufferSampleCount * SAMPLE_CHANNELS * sizeof(s16));
+  }
+
+  u32 sampleCount = script.frameCount * bufferSampleCount;
+  u32 checksum = Crc32cAccumulate(0, output, outputSize);
+  printf("frames  %u of %u samples, %u samples" NEWLINE, script.frameCount, bufferSampleCount, sampleCount);
+  printf("mixer   %.2f cycles/sample, %" PRIu64 " cycles at most in a frame" NEWLINE,
+         sampleCount ? (f64)cycleCount / (f64)sampleCount : 0.0, frameCycleCountMax);
+  printf("stream  %" PRIu64 " underruns of %" PRIu64 " samples, %" PRIu64 " late" NEWLINE,
+         AtomicLoadRelaxed(&audioState.streamUnderrunCount), AtomicLoadRelaxed(&audioState.streamUnderrunSampleCount),
+         AtomicLoadRelaxed(&audioState.streamLateCount));
+  printf("dropped %u commands" NEWLINE, AtomicLoadRelaxed(&audioState.droppedCommandCount));
+  printf("crc32c  %08x" NEWLINE, checksum);
+
+  errorCode = WriteWave(outputPath, output, sampleCount);
+  if (errorCode != HH_AUDIO_RENDER_ERROR_NONE)
+    goto unmap;
+
+  if (goldenPath && isGoldenUpdated)
+    errorCode = UpdateGolden(goldenPath, checksum);
+  else if (goldenPath)
+    errorCode = CheckGolden(goldenPath, checksum);
+
+unmap:
+  munmap(memory, memorySize);
+end:
+  return (s32)errorCode;
+}